@@ -29,10 +29,14 @@ function selectLightColor(color) {
 }
 
 // Function to handle auto-brightness toggle
-function toggleAutoBrightness(isEnabled) {
+function toggleAutoBrightness(isEnabled, firstLoad = false) {
   const brightnessSliderContainer = document.getElementById('brightnessSliderContainer');
   brightnessSliderContainer.style.display = isEnabled ? 'none' : 'block';
 
+  if (firstLoad) {
+    return;
+  }
+
   const enabled = isEnabled ? '1' : '0';
 
   fetch(`/setAutoBrightness?enabled=${enabled}`)
@@ -123,6 +127,31 @@ function saveNTP() {
       .catch(error => console.error('Error saving NTP:', error));
 }
 
+// the clock answers 503 with Retry-After while it is short of memory, page loads try again
+function fetchRetrying(url, options = {}, attempts = 3) {
+  return fetch(url, options).then(response => {
+    if (response.status !== 503 || attempts <= 1) {
+      return response;
+    }
+    const seconds = parseInt(response.headers.get('Retry-After'), 10) || 1;
+    return new Promise(resolve => setTimeout(resolve, seconds * 1000))
+      .then(() => fetchRetrying(url, options, attempts - 1));
+  });
+}
+
+// the full list is served from flash, the selected zone comes with the state
+function loadTimezones(current) {
+  const select = document.getElementById('timezoneSelect');
+
+  return fetchRetrying('/timezones')
+    .then(response => response.text())
+    .then(options => {
+      select.innerHTML = options;
+      select.value = current;
+    })
+    .catch(error => console.error('Error loading timezones:', error));
+}
+
 function toggleNtpTimeUpdate(isChecked, firstLoad = false) {
   const container = document.getElementById('ntpTimeUpdateContainer');
   container.style.display = isChecked ? 'block' : 'none';
@@ -134,13 +163,19 @@ function toggleNtpTimeUpdate(isChecked, firstLoad = false) {
 
 function saveLightSchedule() {
   const lightScheduleToggle = document.getElementById('lightScheduleToggle').checked;
-  const scheduleStart = document.getElementById('startTime').value;
-  const scheduleEnd = document.getElementById('endTime').value;
   const formData = new FormData();
   formData.append('enabled', lightScheduleToggle ? '1' : '0');
   if(lightScheduleToggle) {
-    formData.append('scheduleStart', scheduleStart);
-    formData.append('scheduleEnd', scheduleEnd);
+    for (const edge of ['start', 'end']) {
+      const Edge = edge.charAt(0).toUpperCase() + edge.slice(1);
+      const anchor = document.getElementById(`${edge}Anchor`).value;
+      formData.append(`schedule${Edge}Anchor`, anchor);
+      if (anchor === 'time') {
+        formData.append(`schedule${Edge}`, document.getElementById(`${edge}Time`).value);
+      } else {
+        formData.append(`schedule${Edge}Offset`, document.getElementById(`${edge}Offset`).value || '0');
+      }
+    }
   }
   fetch('/setLightSchedule', {
     method: 'POST',
@@ -153,6 +188,41 @@ function saveLightSchedule() {
     .catch(error => console.error('Error saving light schedule:', error));   
 }
 
+// anchored edges take an offset instead of a time of day
+function updateScheduleAnchor(edge) {
+  const anchor = document.getElementById(`${edge}Anchor`).value;
+  document.getElementById(`${edge}TimeRow`).style.display = anchor === 'time' ? '' : 'none';
+  document.getElementById(`${edge}OffsetRow`).style.display = anchor === 'time' ? 'none' : '';
+}
+
+function saveLocation() {
+  const locationToggle = document.getElementById('locationToggle').checked;
+  const formData = new FormData();
+  formData.append('enabled', locationToggle ? '1' : '0');
+  if(locationToggle) {
+    formData.append('latitude', document.getElementById('latitude').value);
+    formData.append('longitude', document.getElementById('longitude').value);
+  }
+  fetch('/setLocation', {
+    method: 'POST',
+    body: formData
+  })
+    .then(response => response.text())
+    .then(data => {
+      console.log(`Location saved: ${data}`);
+    })
+    .catch(error => console.error('Error saving location:', error));
+}
+
+function toggleLocation(isChecked, firstLoad = false) {
+  const container = document.getElementById('locationContainer');
+  container.style.display = isChecked ? 'block' : 'none';
+
+  if(!firstLoad && !isChecked) {
+    saveLocation();
+  }
+}
+
 function toggleLightSchedule(isChecked, firstLoad = false) {
   const container = document.getElementById('lightScheduleContainer');
   container.style.display = isChecked ? 'block' : 'none';
@@ -264,6 +334,217 @@ function resetConfiguration(event) {
 }
 
 
+// State
+// The pages are static, the current settings are filled in from /api/v1/state
+function formatMinutes(minutes) {
+  return `${String(Math.floor(minutes / 60)).padStart(2, '0')}:${String(minutes % 60).padStart(2, '0')}`;
+}
+
+// anchored edges hold a signed offset from sunrise/sunset instead of a time of day
+function fillScheduleEdge(edge, value, flags, sunriseFlag, sunsetFlag) {
+  const anchor = (flags & sunriseFlag) ? 'sunrise' : ((flags & sunsetFlag) ? 'sunset' : 'time');
+  document.getElementById(`${edge}Anchor`).value = anchor;
+  document.getElementById(`${edge}Time`).value = anchor === 'time' ? formatMinutes(value) : '00:00';
+  document.getElementById(`${edge}Offset`).value = anchor === 'time' ? 0 : value;
+  updateScheduleAnchor(edge);
+}
+
+function fillLightPage(state) {
+  const light = state.light;
+  document.getElementById('lightToggle').checked = light.state;
+  document.getElementById('lightColorPicker').value = light.color;
+  document.getElementById('autoBrightnessToggle').checked = light.autoBrightness.enabled;
+  document.getElementById('brightnessSlider').value = light.brightness;
+  updateBrightnessValue(light.brightness);
+  toggleAutoBrightness(light.autoBrightness.enabled, true);
+}
+
+function fillTimePage(state) {
+  const time = state.time;
+  document.getElementById('currentTime').innerText = time.current;
+  document.getElementById('setTime').value = time.current;
+
+  // the page edits the first rule, further rules are managed through the endpoint
+  const schedule = state.schedule;
+  const rule = schedule.rules.length > 0 ? schedule.rules[0] : { start: 0, end: 0, flags: 0 };
+  document.getElementById('lightScheduleToggle').checked = schedule.enabled;
+  fillScheduleEdge('start', rule.start, rule.flags, 0x04, 0x08);
+  fillScheduleEdge('end', rule.end, rule.flags, 0x10, 0x20);
+  toggleLightSchedule(schedule.enabled, true);
+
+  const location = state.location;
+  document.getElementById('locationToggle').checked = location.enabled;
+  document.getElementById('latitude').value = location.latitude.toFixed(4);
+  document.getElementById('longitude').value = location.longitude.toFixed(4);
+  document.getElementById('sunTimes').innerText = `${time.sunrise || '--:--'} / ${time.sunset || '--:--'}`;
+  toggleLocation(location.enabled, true);
+
+  const ntp = state.ntp;
+  document.getElementById('ntpTimeUpdate').checked = ntp.enabled;
+  document.getElementById('ntpServer').value = ntp.server;
+  document.getElementById('ntpUpdateInterval').value = ntp.interval;
+  toggleNtpTimeUpdate(ntp.enabled, true);
+  return loadTimezones(ntp.timezone);
+}
+
+function fillSystemPage(state) {
+  const mqtt = state.mqtt;
+  document.getElementById('haIntegrationToggle').checked = mqtt.enabled;
+  document.getElementById('brokerIP').value = mqtt.host;
+  document.getElementById('brokerPort').value = mqtt.port;
+  document.getElementById('mqttUsername').value = mqtt.username;
+  document.getElementById('defaultTopic').value = mqtt.topic;
+  toggleHaIntegration(mqtt.enabled, true);
+
+  document.getElementById('clockFaceOptionToggle').checked = state.mode === 1;
+  document.getElementById('configWrites').innerText = state.configWrites;
+}
+
+function loadState() {
+  return fetchRetrying('/api/v1/state', { cache: 'no-store' })
+    .then(response => {
+      if (!response.ok) {
+        throw new Error(`state request failed: ${response.status}`);
+      }
+      return response.json();
+    })
+    .then(state => {
+      if (document.getElementById('lightToggle')) {
+        fillLightPage(state);
+      }
+      if (document.getElementById('ntpTimeUpdate')) {
+        return fillTimePage(state);
+      }
+      if (document.getElementById('haIntegrationToggle')) {
+        fillSystemPage(state);
+      }
+      const fwVersion = document.getElementById('fwVersion');
+      if (fwVersion) {
+        fwVersion.innerText = state.firmware;
+      }
+    })
+    .catch(error => console.error('Error loading state:', error));
+}
+
+// Live updates while a page is open, each event only has the fields that changed
+function applyStateEvent(event) {
+  const delta = JSON.parse(event.data);
+  const update = (id, apply) => {
+    const element = document.getElementById(id);
+    if (element) {
+      apply(element);
+    }
+  };
+
+  if ('state' in delta) {
+    update('lightToggle', element => { element.checked = delta.state; });
+  }
+  if ('color' in delta) {
+    update('lightColorPicker', element => { element.value = delta.color; });
+  }
+  if ('autoBrightness' in delta) {
+    update('autoBrightnessToggle', element => {
+      element.checked = delta.autoBrightness;
+      toggleAutoBrightness(delta.autoBrightness, true);
+    });
+  }
+  if ('brightness' in delta) {
+    // not while the slider is being dragged
+    update('brightnessSlider', element => {
+      if (document.activeElement !== element) {
+        element.value = delta.brightness;
+        updateBrightnessValue(delta.brightness);
+      }
+    });
+  }
+  if ('time' in delta) {
+    update('currentTime', element => { element.innerText = delta.time; });
+  }
+  if ('illuminance' in delta) {
+    update('illuminance', element => { element.innerText = delta.illuminance; });
+  }
+  if ('renderUs' in delta) {
+    update('renderStats', element => { element.innerText = `${delta.renderUs} µs (max ${delta.renderMaxUs} µs)`; });
+  }
+}
+
+function listenForEvents() {
+  if (!window.EventSource) {
+    return;
+  }
+  const source = new EventSource('/events');
+  source.addEventListener('state', applyStateEvent);
+}
+
+// Firmware upload with progress from /api/v1/update, the manifest adds size and SHA-256
+function readManifest(input) {
+  if (!input || input.files.length === 0) {
+    return Promise.resolve(null);
+  }
+  return input.files[0].text().then(text => JSON.parse(text));
+}
+
+function showUpdateProgress(status) {
+  const progress = document.getElementById('updateProgress');
+  const rate = `${Math.round(status.bytesPerSecond / 1024)} KiB/s`;
+  if (status.status === 'failed') {
+    progress.innerText = `Update failed: ${status.error}`;
+  } else if (status.percent !== null) {
+    progress.innerText = `${status.percent} % at ${rate}`;
+  } else {
+    progress.innerText = `${Math.round(status.received / 1024)} KiB at ${rate}`;
+  }
+}
+
+function uploadFirmware(event) {
+  event.preventDefault();
+  const form = event.target;
+  const file = document.getElementById('file').files[0];
+  const progress = document.getElementById('updateProgress');
+  if (!file) {
+    progress.innerText = 'Select a file first';
+    return;
+  }
+
+  // a delta patch carries size and digest of the firmware it makes
+  const updateType = form.querySelector('input[name="updateType"]:checked').value;
+  readManifest(updateType === 'delta' ? null : document.getElementById('manifest'))
+    .then(manifest => {
+      if (manifest && manifest.size !== file.size) {
+        throw new Error('the manifest is for a different file');
+      }
+      // the fields have to come before the file
+      const data = new FormData();
+      data.append('updateType', updateType);
+      data.append('size', file.size);
+      if (manifest) {
+        data.append('sha256', manifest.sha256);
+      }
+      data.append('file', file);
+
+      let polling = null;
+      const poll = () => fetch('/api/v1/update', { cache: 'no-store' })
+        .then(response => response.json())
+        .then(showUpdateProgress)
+        .catch(() => {});
+      const request = new XMLHttpRequest();
+      request.open('POST', '/update');
+      request.onloadend = () => {
+        clearInterval(polling);
+        if (request.status === 200) {
+          progress.innerText = 'Update complete, restarting...';
+          setTimeout(() => { window.location.href = '/system'; }, 10000);
+        } else {
+          poll();
+        }
+      };
+      request.send(data);
+      progress.innerText = 'Uploading...';
+      polling = setInterval(poll, 1000);
+    })
+    .catch(error => { progress.innerText = `Update not started: ${error.message}`; });
+}
+
 // Theme
 // Apply theme based on user's preference
 function applyTheme(theme) {
@@ -285,30 +566,19 @@ function toggleTheme() {
 // Initializer
 
 document.addEventListener('DOMContentLoaded', function () {
-  // Light Page
-  const autoBrightnessToggle = document.getElementById('autoBrightnessToggle');
-  if (autoBrightnessToggle) {
-    toggleAutoBrightness(autoBrightnessToggle.checked);
-  }
-
-
-  // Time  Page
-  const ntpToggle = document.getElementById('ntpTimeUpdate');
-  if (ntpToggle) {
-    toggleNtpTimeUpdate(ntpToggle.checked, true);
-  }
-
-  // Initialize Light Schedule
-  const lightScheduleToggle = document.getElementById('lightScheduleToggle');
-  if (lightScheduleToggle) {
-    toggleLightSchedule(lightScheduleToggle.checked, true);
+  // Configuration pages: the sections follow their toggles once the state is in
+  if (document.getElementById('lightToggle') || document.getElementById('ntpTimeUpdate') ||
+      document.getElementById('haIntegrationToggle') || document.getElementById('fwVersion')) {
+    loadState().then(() => {
+      if (!document.getElementById('fwVersion')) {
+        listenForEvents();
+      }
+    });
   }
 
-  // System page
-  // Initialize HomeAssistant Integration
-  const haIntegrationToggle = document.getElementById('haIntegrationToggle');
-  if (haIntegrationToggle) {
-    toggleHaIntegration(haIntegrationToggle.checked, true);
+  const uploadForm = document.getElementById('upload_form');
+  if (uploadForm) {
+    uploadForm.addEventListener('submit', uploadFirmware);
   }
 
   const resetConfigurationToggle = document.getElementById('resetConfiguration');
@@ -0,0 +1,87 @@
+#include "admissioncontrol.h"
+#include <stdio.h>
+#include <string.h>
+
+// a page render holds the template renderer and the response buffers, the
+// API routes a ConfigData and its JSON reader or writer
+const AdmissionControl::Limits AdmissionControl::DEFAULT_LIMITS[ROUTE_CLASSES] = {
+    {3, 6144}, // Pages
+    {4, 4096}, // Api
+    {4, 1024}, // Commands
+    {6, 2048}  // Assets, a page load asks for several at once
+};
+
+AdmissionControl::AdmissionControl(const Limits *limits, uint32_t minFreeHeap, uint32_t minLargestBlock)
+    : minFreeHeap(minFreeHeap), minLargestBlock(minLargestBlock)
+{
+    memcpy(this->limits, limits, sizeof(this->limits));
+}
+
+AdmissionControl::Verdict AdmissionControl::admit(RouteClass route, const Heap &heap)
+{
+    if (heap.freeHeap < lowestFreeHeap)
+    {
+        lowestFreeHeap = heap.freeHeap;
+    }
+
+    Verdict verdict = Admitted;
+    if (inFlight[route] >= limits[route].maxInFlight)
+    {
+        verdict = Busy;
+    }
+    else if (heap.freeHeap < minFreeHeap + limits[route].heapCost)
+    {
+        verdict = LowHeap;
+    }
+    else if (heap.largestBlock < minLargestBlock)
+    {
+        verdict = Fragmented;
+    }
+
+    if (verdict != Admitted)
+    {
+        rejected[route]++;
+        reasons[verdict]++;
+        return verdict;
+    }
+    inFlight[route]++;
+    admitted[route]++;
+    return Admitted;
+}
+
+void AdmissionControl::release(RouteClass route)
+{
+    if (inFlight[route] > 0)
+    {
+        inFlight[route]--;
+    }
+}
+
+size_t AdmissionControl::formatStats(const Heap &heap, char *buffer, size_t length) const
+{
+    static const char *const ROUTE_NAMES[ROUTE_CLASSES] = {"pages", "api", "commands", "assets"};
+
+    int written = snprintf(buffer, length, "{\"freeHeap\":%u,\"largestBlock\":%u,\"lowestFreeHeap\":%u,\"minFreeHeap\":%u,\"minLargestBlock\":%u,"
+                                           "\"rejected\":{\"busy\":%u,\"heap\":%u,\"block\":%u},\"routes\":{",
+                           (unsigned)heap.freeHeap, (unsigned)heap.largestBlock,
+                           (unsigned)(lowestFreeHeap == UINT32_MAX ? heap.freeHeap : lowestFreeHeap),
+                           (unsigned)minFreeHeap, (unsigned)minLargestBlock,
+                           (unsigned)reasons[Busy], (unsigned)reasons[LowHeap], (unsigned)reasons[Fragmented]);
+    for (uint8_t route = 0; route < ROUTE_CLASSES && written >= 0 && (size_t)written < length; route++)
+    {
+        int part = snprintf(buffer + written, length - written, "%s\"%s\":{\"inFlight\":%u,\"limit\":%u,\"cost\":%u,\"admitted\":%u,\"rejected\":%u}",
+                            route > 0 ? "," : "", ROUTE_NAMES[route], (unsigned)inFlight[route], (unsigned)limits[route].maxInFlight,
+                            (unsigned)limits[route].heapCost, (unsigned)admitted[route], (unsigned)rejected[route]);
+        written = part < 0 ? part : written + part;
+    }
+    if (written >= 0 && (size_t)written < length)
+    {
+        int part = snprintf(buffer + written, length - written, "}}");
+        written = part < 0 ? part : written + part;
+    }
+    if (written < 0 || (size_t)written >= length)
+    {
+        return 0;
+    }
+    return (size_t)written;
+}
@@ -0,0 +1,72 @@
+#ifndef ADMISSIONCONTROL_H
+#define ADMISSIONCONTROL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Decides whether the web server takes a request now or answers 503 with
+// Retry-After: every route class has a cap on requests in flight and a guess
+// of the heap one of its requests needs, and nothing is taken while the free
+// heap or the largest free block is below its floor, so several open pages
+// cannot starve MQTT and OTA. Only used from the AsyncTCP task.
+class AdmissionControl
+{
+public:
+    enum RouteClass : uint8_t {
+        Pages = 0,  // templated HTML
+        Api,        // JSON in or out
+        Commands,   // small form or query requests
+        Assets,     // CSS, JS and option lists from flash
+        ROUTE_CLASSES
+    };
+
+    enum Verdict : uint8_t {
+        Admitted = 0,
+        Busy,       // the class is at its cap
+        LowHeap,    // the request would take the free heap below the floor
+        Fragmented  // no block large enough left
+    };
+
+    struct Limits {
+        uint8_t maxInFlight;
+        uint16_t heapCost;  // bytes a request of the class holds while it runs
+    };
+
+    struct Heap {
+        uint32_t freeHeap;
+        uint32_t largestBlock;
+    };
+
+    static const uint32_t MIN_FREE_HEAP = 32 * 1024;
+    // the OTA writer and the update library need a sector each
+    static const uint32_t MIN_LARGEST_BLOCK = 8 * 1024;
+    static const Limits DEFAULT_LIMITS[ROUTE_CLASSES];
+    // {"freeHeap":...,"rejected":{...},"routes":{"pages":{...},...}} with every member
+    static const size_t STATS_SIZE = 640;
+
+    explicit AdmissionControl(const Limits *limits = DEFAULT_LIMITS,
+                              uint32_t minFreeHeap = MIN_FREE_HEAP, uint32_t minLargestBlock = MIN_LARGEST_BLOCK);
+
+    // an admitted request holds its slot until release()
+    Verdict admit(RouteClass route, const Heap &heap);
+    void release(RouteClass route);
+
+    uint8_t getInFlight(RouteClass route) const { return inFlight[route]; }
+    uint32_t getAdmitted(RouteClass route) const { return admitted[route]; }
+    uint32_t getRejected(RouteClass route) const { return rejected[route]; }
+    uint32_t getRejected(Verdict reason) const { return reasons[reason]; }
+    // the counters as JSON for the stats endpoint, 0 if it does not fit
+    size_t formatStats(const Heap &heap, char *buffer, size_t length) const;
+
+private:
+    Limits limits[ROUTE_CLASSES];
+    uint32_t minFreeHeap;
+    uint32_t minLargestBlock;
+    uint8_t inFlight[ROUTE_CLASSES] = {};
+    uint32_t admitted[ROUTE_CLASSES] = {};
+    uint32_t rejected[ROUTE_CLASSES] = {};
+    uint32_t reasons[Fragmented + 1] = {};
+    uint32_t lowestFreeHeap = UINT32_MAX;
+};
+
+#endif // ADMISSIONCONTROL_H
@@ -3,7 +3,8 @@
 
 enum UpdateType {
     FIRMWARE,
-    FILESYSTEM
+    FILESYSTEM,
+    DELTA
 };
 
 enum ControlType {
@@ -17,7 +18,11 @@ enum ControlType {
   Time,
   NTPSync,
   LightSchedule,
-  WiFiSetup
+  LightScheduleRuleDelete,
+  WiFiSetup,
+  TimeWarp,
+  Location,
+  PullUpdate
 };
 
 enum PageType {
@@ -30,7 +35,8 @@ enum PageType {
 enum SchedulerType {
     Timestamp,
     ScheduleStart,
-    ScheduleEnd
+    ScheduleEnd,
+    SunTimes
 };
 
 enum MQTTEvent {
@@ -43,7 +49,8 @@ enum MQTTEvent {
     Option1SwitchCommand,
     Option2SwitchCommand,
     Option3SwitchCommand,
-    Option4SwitchCommand
+    Option4SwitchCommand,
+    TimeMessage
 };
 
 #endif // CALLBACKTYPES_H
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "clockticker.h"
+
+ClockTicker::ClockTicker()
+{
+    zone.setRule("UTC0");
+}
+
+ClockTicker::~ClockTicker()
+{
+    callback = nullptr;
+}
+
+bool ClockTicker::setTimeZone(const char *posixTz)
+{
+    bool valid = zone.setRule(posixTz);
+    // the local day and the local sun times depend on the zone
+    solarDay = -1;
+    return valid;
+}
+
+void ClockTicker::sync(time_t utc)
+{
+    currentUtc = utc;
+    zone.toLocal(utc, timeinfo);
+    if (locationEnabled)
+    {
+        updateSunTimes();
+    }
+}
+
+void ClockTicker::adjust(time_t utc)
+{
+    const bool jumped = utc - currentUtc > MAX_CATCH_UP || currentUtc - utc > MAX_CATCH_UP;
+    sync(utc);
+    refresh();
+    if (jumped)
+    {
+        schedule.resync();
+    }
+}
+
+bool ClockTicker::setLocation(float latitude, float longitude)
+{
+    if (!SolarCalculator::isValidLocation(latitude, longitude))
+    {
+        return false;
+    }
+
+    this->latitude = latitude;
+    this->longitude = longitude;
+    locationEnabled = true;
+    solarDay = -1;
+    return true;
+}
+
+void ClockTicker::clearLocation()
+{
+    locationEnabled = false;
+    solarDay = -1;
+    sunTimes = {0, 0, SolarCalculator::PolarNight};
+    sunriseMinute = -1;
+    sunsetMinute = -1;
+    schedule.clearSolarTimes();
+    pendingSunTimes = true;
+}
+
+void ClockTicker::updateSunTimes()
+{
+    const int32_t day = static_cast<int32_t>(DstTable::daysFromCivil(timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday));
+    if (day == solarDay)
+    {
+        return;
+    }
+    solarDay = day;
+
+    sunTimes = SolarCalculator::compute(timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday, latitude, longitude);
+    sunriseMinute = -1;
+    sunsetMinute = -1;
+    if (sunTimes.type == SolarCalculator::Normal)
+    {
+        struct tm local;
+        zone.toLocal(sunTimes.sunrise, local);
+        sunriseMinute = local.tm_hour * 60 + local.tm_min;
+        zone.toLocal(sunTimes.sunset, local);
+        sunsetMinute = local.tm_hour * 60 + local.tm_min;
+        schedule.setSolarTimes(sunriseMinute, sunsetMinute);
+    }
+    else
+    {
+        schedule.clearSolarTimes();
+    }
+    pendingSunTimes = true;
+}
+
+void ClockTicker::tick(time_t utc)
+{
+    const int lastHour = timeinfo.tm_hour;
+    const int lastMinute = timeinfo.tm_min;
+    sync(utc);
+
+    if (pendingTick || timeinfo.tm_hour != lastHour || timeinfo.tm_min != lastMinute)
+    {
+        pendingTick = false;
+        tickCount++;
+        if (callback)
+        {
+            callback(SchedulerType::Timestamp, timeinfo.tm_hour, timeinfo.tm_min);
+        }
+    }
+
+    if (pendingSunTimes)
+    {
+        pendingSunTimes = false;
+        if (callback)
+        {
+            callback(SchedulerType::SunTimes, timeinfo.tm_hour, timeinfo.tm_min);
+        }
+    }
+
+    if (scheduleEnabled)
+    {
+        handleSchedule();
+    }
+}
+
+bool ClockTicker::enableSchedule(const LightScheduler::Rule *rules, uint8_t count)
+{
+    bool valid = schedule.setRules(rules, count);
+
+    // the next tick evaluates the current state, so a window we are already in gets applied
+    activeScheduleRule = -1;
+    scheduleEnabled = true;
+    return valid;
+}
+
+void ClockTicker::disableSchedule()
+{
+    scheduleEnabled = false;
+    activeScheduleRule = -1;
+    schedule.clear();
+}
+
+const LightScheduler::Rule *ClockTicker::getActiveScheduleRule() const
+{
+    if (activeScheduleRule < 0)
+    {
+        return nullptr;
+    }
+
+    return schedule.getRule(activeScheduleRule);
+}
+
+void ClockTicker::handleSchedule()
+{
+    // polling by minute of week catches up on events missed during blocking calls or a reboot
+    const LightScheduler::Event *event = schedule.poll(LightScheduler::toMinuteOfWeek(timeinfo.tm_wday, timeinfo.tm_hour, timeinfo.tm_min));
+    if (event == nullptr)
+    {
+        return;
+    }
+
+    activeScheduleRule = event->rule;
+    if (callback)
+    {
+        callback(event->type == LightScheduler::Start ? SchedulerType::ScheduleStart : SchedulerType::ScheduleEnd, timeinfo.tm_hour, timeinfo.tm_min);
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef CLOCKTICKER_H
+#define CLOCKTICKER_H
+
+#include <stdint.h>
+#include <time.h>
+#include <functional>
+#include "callbacktypes.h"
+#include "lightscheduler.h"
+#include "dsttable.h"
+#include "solarcalculator.h"
+
+using SchedulerCallback = std::function<void(SchedulerType type, uint8_t hour, uint8_t minute)>;
+
+// Turns UTC time into local minute ticks and schedule edges. Holds no
+// hardware state, so the whole display/schedule path can be replayed on the
+// host with a virtual time source.
+class ClockTicker
+{
+private:
+    // larger steps re-evaluate the schedule instead of catching up
+    static const time_t MAX_CATCH_UP = 3600;
+    SchedulerCallback callback;
+    LightScheduler schedule;
+    DstTable zone;
+    bool scheduleEnabled = false;
+    int activeScheduleRule = -1;
+    struct tm timeinfo = {};
+    time_t currentUtc = 0;
+    bool pendingTick = true;
+    uint32_t tickCount = 0;
+    bool locationEnabled = false;
+    float latitude = 0;
+    float longitude = 0;
+    int32_t solarDay = -1; // local day the sun times were computed for
+    SolarCalculator::SunTimes sunTimes = {0, 0, SolarCalculator::PolarNight};
+    int16_t sunriseMinute = -1;
+    int16_t sunsetMinute = -1;
+    bool pendingSunTimes = false;
+    void handleSchedule();
+    void updateSunTimes();
+
+public:
+    ClockTicker();
+    ~ClockTicker();
+    void setCallback(const SchedulerCallback &callback) { this->callback = callback; }
+    // POSIX TZ rule used for local time, UTC until set
+    bool setTimeZone(const char *posixTz);
+    // updates the local time without firing callbacks
+    void sync(time_t utc);
+    // steps to utc after a time correction: the next tick redraws, and the
+    // schedule catches up on skipped minutes like after a slow loop. Only a
+    // step of more than MAX_CATCH_UP either way re-evaluates it, which
+    // re-applies the current window over manual changes
+    void adjust(time_t utc);
+    // makes the next tick fire Timestamp even if the minute did not change
+    void refresh() { pendingTick = true; }
+    // fires Timestamp on minute changes and ScheduleStart/End on schedule edges
+    void tick(time_t utc);
+    bool enableSchedule(const LightScheduler::Rule *rules, uint8_t count);
+    void disableSchedule();
+    void resyncSchedule() { schedule.resync(); }
+    const LightScheduler::Rule *getActiveScheduleRule() const;
+    const struct tm &getLocalTime() const { return timeinfo; }
+    // resolves a local wall time in the configured zone
+    time_t toUtc(const struct tm &local) { return zone.toUtc(local); }
+    uint32_t getTickCount() const { return tickCount; }
+    // sun times are recomputed once per local day, SunTimes fires when they change
+    bool setLocation(float latitude, float longitude);
+    void clearLocation();
+    bool hasSunTimes() const { return locationEnabled && sunTimes.type == SolarCalculator::Normal; }
+    const SolarCalculator::SunTimes &getSunTimes() const { return sunTimes; }
+    // local minutes since midnight, -1 without a location or during polar day/night
+    int16_t getSunrise() const { return sunriseMinute; }
+    int16_t getSunset() const { return sunsetMinute; }
+};
+
+#endif // CLOCKTICKER_H
@@ -0,0 +1,85 @@
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Bounded queue for any number of producers and a single consumer, without
+// locks: a producer claims a slot with one compare-and-swap on the tail and
+// publishes it through the slot's sequence number (Vyukov's bounded queue).
+// Web handlers on the AsyncTCP task push, the main loop pops, neither side
+// ever waits for the other.
+template <typename T, size_t N>
+class CommandQueue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "the capacity must be a power of two");
+
+public:
+    CommandQueue()
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // false if the queue is full
+    bool push(const T &item)
+    {
+        size_t position = tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot &slot = slots[position & (N - 1)];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0)
+            {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.item = item;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                // the consumer has not freed this slot yet
+                return false;
+            }
+            else
+            {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // consumer only; false if the next item is not published yet
+    bool pop(T &item)
+    {
+        Slot &slot = slots[head & (N - 1)];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != head + 1)
+        {
+            return false;
+        }
+        item = slot.item;
+        slot.sequence.store(head + N, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    Slot slots[N];
+    std::atomic<size_t> tail{0};
+    size_t head = 0;
+};
+
+#endif // COMMANDQUEUE_H
@@ -0,0 +1,114 @@
+#include "configdata.h"
+#include <string.h>
+#include "defaults.h"
+
+void ConfigData::setDefaults(ConfigData &data)
+{
+    // zeroed padding keeps the stored blob and its CRC deterministic
+    memset(&data, 0, sizeof(data));
+
+    data.system.mode = Regular;
+
+    MqttConfig &mqtt = data.system.mqttConfig;
+    mqtt.enabled = Defaults::DEFAULT_MQTT_ENABLED;
+    mqtt.port = Defaults::DEFAULT_MQTT_PORT;
+    copyString(mqtt.topic, Defaults::DEFAULT_MQTT_TOPIC, sizeof(mqtt.topic));
+
+    NtpConfig &ntp = data.system.ntpConfig;
+    ntp.enabled = Defaults::DEFAULT_NTP_ENABLED;
+    copyString(ntp.timezone, Defaults::DEFAULT_NTP_TIMEZONE, sizeof(ntp.timezone));
+    copyString(ntp.server, Defaults::DEFAULT_NTP_SERVER, sizeof(ntp.server));
+    ntp.interval = Defaults::DEFAULT_NTP_UPDATE_INTERVAL;
+
+    LocationConfig &location = data.system.locationConfig;
+    location.enabled = Defaults::DEFAULT_LOCATION_ENABLED;
+    location.latitude = Defaults::DEFAULT_LATITUDE;
+    location.longitude = Defaults::DEFAULT_LONGITUDE;
+
+    data.system.lightScheduleConfig.enabled = Defaults::DEFAULT_LIGHT_SCHEDULE_ENABLED;
+
+    LightConfig &light = data.light;
+    light.brightness = Defaults::DEFAULT_LIGHT_BRIGHTNESS;
+    light.autoBrightnessConfig.enabled = Defaults::DEFAULT_AUTO_BRIGHTNESS_ENABLED;
+    light.autoBrightnessConfig.illuminanceThresholdHigh = Defaults::DEFAULT_ILLUMINANCE_THRESHOLD_HIGH;
+    light.autoBrightnessConfig.illuminanceThresholdLow = Defaults::DEFAULT_ILLUMINANCE_THRESHOLD_LOW;
+    copyString(light.color, Defaults::DEFAULT_LIGHT_COLOR, sizeof(light.color));
+    light.state = Defaults::DEFAULT_LIGHT_STATE;
+}
+
+void ConfigData::copyString(char *destination, const char *source, size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    size_t length = source ? strnlen(source, size - 1) : 0;
+    memcpy(destination, source, length);
+    // clear the tail as well, stale bytes would end up in the blob
+    memset(destination + length, 0, size - length);
+}
+
+static_assert(sizeof(LightScheduler::Rule) == 10, "Rule must stay free of padding to be compared with memcmp");
+
+static bool sameString(const char *a, const char *b, size_t size)
+{
+    return strncmp(a, b, size) == 0;
+}
+
+bool ConfigData::WifiConfig::operator==(const WifiConfig &other) const
+{
+    return sameString(ssid, other.ssid, sizeof(ssid)) && sameString(password, other.password, sizeof(password));
+}
+
+bool ConfigData::MqttConfig::operator==(const MqttConfig &other) const
+{
+    return enabled == other.enabled && port == other.port && sameString(host, other.host, sizeof(host)) &&
+           sameString(username, other.username, sizeof(username)) &&
+           sameString(password, other.password, sizeof(password)) && sameString(topic, other.topic, sizeof(topic));
+}
+
+bool ConfigData::NtpConfig::operator==(const NtpConfig &other) const
+{
+    return enabled == other.enabled && interval == other.interval &&
+           sameString(timezone, other.timezone, sizeof(timezone)) && sameString(server, other.server, sizeof(server));
+}
+
+bool ConfigData::LocationConfig::operator==(const LocationConfig &other) const
+{
+    return enabled == other.enabled && latitude == other.latitude && longitude == other.longitude;
+}
+
+bool ConfigData::LightScheduleConfig::operator==(const LightScheduleConfig &other) const
+{
+    if (enabled != other.enabled || ruleCount != other.ruleCount)
+    {
+        return false;
+    }
+    // only the used slots matter
+    size_t count = ruleCount < LightScheduler::MAX_RULES ? ruleCount : LightScheduler::MAX_RULES;
+    return memcmp(rules, other.rules, count * sizeof(LightScheduler::Rule)) == 0;
+}
+
+bool ConfigData::AutoBrightnessConfig::operator==(const AutoBrightnessConfig &other) const
+{
+    return enabled == other.enabled && illuminanceThresholdHigh == other.illuminanceThresholdHigh &&
+           illuminanceThresholdLow == other.illuminanceThresholdLow;
+}
+
+bool ConfigData::LightConfig::operator==(const LightConfig &other) const
+{
+    return brightness == other.brightness && state == other.state && autoBrightnessConfig == other.autoBrightnessConfig &&
+           sameString(color, other.color, sizeof(color));
+}
+
+bool ConfigData::SystemConfig::operator==(const SystemConfig &other) const
+{
+    return mode == other.mode && mqttConfig == other.mqttConfig && ntpConfig == other.ntpConfig &&
+           locationConfig == other.locationConfig && lightScheduleConfig == other.lightScheduleConfig;
+}
+
+bool ConfigData::operator==(const ConfigData &other) const
+{
+    return system == other.system && light == other.light && wifi == other.wifi;
+}
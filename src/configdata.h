@@ -0,0 +1,108 @@
+#ifndef CONFIGDATA_H
+#define CONFIGDATA_H
+
+#include <stdint.h>
+#include "lightscheduler.h"
+
+// Everything Configuration persists, as one plain struct. ConfigStore writes
+// it to flash as-is, so any layout change needs a new ConfigStore::VERSION
+// and a migration. Kept free of Arduino types for the host tests.
+struct ConfigData
+{
+    enum ClockMode : uint8_t {
+        Regular = 0,
+        Option_1
+    };
+
+    struct WifiConfig {
+        char ssid[32];
+        char password[64];
+
+        bool operator==(const WifiConfig &other) const;
+        bool operator!=(const WifiConfig &other) const { return !(*this == other); }
+    };
+
+    struct MqttConfig {
+        bool enabled;
+        char host[64];
+        uint16_t port;
+        char username[32];
+        char password[32];
+        char topic[64];
+
+        bool operator==(const MqttConfig &other) const;
+        bool operator!=(const MqttConfig &other) const { return !(*this == other); }
+    };
+
+    struct NtpConfig {
+        bool enabled;
+        char timezone[32];
+        char server[64];
+        uint32_t interval;
+
+        bool operator==(const NtpConfig &other) const;
+        bool operator!=(const NtpConfig &other) const { return !(*this == other); }
+    };
+
+    // used for sunrise/sunset anchored schedule rules
+    struct LocationConfig {
+        bool enabled;
+        float latitude;
+        float longitude;
+
+        bool operator==(const LocationConfig &other) const;
+        bool operator!=(const LocationConfig &other) const { return !(*this == other); }
+    };
+
+    struct LightScheduleConfig {
+        bool enabled;
+        uint8_t ruleCount;
+        LightScheduler::Rule rules[LightScheduler::MAX_RULES];
+
+        bool operator==(const LightScheduleConfig &other) const;
+        bool operator!=(const LightScheduleConfig &other) const { return !(*this == other); }
+    };
+
+    struct AutoBrightnessConfig {
+        bool enabled;
+        uint16_t illuminanceThresholdHigh;
+        uint16_t illuminanceThresholdLow;
+
+        bool operator==(const AutoBrightnessConfig &other) const;
+        bool operator!=(const AutoBrightnessConfig &other) const { return !(*this == other); }
+    };
+
+    struct LightConfig {
+        uint8_t brightness;
+        AutoBrightnessConfig autoBrightnessConfig;
+        char color[8]; // Hex color string (e.g., "#FF0000")
+        bool state;
+
+        bool operator==(const LightConfig &other) const;
+        bool operator!=(const LightConfig &other) const { return !(*this == other); }
+    };
+
+    struct SystemConfig {
+        ClockMode mode;
+        MqttConfig mqttConfig;
+        NtpConfig ntpConfig;
+        LocationConfig locationConfig;
+        LightScheduleConfig lightScheduleConfig;
+
+        bool operator==(const SystemConfig &other) const;
+        bool operator!=(const SystemConfig &other) const { return !(*this == other); }
+    };
+
+    SystemConfig system;
+    LightConfig light;
+    WifiConfig wifi;
+
+    // field by field, padding and bytes behind a string terminator are ignored
+    bool operator==(const ConfigData &other) const;
+    bool operator!=(const ConfigData &other) const { return !(*this == other); }
+
+    static void setDefaults(ConfigData &data);
+    static void copyString(char *destination, const char *source, size_t size);
+};
+
+#endif // CONFIGDATA_H
@@ -0,0 +1,855 @@
+#include "configjson.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#define CONFIG_FIELD(key, type, flags, member) {key, ConfigJson::type, flags, offsetof(ConfigData, member), sizeof(ConfigData::member)}
+#define RULE_FIELD(key, type, member) {key, ConfigJson::type, 0, offsetof(LightScheduler::Rule, member), sizeof(LightScheduler::Rule::member)}
+
+// the table drives both the writer and the reader, document order = table order
+const ConfigJson::Field ConfigJson::CONFIG_FIELDS[] = {
+    {"format", ConfigJson::Format, 0, 0, 0},
+    CONFIG_FIELD("mode", U8, 0, system.mode),
+    {"wifi", ConfigJson::ObjectBegin, 0, 0, 0},
+    CONFIG_FIELD("ssid", Text, 0, wifi.ssid),
+    CONFIG_FIELD("password", Text, FIELD_SECRET, wifi.password),
+    {nullptr, ConfigJson::ObjectEnd, 0, 0, 0},
+    {"mqtt", ConfigJson::ObjectBegin, 0, 0, 0},
+    CONFIG_FIELD("enabled", Bool, 0, system.mqttConfig.enabled),
+    CONFIG_FIELD("host", Text, 0, system.mqttConfig.host),
+    CONFIG_FIELD("port", U16, 0, system.mqttConfig.port),
+    CONFIG_FIELD("username", Text, 0, system.mqttConfig.username),
+    CONFIG_FIELD("password", Text, FIELD_SECRET, system.mqttConfig.password),
+    CONFIG_FIELD("topic", Text, 0, system.mqttConfig.topic),
+    {nullptr, ConfigJson::ObjectEnd, 0, 0, 0},
+    {"ntp", ConfigJson::ObjectBegin, 0, 0, 0},
+    CONFIG_FIELD("enabled", Bool, 0, system.ntpConfig.enabled),
+    CONFIG_FIELD("timezone", Text, 0, system.ntpConfig.timezone),
+    CONFIG_FIELD("server", Text, 0, system.ntpConfig.server),
+    CONFIG_FIELD("interval", U32, 0, system.ntpConfig.interval),
+    {nullptr, ConfigJson::ObjectEnd, 0, 0, 0},
+    {"location", ConfigJson::ObjectBegin, 0, 0, 0},
+    CONFIG_FIELD("enabled", Bool, 0, system.locationConfig.enabled),
+    CONFIG_FIELD("latitude", Float, 0, system.locationConfig.latitude),
+    CONFIG_FIELD("longitude", Float, 0, system.locationConfig.longitude),
+    {nullptr, ConfigJson::ObjectEnd, 0, 0, 0},
+    {"schedule", ConfigJson::ObjectBegin, 0, 0, 0},
+    CONFIG_FIELD("enabled", Bool, 0, system.lightScheduleConfig.enabled),
+    // the rule list, ruleCount up to the end of the schedule
+    {"rules", ConfigJson::Rules, 0, offsetof(ConfigData, system.lightScheduleConfig.ruleCount),
+     sizeof(ConfigData::LightScheduleConfig) - offsetof(ConfigData::LightScheduleConfig, ruleCount)},
+    {nullptr, ConfigJson::ObjectEnd, 0, 0, 0},
+    {"light", ConfigJson::ObjectBegin, 0, 0, 0},
+    CONFIG_FIELD("state", Bool, 0, light.state),
+    CONFIG_FIELD("brightness", U8, 0, light.brightness),
+    CONFIG_FIELD("color", Text, 0, light.color),
+    {"autoBrightness", ConfigJson::ObjectBegin, 0, 0, 0},
+    CONFIG_FIELD("enabled", Bool, 0, light.autoBrightnessConfig.enabled),
+    CONFIG_FIELD("thresholdHigh", U16, 0, light.autoBrightnessConfig.illuminanceThresholdHigh),
+    CONFIG_FIELD("thresholdLow", U16, 0, light.autoBrightnessConfig.illuminanceThresholdLow),
+    {nullptr, ConfigJson::ObjectEnd, 0, 0, 0},
+    {nullptr, ConfigJson::ObjectEnd, 0, 0, 0},
+};
+const size_t ConfigJson::CONFIG_FIELD_COUNT = sizeof(CONFIG_FIELDS) / sizeof(CONFIG_FIELDS[0]);
+static_assert(sizeof(ConfigJson::CONFIG_FIELDS) / sizeof(ConfigJson::CONFIG_FIELDS[0]) <= 64, "ConfigJsonReader::present has a bit per field");
+
+// start and end are offsets (signed) for anchored rules, minutes otherwise
+const ConfigJson::Field ConfigJson::RULE_FIELDS[] = {
+    RULE_FIELD("start", I16, start),
+    RULE_FIELD("end", I16, end),
+    RULE_FIELD("weekdays", U8, weekdays),
+    RULE_FIELD("brightness", U8, brightness),
+    RULE_FIELD("color", Color, color),
+    RULE_FIELD("flags", U8, flags),
+};
+const size_t ConfigJson::RULE_FIELD_COUNT = sizeof(RULE_FIELDS) / sizeof(RULE_FIELDS[0]);
+
+int ConfigJson::findField(const Field *fields, size_t count, int parent, const char *key)
+{
+    int depth = 0;
+    for (size_t i = parent + 1; i < count; i++)
+    {
+        const Field &field = fields[i];
+        if (field.type == ObjectEnd)
+        {
+            if (depth == 0)
+            {
+                return -1;
+            }
+            depth--;
+            continue;
+        }
+        if (depth == 0 && strcmp(field.key, key) == 0)
+        {
+            return i;
+        }
+        if (field.type == ObjectBegin)
+        {
+            depth++;
+        }
+    }
+    return -1;
+}
+
+// Writer
+
+ConfigJsonWriter::ConfigJsonWriter(const ConfigData &data, bool includeSecrets, const char *extraMembers)
+    : data(data), includeSecrets(includeSecrets)
+{
+    ConfigData::copyString(extra, extraMembers != nullptr ? extraMembers : "", sizeof(extra));
+}
+
+size_t ConfigJsonWriter::read(uint8_t *buffer, size_t length)
+{
+    size_t written = 0;
+    while (written < length)
+    {
+        if (pendingOffset == pendingLength && !renderNext())
+        {
+            break;
+        }
+        size_t chunk = pendingLength - pendingOffset;
+        if (chunk > length - written)
+        {
+            chunk = length - written;
+        }
+        memcpy(buffer + written, pending + pendingOffset, chunk);
+        pendingOffset += chunk;
+        written += chunk;
+    }
+    return written;
+}
+
+// renders the next piece into pending, false once the document is complete
+bool ConfigJsonWriter::renderNext()
+{
+    pendingLength = 0;
+    pendingOffset = 0;
+    if (done)
+    {
+        return false;
+    }
+
+    if (step == 0)
+    {
+        append("{");
+        step++;
+        return true;
+    }
+
+    size_t index = step - 1;
+    if (index >= ConfigJson::CONFIG_FIELD_COUNT)
+    {
+        if (extra[0] != '\0')
+        {
+            append(",");
+            append(extra);
+        }
+        append("}");
+        done = true;
+        return true;
+    }
+
+    const ConfigJson::Field &field = ConfigJson::CONFIG_FIELDS[index];
+    switch (field.type)
+    {
+    case ConfigJson::ObjectBegin:
+        appendKey(field.key);
+        append("{");
+        needComma = false;
+        break;
+    case ConfigJson::ObjectEnd:
+        append("}");
+        needComma = true;
+        break;
+    case ConfigJson::Rules:
+    {
+        // one piece per rule, rule counts the pieces already emitted
+        const ConfigData::LightScheduleConfig &schedule = data.system.lightScheduleConfig;
+        if (rule == 0)
+        {
+            appendKey(field.key);
+            append("[");
+            needComma = false;
+            rule++;
+            return true;
+        }
+        if (rule <= schedule.ruleCount && rule <= LightScheduler::MAX_RULES)
+        {
+            if (needComma)
+            {
+                append(",");
+            }
+            append("{");
+            needComma = false;
+            for (size_t i = 0; i < ConfigJson::RULE_FIELD_COUNT; i++)
+            {
+                renderField(ConfigJson::RULE_FIELDS[i], &schedule.rules[rule - 1]);
+            }
+            append("}");
+            needComma = true;
+            rule++;
+            return true;
+        }
+        append("]");
+        needComma = true;
+        rule = 0;
+        break;
+    }
+    default:
+        if (!(field.flags & ConfigJson::FIELD_SECRET) || includeSecrets)
+        {
+            renderField(field, &data);
+        }
+        break;
+    }
+    step++;
+    return true;
+}
+
+void ConfigJsonWriter::renderField(const ConfigJson::Field &field, const void *base)
+{
+    const uint8_t *value = static_cast<const uint8_t *>(base) + field.offset;
+    char number[24];
+
+    appendKey(field.key);
+    switch (field.type)
+    {
+    case ConfigJson::Format:
+        snprintf(number, sizeof(number), "%u", ConfigJson::FORMAT);
+        append(number);
+        break;
+    case ConfigJson::Bool:
+        append(*reinterpret_cast<const bool *>(value) ? "true" : "false");
+        break;
+    case ConfigJson::U8:
+        snprintf(number, sizeof(number), "%u", *value);
+        append(number);
+        break;
+    case ConfigJson::U16:
+        snprintf(number, sizeof(number), "%u", *reinterpret_cast<const uint16_t *>(value));
+        append(number);
+        break;
+    case ConfigJson::I16:
+        snprintf(number, sizeof(number), "%d", static_cast<int16_t>(*reinterpret_cast<const uint16_t *>(value)));
+        append(number);
+        break;
+    case ConfigJson::U32:
+        snprintf(number, sizeof(number), "%lu", static_cast<unsigned long>(*reinterpret_cast<const uint32_t *>(value)));
+        append(number);
+        break;
+    case ConfigJson::Float:
+    {
+        float f = *reinterpret_cast<const float *>(value);
+        snprintf(number, sizeof(number), "%.7g", isfinite(f) ? f : 0.0f);
+        append(number);
+        break;
+    }
+    case ConfigJson::Text:
+        appendString(reinterpret_cast<const char *>(value), field.size);
+        break;
+    case ConfigJson::Color:
+        snprintf(number, sizeof(number), "\"#%02X%02X%02X\"", value[0], value[1], value[2]);
+        append(number);
+        break;
+    default:
+        append("null");
+        break;
+    }
+    needComma = true;
+}
+
+void ConfigJsonWriter::append(const char *text)
+{
+    size_t length = strlen(text);
+    if (length > PENDING_SIZE - pendingLength)
+    {
+        length = PENDING_SIZE - pendingLength;
+    }
+    memcpy(pending + pendingLength, text, length);
+    pendingLength += length;
+}
+
+void ConfigJsonWriter::appendKey(const char *key)
+{
+    if (needComma)
+    {
+        append(",");
+    }
+    append("\"");
+    append(key);
+    append("\":");
+}
+
+void ConfigJsonWriter::appendString(const char *value, size_t size)
+{
+    append("\"");
+    for (size_t i = 0; i < size && value[i] != '\0'; i++)
+    {
+        char c = value[i];
+        char escaped[8] = {c, '\0'};
+        if (c == '"' || c == '\\')
+        {
+            escaped[0] = '\\';
+            escaped[1] = c;
+            escaped[2] = '\0';
+        }
+        else if (static_cast<uint8_t>(c) < 0x20)
+        {
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        }
+        append(escaped);
+    }
+    append("\"");
+}
+
+// Reader
+
+ConfigJsonReader::ConfigJsonReader(const ConfigData &base) : data(base)
+{
+    key[0] = '\0';
+    token[0] = '\0';
+}
+
+ConfigJsonReader::ConfigJsonReader()
+{
+    ConfigData::setDefaults(data);
+    key[0] = '\0';
+    token[0] = '\0';
+}
+
+void ConfigJsonReader::applyTo(ConfigData &target) const
+{
+    const uint8_t *source = reinterpret_cast<const uint8_t *>(&data);
+    uint8_t *destination = reinterpret_cast<uint8_t *>(&target);
+    for (size_t i = 0; i < ConfigJson::CONFIG_FIELD_COUNT; i++)
+    {
+        const ConfigJson::Field &field = ConfigJson::CONFIG_FIELDS[i];
+        if (isPresent(i) && field.size > 0)
+        {
+            memcpy(destination + field.offset, source + field.offset, field.size);
+        }
+    }
+}
+
+bool ConfigJsonReader::feed(const char *input, size_t length)
+{
+    for (size_t i = 0; i < length && error == None; i++)
+    {
+        process(input[i]);
+        position++;
+    }
+    return error == None;
+}
+
+bool ConfigJsonReader::finish()
+{
+    if (error != None)
+    {
+        return false;
+    }
+    if (lexer != Idle || state != Done)
+    {
+        return fail(Incomplete);
+    }
+    return validate();
+}
+
+bool ConfigJsonReader::fail(Error reason)
+{
+    if (error == None)
+    {
+        error = reason;
+    }
+    return false;
+}
+
+static bool isLiteralChar(char c)
+{
+    return isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '+' || c == '.';
+}
+
+bool ConfigJsonReader::process(char c)
+{
+    if (lexer == InString || lexer == InEscape || lexer == InUnicode)
+    {
+        return processString(c);
+    }
+    if (lexer == InLiteral)
+    {
+        if (isLiteralChar(c))
+        {
+            return appendToken(c);
+        }
+        // the delimiter is handled below
+        lexer = Idle;
+        if (!completeValue())
+        {
+            return false;
+        }
+    }
+
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+    {
+        return true;
+    }
+
+    switch (state)
+    {
+    case ExpectValueOrEnd:
+        if (c == ']')
+        {
+            return close(true);
+        }
+        return beginValue(c);
+    case ExpectValue:
+        return beginValue(c);
+    case ExpectKeyOrEnd:
+        if (c == '}')
+        {
+            return close(false);
+        }
+        // fall through
+    case ExpectKey:
+        if (c != '"')
+        {
+            return fail(Syntax);
+        }
+        stringIsKey = true;
+        lexer = InString;
+        tokenLength = 0;
+        tokenTooLong = false;
+        return true;
+    case ExpectColon:
+        if (c != ':')
+        {
+            return fail(Syntax);
+        }
+        state = ExpectValue;
+        return true;
+    case ExpectCommaOrEnd:
+    {
+        const Context &top = stack[depth - 1];
+        if (c == ',')
+        {
+            state = top.isArray ? ExpectValue : ExpectKey;
+            return true;
+        }
+        if (c == (top.isArray ? ']' : '}'))
+        {
+            return close(top.isArray);
+        }
+        return fail(Syntax);
+    }
+    default:
+        // nothing may follow the document
+        return fail(Syntax);
+    }
+}
+
+bool ConfigJsonReader::processString(char c)
+{
+    if (lexer == InEscape)
+    {
+        lexer = InString;
+        switch (c)
+        {
+        case '"': return appendToken('"');
+        case '\\': return appendToken('\\');
+        case '/': return appendToken('/');
+        case 'b': return appendToken('\b');
+        case 'f': return appendToken('\f');
+        case 'n': return appendToken('\n');
+        case 'r': return appendToken('\r');
+        case 't': return appendToken('\t');
+        case 'u':
+            lexer = InUnicode;
+            unicodeDigits = 0;
+            unicodeValue = 0;
+            return true;
+        default:
+            return fail(Syntax);
+        }
+    }
+
+    if (lexer == InUnicode)
+    {
+        if (!isxdigit(static_cast<unsigned char>(c)))
+        {
+            return fail(Syntax);
+        }
+        unicodeValue = (unicodeValue << 4) | (isdigit(static_cast<unsigned char>(c)) ? c - '0' : (tolower(c) - 'a' + 10));
+        if (++unicodeDigits < 4)
+        {
+            return true;
+        }
+        lexer = InString;
+        return appendUtf8(unicodeValue);
+    }
+
+    if (c == '\\')
+    {
+        lexer = InEscape;
+        return true;
+    }
+    if (static_cast<uint8_t>(c) < 0x20)
+    {
+        return fail(Syntax);
+    }
+    if (c != '"')
+    {
+        return appendToken(c);
+    }
+
+    lexer = Idle;
+    token[tokenLength] = '\0';
+    if (stringIsKey)
+    {
+        // keys longer than any known key simply never match
+        if (tokenTooLong || tokenLength >= MAX_KEY)
+        {
+            key[0] = '\0';
+        }
+        else
+        {
+            memcpy(key, token, tokenLength + 1);
+        }
+        state = ExpectColon;
+        return true;
+    }
+    return completeValue();
+}
+
+bool ConfigJsonReader::beginValue(char c)
+{
+    if (depth == 0 && c != '{')
+    {
+        return fail(Syntax);
+    }
+
+    switch (c)
+    {
+    case '{':
+        return open(false);
+    case '[':
+        return open(true);
+    case '"':
+        stringIsKey = false;
+        stringValue = true;
+        lexer = InString;
+        tokenLength = 0;
+        tokenTooLong = false;
+        return true;
+    default:
+        if (c != '-' && !isalnum(static_cast<unsigned char>(c)))
+        {
+            return fail(Syntax);
+        }
+        stringValue = false;
+        lexer = InLiteral;
+        tokenLength = 0;
+        tokenTooLong = false;
+        return appendToken(c);
+    }
+}
+
+bool ConfigJsonReader::appendToken(char c)
+{
+    if (tokenLength < MAX_TOKEN - 1)
+    {
+        token[tokenLength++] = c;
+    }
+    else
+    {
+        tokenTooLong = true;
+    }
+    return true;
+}
+
+bool ConfigJsonReader::appendUtf8(uint16_t codePoint)
+{
+    // surrogate pairs are not needed for any setting
+    if (codePoint == 0 || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+    {
+        return fail(InvalidValue);
+    }
+    if (codePoint < 0x80)
+    {
+        return appendToken(static_cast<char>(codePoint));
+    }
+    if (codePoint < 0x800)
+    {
+        appendToken(static_cast<char>(0xC0 | (codePoint >> 6)));
+        return appendToken(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    appendToken(static_cast<char>(0xE0 | (codePoint >> 12)));
+    appendToken(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+    return appendToken(static_cast<char>(0x80 | (codePoint & 0x3F)));
+}
+
+bool ConfigJsonReader::open(bool isArray)
+{
+    if (depth >= MAX_DEPTH)
+    {
+        return fail(TooDeep);
+    }
+
+    Context context = {Skipped, isArray, -1};
+    if (depth == 0)
+    {
+        context.kind = KnownObject;
+    }
+    else
+    {
+        const Context &top = stack[depth - 1];
+        switch (top.kind)
+        {
+        case KnownObject:
+        {
+            int index = ConfigJson::findField(ConfigJson::CONFIG_FIELDS, ConfigJson::CONFIG_FIELD_COUNT, top.field, key);
+            if (index < 0)
+            {
+                break;
+            }
+            const ConfigJson::Field &field = ConfigJson::CONFIG_FIELDS[index];
+            if (field.type == ConfigJson::ObjectBegin && !isArray)
+            {
+                context.kind = KnownObject;
+                context.field = index;
+            }
+            else if (field.type == ConfigJson::Rules && isArray)
+            {
+                context.kind = RuleList;
+                data.system.lightScheduleConfig.ruleCount = 0;
+                present |= 1ULL << index;
+            }
+            else
+            {
+                return fail(InvalidValue);
+            }
+            break;
+        }
+        case RuleList:
+        {
+            ConfigData::LightScheduleConfig &schedule = data.system.lightScheduleConfig;
+            if (isArray)
+            {
+                return fail(InvalidValue);
+            }
+            if (schedule.ruleCount >= LightScheduler::MAX_RULES)
+            {
+                return fail(TooManyRules);
+            }
+            LightScheduler::Rule &rule = schedule.rules[schedule.ruleCount];
+            memset(&rule, 0, sizeof(rule));
+            rule.weekdays = LightScheduler::ALL_DAYS;
+            rule.flags = LightScheduler::RULE_ENABLED;
+            context.kind = RuleObject;
+            context.field = schedule.ruleCount++;
+            break;
+        }
+        case RuleObject:
+            if (ConfigJson::findField(ConfigJson::RULE_FIELDS, ConfigJson::RULE_FIELD_COUNT, -1, key) >= 0)
+            {
+                return fail(InvalidValue);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    stack[depth++] = context;
+    state = isArray ? ExpectValueOrEnd : ExpectKeyOrEnd;
+    return true;
+}
+
+bool ConfigJsonReader::close(bool isArray)
+{
+    if (depth == 0 || stack[depth - 1].isArray != isArray)
+    {
+        return fail(Syntax);
+    }
+    depth--;
+    state = depth == 0 ? Done : ExpectCommaOrEnd;
+    return true;
+}
+
+bool ConfigJsonReader::completeValue()
+{
+    token[tokenLength] = '\0';
+    state = ExpectCommaOrEnd;
+
+    const Context &top = stack[depth - 1];
+    switch (top.kind)
+    {
+    case KnownObject:
+    {
+        int index = ConfigJson::findField(ConfigJson::CONFIG_FIELDS, ConfigJson::CONFIG_FIELD_COUNT, top.field, key);
+        if (index < 0)
+        {
+            return true;
+        }
+        present |= 1ULL << index;
+        return applyScalar(ConfigJson::CONFIG_FIELDS[index], &data);
+    }
+    case RuleObject:
+    {
+        int index = ConfigJson::findField(ConfigJson::RULE_FIELDS, ConfigJson::RULE_FIELD_COUNT, -1, key);
+        if (index < 0)
+        {
+            return true;
+        }
+        return applyScalar(ConfigJson::RULE_FIELDS[index], &data.system.lightScheduleConfig.rules[top.field]);
+    }
+    case RuleList:
+        return fail(InvalidValue);
+    default:
+        return true;
+    }
+}
+
+bool ConfigJsonReader::applyScalar(const ConfigJson::Field &field, void *base)
+{
+    if (tokenTooLong)
+    {
+        return fail(TooLong);
+    }
+
+    uint8_t *value = static_cast<uint8_t *>(base) + field.offset;
+    long long number = 0;
+    switch (field.type)
+    {
+    case ConfigJson::Format:
+        if (stringValue || !parseInteger(token, 1, 255, number))
+        {
+            return fail(InvalidValue);
+        }
+        return number <= ConfigJson::FORMAT ? true : fail(Unsupported);
+    case ConfigJson::Bool:
+        if (stringValue || (strcmp(token, "true") != 0 && strcmp(token, "false") != 0))
+        {
+            return fail(InvalidValue);
+        }
+        *reinterpret_cast<bool *>(value) = token[0] == 't';
+        return true;
+    case ConfigJson::U8:
+        if (stringValue || !parseInteger(token, 0, UINT8_MAX, number))
+        {
+            return fail(InvalidValue);
+        }
+        *value = static_cast<uint8_t>(number);
+        return true;
+    case ConfigJson::U16:
+        if (stringValue || !parseInteger(token, 0, UINT16_MAX, number))
+        {
+            return fail(InvalidValue);
+        }
+        *reinterpret_cast<uint16_t *>(value) = static_cast<uint16_t>(number);
+        return true;
+    case ConfigJson::I16:
+        if (stringValue || !parseInteger(token, INT16_MIN, INT16_MAX, number))
+        {
+            return fail(InvalidValue);
+        }
+        *reinterpret_cast<uint16_t *>(value) = static_cast<uint16_t>(static_cast<int16_t>(number));
+        return true;
+    case ConfigJson::U32:
+        if (stringValue || !parseInteger(token, 0, UINT32_MAX, number))
+        {
+            return fail(InvalidValue);
+        }
+        *reinterpret_cast<uint32_t *>(value) = static_cast<uint32_t>(number);
+        return true;
+    case ConfigJson::Float:
+    {
+        char *end = nullptr;
+        float f = strtof(token, &end);
+        if (stringValue || tokenLength == 0 || *end != '\0' || !isfinite(f))
+        {
+            return fail(InvalidValue);
+        }
+        *reinterpret_cast<float *>(value) = f;
+        return true;
+    }
+    case ConfigJson::Text:
+        if (!stringValue)
+        {
+            return fail(InvalidValue);
+        }
+        if (tokenLength >= field.size)
+        {
+            return fail(TooLong);
+        }
+        ConfigData::copyString(reinterpret_cast<char *>(value), token, field.size);
+        return true;
+    case ConfigJson::Color:
+        return stringValue && parseColor(token, value) ? true : fail(InvalidValue);
+    default:
+        return fail(InvalidValue);
+    }
+}
+
+bool ConfigJsonReader::validate()
+{
+    if (data.system.mode > ConfigData::Option_1)
+    {
+        return fail(InvalidValue);
+    }
+
+    uint8_t rgb[3];
+    if (!parseColor(data.light.color, rgb))
+    {
+        return fail(InvalidValue);
+    }
+
+    const ConfigData::LocationConfig &location = data.system.locationConfig;
+    if (location.latitude < -90.0f || location.latitude > 90.0f || location.longitude < -180.0f || location.longitude > 180.0f)
+    {
+        return fail(InvalidValue);
+    }
+
+    const ConfigData::LightScheduleConfig &schedule = data.system.lightScheduleConfig;
+    for (uint8_t i = 0; i < schedule.ruleCount; i++)
+    {
+        if (!LightScheduler::isValid(schedule.rules[i]))
+        {
+            return fail(InvalidValue);
+        }
+    }
+    return true;
+}
+
+bool ConfigJsonReader::parseInteger(const char *text, long long minimum, long long maximum, long long &value)
+{
+    char *end = nullptr;
+    if (*text == '\0')
+    {
+        return false;
+    }
+    value = strtoll(text, &end, 10);
+    return *end == '\0' && value >= minimum && value <= maximum;
+}
+
+bool ConfigJsonReader::parseColor(const char *text, uint8_t rgb[3])
+{
+    if (text[0] != '#' || strlen(text) != 7)
+    {
+        return false;
+    }
+    for (int i = 1; i < 7; i++)
+    {
+        if (!isxdigit(static_cast<unsigned char>(text[i])))
+        {
+            return false;
+        }
+    }
+
+    unsigned long value = strtoul(text + 1, nullptr, 16);
+    rgb[0] = (value >> 16) & 0xFF;
+    rgb[1] = (value >> 8) & 0xFF;
+    rgb[2] = value & 0xFF;
+    return true;
+}
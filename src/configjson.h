@@ -0,0 +1,196 @@
+#ifndef CONFIGJSON_H
+#define CONFIGJSON_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "configdata.h"
+
+// Compact JSON form of ConfigData for /api/config. Both directions work on
+// chunks of any size with a fixed amount of memory, the document is never
+// held as a whole:
+//
+// {"format":1,"mode":0,"wifi":{"ssid":"..","password":".."},
+//  "mqtt":{"enabled":true,"host":"..","port":1883,"username":"..","password":"..","topic":".."},
+//  "ntp":{"enabled":true,"timezone":"..","server":"..","interval":86400},
+//  "location":{"enabled":false,"latitude":0,"longitude":0},
+//  "schedule":{"enabled":true,"rules":[{"start":420,"end":1320,"weekdays":127,"brightness":0,"color":"#000000","flags":1}]},
+//  "light":{"state":true,"brightness":128,"color":"#FFFFFF","autoBrightness":{"enabled":false,"thresholdHigh":..,"thresholdLow":..}}}
+//
+// Passwords are only written when secrets are requested. An import starts
+// from the current configuration, so missing keys (like omitted secrets)
+// keep their values and unknown keys are ignored. "rules" replaces the list.
+class ConfigJson
+{
+public:
+    static const uint8_t FORMAT = 1;
+
+    enum FieldType : uint8_t {
+        ObjectBegin = 0,
+        ObjectEnd,
+        Format,
+        Bool,
+        U8,
+        U16,
+        I16,
+        U32,
+        Float,
+        Text,
+        Color, // uint8_t[3] as "#RRGGBB"
+        Rules
+    };
+
+    static const uint8_t FIELD_SECRET = 0x01;
+
+    struct Field {
+        const char *key;
+        FieldType type;
+        uint8_t flags;
+        uint16_t offset;
+        uint16_t size;
+    };
+
+    static const Field CONFIG_FIELDS[];
+    static const size_t CONFIG_FIELD_COUNT;
+    static const Field RULE_FIELDS[];
+    static const size_t RULE_FIELD_COUNT;
+
+    // index of key among the direct children of the object opened at parent (-1 = root)
+    static int findField(const Field *fields, size_t count, int parent, const char *key);
+};
+
+// Produces the document piece by piece, e.g. from a chunked response callback
+class ConfigJsonWriter
+{
+public:
+    // room for extra members, e.g. "time":{...}
+    static const size_t EXTRA_SIZE = 256;
+
+    // extra members (already JSON, without braces) are appended after the configuration
+    ConfigJsonWriter(const ConfigData &data, bool includeSecrets, const char *extraMembers = nullptr);
+    // fills up to length bytes, returns 0 once the document is complete
+    size_t read(uint8_t *buffer, size_t length);
+
+private:
+    // the largest piece is a key with a fully escaped 64 byte string
+    static const size_t PENDING_SIZE = 448;
+
+    ConfigData data;
+    bool includeSecrets;
+    char extra[EXTRA_SIZE];
+    bool needComma = false;
+    bool done = false;
+    uint16_t step = 0;
+    uint8_t rule = 0;
+    char pending[PENDING_SIZE];
+    size_t pendingLength = 0;
+    size_t pendingOffset = 0;
+
+    bool renderNext();
+    void renderField(const ConfigJson::Field &field, const void *base);
+    void append(const char *text);
+    void appendKey(const char *key);
+    void appendString(const char *value, size_t size);
+};
+
+// Applies a document fed in arbitrary chunks onto a copy of the current
+// configuration, or onto the defaults while it records which keys it saw, so
+// a patch can be laid over whatever is current when it is applied
+class ConfigJsonReader
+{
+public:
+    enum Error : uint8_t {
+        None = 0,
+        Syntax,
+        TooDeep,
+        TooLong,
+        InvalidValue,
+        TooManyRules,
+        Unsupported,
+        Incomplete
+    };
+
+    explicit ConfigJsonReader(const ConfigData &base);
+    // starts from the defaults, for patches applied later with applyTo()
+    ConfigJsonReader();
+    // returns false as soon as the document is known to be invalid
+    bool feed(const char *input, size_t length);
+    // true if a complete document was read and the result is valid
+    bool finish();
+    const ConfigData &getData() const { return data; }
+    Error getError() const { return error; }
+    size_t getPosition() const { return position; }
+    // whether the document set the value at index field of ConfigJson::CONFIG_FIELDS
+    bool isPresent(size_t field) const { return (present >> field) & 1; }
+    // copies only the values the document set, "rules" as a whole list
+    void applyTo(ConfigData &target) const;
+
+private:
+    static const uint8_t MAX_DEPTH = 8;
+    static const size_t MAX_KEY = 24;
+    static const size_t MAX_TOKEN = 72;
+
+    enum State : uint8_t {
+        ExpectValue = 0,
+        ExpectValueOrEnd,
+        ExpectKeyOrEnd,
+        ExpectKey,
+        ExpectColon,
+        ExpectCommaOrEnd,
+        Done
+    };
+
+    enum Lexer : uint8_t {
+        Idle = 0,
+        InString,
+        InEscape,
+        InUnicode,
+        InLiteral
+    };
+
+    enum ContextKind : uint8_t {
+        KnownObject = 0, // field is the ObjectBegin index, -1 for the root
+        RuleList,
+        RuleObject,
+        Skipped
+    };
+
+    struct Context {
+        ContextKind kind;
+        bool isArray;
+        int16_t field;
+    };
+
+    ConfigData data;
+    uint64_t present = 0;
+    Error error = None;
+    size_t position = 0;
+    State state = ExpectValue;
+    Lexer lexer = Idle;
+    bool stringIsKey = false;
+    bool tokenTooLong = false;
+    bool stringValue = false;
+    uint8_t unicodeDigits = 0;
+    uint16_t unicodeValue = 0;
+    uint8_t depth = 0;
+    Context stack[MAX_DEPTH];
+    char key[MAX_KEY];
+    char token[MAX_TOKEN];
+    size_t tokenLength = 0;
+
+    bool process(char c);
+    bool processString(char c);
+    bool beginValue(char c);
+    bool open(bool isArray);
+    bool close(bool isArray);
+    bool completeValue();
+    bool applyScalar(const ConfigJson::Field &field, void *base);
+    bool appendToken(char c);
+    bool appendUtf8(uint16_t codePoint);
+    bool fail(Error reason);
+    bool validate();
+
+    static bool parseInteger(const char *text, long long minimum, long long maximum, long long &value);
+    static bool parseColor(const char *text, uint8_t rgb[3]);
+};
+
+#endif // CONFIGJSON_H
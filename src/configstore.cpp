@@ -0,0 +1,100 @@
+#include "configstore.h"
+#include <string.h>
+
+// the schema version has to change along with the layout
+static_assert(sizeof(ConfigData) == 516, "ConfigData layout changed, bump ConfigStore::VERSION and add a migration");
+static_assert(sizeof(ConfigStore::Header) + sizeof(ConfigData) <= ConfigStore::MAX_BLOB_SIZE, "ConfigData outgrew the blob buffer");
+
+ConfigStore::ConfigStore(IKeyValueStore &nvs) : nvs(nvs)
+{
+}
+
+ConfigStore::LoadResult ConfigStore::load(ConfigData &data)
+{
+    size_t length = nvs.getLength(KEY);
+    if (length == 0)
+    {
+        return Missing;
+    }
+    if (length < sizeof(Header) || length > MAX_BLOB_SIZE)
+    {
+        return Corrupt;
+    }
+
+    uint8_t blob[MAX_BLOB_SIZE];
+    if (nvs.read(KEY, blob, length) != length)
+    {
+        return Corrupt;
+    }
+
+    Header header;
+    memcpy(&header, blob, sizeof(header));
+    const uint8_t *payload = blob + sizeof(header);
+    if (header.magic != MAGIC || header.size != length - sizeof(header) || crc32(payload, header.size) != header.crc)
+    {
+        return Corrupt;
+    }
+    if (header.version > VERSION)
+    {
+        return Unsupported;
+    }
+
+    if (!migrate(header.version, payload, header.size, data))
+    {
+        return Corrupt;
+    }
+    return header.version == VERSION ? Loaded : Migrated;
+}
+
+size_t ConfigStore::save(const ConfigData &data)
+{
+    uint8_t blob[sizeof(Header) + sizeof(ConfigData)];
+    Header header = {MAGIC, VERSION, static_cast<uint16_t>(sizeof(ConfigData)), 0};
+    memcpy(blob + sizeof(header), &data, sizeof(data));
+    header.crc = crc32(blob + sizeof(header), sizeof(data));
+    memcpy(blob, &header, sizeof(header));
+
+    return nvs.write(KEY, blob, sizeof(blob)) == sizeof(blob) ? sizeof(blob) : 0;
+}
+
+bool ConfigStore::erase()
+{
+    return nvs.clear();
+}
+
+bool ConfigStore::migrate(uint16_t version, const uint8_t *payload, size_t size, ConfigData &data)
+{
+    // one case per schema version, older ones start from the defaults and copy
+    // what they had. The per-key layout before version 1 is migrated by Configuration
+    switch (version)
+    {
+    case 1:
+        if (size != sizeof(ConfigData))
+        {
+            return false;
+        }
+        memcpy(&data, payload, size);
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint32_t ConfigStore::crc32(const uint8_t *data, size_t length, uint32_t crc)
+{
+    // CRC-32 (IEEE), a nibble at a time: 64 bytes of table instead of 1 KiB
+    static const uint32_t TABLE[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = TABLE[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = TABLE[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
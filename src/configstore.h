@@ -0,0 +1,50 @@
+#ifndef CONFIGSTORE_H
+#define CONFIGSTORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "configdata.h"
+#include "ikeyvaluestore.h"
+
+// Persists ConfigData as a single blob: a small header (magic, schema
+// version, payload size, CRC-32) followed by the packed struct. Boot is one
+// read, a factory reset is one erase.
+class ConfigStore
+{
+public:
+    static const uint32_t MAGIC = 0x31434F57; // "WOC1"
+    // bump on every ConfigData layout change and add a case to migrate()
+    static const uint16_t VERSION = 1;
+    static const size_t MAX_BLOB_SIZE = 1024;
+    static constexpr const char *KEY = "cfg";
+
+    enum LoadResult : uint8_t {
+        Loaded = 0,
+        Migrated,   // an older schema was converted, save to finish the migration
+        Missing,
+        Corrupt,    // bad magic, size or CRC
+        Unsupported // written by a newer firmware
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t size;
+        uint32_t crc; // over the payload
+    };
+
+    explicit ConfigStore(IKeyValueStore &nvs);
+    LoadResult load(ConfigData &data);
+    // returns the number of bytes written, 0 on failure
+    size_t save(const ConfigData &data);
+    bool erase();
+
+    static uint32_t crc32(const uint8_t *data, size_t length, uint32_t crc = 0);
+
+private:
+    IKeyValueStore &nvs;
+
+    static bool migrate(uint16_t version, const uint8_t *payload, size_t size, ConfigData &data);
+};
+
+#endif // CONFIGSTORE_H
@@ -2,277 +2,279 @@
 
 #include "configuration.h"
 
-// System Preferences Keys
-const char Configuration::IS_INITIALIZED_KEY[] PROGMEM    = "is_init";
-const char Configuration::CLOCK_MODE_KEY[] PROGMEM          = "clock_mode";
-const char Configuration::WIFI_SSID_KEY[] PROGMEM           = "wifi_ssid";
-const char Configuration::WIFI_PASSWORD_KEY[] PROGMEM       = "wifi_pass";
-const char Configuration::MQTT_ENABLED_KEY[] PROGMEM        = "mqtt_nbld";
-const char Configuration::MQTT_HOST_KEY[] PROGMEM           = "mqtt_host";
-const char Configuration::MQTT_PORT_KEY[] PROGMEM           = "mqtt_port";
-const char Configuration::MQTT_USERNAME_KEY[] PROGMEM       = "mqtt_user";
-const char Configuration::MQTT_PASSWORD_KEY[] PROGMEM       = "mqtt_pass";
-const char Configuration::MQTT_TOPIC_KEY[] PROGMEM          = "mqtt_tpc";
-const char Configuration::NTP_ENABLED_KEY[] PROGMEM         = "ntp_nbld";
-const char Configuration::NTP_TIMEZONE_KEY[] PROGMEM        = "ntp_tz";
-const char Configuration::NTP_SERVER_KEY[] PROGMEM          = "ntp_srv";
-const char Configuration::NTP_UPDATE_ENABLED_KEY[] PROGMEM  = "ntp_upd_nbld";
-const char Configuration::NTP_UPDATE_INTERVAL_KEY[] PROGMEM = "ntp_upd_itvl";
-
-// Light Preferences Keys
-const char Configuration::LIGHT_SCHEDULE_ENABLED_KEY[] PROGMEM   = "ls_nbld";
-const char Configuration::LIGHT_SCHEDULE_START_TIME_KEY[] PROGMEM  = "ls_start_t";
-const char Configuration::LIGHT_SCHEDULE_END_TIME_KEY[] PROGMEM    = "ls_end_t";
-const char Configuration::AUTO_BRIGHTNESS_ENABLED_KEY[] PROGMEM    = "ab_nbld";
-const char Configuration::AUTO_BRIGHTNESS_THRESH_HIGH_KEY[] PROGMEM  = "ab_thrsh_hi";
-const char Configuration::AUTO_BRIGHTNESS_THRESH_LOW_KEY[] PROGMEM   = "ab_thrsh_lo";
-const char Configuration::LIGHT_BRIGHTNESS_KEY[] PROGMEM           = "lght_brightn";
-const char Configuration::LIGHT_COLOR_KEY[] PROGMEM                = "lght_color";
-const char Configuration::LIGHT_STATE_KEY[] PROGMEM               = "lght_state";
-
 // Constructor
-Configuration::Configuration() {
-    // Initialization is done in the init() method
+Configuration::Configuration() : nvs(preferences), store(nvs) {
+    ConfigData::setDefaults(data);
+    ConfigData::setDefaults(stored);
 }
 
 // Destructor
 Configuration::~Configuration() {
-    systemPreferences.end();
-    lightPreferences.end();
+    flush();
+    preferences.end();
 }
 
-// Initialize Preferences namespaces
+// Single read at boot, afterwards everything is served from RAM
 void Configuration::init() {
-    systemPreferences.begin("system", false); 
-    lightPreferences.begin("light", false);
-    if(!getIsInitialized()) {
-        initializeDefaultConfig();
+    preferences.begin(NAMESPACE, false);
+
+    switch (store.load(data)) {
+    case ConfigStore::Loaded:
+        stored = data;
+        return;
+    case ConfigStore::Migrated:
+        break;
+    case ConfigStore::Missing:
+        if (!migrateLegacyKeys()) {
+            ConfigData::setDefaults(data);
+        }
+        break;
+    case ConfigStore::Corrupt:
+        Serial.println(F("Stored configuration is corrupt, using defaults"));
+        ConfigData::setDefaults(data);
+        break;
+    case ConfigStore::Unsupported:
+        // leave the newer blob alone until something is changed, a downgrade might be temporary
+        Serial.println(F("Stored configuration is from a newer firmware, using defaults"));
+        ConfigData::setDefaults(data);
+        return;
+    }
+    if (store.save(data) > 0) {
+        stored = data;
     }
 }
 
-void Configuration::setIsInitialized(bool isInitialized) {
-    systemPreferences.putBool(IS_INITIALIZED_KEY, isInitialized);
-}
+// Reads the per-key "system"/"light" namespaces of older firmware into data and clears them
+bool Configuration::migrateLegacyKeys() {
+    Preferences systemPreferences;
+    Preferences lightPreferences;
+    systemPreferences.begin(LegacyConfig::SYSTEM_NAMESPACE, false);
+    lightPreferences.begin(LegacyConfig::LIGHT_NAMESPACE, false);
+    LegacyPreferences system(systemPreferences);
+    LegacyPreferences light(lightPreferences);
+
+    bool found = LegacyConfig::read(system, light, data);
+    if (found) {
+        Serial.println(F("Migrated per-key configuration"));
+    }
 
-bool Configuration::getIsInitialized() {
-    return systemPreferences.getBool(IS_INITIALIZED_KEY, false);
+    systemPreferences.clear();
+    lightPreferences.clear();
+    systemPreferences.end();
+    lightPreferences.end();
+    return found;
 }
 
-// ClockMode
-void Configuration::setClockMode(ClockMode mode) {
-    systemPreferences.putUInt(CLOCK_MODE_KEY, static_cast<uint32_t>(mode));
+void Configuration::markDirty() {
+    uint32_t now = millis();
+    if (!dirty) {
+        firstDirtyMs = now;
+    }
+    dirty = true;
+    lastDirtyMs = now;
+    writeStats.changes++;
 }
 
-Configuration::ClockMode Configuration::getClockMode() {
-    uint32_t mode = systemPreferences.getUInt(CLOCK_MODE_KEY, static_cast<uint32_t>(Regular));
-    return static_cast<ClockMode>(mode);
+bool Configuration::unchanged() {
+    writeStats.unchanged++;
+    return false;
 }
 
-// WiFi Configuration
-void Configuration::setWifiConfig(const WifiConfig& config) {
-    systemPreferences.putBytes(WIFI_SSID_KEY, config.ssid, sizeof(config.ssid));
-    systemPreferences.putBytes(WIFI_PASSWORD_KEY, config.password, sizeof(config.password));
+void Configuration::loop() {
+    if (!dirty) {
+        return;
+    }
+
+    // wait for a quiet period (slider drags, MQTT bursts), but never hold changes back for too long
+    uint32_t now = millis();
+    if (now - lastDirtyMs >= FLUSH_DELAY_MS || now - firstDirtyMs >= MAX_FLUSH_DELAY_MS) {
+        flush();
+    }
 }
 
-Configuration::WifiConfig Configuration::getWifiConfig() {
-    WifiConfig config;
-    systemPreferences.getBytes(WIFI_SSID_KEY, config.ssid, sizeof(config.ssid));
-    systemPreferences.getBytes(WIFI_PASSWORD_KEY, config.password, sizeof(config.password));
-    return config;
+size_t Configuration::flush() {
+    if (!dirty) {
+        return 0;
+    }
+    dirty = false;
+
+    // e.g. a light toggled on and off again before the flush
+    if (data == stored) {
+        writeStats.skippedFlushes++;
+        writeStats.lastFlushBytes = 0;
+        return 0;
+    }
+
+    uint32_t start = micros();
+    size_t written = store.save(data);
+    uint32_t elapsed = micros() - start;
+    if (written > 0) {
+        stored = data;
+    } else {
+        Serial.println(F("Failed to write configuration"));
+    }
+
+    writeStats.bytesWritten += written;
+    writeStats.lastFlushBytes = written;
+    writeStats.flushes++;
+    writeStats.lastFlushMicros = elapsed;
+    if (elapsed > writeStats.maxFlushMicros) {
+        writeStats.maxFlushMicros = elapsed;
+    }
+    return written;
 }
 
-// MQTT Configuration
-void Configuration::setMqttConfig(const MqttConfig& config) {
-    systemPreferences.putBool(MQTT_ENABLED_KEY, config.enabled);
-    int size = systemPreferences.putBytes(MQTT_HOST_KEY, config.host, sizeof(config.host));
-    systemPreferences.putUInt(MQTT_PORT_KEY, config.port);
-    systemPreferences.putBytes(MQTT_USERNAME_KEY, config.username, sizeof(config.username));
-    systemPreferences.putBytes(MQTT_PASSWORD_KEY, config.password, sizeof(config.password));
-    systemPreferences.putBytes(MQTT_TOPIC_KEY, config.topic, sizeof(config.topic));
+// ClockMode
+bool Configuration::setClockMode(ClockMode mode) {
+    if (data.system.mode == mode) {
+        return unchanged();
+    }
+    data.system.mode = mode;
+    markDirty();
+    return true;
 }
 
-Configuration::MqttConfig Configuration::getMqttConfig() {
-    MqttConfig config;
-    config.enabled = systemPreferences.getBool(MQTT_ENABLED_KEY, Defaults::DEFAULT_MQTT_ENABLED);
-    if(systemPreferences.getBytes(MQTT_HOST_KEY, config.host, sizeof(config.host)) == 0) {
-        strlcpy(config.host, "", sizeof(config.host));
+
+// WiFi Configuration
+bool Configuration::setWifiConfig(const WifiConfig& config) {
+    if (data.wifi == config) {
+        return unchanged();
     }
-    config.port = systemPreferences.getUInt(MQTT_PORT_KEY, Defaults::DEFAULT_MQTT_PORT);
-    systemPreferences.getBytes(MQTT_USERNAME_KEY, config.username, sizeof(config.username));
-    systemPreferences.getBytes(MQTT_PASSWORD_KEY, config.password, sizeof(config.password));
-    systemPreferences.getBytes(MQTT_TOPIC_KEY, config.topic, sizeof(config.topic));
-    return config;
+    data.wifi = config;
+    markDirty();
+    return true;
 }
 
-// NTP Configuration
-void Configuration::setNtpConfig(const NtpConfig& config) {
-    systemPreferences.putBool(NTP_ENABLED_KEY, config.enabled);
-    systemPreferences.putBytes(NTP_TIMEZONE_KEY, config.timezone, sizeof(config.timezone));
-    systemPreferences.putBytes(NTP_SERVER_KEY, config.server, sizeof(config.server));
-    systemPreferences.putULong(NTP_UPDATE_INTERVAL_KEY, config.interval);
+Configuration::WifiConfig Configuration::getWifiConfig() {
+    return data.wifi;
 }
 
-Configuration::NtpConfig Configuration::getNtpConfig() {
-    NtpConfig config;
 
-    // Initialize buffers
-    // memset(config.timezone, 0, sizeof(config.timezone));
-    // memset(config.server, 0, sizeof(config.server));
+// MQTT Configuration
+bool Configuration::setMqttConfig(const MqttConfig& config) {
+    if (data.system.mqttConfig == config) {
+        return unchanged();
+    }
+    data.system.mqttConfig = config;
+    markDirty();
+    return true;
+}
 
-    // Enabled
-    config.enabled = systemPreferences.getBool(NTP_ENABLED_KEY, Defaults::DEFAULT_NTP_ENABLED);
-    config.interval = systemPreferences.getULong(NTP_UPDATE_INTERVAL_KEY, Defaults::DEFAULT_NTP_UPDATE_INTERVAL); // Default interval: 24 hours
 
-    // Timezone
-    size_t tzLen = systemPreferences.getBytes(NTP_TIMEZONE_KEY, config.timezone, sizeof(config.timezone));
-    if (tzLen == 0) {
-        strlcpy(config.timezone, Defaults::DEFAULT_NTP_TIMEZONE, sizeof(config.timezone));
+// NTP Configuration
+bool Configuration::setNtpConfig(const NtpConfig& config) {
+    if (data.system.ntpConfig == config) {
+        return unchanged();
     }
+    data.system.ntpConfig = config;
+    markDirty();
+    return true;
+}
 
-    // Server
-    size_t serverLen = systemPreferences.getBytes(NTP_SERVER_KEY, config.server, sizeof(config.server));
-    if (serverLen == 0) {
-        strlcpy(config.server, Defaults::DEFAULT_NTP_SERVER, sizeof(config.server));
-    }
 
-    return config;
+// Location
+bool Configuration::setLocationConfig(const LocationConfig& config) {
+    if (data.system.locationConfig == config) {
+        return unchanged();
+    }
+    data.system.locationConfig = config;
+    markDirty();
+    return true;
 }
 
 
-
 // Light Schedule
-void Configuration::setLightSchedule(const LightScheduleConfig& schedule) {
-    lightPreferences.putBool(LIGHT_SCHEDULE_ENABLED_KEY, schedule.enabled);
-    lightPreferences.putUInt(LIGHT_SCHEDULE_START_TIME_KEY, schedule.startTime);
-    lightPreferences.putUInt(LIGHT_SCHEDULE_END_TIME_KEY, schedule.endTime);
+bool Configuration::setLightSchedule(const LightScheduleConfig& schedule) {
+    if (data.system.lightScheduleConfig == schedule) {
+        return unchanged();
+    }
+    data.system.lightScheduleConfig = schedule;
+    markDirty();
+    return true;
 }
 
-Configuration::LightScheduleConfig Configuration::getLightSchedule() {
-    LightScheduleConfig schedule;
-    schedule.enabled = lightPreferences.getBool(LIGHT_SCHEDULE_ENABLED_KEY, Defaults::DEFAULT_LIGHT_SCHEDULE_ENABLED);
-    schedule.startTime = lightPreferences.getUInt(LIGHT_SCHEDULE_START_TIME_KEY, 0);
-    schedule.endTime = lightPreferences.getUInt(LIGHT_SCHEDULE_END_TIME_KEY, 0);
-    return schedule;
-}
 
 // Auto Brightness
-void Configuration::setAutoBrightness(const AutoBrightnessConfig& brightnessConfig) {
-    lightPreferences.putBool(AUTO_BRIGHTNESS_ENABLED_KEY, brightnessConfig.enabled);
-    lightPreferences.putUShort(AUTO_BRIGHTNESS_THRESH_HIGH_KEY, brightnessConfig.illuminanceThresholdHigh);
-    lightPreferences.putUShort(AUTO_BRIGHTNESS_THRESH_LOW_KEY, brightnessConfig.illuminanceThresholdLow);
+bool Configuration::setAutoBrightness(const AutoBrightnessConfig& brightnessConfig) {
+    if (data.light.autoBrightnessConfig == brightnessConfig) {
+        return unchanged();
+    }
+    data.light.autoBrightnessConfig = brightnessConfig;
+    markDirty();
+    return true;
 }
 
-Configuration::AutoBrightnessConfig Configuration::getAutoBrightness() {
-    AutoBrightnessConfig config;
-    
-    config.enabled = lightPreferences.getBool(AUTO_BRIGHTNESS_ENABLED_KEY, Defaults::DEFAULT_AUTO_BRIGHTNESS_ENABLED);
-    
-    config.illuminanceThresholdHigh = lightPreferences.getUShort(
-        AUTO_BRIGHTNESS_THRESH_HIGH_KEY, Defaults::DEFAULT_ILLUMINANCE_THRESHOLD_HIGH);
-
-    config.illuminanceThresholdLow = lightPreferences.getUShort(
-        AUTO_BRIGHTNESS_THRESH_LOW_KEY, Defaults::DEFAULT_ILLUMINANCE_THRESHOLD_LOW);
-
-    return config;
-}
 
 // Light Configuration
 // void Configuration::setLightConfig(const LightConfig& config) {
-//     lightPreferences.putUChar(LIGHT_BRIGHTNESS_KEY, config.brightness);
-//     lightPreferences.putBytes(LIGHT_COLOR_KEY, config.color, sizeof(config.color));
-//     lightPreferences.putBool(LIGHT_STATE_KEY, config.state);
+//     prefs.putUChar(LIGHT_BRIGHTNESS_KEY, config.brightness);
+//     prefs.putBytes(LIGHT_COLOR_KEY, config.color, sizeof(config.color));
+//     prefs.putBool(LIGHT_STATE_KEY, config.state);
 //     setAutoBrightness(config.autoBrightnessConfig);
 // }
 
-void Configuration::setLightState(bool state) {
-    lightPreferences.putBool(LIGHT_STATE_KEY, state);
+bool Configuration::setLightState(bool state) {
+    if (data.light.state == state) {
+        return unchanged();
+    }
+    data.light.state = state;
+    markDirty();
+    return true;
 }
 
-void Configuration::setLightBrightness(uint8_t brightness) {
-    lightPreferences.putUChar(LIGHT_BRIGHTNESS_KEY, brightness);
+bool Configuration::setLightBrightness(uint8_t brightness) {
+    if (data.light.brightness == brightness) {
+        return unchanged();
+    }
+    data.light.brightness = brightness;
+    markDirty();
+    return true;
 }
 
-void Configuration::setLightColor(const char* color) {
-    lightPreferences.putBytes(LIGHT_COLOR_KEY, color, strlen(color));
+bool Configuration::setLightColor(const char* color) {
+    if (strncmp(data.light.color, color, sizeof(data.light.color)) == 0) {
+        return unchanged();
+    }
+    ConfigData::copyString(data.light.color, color, sizeof(data.light.color));
+    markDirty();
+    return true;
 }
 
-
 Configuration::LightConfig Configuration::getLightConfig() {
-    LightConfig config;
-
-    config.brightness = lightPreferences.getUChar(LIGHT_BRIGHTNESS_KEY, Defaults::DEFAULT_LIGHT_BRIGHTNESS);
-    config.state = lightPreferences.getBool(LIGHT_STATE_KEY, true);
+    return data.light;
+}
 
-    memset(config.color, 0, sizeof(config.color));
 
-    size_t colorLen = lightPreferences.getBytes(LIGHT_COLOR_KEY, config.color, sizeof(config.color));
-    if (colorLen == 0) {
-        strlcpy(config.color, Defaults::DEFAULT_LIGHT_COLOR, sizeof(config.color));
-    } 
+Configuration::SystemConfig Configuration::getSystemConfig() {
+    return data.system;
+}
 
-    config.autoBrightnessConfig = getAutoBrightness();
 
-    return config;
+// Bulk updates
+void Configuration::update(const ConfigData &updated) {
+    setClockMode(updated.system.mode);
+    setMqttConfig(updated.system.mqttConfig);
+    setNtpConfig(updated.system.ntpConfig);
+    setLocationConfig(updated.system.locationConfig);
+    setLightSchedule(updated.system.lightScheduleConfig);
+    setLightState(updated.light.state);
+    setLightBrightness(updated.light.brightness);
+    setLightColor(updated.light.color);
+    setAutoBrightness(updated.light.autoBrightnessConfig);
+    setWifiConfig(updated.wifi);
 }
 
-Configuration::SystemConfig Configuration::getSystemConfig() {
-    SystemConfig config;
-    config.mqttConfig = getMqttConfig();
-    config.ntpConfig = getNtpConfig();
-    config.lightScheduleConfig = getLightSchedule();
-    config.mode = getClockMode();
-    return config;
+bool Configuration::importData(const ConfigData &imported) {
+    update(imported);
+    flush();
+    return data == stored;
 }
 
-
 // Reset all configurations
 void Configuration::reset() {
-    systemPreferences.clear();
-    lightPreferences.clear();
+    // pending changes must not resurrect the old values
+    dirty = false;
+    store.erase();
+    ConfigData::setDefaults(data);
+    stored = data;
 }
-
-void Configuration::initializeDefaultConfig(){
-    Configuration::WifiConfig wifiConfig;
-    strlcpy(wifiConfig.ssid, "", sizeof(wifiConfig.ssid));
-    strlcpy(wifiConfig.ssid, "", sizeof(wifiConfig.ssid));
-    strlcpy(wifiConfig.password, "", sizeof(wifiConfig.password));
-    setWifiConfig(wifiConfig);
-
-    Configuration::MqttConfig mqttConfig;
-    mqttConfig.enabled = Defaults::DEFAULT_MQTT_ENABLED;
-    strlcpy(mqttConfig.host, "", sizeof(mqttConfig.host));
-    mqttConfig.port = Defaults::DEFAULT_MQTT_PORT;
-    strlcpy(mqttConfig.username, "", sizeof(mqttConfig.username));
-    strlcpy(mqttConfig.password, "", sizeof(mqttConfig.password));
-    strlcpy(mqttConfig.topic, Defaults::DEFAULT_MQTT_TOPIC, sizeof(mqttConfig.topic));
-    setMqttConfig(mqttConfig);
-
-    Configuration::NtpConfig ntpConfig;
-    ntpConfig.enabled = Defaults::DEFAULT_NTP_ENABLED;
-    strlcpy(ntpConfig.timezone, Defaults::DEFAULT_NTP_TIMEZONE, sizeof(ntpConfig.timezone));
-    strlcpy(ntpConfig.server, Defaults::DEFAULT_NTP_SERVER, sizeof(ntpConfig.server));
-    ntpConfig.interval = Defaults::DEFAULT_NTP_UPDATE_INTERVAL;
-    setNtpConfig(ntpConfig);
-
-    Configuration::LightScheduleConfig lightScheduleConfig;
-    lightScheduleConfig.enabled = Defaults::DEFAULT_LIGHT_SCHEDULE_ENABLED;
-    lightScheduleConfig.startTime = 0;
-    lightScheduleConfig.endTime = 0;
-    setLightSchedule(lightScheduleConfig);
-
-    Configuration::LightConfig lightConfig;
-    lightConfig.brightness = Defaults::DEFAULT_LIGHT_BRIGHTNESS;
-    lightConfig.autoBrightnessConfig.enabled = Defaults::DEFAULT_AUTO_BRIGHTNESS_ENABLED;
-    lightConfig.autoBrightnessConfig.illuminanceThresholdHigh = Defaults::DEFAULT_ILLUMINANCE_THRESHOLD_HIGH;
-    lightConfig.autoBrightnessConfig.illuminanceThresholdLow = Defaults::DEFAULT_ILLUMINANCE_THRESHOLD_LOW;
-    strlcpy(lightConfig.color, Defaults::DEFAULT_LIGHT_COLOR, sizeof(lightConfig.color));
-    lightConfig.state = Defaults::DEFAULT_LIGHT_STATE;
-    setLightState(lightConfig.state);
-    setLightBrightness(lightConfig.brightness);
-    setLightColor(lightConfig.color);
-    setAutoBrightness(lightConfig.autoBrightnessConfig);  
-
-    setClockMode(Regular);
-
-    setIsInitialized();
-}
\ No newline at end of file
@@ -5,120 +5,90 @@
 #include <Preferences.h>
 #include <RTClib.h> // For DateTime
 #include "defaults.h"
+#include "configdata.h"
+#include "configstore.h"
+#include "preferencesstore.h"
 
 class Configuration {
 public:
-    enum ClockMode {
-        Regular = 0,
-        Option_1
-    };
-
-    struct WifiConfig {
-        char ssid[32];
-        char password[64];
-    };
+    // the structs live in ConfigData so the blob layout can be tested on the host
+    using ClockMode = ConfigData::ClockMode;
+    using WifiConfig = ConfigData::WifiConfig;
+    using MqttConfig = ConfigData::MqttConfig;
+    using NtpConfig = ConfigData::NtpConfig;
+    using LocationConfig = ConfigData::LocationConfig;
+    using LightScheduleConfig = ConfigData::LightScheduleConfig;
+    using AutoBrightnessConfig = ConfigData::AutoBrightnessConfig;
+    using LightConfig = ConfigData::LightConfig;
+    using SystemConfig = ConfigData::SystemConfig;
+    static constexpr ClockMode Regular = ConfigData::Regular;
+    static constexpr ClockMode Option_1 = ConfigData::Option_1;
 
-    struct MqttConfig {
-        bool enabled;
-        char host[64];
-        uint16_t port;
-        char username[32];
-        char password[32];
-        char topic[64];
-    };
-
-    struct NtpConfig {
-        bool enabled;
-        char timezone[32];
-        char server[64];
-        uint32_t interval;
-    };
+    // setters only update the RAM copy and ignore values that are already set,
+    // loop() commits to flash once changes settle
+    static const uint32_t FLUSH_DELAY_MS = 2000;
+    static const uint32_t MAX_FLUSH_DELAY_MS = 30000;
 
-    struct LightScheduleConfig {
-        bool enabled;
-        uint32_t startTime; // Time in seconds since midnight
-        uint32_t endTime;
+    struct WriteStats {
+        uint32_t changes;        // setter calls that changed a value
+        uint32_t unchanged;      // setter calls with the current value
+        uint32_t flushes;        // blob commits
+        uint32_t skippedFlushes; // pending changes that ended up equal to flash
+        uint32_t bytesWritten;   // header included
+        uint32_t lastFlushBytes;
+        uint32_t lastFlushMicros;
+        uint32_t maxFlushMicros;
     };
 
-    struct AutoBrightnessConfig {
-        bool enabled;
-        uint16_t illuminanceThresholdHigh;
-        uint16_t illuminanceThresholdLow;
-    };
-
-    struct LightConfig {
-        uint8_t brightness;
-        AutoBrightnessConfig autoBrightnessConfig;       
-        char color[8]; // Hex color string (e.g., "FF0000")
-        bool state;
-    };
-
-    struct SystemConfig {
-        //WifiConfig wifiConfig;
-        ClockMode mode;
-        MqttConfig mqttConfig;
-        NtpConfig ntpConfig;
-        LightScheduleConfig lightScheduleConfig; 
-    };    
-
     Configuration();
     ~Configuration();
     void init();
+    void loop();
+    // commits pending changes right away, call before restarts and OTA.
+    // Returns the number of bytes written, 0 if nothing differed from flash
+    size_t flush();
+    bool hasPendingChanges() const { return dirty; }
+    const WriteStats &getWriteStats() const { return writeStats; }
 
-    void setLightState(bool state);
-    void setLightBrightness(uint8_t brightness);
-    void setLightColor(const char* color);
-    void setAutoBrightness(const AutoBrightnessConfig& brightnessConfig);
+    // setters return false when the value was already set
+    bool setLightState(bool state);
+    bool setLightBrightness(uint8_t brightness);
+    bool setLightColor(const char* color);
+    bool setAutoBrightness(const AutoBrightnessConfig& brightnessConfig);
     LightConfig getLightConfig();
-    void setClockMode(ClockMode mode);
-    void setMqttConfig(const MqttConfig& config);
-    void setNtpConfig(const NtpConfig& config);
-    void setLightSchedule(const LightScheduleConfig& schedule);
+    bool setClockMode(ClockMode mode);
+    bool setMqttConfig(const MqttConfig& config);
+    bool setNtpConfig(const NtpConfig& config);
+    bool setLocationConfig(const LocationConfig& config);
+    bool setLightSchedule(const LightScheduleConfig& schedule);
     SystemConfig getSystemConfig();
-    void setWifiConfig(const WifiConfig& config);
+    bool setWifiConfig(const WifiConfig& config);
     WifiConfig getWifiConfig();
+    const ConfigData &getData() const { return data; }
+    // takes over whatever differs, committed like any other change
+    void update(const ConfigData &updated);
+    // replaces everything at once with a single commit, false if that write failed
+    bool importData(const ConfigData &imported);
     void reset();
 
 private:
-    Preferences systemPreferences;
-    Preferences lightPreferences;
-    //Preferences internalPreferences;
+    static constexpr const char *NAMESPACE = "woc";
 
-    // System Preferences Keys
-    static const char IS_INITIALIZED_KEY[] PROGMEM;
-    static const char CLOCK_MODE_KEY[] PROGMEM;
-    static const char WIFI_SSID_KEY[] PROGMEM;
-    static const char WIFI_PASSWORD_KEY[] PROGMEM;
-    static const char MQTT_ENABLED_KEY[] PROGMEM;
-    static const char MQTT_HOST_KEY[] PROGMEM;
-    static const char MQTT_PORT_KEY[] PROGMEM;
-    static const char MQTT_USERNAME_KEY[] PROGMEM;
-    static const char MQTT_PASSWORD_KEY[] PROGMEM;
-    static const char MQTT_TOPIC_KEY[] PROGMEM;
-    static const char NTP_ENABLED_KEY[] PROGMEM;
-    static const char NTP_TIMEZONE_KEY[] PROGMEM;
-    static const char NTP_SERVER_KEY[] PROGMEM;
-    static const char NTP_UPDATE_ENABLED_KEY[] PROGMEM;
-    static const char NTP_UPDATE_INTERVAL_KEY[] PROGMEM;
+    Preferences preferences;
+    PreferencesStore nvs;
+    ConfigStore store;
 
-    // Light Preferences Keys
-    static const char LIGHT_SCHEDULE_ENABLED_KEY[] PROGMEM;
-    static const char LIGHT_SCHEDULE_START_TIME_KEY[] PROGMEM;
-    static const char LIGHT_SCHEDULE_END_TIME_KEY[] PROGMEM;
-    static const char AUTO_BRIGHTNESS_ENABLED_KEY[] PROGMEM;
-    static const char AUTO_BRIGHTNESS_THRESH_HIGH_KEY[] PROGMEM;
-    static const char AUTO_BRIGHTNESS_THRESH_LOW_KEY[] PROGMEM;
-    static const char LIGHT_BRIGHTNESS_KEY[] PROGMEM;
-    static const char LIGHT_COLOR_KEY[] PROGMEM;
-    static const char LIGHT_STATE_KEY[] PROGMEM;
+    // RAM copy of everything in flash, the getters never touch NVS
+    ConfigData data;
+    // what the last flush committed, to drop changes that were reverted in the meantime
+    ConfigData stored;
+    bool dirty = false;
+    uint32_t firstDirtyMs = 0;
+    uint32_t lastDirtyMs = 0;
+    WriteStats writeStats = {};
 
-    bool getIsInitialized();
-    void setIsInitialized(bool isInitialized = true);
-    void initializeDefaultConfig();
-    ClockMode getClockMode();
-    MqttConfig getMqttConfig();
-    NtpConfig getNtpConfig();
-    LightScheduleConfig getLightSchedule();
-    AutoBrightnessConfig getAutoBrightness();
+    void markDirty();
+    bool unchanged();
+    bool migrateLegacyKeys();
 };
 #endif // CONFIGURATION_H
@@ -1,7 +1,7 @@
 #ifndef DEFAULTS_H
 #define DEFAULTS_H
 
-#include <Arduino.h>
+#include <stdint.h>
 
 class Defaults
 {
@@ -16,17 +16,23 @@ public:
     static constexpr uint16_t DEFAULT_MQTT_PORT = 1883;
     static constexpr const char* DEFAULT_MQTT_TOPIC = "woc";
     static constexpr bool DEFAULT_NTP_ENABLED = true;
-    static constexpr const char* DEFAULT_NTP_TIMEZONE = "Etc/UTC"; // see timezone_data.h
+    static constexpr const char* DEFAULT_NTP_TIMEZONE = "Etc/UTC"; // see timezone_data.h, regenerate with tools/gen_timezones.py
     static constexpr const char* DEFAULT_NTP_SERVER = "0.pool.ntp.org";
     static constexpr bool DEFAULT_LIGHT_SCHEDULE_ENABLED = false;
     static constexpr bool DEFAULT_NTP_UPDATE_ENABLED = true;
     static constexpr uint32_t DEFAULT_NTP_UPDATE_INTERVAL = 60; // minutes
+    static constexpr bool DEFAULT_LOCATION_ENABLED = false;
+    static constexpr float DEFAULT_LATITUDE = 0.0f;
+    static constexpr float DEFAULT_LONGITUDE = 0.0f;
     static constexpr bool DEFAULT_AUTO_BRIGHTNESS_ENABLED = true;
     static constexpr uint16_t DEFAULT_ILLUMINANCE_THRESHOLD_HIGH = 4095;
     static constexpr uint16_t DEFAULT_ILLUMINANCE_THRESHOLD_LOW = 300;
     static constexpr uint8_t DEFAULT_LIGHT_BRIGHTNESS = 50;
     static constexpr const char* DEFAULT_LIGHT_COLOR = "#FFFFFF";
     static constexpr bool DEFAULT_LIGHT_STATE = true;
+    // builds with -DWOC_PULL_OTA_URL look for new images on their own
+    static constexpr uint32_t PULL_OTA_FIRST_CHECK_MS = 60000;
+    static constexpr uint32_t PULL_OTA_INTERVAL_MS = 6 * 60 * 60 * 1000;
 
     Defaults(/* args */);
     ~Defaults();
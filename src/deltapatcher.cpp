@@ -0,0 +1,317 @@
+#include "deltapatcher.h"
+#include <string.h>
+
+static const uint8_t MAGIC[4] = {'W', 'D', 'L', 'T'};
+static const uint16_t VERSION = 1;
+
+static uint32_t readLe32(const uint8_t *data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+DeltaPatcher::DeltaPatcher(const HeaderCallback &headerCb, const ReadCallback &readCb, const OutputCallback &outputCb)
+    : headerCallback(headerCb), readCallback(readCb), outputCallback(outputCb)
+{
+    memset(&header, 0, sizeof(header));
+}
+
+void DeltaPatcher::begin()
+{
+    memset(&header, 0, sizeof(header));
+    state = ReadHeader;
+    error = ErrorNone;
+    produced = 0;
+    fieldLength = 0;
+    varint = 0;
+    varintShift = 0;
+    remaining = 0;
+    diffLeft = 0;
+    oldPosition = 0;
+    oldBufferStart = 0;
+    oldBufferLength = 0;
+    outputLength = 0;
+}
+
+bool DeltaPatcher::write(const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        uint8_t byte = data[i];
+        switch (state)
+        {
+        case ReadHeader:
+            field[fieldLength++] = byte;
+            if (fieldLength == HEADER_SIZE && !parseHeader())
+            {
+                return false;
+            }
+            break;
+
+        case ReadCommand:
+            if (byte == 'L')
+            {
+                state = ReadLiteralLength;
+            }
+            else if (byte == 'D')
+            {
+                fieldLength = 0;
+                state = ReadDiffOffset;
+            }
+            else if (byte == 'E')
+            {
+                if (!flushOutput())
+                {
+                    return false;
+                }
+                state = Ended;
+            }
+            else
+            {
+                return fail(ErrorFormat);
+            }
+            break;
+
+        case ReadLiteralLength:
+            if (!readVarint(byte))
+            {
+                break;
+            }
+            if (varint > header.newSize - produced)
+            {
+                return fail(ErrorSize);
+            }
+            remaining = varint;
+            state = remaining > 0 ? CopyLiteral : ReadCommand;
+            break;
+
+        case CopyLiteral:
+        {
+            // the rest of the literal that is in this chunk, in one go
+            size_t count = length - i < remaining ? length - i : remaining;
+            for (size_t k = 0; k < count; k++)
+            {
+                if (!emit(data[i + k]))
+                {
+                    return false;
+                }
+            }
+            i += count - 1;
+            remaining -= count;
+            if (remaining == 0)
+            {
+                state = ReadCommand;
+            }
+            break;
+        }
+
+        case ReadDiffOffset:
+            field[fieldLength++] = byte;
+            if (fieldLength == 4)
+            {
+                oldPosition = readLe32(field);
+                state = ReadDiffLength;
+            }
+            break;
+
+        case ReadDiffLength:
+            if (!readVarint(byte))
+            {
+                break;
+            }
+            if (oldPosition > header.oldSize || varint > header.oldSize - oldPosition)
+            {
+                return fail(ErrorFormat);
+            }
+            if (varint > header.newSize - produced)
+            {
+                return fail(ErrorSize);
+            }
+            diffLeft = varint;
+            state = diffLeft > 0 ? ReadZeros : ReadCommand;
+            break;
+
+        case ReadZeros:
+            if (!readVarint(byte))
+            {
+                break;
+            }
+            if (varint > diffLeft)
+            {
+                return fail(ErrorFormat);
+            }
+            // unchanged bytes cost nothing in the patch
+            diffLeft -= varint;
+            if (!copyOld(varint))
+            {
+                return false;
+            }
+            state = ReadCount;
+            break;
+
+        case ReadCount:
+            if (!readVarint(byte))
+            {
+                break;
+            }
+            if (varint > diffLeft)
+            {
+                return fail(ErrorFormat);
+            }
+            remaining = varint;
+            diffLeft -= varint;
+            if (remaining > 0)
+            {
+                state = AddBytes;
+            }
+            else
+            {
+                state = diffLeft > 0 ? ReadZeros : ReadCommand;
+            }
+            break;
+
+        case AddBytes:
+        {
+            uint8_t old;
+            if (!oldByte(old) || !emit(static_cast<uint8_t>(old + byte)))
+            {
+                return false;
+            }
+            if (--remaining == 0)
+            {
+                state = diffLeft > 0 ? ReadZeros : ReadCommand;
+            }
+            break;
+        }
+
+        case Ended:
+            return fail(ErrorFormat);
+
+        case Stopped:
+            return false;
+        }
+    }
+    // a bad varint stops without returning from the loop
+    return state != Stopped;
+}
+
+bool DeltaPatcher::finish()
+{
+    if (state == Stopped)
+    {
+        return false;
+    }
+    if (state != Ended)
+    {
+        // cut off
+        return fail(ErrorFormat);
+    }
+    if (produced != header.newSize)
+    {
+        return fail(ErrorSize);
+    }
+    state = Stopped;
+    return true;
+}
+
+bool DeltaPatcher::parseHeader()
+{
+    if (memcmp(field, MAGIC, sizeof(MAGIC)) != 0 || (field[4] | (field[5] << 8)) != VERSION)
+    {
+        return fail(ErrorFormat);
+    }
+    header.oldSize = readLe32(field + 8);
+    header.newSize = readLe32(field + 12);
+    memcpy(header.oldMd5, field + 16, MD5_SIZE);
+    memcpy(header.newSha256, field + 32, Sha256::DIGEST_SIZE);
+    if (header.newSize == 0)
+    {
+        return fail(ErrorFormat);
+    }
+    if (!headerCallback(header))
+    {
+        return fail(ErrorBase);
+    }
+    state = ReadCommand;
+    return true;
+}
+
+// true once the varint is complete, in varint
+bool DeltaPatcher::readVarint(uint8_t byte)
+{
+    if (varintShift == 0)
+    {
+        varint = 0;
+    }
+    if (varintShift > 28)
+    {
+        fail(ErrorFormat);
+        return false;
+    }
+    varint |= static_cast<uint32_t>(byte & 0x7F) << varintShift;
+    if (byte & 0x80)
+    {
+        varintShift += 7;
+        return false;
+    }
+    varintShift = 0;
+    return true;
+}
+
+bool DeltaPatcher::emit(uint8_t byte)
+{
+    output[outputLength++] = byte;
+    produced++;
+    return outputLength < OUTPUT_BUFFER_SIZE || flushOutput();
+}
+
+bool DeltaPatcher::flushOutput()
+{
+    if (outputLength > 0 && !outputCallback(output, outputLength))
+    {
+        return fail(ErrorOutput);
+    }
+    outputLength = 0;
+    return true;
+}
+
+bool DeltaPatcher::oldByte(uint8_t &byte)
+{
+    if (oldPosition < oldBufferStart || oldPosition >= oldBufferStart + oldBufferLength)
+    {
+        // records are checked against the old size, so there is always something left to read
+        size_t length = header.oldSize - oldPosition < OLD_BUFFER_SIZE ? header.oldSize - oldPosition : OLD_BUFFER_SIZE;
+        if (!readCallback(oldPosition, oldBuffer, length))
+        {
+            oldBufferLength = 0;
+            return fail(ErrorRead);
+        }
+        oldBufferStart = oldPosition;
+        oldBufferLength = length;
+    }
+    byte = oldBuffer[oldPosition - oldBufferStart];
+    oldPosition++;
+    return true;
+}
+
+bool DeltaPatcher::copyOld(uint32_t length)
+{
+    for (uint32_t k = 0; k < length; k++)
+    {
+        uint8_t byte;
+        if (!oldByte(byte) || !emit(byte))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DeltaPatcher::fail(Error reason)
+{
+    if (state != Stopped)
+    {
+        error = reason;
+        state = Stopped;
+    }
+    return false;
+}
@@ -0,0 +1,107 @@
+#ifndef DELTAPATCHER_H
+#define DELTAPATCHER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include "sha256.h"
+
+// Rebuilds a new firmware image from the running one and a delta patch made
+// by tools/deltapatch.py, while the patch is still arriving: chunks of any
+// size go in, the new image comes out in order, the old image is read back
+// in small pieces. Nothing grows with the image, the state is the few
+// hundred bytes of this object.
+class DeltaPatcher
+{
+public:
+    static const size_t HEADER_SIZE = 64;
+    static const size_t MD5_SIZE = 16;
+    // old image bytes read at once, and new image bytes handed on at once
+    static const size_t OLD_BUFFER_SIZE = 256;
+    static const size_t OUTPUT_BUFFER_SIZE = 256;
+
+    struct Header {
+        uint32_t oldSize;
+        uint32_t newSize;
+        uint8_t oldMd5[MD5_SIZE];
+        uint8_t newSha256[Sha256::DIGEST_SIZE];
+    };
+
+    enum Error : uint8_t {
+        ErrorNone = 0,
+        ErrorFormat, // not a patch, or a record out of range
+        ErrorBase,   // made for a different running image
+        ErrorRead,
+        ErrorOutput,
+        ErrorSize    // more or less than the header promised
+    };
+
+    // checks the patch fits the running image and prepares the output, false rejects it
+    using HeaderCallback = std::function<bool(const Header &header)>;
+    // reads length bytes of the running image at offset
+    using ReadCallback = std::function<bool(uint32_t offset, uint8_t *buffer, size_t length)>;
+    // takes the next bytes of the new image
+    using OutputCallback = std::function<bool(const uint8_t *data, size_t length)>;
+
+    DeltaPatcher(const HeaderCallback &headerCb, const ReadCallback &readCb, const OutputCallback &outputCb);
+
+    void begin();
+    // false once anything failed, the rest of the patch is ignored
+    bool write(const uint8_t *data, size_t length);
+    // true if the patch ended properly and the whole new image was handed on
+    bool finish();
+
+    Error getError() const { return error; }
+    uint32_t getProduced() const { return produced; }
+    const Header &getHeader() const { return header; }
+
+private:
+    enum State : uint8_t {
+        ReadHeader,
+        ReadCommand,
+        ReadLiteralLength,
+        CopyLiteral,
+        ReadDiffOffset,
+        ReadDiffLength,
+        ReadZeros,
+        ReadCount,
+        AddBytes,
+        Ended,
+        Stopped
+    };
+
+    HeaderCallback headerCallback;
+    ReadCallback readCallback;
+    OutputCallback outputCallback;
+
+    Header header;
+    State state = Stopped;
+    Error error = ErrorNone;
+    uint32_t produced = 0;
+
+    // header bytes, varints and the diff offset collect here
+    uint8_t field[HEADER_SIZE];
+    size_t fieldLength = 0;
+    uint32_t varint = 0;
+    uint8_t varintShift = 0;
+
+    uint32_t remaining = 0;  // bytes left in the literal, the diff record or the current run
+    uint32_t diffLeft = 0;   // bytes left in the diff record after the current run
+    uint32_t oldPosition = 0;
+
+    uint8_t oldBuffer[OLD_BUFFER_SIZE];
+    uint32_t oldBufferStart = 0;
+    size_t oldBufferLength = 0;
+    uint8_t output[OUTPUT_BUFFER_SIZE];
+    size_t outputLength = 0;
+
+    bool parseHeader();
+    bool readVarint(uint8_t byte);
+    bool emit(uint8_t byte);
+    bool flushOutput();
+    bool oldByte(uint8_t &byte);
+    bool copyOld(uint32_t length);
+    bool fail(Error reason);
+};
+
+#endif // DELTAPATCHER_H
@@ -0,0 +1,438 @@
+#include "dsttable.h"
+
+static const int32_t SECONDS_PER_DAY = 86400;
+
+DstTable::DstTable()
+{
+}
+
+DstTable::~DstTable()
+{
+}
+
+bool DstTable::setRule(const char *posixTz)
+{
+    transitionCount = 0;
+    validFrom = 0;
+    validUntil = 0;
+    currentFrom = 0;
+    currentUntil = 0;
+    if (posixTz == nullptr)
+    {
+        return false;
+    }
+
+    // POSIX offsets count west of UTC, the table stores seconds east
+    int32_t offset;
+    const char *p = parseName(posixTz);
+    p = p ? parseOffset(p, offset) : nullptr;
+    if (p == nullptr)
+    {
+        return false;
+    }
+    stdOffset = -offset;
+    dstOffset = stdOffset;
+    baseOffset = stdOffset;
+    baseDst = false;
+    hasDst = false;
+
+    if (*p == '\0')
+    {
+        return true;
+    }
+
+    p = parseName(p);
+    if (p == nullptr)
+    {
+        return false;
+    }
+
+    dstOffset = stdOffset + 3600;
+    if (*p != ',' && *p != '\0')
+    {
+        p = parseOffset(p, offset);
+        if (p == nullptr)
+        {
+            return false;
+        }
+        dstOffset = -offset;
+    }
+
+    if (*p == '\0')
+    {
+        // no rule given, libc falls back to the US rules
+        start = {'M', 0, 3, 2, 7200};
+        end = {'M', 0, 11, 1, 7200};
+    }
+    else
+    {
+        p = parseRuleDate(p + 1, start);
+        if (p == nullptr || *p != ',')
+        {
+            return false;
+        }
+        p = parseRuleDate(p + 1, end);
+        if (p == nullptr || *p != '\0')
+        {
+            return false;
+        }
+    }
+
+    hasDst = true;
+    return true;
+}
+
+void DstTable::build(int year)
+{
+    transitionCount = 0;
+    currentFrom = 0;
+    currentUntil = 0;
+    if (!hasDst)
+    {
+        return;
+    }
+
+    for (int y = year; y <= year + 1; y++)
+    {
+        // each end of the period is written in the wall time in effect before it
+        transitions[transitionCount++] = {transitionTime(y, start, stdOffset), dstOffset, true};
+        transitions[transitionCount++] = {transitionTime(y, end, dstOffset), stdOffset, false};
+    }
+
+    for (uint8_t i = 1; i < transitionCount; i++)
+    {
+        Transition t = transitions[i];
+        uint8_t j = i;
+        for (; j > 0 && transitions[j - 1].at > t.at; j--)
+        {
+            transitions[j] = transitions[j - 1];
+        }
+        transitions[j] = t;
+    }
+
+    // before the first transition the zone is in the state the last one leaves it in
+    baseOffset = transitions[transitionCount - 1].offset;
+    baseDst = transitions[transitionCount - 1].dst;
+
+    time_t previousStart = transitionTime(year - 1, start, stdOffset);
+    time_t previousEnd = transitionTime(year - 1, end, dstOffset);
+    validFrom = previousStart > previousEnd ? previousStart : previousEnd;
+    time_t nextStart = transitionTime(year + 2, start, stdOffset);
+    time_t nextEnd = transitionTime(year + 2, end, dstOffset);
+    validUntil = nextStart < nextEnd ? nextStart : nextEnd;
+}
+
+const DstTable::Transition *DstTable::getTransition(uint8_t index) const
+{
+    if (index >= transitionCount)
+    {
+        return nullptr;
+    }
+
+    return &transitions[index];
+}
+
+const DstTable::Transition *DstTable::lookup(time_t utc)
+{
+    if (!hasDst)
+    {
+        return nullptr;
+    }
+
+    // the table is built for two years, rebuild once utc leaves them
+    if (transitionCount == 0 || utc < validFrom || utc >= validUntil)
+    {
+        struct tm date;
+        time_t local = utc + stdOffset;
+        gmtime_r(&local, &date);
+        build(date.tm_year + 1900);
+        if (utc < validFrom)
+        {
+            build(date.tm_year + 1899);
+        }
+    }
+
+    const Transition *match = nullptr;
+    for (uint8_t i = 0; i < transitionCount && transitions[i].at <= utc; i++)
+    {
+        match = &transitions[i];
+    }
+    return match;
+}
+
+void DstTable::resolve(time_t utc, int32_t &offset, bool &dst)
+{
+    if (utc >= currentFrom && utc < currentUntil)
+    {
+        offset = currentOffset;
+        dst = currentDst;
+        return;
+    }
+
+    const Transition *transition = lookup(utc);
+    offset = transition ? transition->offset : baseOffset;
+    dst = transition ? transition->dst : baseDst;
+    if (!hasDst)
+    {
+        return;
+    }
+
+    // remember the span up to the next transition, or the end of the table
+    uint8_t next = transition ? transition - transitions + 1 : 0;
+    currentFrom = transition ? transition->at : validFrom;
+    currentUntil = next < transitionCount ? transitions[next].at : validUntil;
+    currentOffset = offset;
+    currentDst = dst;
+}
+
+int32_t DstTable::offsetAt(time_t utc)
+{
+    int32_t offset;
+    bool dst;
+    resolve(utc, offset, dst);
+    return offset;
+}
+
+bool DstTable::isDstAt(time_t utc)
+{
+    int32_t offset;
+    bool dst;
+    resolve(utc, offset, dst);
+    return dst;
+}
+
+void DstTable::toLocal(time_t utc, struct tm &local)
+{
+    int32_t offset;
+    bool dst;
+    resolve(utc, offset, dst);
+
+    int64_t shifted = static_cast<int64_t>(utc) + offset;
+    int64_t day = shifted / SECONDS_PER_DAY;
+    int32_t second = static_cast<int32_t>(shifted - day * SECONDS_PER_DAY);
+    if (second < 0)
+    {
+        day--;
+        second += SECONDS_PER_DAY;
+    }
+    // the date only changes once a day, gmtime_r would work it out on every call
+    if (day != currentDay)
+    {
+        civilFromDays(day, currentDate);
+        currentDay = day;
+    }
+
+    local = currentDate;
+    local.tm_hour = second / 3600;
+    local.tm_min = second / 60 % 60;
+    local.tm_sec = second % 60;
+    local.tm_isdst = dst ? 1 : 0;
+}
+
+time_t DstTable::toUtc(const struct tm &local)
+{
+    int64_t days = daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, 1) + local.tm_mday - 1;
+    time_t wall = days * SECONDS_PER_DAY + local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+
+    // guess with the offset in effect a day earlier, then correct once
+    time_t utc = wall - offsetAt(wall - stdOffset - SECONDS_PER_DAY);
+    int32_t offset = offsetAt(utc);
+    if (utc + offset != wall)
+    {
+        time_t corrected = wall - offset;
+        // inside a gap the corrected guess falls back before the transition, keep the first guess
+        if (offsetAt(corrected) == offset)
+        {
+            utc = corrected;
+        }
+    }
+    return utc;
+}
+
+int64_t DstTable::daysFromCivil(int year, unsigned month, unsigned day)
+{
+    // days since 1970-01-01 in the proleptic Gregorian calendar
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yearOfEra = (unsigned)(year - era * 400);
+    const unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + (int64_t)dayOfEra - 719468;
+}
+
+void DstTable::civilFromDays(int64_t days, struct tm &date)
+{
+    // inverse of daysFromCivil
+    const int64_t shifted = days + 719468;
+    const int64_t era = (shifted >= 0 ? shifted : shifted - 146096) / 146097;
+    const unsigned dayOfEra = (unsigned)(shifted - era * 146097);
+    const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+    const unsigned month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    const int year = (int)(yearOfEra + era * 400) + (month <= 2);
+
+    date = {};
+    date.tm_year = year - 1900;
+    date.tm_mon = month - 1;
+    date.tm_mday = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    // 1970-01-01 was a Thursday
+    date.tm_wday = (int)(((days + 4) % 7 + 7) % 7);
+    date.tm_yday = (int)(days - daysFromCivil(year, 1, 1));
+}
+
+bool DstTable::isLeapYear(int year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+time_t DstTable::transitionTime(int year, const RuleDate &date, int32_t offsetBefore)
+{
+    static const uint8_t DAYS_IN_MONTH[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int64_t days = daysFromCivil(year, 1, 1);
+
+    switch (date.kind)
+    {
+    case 'J':
+        // Jn never counts February 29
+        days += date.day - 1 + (isLeapYear(year) && date.day >= 60 ? 1 : 0);
+        break;
+    case 'D':
+        days += date.day;
+        break;
+    default:
+    {
+        int64_t first = daysFromCivil(year, date.month, 1);
+        // 1970-01-01 was a Thursday
+        int firstWeekday = (int)(((first + 4) % 7 + 7) % 7);
+        int day = 1 + (date.day - firstWeekday + 7) % 7 + (date.week - 1) * 7;
+        int length = DAYS_IN_MONTH[date.month - 1] + (date.month == 2 && isLeapYear(year) ? 1 : 0);
+        while (day > length)
+        {
+            day -= 7;
+        }
+        days = first + day - 1;
+        break;
+    }
+    }
+
+    return (time_t)(days * SECONDS_PER_DAY + date.time - offsetBefore);
+}
+
+const char *DstTable::parseName(const char *p)
+{
+    const char *begin = p;
+    if (*p == '<')
+    {
+        while (*p != '\0' && *p != '>')
+        {
+            p++;
+        }
+        return *p == '>' && p - begin > 1 ? p + 1 : nullptr;
+    }
+
+    while ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z'))
+    {
+        p++;
+    }
+    return p - begin >= 3 ? p : nullptr;
+}
+
+const char *DstTable::parseOffset(const char *p, int32_t &seconds)
+{
+    int sign = 1;
+    if (*p == '+' || *p == '-')
+    {
+        sign = *p == '-' ? -1 : 1;
+        p++;
+    }
+
+    // hh[:mm[:ss]], rule times allow hours up to 167
+    int32_t parts[3] = {0, 0, 0};
+    for (int i = 0; i < 3; i++)
+    {
+        if (*p < '0' || *p > '9')
+        {
+            return nullptr;
+        }
+        while (*p >= '0' && *p <= '9')
+        {
+            parts[i] = parts[i] * 10 + (*p++ - '0');
+            if (parts[i] > 167)
+            {
+                return nullptr;
+            }
+        }
+        if (*p != ':' || i == 2)
+        {
+            break;
+        }
+        p++;
+    }
+
+    seconds = sign * (parts[0] * 3600 + parts[1] * 60 + parts[2]);
+    return p;
+}
+
+const char *DstTable::parseRuleDate(const char *p, RuleDate &date)
+{
+    date = {};
+    date.time = 7200; // 02:00 unless given
+
+    auto number = [&p](int &value) -> bool {
+        if (*p < '0' || *p > '9')
+        {
+            return false;
+        }
+        value = 0;
+        while (*p >= '0' && *p <= '9' && value < 1000)
+        {
+            value = value * 10 + (*p++ - '0');
+        }
+        return true;
+    };
+
+    int value;
+    if (*p == 'M')
+    {
+        int month, week, weekday;
+        p++;
+        if (!number(month) || *p++ != '.' || !number(week) || *p++ != '.' || !number(weekday))
+        {
+            return nullptr;
+        }
+        if (month < 1 || month > 12 || week < 1 || week > 5 || weekday > 6)
+        {
+            return nullptr;
+        }
+        date.kind = 'M';
+        date.month = month;
+        date.week = week;
+        date.day = weekday;
+    }
+    else if (*p == 'J')
+    {
+        p++;
+        if (!number(value) || value < 1 || value > 365)
+        {
+            return nullptr;
+        }
+        date.kind = 'J';
+        date.day = value;
+    }
+    else
+    {
+        if (!number(value) || value > 365)
+        {
+            return nullptr;
+        }
+        date.kind = 'D';
+        date.day = value;
+    }
+
+    if (*p == '/')
+    {
+        p = parseOffset(p + 1, date.time);
+    }
+    return p;
+}
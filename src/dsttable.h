@@ -0,0 +1,80 @@
+#ifndef DSTTABLE_H
+#define DSTTABLE_H
+
+#include <stdint.h>
+#include <time.h>
+
+// UTC offsets of one POSIX TZ rule, precomputed for the current and the next
+// year. Converting UTC to local time is then a lookup in at most four
+// transitions instead of going through setenv/tzset/localtime.
+// Kept free of Arduino dependencies so it can be checked against libc on the host.
+class DstTable
+{
+public:
+    static const uint8_t MAX_TRANSITIONS = 4;
+
+    struct Transition {
+        time_t at;      // UTC instant the offset takes effect
+        int32_t offset; // seconds east of UTC
+        bool dst;
+    };
+
+    DstTable();
+    ~DstTable();
+    // parses a POSIX TZ string (e.g. "CET-1CEST,M3.5.0,M10.5.0/3"), false if malformed
+    bool setRule(const char *posixTz);
+    // computes the transitions for year and year + 1
+    void build(int year);
+    int32_t offsetAt(time_t utc);
+    bool isDstAt(time_t utc);
+    void toLocal(time_t utc, struct tm &local);
+    // resolves local wall time, nonexistent times move forward, repeated ones take the first
+    time_t toUtc(const struct tm &local);
+    uint8_t getTransitionCount() const { return transitionCount; }
+    const Transition *getTransition(uint8_t index) const;
+
+    static int64_t daysFromCivil(int year, unsigned month, unsigned day);
+
+private:
+    // one end of the DST period as written in the rule
+    struct RuleDate {
+        char kind;     // 'J' julian without leap day, 'D' zero based day, 'M' month.week.weekday
+        uint16_t day;  // J: 1-365, D: 0-365, M: weekday 0-6
+        uint8_t month; // M only
+        uint8_t week;  // M only, 5 = last
+        int32_t time;  // seconds after local midnight, may be negative or beyond 24h
+    };
+
+    int32_t stdOffset = 0;
+    int32_t dstOffset = 0;
+    bool hasDst = false;
+    RuleDate start = {};
+    RuleDate end = {};
+
+    Transition transitions[MAX_TRANSITIONS];
+    uint8_t transitionCount = 0;
+    int32_t baseOffset = 0;
+    bool baseDst = false;
+    time_t validFrom = 0;
+    time_t validUntil = 0;
+
+    // the offset between two transitions, most calls land in the same one
+    time_t currentFrom = 0;
+    time_t currentUntil = 0;
+    int32_t currentOffset = 0;
+    bool currentDst = false;
+    // the date of the last local day toLocal() converted
+    int64_t currentDay = INT64_MIN;
+    struct tm currentDate = {};
+
+    const Transition *lookup(time_t utc);
+    void resolve(time_t utc, int32_t &offset, bool &dst);
+    static void civilFromDays(int64_t days, struct tm &date);
+    time_t transitionTime(int year, const RuleDate &date, int32_t offsetBefore);
+    static const char *parseName(const char *p);
+    static const char *parseOffset(const char *p, int32_t &seconds);
+    static const char *parseRuleDate(const char *p, RuleDate &date);
+    static bool isLeapYear(int year);
+};
+
+#endif // DSTTABLE_H
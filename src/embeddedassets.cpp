@@ -0,0 +1,49 @@
+#include "embeddedassets.h"
+#include <string.h>
+
+#ifdef WOC_EMBEDDED_ASSETS
+#include "webasset_data.h"
+#else
+static const EmbeddedAssets::Asset *const ASSETS = nullptr;
+static const size_t ASSET_COUNT = 0;
+#endif
+
+const EmbeddedAssets::Asset *EmbeddedAssets::find(const char *path)
+{
+    if (path == nullptr)
+    {
+        return nullptr;
+    }
+
+    size_t low = 0;
+    size_t high = ASSET_COUNT;
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        int cmp = strcmp(path, ASSETS[mid].path);
+        if (cmp == 0)
+        {
+            return &ASSETS[mid];
+        }
+
+        if (cmp < 0)
+        {
+            high = mid;
+        }
+        else
+        {
+            low = mid + 1;
+        }
+    }
+    return nullptr;
+}
+
+size_t EmbeddedAssets::count()
+{
+    return ASSET_COUNT;
+}
+
+const EmbeddedAssets::Asset *EmbeddedAssets::get(size_t index)
+{
+    return index < ASSET_COUNT ? &ASSETS[index] : nullptr;
+}
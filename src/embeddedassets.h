@@ -0,0 +1,28 @@
+#ifndef EMBEDDEDASSETS_H
+#define EMBEDDEDASSETS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Web assets compiled into the firmware (build flag WOC_EMBEDDED_ASSETS, data
+// generated by tools/webassets.py). The data is const and stays in mapped
+// flash, responses point straight at it. Without the flag the table is empty
+// and everything comes from LittleFS.
+class EmbeddedAssets
+{
+public:
+    struct Asset {
+        const char *path;        // as on LittleFS, e.g. "/style.css.gz"
+        const char *contentType; // of the decoded content
+        const char *etag;        // quoted content hash
+        const uint8_t *data;
+        uint32_t length;
+    };
+
+    // binary search by path, nullptr if the asset is not built in
+    static const Asset *find(const char *path);
+    static size_t count();
+    static const Asset *get(size_t index);
+};
+
+#endif // EMBEDDEDASSETS_H
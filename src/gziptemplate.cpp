@@ -0,0 +1,324 @@
+#include "gziptemplate.h"
+#include "configstore.h"
+#include <string.h>
+
+static const uint32_t CRC_POLYNOMIAL = 0xEDB88320;
+
+static uint32_t readLE32(const uint8_t *data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+static void writeLE32(uint8_t *data, uint32_t value)
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        data[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+// a * b modulo the CRC polynomial, bit reflected like the CRC itself; a must not be 0
+static uint32_t multiplyModP(uint32_t a, uint32_t b)
+{
+    uint32_t mask = 1u << 31;
+    uint32_t product = 0;
+    for (;;)
+    {
+        if (a & mask)
+        {
+            product ^= b;
+            if ((a & (mask - 1)) == 0)
+            {
+                break;
+            }
+        }
+        mask >>= 1;
+        b = b & 1 ? (b >> 1) ^ CRC_POLYNOMIAL : b >> 1;
+    }
+    return product;
+}
+
+// x^(8 * bytes) modulo the CRC polynomial, from a table of x^(2^k)
+static uint32_t shiftBytes(uint32_t bytes)
+{
+    struct PowerTable
+    {
+        uint32_t powers[32];
+        PowerTable()
+        {
+            uint32_t power = 1u << 30; // x^1
+            for (uint8_t k = 0; k < 32; k++)
+            {
+                powers[k] = power;
+                power = multiplyModP(power, power);
+            }
+        }
+    };
+    static const PowerTable TABLE;
+
+    uint32_t result = 1u << 31; // x^0
+    for (uint8_t k = 3; bytes != 0; bytes >>= 1, k++)
+    {
+        if (bytes & 1)
+        {
+            result = multiplyModP(TABLE.powers[k & 31], result);
+        }
+    }
+    return result;
+}
+
+uint32_t GzipTemplate::crc32Combine(uint32_t crcA, uint32_t crcB, uint32_t lengthB)
+{
+    // a few hundred shifts instead of running the CRC over the text again
+    return multiplyModP(shiftBytes(lengthB), crcA) ^ crcB;
+}
+
+void GzipTemplate::reset()
+{
+    segments.clear();
+    state = Header;
+    recordLength = 0;
+    recordSize = HEADER_SIZE;
+    segmentCount = 0;
+    position = 0;
+    dataStart = 0;
+    dataSize = 0;
+}
+
+void GzipTemplate::feed(const uint8_t *chunk, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        if (state == Data)
+        {
+            position += length - i;
+            return;
+        }
+        if (state == Invalid)
+        {
+            return;
+        }
+
+        record[recordLength++] = chunk[i];
+        position++;
+        if (recordLength == recordSize)
+        {
+            parseRecord();
+            recordLength = 0;
+        }
+    }
+}
+
+void GzipTemplate::parseRecord()
+{
+    switch (state)
+    {
+    case Header:
+        if (memcmp(record, "WGZT", 4) != 0 || (record[4] | (record[5] << 8)) != VERSION)
+        {
+            state = Invalid;
+            return;
+        }
+        segmentCount = record[6] | (record[7] << 8);
+        segments.reserve(segmentCount);
+        nextSegment();
+        break;
+    case Kind:
+        if (record[0] == 0)
+        {
+            state = Literal;
+            recordSize = LITERAL_SIZE;
+        }
+        else if (record[0] == 1)
+        {
+            state = NameLength;
+            recordSize = 1;
+        }
+        else
+        {
+            state = Invalid;
+        }
+        break;
+    case Literal:
+    {
+        // offsets are relative to the data until the table is complete
+        Segment segment = {dataSize, readLE32(record), readLE32(record + 4), readLE32(record + 8), PageTemplate::Literal};
+        dataSize += segment.length;
+        segments.push_back(segment);
+        nextSegment();
+        break;
+    }
+    case NameLength:
+        if (record[0] == 0 || record[0] > PageTemplate::MAX_NAME)
+        {
+            state = Invalid;
+            return;
+        }
+        state = Name;
+        recordSize = record[0];
+        break;
+    case Name:
+        segments.push_back({0, 0, 0, 0, PageTemplate::findVariable(reinterpret_cast<const char *>(record), recordSize)});
+        nextSegment();
+        break;
+    default:
+        break;
+    }
+}
+
+void GzipTemplate::nextSegment()
+{
+    if (segments.size() < segmentCount)
+    {
+        state = Kind;
+        recordSize = 1;
+        return;
+    }
+    dataStart = position;
+    for (Segment &segment : segments)
+    {
+        if (segment.variable == PageTemplate::Literal)
+        {
+            segment.offset += dataStart;
+        }
+    }
+    state = Data;
+}
+
+bool GzipTemplate::finish()
+{
+    if (state != Data || position != dataStart + dataSize)
+    {
+        segments.clear();
+        state = Invalid;
+        return false;
+    }
+    return true;
+}
+
+GzipRenderer::GzipRenderer(const GzipTemplate &page, const GzipTemplate &header, const uint8_t *headerData)
+    : page(page), header(header), headerData(headerData)
+{
+}
+
+void GzipRenderer::startPending(size_t length)
+{
+    pendingLength = length;
+    pendingOffset = 0;
+}
+
+size_t GzipRenderer::read(uint8_t *buffer, size_t length)
+{
+    size_t written = 0;
+    while (written < length && !done)
+    {
+        if (pendingOffset < pendingLength)
+        {
+            size_t count = pendingLength - pendingOffset;
+            if (count > length - written)
+            {
+                count = length - written;
+            }
+            memcpy(buffer + written, pending + pendingOffset, count);
+            pendingOffset += count;
+            written += count;
+            continue;
+        }
+        if (ended)
+        {
+            done = true;
+            break;
+        }
+        if (!started)
+        {
+            // deflate, no name or time stamp, unknown OS
+            static const uint8_t GZIP_HEADER[10] = {0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF};
+            memcpy(pending, GZIP_HEADER, sizeof(GZIP_HEADER));
+            startPending(sizeof(GZIP_HEADER));
+            started = true;
+            continue;
+        }
+
+        const GzipTemplate &current = inHeader ? header : page;
+        size_t &index = inHeader ? headerIndex : pageIndex;
+        if (index >= current.getSegmentCount())
+        {
+            if (inHeader)
+            {
+                inHeader = false;
+                pageIndex++;
+                continue;
+            }
+            // empty final stored block, then the gzip trailer
+            static const uint8_t FINAL_BLOCK[STORED_HEADER] = {0x01, 0x00, 0x00, 0xFF, 0xFF};
+            memcpy(pending, FINAL_BLOCK, sizeof(FINAL_BLOCK));
+            writeLE32(pending + STORED_HEADER, crc);
+            writeLE32(pending + STORED_HEADER + 4, size);
+            startPending(STORED_HEADER + 8);
+            ended = true;
+            continue;
+        }
+
+        const GzipTemplate::Segment &segment = current.getSegments()[index];
+        if (segment.variable == PageTemplate::Literal)
+        {
+            size_t count = segment.length - progress;
+            if (count > length - written)
+            {
+                count = length - written;
+            }
+            if (inHeader)
+            {
+                memcpy(buffer + written, headerData + segment.offset + progress, count);
+            }
+            else
+            {
+                count = readPage(segment.offset + progress, buffer + written, count);
+                if (count == 0)
+                {
+                    done = true;
+                    failed = true;
+                    break;
+                }
+            }
+            written += count;
+            progress += count;
+            if (progress == segment.length)
+            {
+                crc = GzipTemplate::crc32Combine(crc, segment.crc, segment.rawLength);
+                size += segment.rawLength;
+                progress = 0;
+                index++;
+            }
+        }
+        else if (segment.variable == PageTemplate::IncludeHeader && !inHeader && headerData != nullptr)
+        {
+            inHeader = true;
+            headerIndex = 0;
+        }
+        else
+        {
+            char *value = reinterpret_cast<char *>(pending + STORED_HEADER);
+            size_t valueLength = segment.variable == PageTemplate::Unknown ? 0 : writeVariable(segment.variable, value, VALUE_SIZE);
+            if (valueLength > VALUE_SIZE)
+            {
+                valueLength = VALUE_SIZE;
+            }
+            index++;
+            if (valueLength == 0)
+            {
+                continue;
+            }
+            // values go out as stored blocks, byte aligned like the deflated spans
+            pending[0] = 0x00;
+            pending[1] = valueLength & 0xFF;
+            pending[2] = valueLength >> 8;
+            pending[3] = ~pending[1];
+            pending[4] = ~pending[2];
+            crc = ConfigStore::crc32(pending + STORED_HEADER, valueLength, crc);
+            size += valueLength;
+            startPending(STORED_HEADER + valueLength);
+        }
+    }
+    return written;
+}
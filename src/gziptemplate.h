@@ -0,0 +1,109 @@
+#ifndef GZIPTEMPLATE_H
+#define GZIPTEMPLATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "pagetemplate.h"
+
+// A page template prepared by tools/webassets.py (.gzt): literal spans are
+// deflated one by one at build time, so a page can be sent gzip encoded by
+// splicing the values in between as stored blocks.
+class GzipTemplate
+{
+public:
+    struct Segment {
+        uint32_t offset;    // deflated span in the file, Literal only
+        uint32_t length;
+        uint32_t rawLength; // text length and CRC-32, needed for the gzip trailer
+        uint32_t crc;
+        PageTemplate::Variable variable;
+    };
+
+    static const uint16_t VERSION = 1;
+
+    // CRC-32 of a + b from the CRC-32 of both parts and the length of b
+    static uint32_t crc32Combine(uint32_t crcA, uint32_t crcB, uint32_t lengthB);
+
+    // parses the segment table from chunks of any size, the deflated data after it is skipped
+    void reset();
+    void feed(const uint8_t *chunk, size_t length);
+    // false unless the table was valid and the file has exactly the data it lists
+    bool finish();
+
+    const Segment *getSegments() const { return segments.data(); }
+    size_t getSegmentCount() const { return segments.size(); }
+    bool isEmpty() const { return segments.empty(); }
+
+private:
+    enum ParseState : uint8_t {
+        Header,
+        Kind,
+        Literal,
+        NameLength,
+        Name,
+        Data,
+        Invalid
+    };
+
+    static const uint8_t HEADER_SIZE = 8;
+    static const uint8_t LITERAL_SIZE = 12;
+
+    std::vector<Segment> segments;
+    ParseState state = Header;
+    uint8_t record[PageTemplate::MAX_NAME];
+    uint8_t recordLength = 0;
+    uint8_t recordSize = HEADER_SIZE;
+    uint16_t segmentCount = 0;
+    uint32_t position = 0;
+    uint32_t dataStart = 0;
+    uint32_t dataSize = 0;
+
+    void parseRecord();
+    void nextSegment();
+};
+
+// Streams a complete gzip member for a .gzt page, expanding IncludeHeader with
+// a second .gzt whose file is held in RAM. Subclasses supply the page file and
+// the values, the interface matches TemplateRenderer.
+class GzipRenderer
+{
+public:
+    static const size_t VALUE_SIZE = TemplateRenderer::VALUE_SIZE;
+
+    GzipRenderer(const GzipTemplate &page, const GzipTemplate &header, const uint8_t *headerData);
+    virtual ~GzipRenderer() {}
+
+    // fills up to length bytes, returns 0 once the gzip trailer is out
+    size_t read(uint8_t *buffer, size_t length);
+    bool hasFailed() const { return failed; }
+
+protected:
+    virtual size_t readPage(uint32_t offset, uint8_t *buffer, size_t length) = 0;
+    virtual size_t writeVariable(PageTemplate::Variable variable, char *buffer, size_t length) = 0;
+
+private:
+    // stored block header: BFINAL/BTYPE byte, LEN, NLEN
+    static const uint8_t STORED_HEADER = 5;
+
+    const GzipTemplate &page;
+    const GzipTemplate &header;
+    const uint8_t *headerData;
+    bool started = false;
+    bool inHeader = false;
+    bool ended = false;
+    bool done = false;
+    bool failed = false;
+    size_t pageIndex = 0;
+    size_t headerIndex = 0;
+    uint32_t progress = 0;
+    uint32_t crc = 0;
+    uint32_t size = 0;
+    uint8_t pending[STORED_HEADER + VALUE_SIZE];
+    size_t pendingLength = 0;
+    size_t pendingOffset = 0;
+
+    void startPending(size_t length);
+};
+
+#endif // GZIPTEMPLATE_H
@@ -9,12 +9,16 @@ const char WoC_MQTT::NAME_OPTION1[] PROGMEM = "Option 1";
 const char WoC_MQTT::NAME_OPTION2[] PROGMEM = "Option 2";
 const char WoC_MQTT::NAME_OPTION3[] PROGMEM = "Option 3";
 const char WoC_MQTT::NAME_OPTION4[] PROGMEM = "Option 4";
+const char WoC_MQTT::NAME_SUNRISE[] PROGMEM = "Sunrise";
+const char WoC_MQTT::NAME_SUNSET[] PROGMEM = "Sunset";
 
 // // Static callback forwarders
 void WoC_MQTT::onMqttConnectedStatic()
 {
     if (instance && instance->mqttEventCallback)
     {
+        // subscriptions do not survive a reconnect
+        instance->haMqtt->subscribe(instance->timeTopic);
         instance->mqttEventCallback(MQTTEvent::Connected, nullptr);
     }
 }
@@ -94,6 +98,21 @@ void WoC_MQTT::onSwitchCommandStatic(bool state, HASwitch *sender)
     }
 }
 
+void WoC_MQTT::onMessageStatic(const char *topic, const uint8_t *payload, uint16_t length)
+{
+    if (instance && instance->mqttEventCallback && strcmp(topic, instance->timeTopic) == 0)
+    {
+        char value[24];
+        if (length >= sizeof(value))
+        {
+            return;
+        }
+        memcpy(value, payload, length);
+        value[length] = '\0';
+        instance->mqttEventCallback(MQTTEvent::TimeMessage, value);
+    }
+}
+
 WoC_MQTT::WoC_MQTT(WiFiClient &client, const char *devicename, const char *firmware) //: device(), mqtt(client, device)
 {
     // Set the static instance pointer
@@ -154,9 +173,12 @@ void WoC_MQTT::connect(IPAddress host, MqttEventCallback eventCallback, const ch
     {
         haMqtt->setDataPrefix(Defaults::DEFAULT_MQTT_TOPIC);
     }
+    // Home Assistant publishes the unix time here, e.g. from an automation every few minutes
+    snprintf(timeTopic, sizeof(timeTopic), "%s%s", topic ? topic : Defaults::DEFAULT_MQTT_TOPIC, TIME_TOPIC_SUFFIX);
 
     // callbacks and components setup
     haMqtt->onConnected(onMqttConnectedStatic);
+    haMqtt->onMessage(onMessageStatic);
     haMqtt->onDisconnected(onMqttConnectedStatic);
     setupHomeAssistant();
 
@@ -187,6 +209,7 @@ void WoC_MQTT::disconnect()
     disableHomeAssistant();
     haMqtt->onConnected(nullptr);
     haMqtt->onDisconnected(nullptr);
+    haMqtt->onMessage(nullptr);
     mqttEventCallback = nullptr;
 }
 
@@ -229,6 +252,8 @@ void WoC_MQTT::setupHomeAssistant()
     snprintf(idOption2, sizeof(idOption2), ID_PATTERN, uniqueid, ID_OPTION2);
     snprintf(idOption3, sizeof(idOption3), ID_PATTERN, uniqueid, ID_OPTION3);
     snprintf(idOption4, sizeof(idOption4), ID_PATTERN, uniqueid, ID_OPTION4);
+    snprintf(idSunrise, sizeof(idSunrise), ID_PATTERN, uniqueid, ID_SUNRISE);
+    snprintf(idSunset, sizeof(idSunset), ID_PATTERN, uniqueid, ID_SUNSET);
 
     light = new HALight(idLeds, HALight::BrightnessFeature | HALight::RGBFeature);
     light->onBrightnessCommand(onBrightnessCommandStatic);
@@ -244,6 +269,14 @@ void WoC_MQTT::setupHomeAssistant()
     autoBrightness->onCommand(onSwitchCommandStatic);
     autoBrightness->setName(NAME_AUTO_BRIGHTNESS);
 
+    sunrise = new HASensor(idSunrise);
+    sunrise->setName(NAME_SUNRISE);
+    sunrise->setIcon("mdi:weather-sunset-up");
+
+    sunset = new HASensor(idSunset);
+    sunset->setName(NAME_SUNSET);
+    sunset->setIcon("mdi:weather-sunset-down");
+
     if (useOptions)
     {
         option1 = new HASwitch(idOption1);
@@ -278,6 +311,14 @@ void WoC_MQTT::disableHomeAssistant()
         delete autoBrightness;
         autoBrightness = nullptr;
     }
+    if (sunrise) {
+        delete sunrise;
+        sunrise = nullptr;
+    }
+    if (sunset) {
+        delete sunset;
+        sunset = nullptr;
+    }
     if (useOptions) {
         if (option1) {
             delete option1;
@@ -351,6 +392,16 @@ void WoC_MQTT::setLightSensorValue(const uint16_t sensorValue)
     lightSensor->setValue(sensorValue);
 }
 
+void WoC_MQTT::setSunTimes(const char *sunriseTime, const char *sunsetTime)
+{
+    if (!isInitialized || !sunrise || !sunset)
+    {
+        return;
+    }
+    sunrise->setValue(sunriseTime);
+    sunset->setValue(sunsetTime);
+}
+
 void WoC_MQTT::toggleAutoBrightness(bool state)
 {
     if (!isInitialized || !autoBrightness)
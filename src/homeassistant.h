@@ -20,6 +20,8 @@ class WoC_MQTT
         static const char NAME_OPTION2[] PROGMEM;
         static const char NAME_OPTION3[] PROGMEM;
         static const char NAME_OPTION4[] PROGMEM;
+        static const char NAME_SUNRISE[] PROGMEM;
+        static const char NAME_SUNSET[] PROGMEM;
 
         static constexpr const char* ID_PATTERN = "%s_%s";
         static constexpr const char* ID_DEVICE = "woc";
@@ -30,6 +32,9 @@ class WoC_MQTT
         static constexpr const char* ID_OPTION2 = "option2";
         static constexpr const char* ID_OPTION3 = "option3";
         static constexpr const char* ID_OPTION4 = "option4";
+        static constexpr const char* ID_SUNRISE = "sunrise";
+        static constexpr const char* ID_SUNSET = "sunset";
+        static constexpr const char* TIME_TOPIC_SUFFIX = "/time";
 
         //because of how the ArduinoHA lib is built, we need to run this class as singleton
         static WoC_MQTT* instance;
@@ -40,6 +45,7 @@ class WoC_MQTT
         static void onRGBCommandStatic(HALight::RGBColor color, HALight* sender);
         static void onStateCommandStatic(bool state, HALight* sender);
         static void onSwitchCommandStatic(bool state, HASwitch* sender);
+        static void onMessageStatic(const char* topic, const uint8_t* payload, uint16_t length);
     
         HAMqtt *haMqtt;
         HADevice *device;
@@ -50,6 +56,8 @@ class WoC_MQTT
         HASwitch *option2 = nullptr;
         HASwitch *option3 = nullptr;
         HASwitch *option4 = nullptr;
+        HASensor *sunrise = nullptr;
+        HASensor *sunset = nullptr;
 
         MqttEventCallback mqttEventCallback;
 
@@ -66,6 +74,9 @@ class WoC_MQTT
         char idOption2[17]; // uniqueid + '_option2' + null terminator (1)
         char idOption3[17]; // uniqueid + '_option3' + null terminator (1)
         char idOption4[17]; // uniqueid + '_option4' + null terminator (1)
+        char idSunrise[17]; // uniqueid + '_sunrise' + null terminator (1)
+        char idSunset[16]; // uniqueid + '_sunset' + null terminator (1)
+        char timeTopic[70]; // topic (63) + '/time' + null terminator (1)
 
         // helper methods
         void setupHomeAssistant();
@@ -81,6 +92,8 @@ class WoC_MQTT
         void setLightBrightness(uint8_t brightness);
         void setLightSensorValue(const uint16_t sensorValue);
         void toggleAutoBrightness(bool state);
+        // local "HH:MM", empty when the sun does not rise or set
+        void setSunTimes(const char* sunriseTime, const char* sunsetTime);
         void toggleOption1(bool state);
         void toggleOption2(bool state);
         void toggleOption3(bool state);
@@ -0,0 +1,164 @@
+#include "httpdateprobe.h"
+#include <errno.h>
+#include <lwip/sockets.h>
+#include "timeformats.h"
+
+HttpDateProbe::HttpDateProbe()
+{
+}
+
+HttpDateProbe::~HttpDateProbe()
+{
+    cancel();
+}
+
+void HttpDateProbe::setHost(IPAddress host, uint16_t port)
+{
+    this->host = host;
+    this->port = port;
+}
+
+void HttpDateProbe::request(uint32_t nowMs)
+{
+    cancel();
+    if (!WiFi.isConnected())
+    {
+        return;
+    }
+
+    target = host == IPAddress() ? WiFi.gatewayIP() : host;
+    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0)
+    {
+        return;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = static_cast<uint32_t>(target);
+    if (connect(sock, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0 && errno != EINPROGRESS)
+    {
+        cancel();
+        return;
+    }
+
+    connectMs = nowMs;
+    lineLength = 0;
+    state = Connecting;
+}
+
+bool HttpDateProbe::poll(uint32_t nowMs, TimeSample &sample)
+{
+    if (state == Connecting && !connected(nowMs))
+    {
+        return false;
+    }
+    if (state != Waiting)
+    {
+        return false;
+    }
+    return readHeaders(sample);
+}
+
+// sends the request once the socket is writable, false while it is still connecting
+bool HttpDateProbe::connected(uint32_t nowMs)
+{
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(sock, &writable);
+    struct timeval noWait = {0, 0};
+    if (select(sock + 1, nullptr, &writable, nullptr, &noWait) <= 0)
+    {
+        if (nowMs - connectMs >= CONNECT_TIMEOUT_MS)
+        {
+            cancel();
+        }
+        return false;
+    }
+
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0)
+    {
+        cancel();
+        return false;
+    }
+
+    char request[80];
+    int requestLength = snprintf(request, sizeof(request), "HEAD / HTTP/1.0\r\nHost: %s\r\nConnection: close\r\n\r\n",
+                                 target.toString().c_str());
+    if (send(sock, request, requestLength, 0) != requestLength)
+    {
+        cancel();
+        return false;
+    }
+    sentMs = millis();
+    state = Waiting;
+    return true;
+}
+
+bool HttpDateProbe::readHeaders(TimeSample &sample)
+{
+    char buffer[64];
+    while (true)
+    {
+        int received = recv(sock, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return false;
+        }
+        if (received <= 0)
+        {
+            // closed or failed before a Date header came
+            cancel();
+            return false;
+        }
+
+        for (int i = 0; i < received; i++)
+        {
+            char c = buffer[i];
+            if (c != '\n')
+            {
+                if (c != '\r' && lineLength < LINE_LENGTH - 1)
+                {
+                    line[lineLength++] = c;
+                }
+                continue;
+            }
+
+            line[lineLength] = '\0';
+            bool endOfHeaders = lineLength == 0;
+            lineLength = 0;
+            time_t utc;
+            if (strncasecmp(line, "Date:", 5) == 0 && TimeFormats::parseHttpDate(line + 5 + strspn(line + 5, " "), utc))
+            {
+                const uint32_t receivedMs = millis();
+                const uint32_t roundTrip = receivedMs - sentMs;
+                cancel();
+                // the header truncates to the second, assume the middle of it
+                sample.utcMs = static_cast<int64_t>(utc) * 1000 + 500 + roundTrip / 2;
+                sample.localMs = receivedMs;
+                sample.errorMs = 500 + roundTrip / 2;
+                return true;
+            }
+
+            if (endOfHeaders)
+            {
+                cancel();
+                return false;
+            }
+        }
+    }
+}
+
+void HttpDateProbe::cancel()
+{
+    state = Idle;
+    if (sock >= 0)
+    {
+        close(sock);
+        sock = -1;
+    }
+}
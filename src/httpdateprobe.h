@@ -0,0 +1,44 @@
+#ifndef HTTPDATEPROBE_H
+#define HTTPDATEPROBE_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "itimeprobe.h"
+
+// Reads the Date header of a HEAD request to a local HTTP server (the
+// gateway unless set). Only second resolution, but independent of NTP.
+class HttpDateProbe : public ITimeProbe
+{
+private:
+    static const uint16_t CONNECT_TIMEOUT_MS = 500;
+    static const size_t LINE_LENGTH = 96;
+    enum State : uint8_t {
+        Idle = 0,
+        Connecting,  // the socket connects in the background, poll() checks it
+        Waiting      // request sent, reading the response headers
+    };
+    IPAddress host;
+    uint16_t port = 80;
+    // a plain lwIP socket, WiFiClient::connect() blocks until connected
+    int sock = -1;
+    IPAddress target;
+    char line[LINE_LENGTH];
+    size_t lineLength = 0;
+    uint32_t connectMs = 0;
+    uint32_t sentMs = 0;
+    State state = Idle;
+
+    bool connected(uint32_t nowMs);
+    bool readHeaders(TimeSample &sample);
+
+public:
+    HttpDateProbe();
+    ~HttpDateProbe();
+    void setHost(IPAddress host, uint16_t port = 80);
+    const char *getName() const override { return "http"; }
+    void request(uint32_t nowMs) override;
+    bool poll(uint32_t nowMs, TimeSample &sample) override;
+    void cancel() override;
+};
+
+#endif // HTTPDATEPROBE_H
@@ -0,0 +1,19 @@
+#ifndef IKEYVALUESTORE_H
+#define IKEYVALUESTORE_H
+
+#include <stddef.h>
+
+// Blob storage behind ConfigStore: NVS Preferences on the device, a map in
+// the host tests.
+class IKeyValueStore {
+public:
+    virtual ~IKeyValueStore() = default;
+    // 0 if the key does not exist
+    virtual size_t getLength(const char *key) = 0;
+    virtual size_t read(const char *key, void *buffer, size_t length) = 0;
+    virtual size_t write(const char *key, const void *buffer, size_t length) = 0;
+    // removes every key of the store
+    virtual bool clear() = 0;
+};
+
+#endif // IKEYVALUESTORE_H
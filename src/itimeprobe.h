@@ -0,0 +1,28 @@
+#ifndef ITIMEPROBE_H
+#define ITIMEPROBE_H
+
+#include <stdint.h>
+
+// One reading of a network time reference: UTC in milliseconds as it was at
+// the local millis() value localMs, true within +/- errorMs.
+struct TimeSample {
+    int64_t utcMs;
+    uint32_t localMs;
+    uint32_t errorMs;
+};
+
+// A time reference the TimeArbiter can query. Queries are asynchronous so all
+// probes of a round run in parallel; tests replace probes with local stand-ins.
+class ITimeProbe {
+public:
+    virtual ~ITimeProbe() = default;
+    virtual const char *getName() const = 0;
+    // starts a query, passive probes may ignore it
+    virtual void request(uint32_t nowMs) = 0;
+    // true once, when the answer to the current query is available
+    virtual bool poll(uint32_t nowMs, TimeSample &sample) = 0;
+    // drops an unanswered query
+    virtual void cancel() {}
+};
+
+#endif // ITIMEPROBE_H
@@ -0,0 +1,19 @@
+#ifndef ITIMESOURCE_H
+#define ITIMESOURCE_H
+
+#include <time.h>
+
+// A source of UTC wall clock time. WClock reads its displayed time from one
+// source (RTC, software clock or virtual) and synchronizes it through the
+// TimeArbiter from the network references.
+class ITimeSource {
+public:
+    virtual ~ITimeSource() = default;
+    virtual bool begin() = 0;
+    // false if the source currently has no valid time
+    virtual bool now(time_t &utc) = 0;
+    // sources that keep time themselves can be set, others ignore it
+    virtual bool adjust(time_t) { return false; }
+};
+
+#endif // ITIMESOURCE_H
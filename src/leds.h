@@ -27,6 +27,11 @@ public:
     void unregisterIlluminanceSensorCallback();
     void test();
     void loop();
+    // as shown, follows the sensor with auto brightness
+    uint8_t getBrightness() const { return brightness; }
+    uint16_t getIlluminance() const { return illuminance; }
+    uint32_t getLastRenderDurationUs() const { return lastRenderDurationUs; }
+    uint32_t getMaxRenderDurationUs() const { return maxRenderDurationUs; }
     static String RGBtoHex(const CRGB& color);
     static CRGB HexToRGB(const String& hex);
 private:
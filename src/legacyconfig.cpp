@@ -0,0 +1,143 @@
+#include "legacyconfig.h"
+#include <string.h>
+#include "defaults.h"
+
+const char LegacyConfig::SYSTEM_NAMESPACE[] = "system";
+const char LegacyConfig::LIGHT_NAMESPACE[] = "light";
+
+// System Preferences Keys
+const char LegacyConfig::IS_INITIALIZED_KEY[]      = "is_init";
+const char LegacyConfig::CLOCK_MODE_KEY[]          = "clock_mode";
+const char LegacyConfig::WIFI_SSID_KEY[]           = "wifi_ssid";
+const char LegacyConfig::WIFI_PASSWORD_KEY[]       = "wifi_pass";
+const char LegacyConfig::MQTT_ENABLED_KEY[]        = "mqtt_nbld";
+const char LegacyConfig::MQTT_HOST_KEY[]           = "mqtt_host";
+const char LegacyConfig::MQTT_PORT_KEY[]           = "mqtt_port";
+const char LegacyConfig::MQTT_USERNAME_KEY[]       = "mqtt_user";
+const char LegacyConfig::MQTT_PASSWORD_KEY[]       = "mqtt_pass";
+const char LegacyConfig::MQTT_TOPIC_KEY[]          = "mqtt_tpc";
+const char LegacyConfig::NTP_ENABLED_KEY[]         = "ntp_nbld";
+const char LegacyConfig::NTP_TIMEZONE_KEY[]        = "ntp_tz";
+const char LegacyConfig::NTP_SERVER_KEY[]          = "ntp_srv";
+const char LegacyConfig::NTP_UPDATE_ENABLED_KEY[]  = "ntp_upd_nbld";
+const char LegacyConfig::NTP_UPDATE_INTERVAL_KEY[] = "ntp_upd_itvl";
+const char LegacyConfig::LOCATION_ENABLED_KEY[]    = "loc_nbld";
+const char LegacyConfig::LOCATION_LATITUDE_KEY[]   = "loc_lat";
+const char LegacyConfig::LOCATION_LONGITUDE_KEY[]  = "loc_lon";
+
+// Light Preferences Keys
+const char LegacyConfig::LIGHT_SCHEDULE_ENABLED_KEY[]      = "ls_nbld";
+const char LegacyConfig::LIGHT_SCHEDULE_START_TIME_KEY[]   = "ls_start_t";
+const char LegacyConfig::LIGHT_SCHEDULE_END_TIME_KEY[]     = "ls_end_t";
+const char LegacyConfig::LIGHT_SCHEDULE_RULES_KEY[]        = "ls_rules";
+const char LegacyConfig::AUTO_BRIGHTNESS_ENABLED_KEY[]     = "ab_nbld";
+const char LegacyConfig::AUTO_BRIGHTNESS_THRESH_HIGH_KEY[] = "ab_thrsh_hi";
+const char LegacyConfig::AUTO_BRIGHTNESS_THRESH_LOW_KEY[]  = "ab_thrsh_lo";
+const char LegacyConfig::LIGHT_BRIGHTNESS_KEY[]            = "lght_brightn";
+const char LegacyConfig::LIGHT_COLOR_KEY[]                 = "lght_color";
+const char LegacyConfig::LIGHT_STATE_KEY[]                 = "lght_state";
+
+bool LegacyConfig::read(ILegacyPreferences &system, ILegacyPreferences &light, ConfigData &data) {
+    if (!system.getBool(IS_INITIALIZED_KEY, false)) {
+        return false;
+    }
+    ConfigData::setDefaults(data);
+    data.system.mode = loadClockMode(system);
+    data.system.mqttConfig = loadMqttConfig(system);
+    data.system.ntpConfig = loadNtpConfig(system);
+    data.system.locationConfig = loadLocationConfig(system);
+    data.system.lightScheduleConfig = loadLightSchedule(light);
+    data.light = loadLightConfig(light);
+    data.wifi = loadWifiConfig(system);
+    return true;
+}
+
+ConfigData::ClockMode LegacyConfig::loadClockMode(ILegacyPreferences &prefs) {
+    uint32_t mode = prefs.getUInt(CLOCK_MODE_KEY, static_cast<uint32_t>(ConfigData::Regular));
+    return static_cast<ConfigData::ClockMode>(mode);
+}
+
+ConfigData::WifiConfig LegacyConfig::loadWifiConfig(ILegacyPreferences &prefs) {
+    ConfigData::WifiConfig config = {};
+    prefs.getBytes(WIFI_SSID_KEY, config.ssid, sizeof(config.ssid));
+    prefs.getBytes(WIFI_PASSWORD_KEY, config.password, sizeof(config.password));
+    return config;
+}
+
+ConfigData::MqttConfig LegacyConfig::loadMqttConfig(ILegacyPreferences &prefs) {
+    ConfigData::MqttConfig config = {};
+    config.enabled = prefs.getBool(MQTT_ENABLED_KEY, Defaults::DEFAULT_MQTT_ENABLED);
+    prefs.getBytes(MQTT_HOST_KEY, config.host, sizeof(config.host));
+    config.port = prefs.getUInt(MQTT_PORT_KEY, Defaults::DEFAULT_MQTT_PORT);
+    prefs.getBytes(MQTT_USERNAME_KEY, config.username, sizeof(config.username));
+    prefs.getBytes(MQTT_PASSWORD_KEY, config.password, sizeof(config.password));
+    prefs.getBytes(MQTT_TOPIC_KEY, config.topic, sizeof(config.topic));
+    return config;
+}
+
+ConfigData::NtpConfig LegacyConfig::loadNtpConfig(ILegacyPreferences &prefs) {
+    ConfigData::NtpConfig config = {};
+    config.enabled = prefs.getBool(NTP_ENABLED_KEY, Defaults::DEFAULT_NTP_ENABLED);
+    config.interval = prefs.getULong(NTP_UPDATE_INTERVAL_KEY, Defaults::DEFAULT_NTP_UPDATE_INTERVAL);
+    if (prefs.getBytes(NTP_TIMEZONE_KEY, config.timezone, sizeof(config.timezone)) == 0) {
+        ConfigData::copyString(config.timezone, Defaults::DEFAULT_NTP_TIMEZONE, sizeof(config.timezone));
+    }
+    if (prefs.getBytes(NTP_SERVER_KEY, config.server, sizeof(config.server)) == 0) {
+        ConfigData::copyString(config.server, Defaults::DEFAULT_NTP_SERVER, sizeof(config.server));
+    }
+    return config;
+}
+
+ConfigData::LocationConfig LegacyConfig::loadLocationConfig(ILegacyPreferences &prefs) {
+    ConfigData::LocationConfig config = {};
+    config.enabled = prefs.getBool(LOCATION_ENABLED_KEY, Defaults::DEFAULT_LOCATION_ENABLED);
+    config.latitude = prefs.getFloat(LOCATION_LATITUDE_KEY, Defaults::DEFAULT_LATITUDE);
+    config.longitude = prefs.getFloat(LOCATION_LONGITUDE_KEY, Defaults::DEFAULT_LONGITUDE);
+    return config;
+}
+
+ConfigData::LightScheduleConfig LegacyConfig::loadLightSchedule(ILegacyPreferences &prefs) {
+    ConfigData::LightScheduleConfig schedule;
+    memset(&schedule, 0, sizeof(schedule));
+    schedule.enabled = prefs.getBool(LIGHT_SCHEDULE_ENABLED_KEY, Defaults::DEFAULT_LIGHT_SCHEDULE_ENABLED);
+
+    size_t len = prefs.getBytesLength(LIGHT_SCHEDULE_RULES_KEY);
+    if (len > 0 && len <= sizeof(schedule.rules) && len % sizeof(LightScheduler::Rule) == 0) {
+        prefs.getBytes(LIGHT_SCHEDULE_RULES_KEY, schedule.rules, len);
+        schedule.ruleCount = len / sizeof(LightScheduler::Rule);
+    } else if (prefs.isKey(LIGHT_SCHEDULE_START_TIME_KEY)) {
+        // migrate the single start/end pair (seconds since midnight) into a daily rule
+        uint32_t startTime = prefs.getUInt(LIGHT_SCHEDULE_START_TIME_KEY, 0);
+        uint32_t endTime = prefs.getUInt(LIGHT_SCHEDULE_END_TIME_KEY, 0);
+        if (startTime != endTime) {
+            LightScheduler::Rule &rule = schedule.rules[0];
+            rule.start = startTime / 60;
+            rule.end = endTime / 60;
+            rule.weekdays = LightScheduler::ALL_DAYS;
+            rule.flags = LightScheduler::RULE_ENABLED;
+            schedule.ruleCount = 1;
+        }
+    }
+    return schedule;
+}
+
+ConfigData::AutoBrightnessConfig LegacyConfig::loadAutoBrightness(ILegacyPreferences &prefs) {
+    ConfigData::AutoBrightnessConfig config = {};
+    config.enabled = prefs.getBool(AUTO_BRIGHTNESS_ENABLED_KEY, Defaults::DEFAULT_AUTO_BRIGHTNESS_ENABLED);
+    config.illuminanceThresholdHigh = prefs.getUShort(
+        AUTO_BRIGHTNESS_THRESH_HIGH_KEY, Defaults::DEFAULT_ILLUMINANCE_THRESHOLD_HIGH);
+    config.illuminanceThresholdLow = prefs.getUShort(
+        AUTO_BRIGHTNESS_THRESH_LOW_KEY, Defaults::DEFAULT_ILLUMINANCE_THRESHOLD_LOW);
+    return config;
+}
+
+ConfigData::LightConfig LegacyConfig::loadLightConfig(ILegacyPreferences &prefs) {
+    ConfigData::LightConfig config = {};
+    config.brightness = prefs.getUChar(LIGHT_BRIGHTNESS_KEY, Defaults::DEFAULT_LIGHT_BRIGHTNESS);
+    config.state = prefs.getBool(LIGHT_STATE_KEY, true);
+    if (prefs.getBytes(LIGHT_COLOR_KEY, config.color, sizeof(config.color)) == 0) {
+        ConfigData::copyString(config.color, Defaults::DEFAULT_LIGHT_COLOR, sizeof(config.color));
+    }
+    config.autoBrightnessConfig = loadAutoBrightness(prefs);
+    return config;
+}
@@ -0,0 +1,80 @@
+#ifndef LEGACYCONFIG_H
+#define LEGACYCONFIG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "configdata.h"
+
+// Read access to one namespace of the per-key layout older firmware wrote:
+// Preferences on the device, a map in the host tests.
+class ILegacyPreferences {
+public:
+    virtual ~ILegacyPreferences() = default;
+    virtual bool isKey(const char *key) = 0;
+    virtual bool getBool(const char *key, bool defaultValue) = 0;
+    virtual uint8_t getUChar(const char *key, uint8_t defaultValue) = 0;
+    virtual uint16_t getUShort(const char *key, uint16_t defaultValue) = 0;
+    virtual uint32_t getUInt(const char *key, uint32_t defaultValue) = 0;
+    virtual uint32_t getULong(const char *key, uint32_t defaultValue) = 0;
+    virtual float getFloat(const char *key, float defaultValue) = 0;
+    // 0 if the key does not exist
+    virtual size_t getBytesLength(const char *key) = 0;
+    // 0 if the key does not exist or does not fit
+    virtual size_t getBytes(const char *key, void *buffer, size_t length) = 0;
+};
+
+// The "system" and "light" namespaces used before the configuration became
+// one blob, only read once to migrate them
+class LegacyConfig {
+public:
+    static const char SYSTEM_NAMESPACE[];
+    static const char LIGHT_NAMESPACE[];
+
+    // System Preferences Keys
+    static const char IS_INITIALIZED_KEY[];
+    static const char CLOCK_MODE_KEY[];
+    static const char WIFI_SSID_KEY[];
+    static const char WIFI_PASSWORD_KEY[];
+    static const char MQTT_ENABLED_KEY[];
+    static const char MQTT_HOST_KEY[];
+    static const char MQTT_PORT_KEY[];
+    static const char MQTT_USERNAME_KEY[];
+    static const char MQTT_PASSWORD_KEY[];
+    static const char MQTT_TOPIC_KEY[];
+    static const char NTP_ENABLED_KEY[];
+    static const char NTP_TIMEZONE_KEY[];
+    static const char NTP_SERVER_KEY[];
+    static const char NTP_UPDATE_ENABLED_KEY[];
+    static const char NTP_UPDATE_INTERVAL_KEY[];
+    static const char LOCATION_ENABLED_KEY[];
+    static const char LOCATION_LATITUDE_KEY[];
+    static const char LOCATION_LONGITUDE_KEY[];
+
+    // Light Preferences Keys
+    static const char LIGHT_SCHEDULE_ENABLED_KEY[];
+    static const char LIGHT_SCHEDULE_START_TIME_KEY[];
+    static const char LIGHT_SCHEDULE_END_TIME_KEY[];
+    static const char LIGHT_SCHEDULE_RULES_KEY[];
+    static const char AUTO_BRIGHTNESS_ENABLED_KEY[];
+    static const char AUTO_BRIGHTNESS_THRESH_HIGH_KEY[];
+    static const char AUTO_BRIGHTNESS_THRESH_LOW_KEY[];
+    static const char LIGHT_BRIGHTNESS_KEY[];
+    static const char LIGHT_COLOR_KEY[];
+    static const char LIGHT_STATE_KEY[];
+
+    // Fills data from both namespaces, false and data untouched if the
+    // system namespace was never initialised
+    static bool read(ILegacyPreferences &system, ILegacyPreferences &light, ConfigData &data);
+
+private:
+    static ConfigData::ClockMode loadClockMode(ILegacyPreferences &prefs);
+    static ConfigData::MqttConfig loadMqttConfig(ILegacyPreferences &prefs);
+    static ConfigData::NtpConfig loadNtpConfig(ILegacyPreferences &prefs);
+    static ConfigData::LocationConfig loadLocationConfig(ILegacyPreferences &prefs);
+    static ConfigData::LightScheduleConfig loadLightSchedule(ILegacyPreferences &prefs);
+    static ConfigData::AutoBrightnessConfig loadAutoBrightness(ILegacyPreferences &prefs);
+    static ConfigData::LightConfig loadLightConfig(ILegacyPreferences &prefs);
+    static ConfigData::WifiConfig loadWifiConfig(ILegacyPreferences &prefs);
+};
+
+#endif // LEGACYCONFIG_H
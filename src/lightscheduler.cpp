@@ -0,0 +1,224 @@
+#include "lightscheduler.h"
+#include <algorithm>
+
+LightScheduler::LightScheduler()
+{
+}
+
+LightScheduler::~LightScheduler()
+{
+}
+
+bool LightScheduler::isValidTime(uint16_t value, bool anchored)
+{
+    if (!anchored)
+    {
+        return value < MINUTES_PER_DAY;
+    }
+
+    int16_t offset = static_cast<int16_t>(value);
+    return offset >= -MAX_ANCHOR_OFFSET && offset <= MAX_ANCHOR_OFFSET;
+}
+
+bool LightScheduler::isAnchored(const Rule &rule)
+{
+    return (rule.flags & (RULE_START_SUNRISE | RULE_START_SUNSET | RULE_END_SUNRISE | RULE_END_SUNSET)) != 0;
+}
+
+bool LightScheduler::isValid(const Rule &rule)
+{
+    const uint8_t startAnchor = rule.flags & (RULE_START_SUNRISE | RULE_START_SUNSET);
+    const uint8_t endAnchor = rule.flags & (RULE_END_SUNRISE | RULE_END_SUNSET);
+    if (startAnchor == (RULE_START_SUNRISE | RULE_START_SUNSET) || endAnchor == (RULE_END_SUNRISE | RULE_END_SUNSET))
+    {
+        return false;
+    }
+
+    // the same anchor on both ends with the same offset is an empty window
+    const bool sameReference = (startAnchor == 0 && endAnchor == 0) ||
+                               (startAnchor == RULE_START_SUNRISE && endAnchor == RULE_END_SUNRISE) ||
+                               (startAnchor == RULE_START_SUNSET && endAnchor == RULE_END_SUNSET);
+    return isValidTime(rule.start, startAnchor != 0) && isValidTime(rule.end, endAnchor != 0) &&
+           !(sameReference && rule.start == rule.end) && (rule.weekdays & ALL_DAYS) != 0;
+}
+
+uint16_t LightScheduler::toMinuteOfWeek(uint8_t weekday, uint8_t hour, uint8_t minute)
+{
+    return (weekday % 7) * MINUTES_PER_DAY + hour * 60 + minute;
+}
+
+bool LightScheduler::setRules(const Rule *newRules, uint8_t count)
+{
+    if (count > MAX_RULES)
+    {
+        return false;
+    }
+
+    uint8_t accepted = 0;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (isValid(newRules[i]))
+        {
+            rules[accepted++] = newRules[i];
+        }
+    }
+
+    std::sort(rules, rules + accepted, [](const Rule &a, const Rule &b)
+              { return a.start != b.start ? a.start < b.start : a.weekdays < b.weekdays; });
+    ruleCount = accepted;
+
+    buildEvents();
+    synced = false;
+    return accepted == count;
+}
+
+void LightScheduler::clear()
+{
+    ruleCount = 0;
+    eventCount = 0;
+    synced = false;
+}
+
+const LightScheduler::Rule *LightScheduler::getRule(uint8_t index) const
+{
+    return index < ruleCount ? &rules[index] : nullptr;
+}
+
+void LightScheduler::setSolarTimes(uint16_t sunrise, uint16_t sunset)
+{
+    if (sunrise >= MINUTES_PER_DAY || sunset >= MINUTES_PER_DAY)
+    {
+        sunrise = NO_SOLAR_TIME;
+        sunset = NO_SOLAR_TIME;
+    }
+    if (sunrise == this->sunrise && sunset == this->sunset)
+    {
+        return;
+    }
+
+    this->sunrise = sunrise;
+    this->sunset = sunset;
+    // the polled minute is kept, a shifted edge is picked up once the clock passes it
+    buildEvents();
+}
+
+bool LightScheduler::resolve(uint16_t value, bool atSunrise, bool atSunset, uint16_t &minute) const
+{
+    if (!atSunrise && !atSunset)
+    {
+        minute = value;
+        return true;
+    }
+
+    if (!hasSolarTimes())
+    {
+        return false;
+    }
+
+    int32_t resolved = (atSunrise ? sunrise : sunset) + static_cast<int16_t>(value);
+    minute = static_cast<uint16_t>((resolved + MINUTES_PER_DAY) % MINUTES_PER_DAY);
+    return true;
+}
+
+void LightScheduler::buildEvents()
+{
+    eventCount = 0;
+    for (uint8_t r = 0; r < ruleCount; r++)
+    {
+        const Rule &rule = rules[r];
+        if (!(rule.flags & RULE_ENABLED))
+        {
+            continue;
+        }
+
+        uint16_t start, end;
+        if (!resolve(rule.start, rule.flags & RULE_START_SUNRISE, rule.flags & RULE_START_SUNSET, start) ||
+            !resolve(rule.end, rule.flags & RULE_END_SUNRISE, rule.flags & RULE_END_SUNSET, end) ||
+            start == end)
+        {
+            continue;
+        }
+
+        for (uint8_t day = 0; day < 7; day++)
+        {
+            if (!(rule.weekdays & (1 << day)))
+            {
+                continue;
+            }
+
+            // overnight ranges end on the following day
+            uint8_t endDay = end < start ? day + 1 : day;
+            events[eventCount++] = {static_cast<uint16_t>(toMinuteOfWeek(day, 0, 0) + start), r, Start};
+            events[eventCount++] = {static_cast<uint16_t>(toMinuteOfWeek(endDay, 0, 0) + end), r, End};
+        }
+    }
+
+    // an end and a start on the same minute hand over to the starting rule
+    std::sort(events, events + eventCount, [](const Event &a, const Event &b)
+              { return a.minuteOfWeek != b.minuteOfWeek ? a.minuteOfWeek < b.minuteOfWeek : a.type > b.type; });
+}
+
+size_t LightScheduler::upperBound(uint16_t minuteOfWeek) const
+{
+    const Event *it = std::upper_bound(events, events + eventCount, minuteOfWeek, [](uint16_t minute, const Event &e)
+                                       { return minute < e.minuteOfWeek; });
+    return it - events;
+}
+
+uint16_t LightScheduler::distance(uint16_t from, uint16_t to)
+{
+    return (to + MINUTES_PER_WEEK - from) % MINUTES_PER_WEEK;
+}
+
+const LightScheduler::Event *LightScheduler::nextEvent(uint16_t minuteOfWeek) const
+{
+    if (eventCount == 0)
+    {
+        return nullptr;
+    }
+
+    size_t idx = upperBound(minuteOfWeek);
+    return &events[idx < eventCount ? idx : 0];
+}
+
+const LightScheduler::Event *LightScheduler::currentEvent(uint16_t minuteOfWeek) const
+{
+    if (eventCount == 0)
+    {
+        return nullptr;
+    }
+
+    size_t idx = upperBound(minuteOfWeek);
+    return &events[idx > 0 ? idx - 1 : eventCount - 1];
+}
+
+const LightScheduler::Event *LightScheduler::poll(uint16_t minuteOfWeek)
+{
+    minuteOfWeek %= MINUTES_PER_WEEK;
+
+    if (!synced)
+    {
+        synced = true;
+        lastPolled = minuteOfWeek;
+        return currentEvent(minuteOfWeek);
+    }
+
+    if (minuteOfWeek == lastPolled)
+    {
+        return nullptr;
+    }
+
+    const Event *latest = currentEvent(minuteOfWeek);
+    uint16_t window = distance(lastPolled, minuteOfWeek);
+    uint16_t since = latest ? distance(lastPolled, latest->minuteOfWeek) : 0;
+    lastPolled = minuteOfWeek;
+
+    // only report events that happened after the previous poll, up to now.
+    // Large windows are clocks going backwards (DST fall back), nothing was missed there
+    if (latest == nullptr || since == 0 || since > window || window > MINUTES_PER_WEEK / 2)
+    {
+        return nullptr;
+    }
+
+    return latest;
+}
@@ -0,0 +1,96 @@
+#ifndef LIGHTSCHEDULER_H
+#define LIGHTSCHEDULER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Weekday-aware light schedule. Rules are expanded into a sorted table of
+// start/end events over one week (minute 0 = Sunday 00:00), so looking up the
+// next or the currently effective event is a binary search.
+// Kept free of Arduino dependencies so it can be exercised on the host.
+class LightScheduler
+{
+public:
+    static const uint8_t MAX_RULES = 8;
+    static const uint16_t MINUTES_PER_DAY = 1440;
+    static const uint16_t MINUTES_PER_WEEK = 7 * MINUTES_PER_DAY;
+    static const uint8_t ALL_DAYS = 0x7F; // bit n = tm_wday n (0 = Sunday)
+
+    static const uint8_t RULE_ENABLED = 0x01;
+    static const uint8_t RULE_HAS_COLOR = 0x02;
+    // anchored start/end hold a signed minute offset instead of a time of day
+    static const uint8_t RULE_START_SUNRISE = 0x04;
+    static const uint8_t RULE_START_SUNSET = 0x08;
+    static const uint8_t RULE_END_SUNRISE = 0x10;
+    static const uint8_t RULE_END_SUNSET = 0x20;
+    static const int16_t MAX_ANCHOR_OFFSET = 720;
+    static const uint16_t NO_SOLAR_TIME = 0xFFFF;
+
+    enum EventType : uint8_t {
+        Start = 0,
+        End
+    };
+
+    // 10 bytes, persisted as-is by Configuration
+    struct Rule {
+        uint16_t start;     // minutes since midnight, or an int16 offset when anchored
+        uint16_t end;       // minutes since midnight, end < start spans midnight
+        uint8_t weekdays;   // days on which the rule starts
+        uint8_t brightness; // 0 = keep current brightness
+        uint8_t color[3];   // RGB, used when RULE_HAS_COLOR is set
+        uint8_t flags;
+    };
+
+    struct Event {
+        uint16_t minuteOfWeek;
+        uint8_t rule;
+        uint8_t type;
+    };
+
+    LightScheduler();
+    ~LightScheduler();
+
+    bool setRules(const Rule *rules, uint8_t count);
+    void clear();
+    uint8_t getRuleCount() const { return ruleCount; }
+    const Rule *getRule(uint8_t index) const;
+    size_t getEventCount() const { return eventCount; }
+    // local sunrise/sunset in minutes since midnight, anchored rules stay inactive without them
+    void setSolarTimes(uint16_t sunrise, uint16_t sunset);
+    void clearSolarTimes() { setSolarTimes(NO_SOLAR_TIME, NO_SOLAR_TIME); }
+    bool hasSolarTimes() const { return sunrise != NO_SOLAR_TIME; }
+
+    // next event strictly after the given minute, wrapping around the week
+    const Event *nextEvent(uint16_t minuteOfWeek) const;
+    // last event at or before the given minute, wrapping around the week
+    const Event *currentEvent(uint16_t minuteOfWeek) const;
+    // returns the latest event passed since the previous poll (catching up on
+    // missed minutes), or the currently effective event on the first poll
+    const Event *poll(uint16_t minuteOfWeek);
+    // forces the next poll to re-evaluate the current state (boot, time set)
+    void resync() { synced = false; }
+
+    static bool isValid(const Rule &rule);
+    static bool isAnchored(const Rule &rule);
+    static uint16_t toMinuteOfWeek(uint8_t weekday, uint8_t hour, uint8_t minute);
+
+private:
+    static const size_t MAX_EVENTS = MAX_RULES * 7 * 2;
+
+    Rule rules[MAX_RULES];
+    uint8_t ruleCount = 0;
+    Event events[MAX_EVENTS];
+    size_t eventCount = 0;
+    uint16_t lastPolled = 0;
+    uint16_t sunrise = NO_SOLAR_TIME;
+    uint16_t sunset = NO_SOLAR_TIME;
+    bool synced = false;
+
+    void buildEvents();
+    bool resolve(uint16_t value, bool atSunrise, bool atSunset, uint16_t &minute) const;
+    static bool isValidTime(uint16_t value, bool anchored);
+    size_t upperBound(uint16_t minuteOfWeek) const;
+    static uint16_t distance(uint16_t from, uint16_t to);
+};
+
+#endif // LIGHTSCHEDULER_H
@@ -3,6 +3,7 @@
 #include <LittleFS.h>
 #include <RTClib.h>
 #include <Update.h>
+#include <esp_ota_ops.h>
 #include <vector>
 
 #include "defaults.h"
@@ -14,21 +15,96 @@
 #include "homeassistant.h"
 #include "timeconverterde.h"
 #include "callbacktypes.h"
+#include "mqtttimeprobe.h"
+#include "statestore.h"
+#include "restartscheduler.h"
+#include "otawriter.h"
+#include "pullupdater.h"
+#include "deltapatcher.h"
+#include "wificlientstream.h"
 
 boolean isSetup;
 
 RTC_DS3231 rtc;
 WiFiClient client;
 Configuration config;
-Configuration::SystemConfig systemConfig;
-Configuration::LightConfig lightConfig;
-Configuration::WifiConfig wifiConfig;
+StateStore state;
+RestartScheduler restartScheduler;
+// erased right before the restart, so nothing written in the grace period brings the old values back
+bool resetOnRestart = false;
+// uploads reach the flash in whole sectors
+OtaWriter otaWriter([](const uint8_t *data, size_t length)
+                    { return Update.write(const_cast<uint8_t *>(data), length) == length; });
+// images fetched from a server on the LAN, through the same writer
+WiFiClientStream pullStream;
+PullUpdater pullUpdater(pullStream, otaWriter,
+                        [](UpdateType type, uint32_t size)
+                        {
+                          config.flush();
+                          if (!Update.begin(size, type == UpdateType::FIRMWARE ? U_FLASH : U_SPIFFS))
+                          {
+                            Update.printError(Serial);
+                            return false;
+                          }
+                          return true;
+                        },
+                        [](UpdateType type, bool verified)
+                        {
+                          if (verified && Update.end(true))
+                          {
+                            return true;
+                          }
+                          Update.printError(Serial);
+                          Update.abort();
+                          return false;
+                        });
+// delta uploads rebuild the new firmware from the running one while the patch arrives
+DeltaPatcher deltaPatcher([](const DeltaPatcher::Header &header)
+                          {
+                            // ESP.getSketchMD5() reads the running image once and keeps the result
+                            char md5[2 * DeltaPatcher::MD5_SIZE + 1];
+                            for (size_t i = 0; i < DeltaPatcher::MD5_SIZE; i++)
+                            {
+                              snprintf(md5 + 2 * i, 3, "%02x", header.oldMd5[i]);
+                            }
+                            if (header.oldSize != ESP.getSketchSize() || !ESP.getSketchMD5().equalsIgnoreCase(md5))
+                            {
+                              Serial.println("Delta patch is for a different firmware");
+                              otaWriter.fail(OtaWriter::ErrorPatch);
+                              return false;
+                            }
+                            OtaWriter::Manifest manifest = {header.newSize, true, {}};
+                            memcpy(manifest.sha256, header.newSha256, sizeof(manifest.sha256));
+                            if (!otaWriter.begin(manifest, millis()))
+                            {
+                              Serial.println("No memory for the update buffer");
+                              return false;
+                            }
+                            if (!Update.begin(header.newSize, U_FLASH))
+                            {
+                              Update.printError(Serial);
+                              otaWriter.fail(OtaWriter::ErrorBegin);
+                              return false;
+                            }
+                            Serial.printf("Patching %u byte firmware into %u bytes\n", header.oldSize, header.newSize);
+                            return true;
+                          },
+                          [](uint32_t offset, uint8_t *buffer, size_t length)
+                          { return esp_partition_read(esp_ota_get_running_partition(), offset, buffer, length) == ESP_OK; },
+                          [](const uint8_t *data, size_t length)
+                          { return otaWriter.write(data, length, millis()); });
+bool deltaUpload = false;
+#ifdef WOC_PULL_OTA_URL
+unsigned long lastPullCheck = 0;
+bool pullChecked = false;
+#endif
 AsyncWebServer server(80);
 WebUI webui(server);
 WClock *wordClock;
 WoC_MQTT *haMqtt;
 ITimeConverter *timeConverter;
 LED ledController;
+MqttTimeProbe mqttTimeProbe;
 
 bool initialized = false;
 unsigned long lastUpdate = 0;
@@ -39,47 +115,90 @@ uint8_t lastMinute = 0;
 void showCurrentTime(uint8_t hour, uint8_t minute)
 {
   //Serial.printf("Current time: %d:%d\n", hour, minute);
-  std::vector<std::pair<int, int>> leds = timeConverter->convertTime(hour, minute, (systemConfig.mode == Configuration::ClockMode::Regular), true);
+  std::vector<std::pair<int, int>> leds = timeConverter->convertTime(hour, minute, (state.getSystem().mode == Configuration::ClockMode::Regular), true);
   //Serial.printf("LEDs: %d\n", leds.size());
   ledController.setLEDs(leds);
 }
 
 // callbacks
-void handleFWUpload(UpdateType updateType, const String filename, size_t index, uint8_t *data, size_t len, bool final)
+bool handleFWUpload(UpdateType updateType, const OtaWriter::Manifest &manifest, const String filename, size_t index, uint8_t *data, size_t len, bool final)
 {
+  if (pullUpdater.isBusy())
+  {
+    // the updater owns the flash until it is done
+    if (!index)
+    {
+      Serial.println("Upload refused, an update is being downloaded");
+    }
+    return false;
+  }
+
   if (!index)
   {
     Serial.printf("UploadStart: %s\n", filename.c_str());
-    Serial.printf("Update type: %s\n", updateType == UpdateType::FIRMWARE ? "Firmware" : "Filesystem");
-    if (!Update.begin(UPDATE_SIZE_UNKNOWN, updateType == UpdateType::FIRMWARE ? U_FLASH : U_SPIFFS))
-    { // start with max available size
-      Update.printError(Serial);
+    deltaUpload = updateType == UpdateType::DELTA;
+    if (deltaUpload)
+    {
+      // the writer and the flash are set up from the patch header
+      Serial.println("Update type: Firmware delta");
+      deltaPatcher.begin();
     }
     else
-      Serial.println("OTA update started!");
+    {
+      Serial.printf("Update type: %s\n", updateType == UpdateType::FIRMWARE ? "Firmware" : "Filesystem");
+      if (!otaWriter.begin(manifest, millis()))
+      {
+        Serial.println("No memory for the update buffer");
+      }
+      else if (!Update.begin(manifest.size > 0 ? manifest.size : UPDATE_SIZE_UNKNOWN, updateType == UpdateType::FIRMWARE ? U_FLASH : U_SPIFFS))
+      { // start with max available size
+        Update.printError(Serial);
+        otaWriter.fail(OtaWriter::ErrorBegin);
+      }
+      else
+        Serial.println("OTA update started!");
+    }
   }
 
-  if (Update.write(data, len) != len)
+  bool written = deltaUpload ? deltaPatcher.write(data, len) : otaWriter.write(data, len, millis());
+  if (!written && otaWriter.getProgress().error == OtaWriter::ErrorWrite)
   {
     Update.printError(Serial);
-  } // else Serial.printf("Written: %u\n", index + len);
+  }
+  if (!written && deltaUpload && otaWriter.getProgress().status != OtaWriter::Failed)
+  {
+    otaWriter.fail(OtaWriter::ErrorPatch);
+  }
 
   if (final)
   {
-    if (Update.end(true))
+    if (deltaUpload && !deltaPatcher.finish() && otaWriter.getProgress().status != OtaWriter::Failed)
     {
-      Serial.printf("UpdateSuccess: %u\n", index + len);
+      Serial.printf("Delta patch error %u\n", deltaPatcher.getError());
+      otaWriter.fail(OtaWriter::ErrorPatch);
+    }
+    // the digest is checked before the image is activated
+    if (otaWriter.finish(millis()) && Update.end(true))
+    {
+      OtaWriter::Progress progress = otaWriter.getProgress();
+      Serial.printf("UpdateSuccess: %u bytes, %u B/s%s\n", progress.received, progress.bytesPerSecond, progress.verified ? ", SHA-256 verified" : "");
     }
     else
     {
-      Update.printError(Serial);
+      Serial.printf("Update failed: error %u\n", otaWriter.getProgress().error);
+      if (Update.isRunning())
+      {
+        Update.printError(Serial);
+        Update.abort();
+      }
     }
   }
+  return true;
 }
 
 bool isUpdateSuccess()
 {
-  return !Update.hasError();
+  return otaWriter.getProgress().status == OtaWriter::Done && !Update.hasError();
 }
 
 void handleWiFiCredentials(const String &ssid, const String &password)
@@ -87,74 +206,168 @@ void handleWiFiCredentials(const String &ssid, const String &password)
   // Serial.printf("SSID set to: %s\n", ssid.c_str());
   // Serial.printf("Password set to: %s\n", password.c_str());
 
-  strlcpy(wifiConfig.ssid, ssid.c_str(), sizeof(wifiConfig.ssid));
-  strlcpy(wifiConfig.password, password.c_str(), sizeof(wifiConfig.password));
-  config.setWifiConfig(wifiConfig);
+  Configuration::WifiConfig wifi = state.getWifi();
+  strlcpy(wifi.ssid, ssid.c_str(), sizeof(wifi.ssid));
+  strlcpy(wifi.password, password.c_str(), sizeof(wifi.password));
+  state.setWifiConfig(wifi);
 }
 
-void setColor(const char *color)
+// state subscribers, each runs at most once per loop iteration with everything that changed
+void applyLight(StateStore::FieldMask changed, const StateStore &current)
 {
-  ledController.setColor(ledController.HexToRGB(color));
-  strlcpy(lightConfig.color, color, sizeof(lightConfig.color));
-  config.setLightColor(lightConfig.color);
+  const Configuration::LightConfig &light = current.getLight();
+  if (changed & StateStore::bit(StateStore::AutoBrightness))
+  {
+    if (light.autoBrightnessConfig.enabled)
+    {
+      ledController.enableAutoBrightness(light.autoBrightnessConfig.illuminanceThresholdHigh, light.autoBrightnessConfig.illuminanceThresholdLow);
+    }
+    else
+    {
+      ledController.disableAutoBrightness();
+      ledController.setBrightness(light.brightness);
+    }
+  }
+  else if (changed & StateStore::bit(StateStore::Brightness))
+  {
+    ledController.setBrightness(light.brightness);
+  }
+  if (changed & StateStore::bit(StateStore::Color))
+  {
+    ledController.setColor(ledController.HexToRGB(light.color));
+  }
+  if (changed & StateStore::bit(StateStore::LightState))
+  {
+    ledController.setDark(!light.state);
+  }
+  if (light.state && (changed & (StateStore::bit(StateStore::LightState) | StateStore::bit(StateStore::ClockMode))))
+  {
+    showCurrentTime(lastHour, lastMinute);
+  }
 }
 
-void setBrightness(uint8_t brightness)
+void publishLight(StateStore::FieldMask changed, const StateStore &current)
 {
-  ledController.setBrightness(brightness);
-  lightConfig.brightness = brightness;
-  config.setLightBrightness(lightConfig.brightness);
-}
+  if (!current.getSystem().mqttConfig.enabled || haMqtt == nullptr)
+  {
+    return;
+  }
 
-void setAutoBrightness(bool enabled)
-{
-  if (enabled)
+  const Configuration::LightConfig &light = current.getLight();
+  if (changed & StateStore::bit(StateStore::LightState))
   {
-    ledController.enableAutoBrightness(lightConfig.autoBrightnessConfig.illuminanceThresholdHigh, lightConfig.autoBrightnessConfig.illuminanceThresholdLow);
+    haMqtt->toggleLightState(light.state);
   }
-  else
+  if (changed & StateStore::bit(StateStore::Color))
   {
-    ledController.disableAutoBrightness();
-    ledController.setBrightness(lightConfig.brightness);
+    haMqtt->setLightColor(light.color);
+  }
+  if (changed & StateStore::bit(StateStore::AutoBrightness))
+  {
+    haMqtt->toggleAutoBrightness(light.autoBrightnessConfig.enabled);
+  }
+  if ((changed & StateStore::bit(StateStore::Brightness)) ||
+      ((changed & StateStore::bit(StateStore::AutoBrightness)) && !light.autoBrightnessConfig.enabled))
+  {
+    haMqtt->setLightBrightness(light.brightness);
   }
-
-  lightConfig.autoBrightnessConfig.enabled = enabled;
-  config.setAutoBrightness(lightConfig.autoBrightnessConfig);
 }
 
-void setLightState(bool state)
+void persistState(StateStore::FieldMask changed, const StateStore &current)
 {
-  if (state)
+  // only the fields that changed, so the unchanged count stays meaningful; the commit is debounced
+  const ConfigData &data = current.get();
+  if (changed & StateStore::bit(StateStore::LightState))
   {
-    ledController.setDark(false);
-    showCurrentTime(lastHour, lastMinute);
+    config.setLightState(data.light.state);
   }
-  else
+  if (changed & StateStore::bit(StateStore::Brightness))
+  {
+    config.setLightBrightness(data.light.brightness);
+  }
+  if (changed & StateStore::bit(StateStore::Color))
+  {
+    config.setLightColor(data.light.color);
+  }
+  if (changed & StateStore::bit(StateStore::AutoBrightness))
+  {
+    config.setAutoBrightness(data.light.autoBrightnessConfig);
+  }
+  if (changed & StateStore::bit(StateStore::ClockMode))
+  {
+    config.setClockMode(data.system.mode);
+  }
+  if (changed & StateStore::bit(StateStore::Mqtt))
+  {
+    config.setMqttConfig(data.system.mqttConfig);
+  }
+  if (changed & StateStore::bit(StateStore::Ntp))
+  {
+    config.setNtpConfig(data.system.ntpConfig);
+  }
+  if (changed & StateStore::bit(StateStore::Location))
+  {
+    config.setLocationConfig(data.system.locationConfig);
+  }
+  if (changed & StateStore::bit(StateStore::Schedule))
+  {
+    config.setLightSchedule(data.system.lightScheduleConfig);
+  }
+  if (changed & StateStore::bit(StateStore::Wifi))
   {
-    ledController.setDark();
+    config.setWifiConfig(data.wifi);
   }
+}
 
-  lightConfig.state = state;
-  config.setLightState(lightConfig.state);
+StateStore::FieldMask patchedFields(const ConfigJsonReader &patch)
+{
+  StateStore::FieldMask fields = 0;
+  for (size_t i = 0; i < ConfigJson::CONFIG_FIELD_COUNT; i++)
+  {
+    if (patch.isPresent(i))
+    {
+      fields |= StateStore::fieldsAt(ConfigJson::CONFIG_FIELDS[i].offset, ConfigJson::CONFIG_FIELDS[i].size);
+    }
+  }
+  return fields;
 }
 
 void lightSensorCallback(const int value)
 {
-  if (systemConfig.mqttConfig.enabled && haMqtt != nullptr)
+  if (state.getSystem().mqttConfig.enabled && haMqtt != nullptr)
   {
     haMqtt->setLightSensorValue(value);
   }
 }
 
+void pushSunTimesToMqtt()
+{
+  if (state.getSystem().mqttConfig.enabled && haMqtt != nullptr)
+  {
+    char sunrise[6] = "";
+    char sunset[6] = "";
+    int16_t sunriseMinutes = wordClock->getSunrise();
+    int16_t sunsetMinutes = wordClock->getSunset();
+    if (sunriseMinutes >= 0)
+    {
+      snprintf(sunrise, sizeof(sunrise), "%02d:%02d", sunriseMinutes / 60, sunriseMinutes % 60);
+      snprintf(sunset, sizeof(sunset), "%02d:%02d", sunsetMinutes / 60, sunsetMinutes % 60);
+    }
+    haMqtt->setSunTimes(sunrise, sunset);
+  }
+}
+
 void pushInitialStatusToMqtt()
 {
-  if (systemConfig.mqttConfig.enabled && haMqtt != nullptr)
+  if (state.getSystem().mqttConfig.enabled && haMqtt != nullptr)
   {
+    const Configuration::LightConfig &lightConfig = state.getLight();
     haMqtt->toggleLightState(lightConfig.state);
     haMqtt->setLightColor(lightConfig.color);
     haMqtt->setLightBrightness(lightConfig.brightness);
     haMqtt->toggleAutoBrightness(lightConfig.autoBrightnessConfig.enabled);
   }
+  pushSunTimesToMqtt();
 }
 
 void mqttCallback(MQTTEvent event, const char* payload) {
@@ -170,16 +383,16 @@ void mqttCallback(MQTTEvent event, const char* payload) {
     Serial.println("MQTT Disconnected!");
     break;
   case MQTTEvent::BrightnessCommand:
-    setBrightness(atoi(payload));
+    state.setBrightness(atoi(payload));
     break;
   case MQTTEvent::RGBCommand:
-    setColor(payload);
+    state.setColor(payload);
     break;
   case MQTTEvent::StateCommand:
-    setLightState(payload == "1"); //hmmm
+    state.setLightState(strcmp(payload, "1") == 0);
     break;
   case MQTTEvent::AutoBrightnessSwitchCommand:
-    setAutoBrightness(payload == "1");
+    state.setAutoBrightness(strcmp(payload, "1") == 0);
     break;
   case MQTTEvent::Option1SwitchCommand:
     Serial.printf("Option1 switch command received: %s\n", payload);
@@ -193,6 +406,12 @@ void mqttCallback(MQTTEvent event, const char* payload) {
   case MQTTEvent::Option4SwitchCommand:
     Serial.printf("Option4 switch command received: %s\n", payload);
     break;  
+  case MQTTEvent::TimeMessage:
+    if (!mqttTimeProbe.push(payload, millis()))
+    {
+      Serial.printf("Invalid time payload: %s\n", payload);
+    }
+    break;
   default:
     break;
   }
@@ -200,11 +419,13 @@ void mqttCallback(MQTTEvent event, const char* payload) {
 
 void enableMqtt()
 {
-  if (systemConfig.mqttConfig.host != nullptr)
+  const Configuration::MqttConfig &mqttConfig = state.getSystem().mqttConfig;
+  if (mqttConfig.host[0] != '\0')
   {
     haMqtt = new WoC_MQTT(client, Defaults::PRODUCT, Defaults::FW_VERSION);
-    haMqtt->connect(IPAddress(systemConfig.mqttConfig.host), mqttCallback, systemConfig.mqttConfig.username, systemConfig.mqttConfig.password, systemConfig.mqttConfig.topic);
+    haMqtt->connect(IPAddress(mqttConfig.host), mqttCallback, mqttConfig.username, mqttConfig.password, mqttConfig.topic);
     ledController.registerIlluminanceSensorCallback(lightSensorCallback);
+    wordClock->addTimeProbe(&mqttTimeProbe);
     pushStatus = true;
   }
 }
@@ -214,6 +435,7 @@ void disableMqtt()
   if (haMqtt != nullptr)
   {
     ledController.unregisterIlluminanceSensorCallback();
+    wordClock->removeTimeProbe(&mqttTimeProbe);
     haMqtt->disconnect();
     delete haMqtt;
     haMqtt = nullptr;
@@ -221,148 +443,195 @@ void disableMqtt()
 }
 
 
-void httpRequestCallback(ControlType type, const std::map<String, String> &params)
+void applySystem(StateStore::FieldMask changed, const StateStore &current)
 {
-  // Serial.printf("Control type: %d\n", type);
-  // Serial.printf("Params: %d\n", params.size());
-  // for (auto const &x : params)
-  // {
-  //   Serial.printf("Key: %s, Value: %s\n", x.first.c_str(), x.second.c_str());
-  // }
+  const Configuration::SystemConfig &system = current.getSystem();
+  if (changed & StateStore::bit(StateStore::Ntp))
+  {
+    if (system.ntpConfig.enabled)
+    {
+      wordClock->enableNTP(system.ntpConfig.timezone, system.ntpConfig.server, system.ntpConfig.interval);
+    }
+    else
+    {
+      wordClock->disableNTP();
+    }
+  }
+  if (changed & StateStore::bit(StateStore::Location))
+  {
+    if (!system.locationConfig.enabled)
+    {
+      wordClock->clearLocation();
+    }
+    else if (!wordClock->setLocation(system.locationConfig.latitude, system.locationConfig.longitude))
+    {
+      Configuration::LocationConfig location = system.locationConfig;
+      location.enabled = false;
+      state.setLocationConfig(location);
+    }
+  }
+  if (changed & StateStore::bit(StateStore::Schedule))
+  {
+    if (system.lightScheduleConfig.enabled)
+    {
+      wordClock->enableSchedule(system.lightScheduleConfig.rules, system.lightScheduleConfig.ruleCount);
+    }
+    else
+    {
+      wordClock->disableSchedule();
+    }
+  }
+  if (changed & StateStore::bit(StateStore::Mqtt))
+  {
+    disableMqtt();
+    if (system.mqttConfig.enabled)
+    {
+      enableMqtt();
+    }
+  }
+}
 
-  switch (type)
+void httpRequestCallback(const WebRequest &request)
+{
+  // Serial.printf("Control type: %d\n", request.type);
+
+  switch (request.type)
   {
   case ControlType::LightStatus:
   {
-    setLightState(params.at(FPSTR(WebUI::PARAM_ENABLED)) == FPSTR(WebUI::VALUE_ON));
-    if(systemConfig.mqttConfig.enabled && haMqtt != nullptr) {
-      haMqtt->toggleLightState(lightConfig.state);
-    }
+    state.setLightState(request.enabled);
     break;
   }
   case ControlType::Color:
   {
-    setColor(params.at(FPSTR(WebUI::PARAM_COLOR)).c_str());
-
-    if(systemConfig.mqttConfig.enabled && haMqtt != nullptr) {
-      haMqtt->setLightColor(lightConfig.color);
-    }
+    state.setColor(request.color);
     break;
   }
   case ControlType::AutoBrightness:
   {
-    setAutoBrightness(params.at(FPSTR(WebUI::PARAM_AUTO_BRIGHTNESS_ENABLED)) == FPSTR(WebUI::VALUE_ON));
-    if(systemConfig.mqttConfig.enabled && haMqtt != nullptr) {    
-      haMqtt->toggleAutoBrightness(lightConfig.autoBrightnessConfig.enabled);
-      if(!lightConfig.autoBrightnessConfig.enabled) {
-        haMqtt->setLightBrightness(lightConfig.brightness);
-      }
-    }
+    state.setAutoBrightness(request.enabled);
     break;
   }
   case ControlType::Brightness:
   {
-    setBrightness(params.at(FPSTR(WebUI::PARAM_BRIGHTNESS)).toInt());
-    if(systemConfig.mqttConfig.enabled && haMqtt != nullptr) {
-      haMqtt->setLightBrightness(lightConfig.brightness);
-    }
-
+    state.setBrightness(request.brightness);
     break;
   }
   case ControlType::HaIntegration:
   {
-    systemConfig.mqttConfig.enabled = (params.at(FPSTR(WebUI::PARAM_ENABLED)) == FPSTR(WebUI::VALUE_ON));
-
-    if (systemConfig.mqttConfig.enabled)
+    // switching off keeps the broker settings for later
+    Configuration::MqttConfig mqttConfig = state.getSystem().mqttConfig;
+    if (request.mqtt.enabled)
     {
-      strlcpy(systemConfig.mqttConfig.host, params.at(FPSTR(WebUI::PARAM_BROKER_HOST)).c_str(), sizeof(systemConfig.mqttConfig.host));
-      systemConfig.mqttConfig.port = params.at(FPSTR(WebUI::PARAM_BROKER_PORT)).toInt();
-      strlcpy(systemConfig.mqttConfig.username, params.at(FPSTR(WebUI::PARAM_BROKER_USER)).c_str(), sizeof(systemConfig.mqttConfig.username));
-      strlcpy(systemConfig.mqttConfig.password, params.at(FPSTR(WebUI::PARAM_BROKER_PASS)).c_str(), sizeof(systemConfig.mqttConfig.password));
-      strlcpy(systemConfig.mqttConfig.topic, params.at(FPSTR(WebUI::PARAM_BROKER_DEFAULT_TOPIC)).c_str(), sizeof(systemConfig.mqttConfig.topic));
-      config.setMqttConfig(systemConfig.mqttConfig);
-
-      enableMqtt();
-    }
-    else
-    {
-      config.setMqttConfig(systemConfig.mqttConfig);
-      disableMqtt();
+      mqttConfig = request.mqtt;
     }
+    mqttConfig.enabled = request.mqtt.enabled;
+    state.setMqttConfig(mqttConfig);
     break;
   }
   case ControlType::ClockFace:
   {
-    if (params.at(FPSTR(WebUI::PARAM_OPTION)) == FPSTR(WebUI::VALUE_OFF))
-    {
-      systemConfig.mode = Configuration::ClockMode::Regular;
-      //Serial.println("Clock mode set to dreiviertel");
-    }
-    else
-    {
-      systemConfig.mode = Configuration::ClockMode::Option_1;
-      //Serial.println("Clock mode set to viertel vor");
-    }
-    config.setClockMode(systemConfig.mode);
+    state.setClockMode(request.clockMode);
     break;
   }
   case ControlType::ResetConfig:
   {
-    config.reset();
-    Serial.println("Configuration reset. Restarting...");
-    delay(2000);
-    ESP.restart();
+    Serial.println("Configuration reset requested");
+    resetOnRestart = true;
+    restartScheduler.schedule(millis());
     break;
   }
   case ControlType::Time:
   {
-    // auto muh = params.at(FPSTR(WebUI::PARAM_TIME));
-    // Serial.printf("Hour: %d\n", muh.substring(0,2).toInt());
-    // Serial.printf("Minute: %d\n", muh.substring(3,5).toInt());
-    wordClock->setTime(params.at(FPSTR(WebUI::PARAM_TIME)).substring(0, 2).toInt(), params.at(FPSTR(WebUI::PARAM_TIME)).substring(3, 5).toInt());
+    wordClock->setTime(request.time.hour, request.time.minute);
     break;
   }
   case ControlType::NTPSync:
   {
-    systemConfig.ntpConfig.enabled = params.at(FPSTR(WebUI::PARAM_NTP_ENABLED)) == FPSTR(WebUI::VALUE_ON);
-
-    if(systemConfig.ntpConfig.enabled) {
-      strlcpy(systemConfig.ntpConfig.server, params.at(FPSTR(WebUI::PARAM_NTP_HOST)).c_str(), sizeof(systemConfig.ntpConfig.server));
-      systemConfig.ntpConfig.interval = params.at(FPSTR(WebUI::PARAM_NTP_UPDATE_INTERVAL)).toInt();
-      strlcpy(systemConfig.ntpConfig.timezone, params.at(FPSTR(WebUI::PARAM_NTP_TIMEZONE)).c_str(), sizeof(systemConfig.ntpConfig.timezone));
-      config.setNtpConfig(systemConfig.ntpConfig);
-  
-      //printf("NTP enabled with server: %s, interval: %d, timezone: %s\n", systemConfig.ntpConfig.server, systemConfig.ntpConfig.interval, systemConfig.ntpConfig.timezone);
-      wordClock->enableNTP(systemConfig.ntpConfig.timezone, systemConfig.ntpConfig.server, systemConfig.ntpConfig.interval);
-    } else {
-      config.setNtpConfig(systemConfig.ntpConfig);
-      wordClock->disableNTP();
+    Configuration::NtpConfig ntpConfig = state.getSystem().ntpConfig;
+    if(request.ntp.enabled) {
+      ntpConfig = request.ntp;
+      //printf("NTP enabled with server: %s, interval: %d, timezone: %s\n", ntpConfig.server, ntpConfig.interval, ntpConfig.timezone);
     }
-
+    ntpConfig.enabled = request.ntp.enabled;
+    state.setNtpConfig(ntpConfig);
     break;
   }
   case ControlType::LightSchedule:
   {
-    systemConfig.lightScheduleConfig.enabled = params.at(FPSTR(WebUI::PARAM_SCHEDULE_ENABLED)) == FPSTR(WebUI::VALUE_ON);
+    Configuration::LightScheduleConfig schedule = state.getSystem().lightScheduleConfig;
+    schedule.enabled = request.schedule.enabled;
 
-    if(systemConfig.lightScheduleConfig.enabled) {    
-      systemConfig.lightScheduleConfig.startTime = params.at(FPSTR(WebUI::PARAM_SCHEDULE_START)).toInt();
-      systemConfig.lightScheduleConfig.endTime = params.at(FPSTR(WebUI::PARAM_SCHEDULE_END)).toInt();
+    if(schedule.enabled) {
+      uint8_t index = request.schedule.index;
+      if(index > schedule.ruleCount || index >= LightScheduler::MAX_RULES) {
+        Serial.println("Invalid schedule rule index");
+        break;
+      }
 
-      config.setLightSchedule(systemConfig.lightScheduleConfig);
-      wordClock->enableSchedule(systemConfig.lightScheduleConfig.startTime, systemConfig.lightScheduleConfig.endTime);
-    } else {
+      schedule.rules[index] = request.schedule.rule;
+      if(LightScheduler::isAnchored(request.schedule.rule) && !state.getSystem().locationConfig.enabled) {
+        Serial.println("Sunrise/sunset rules stay inactive until a location is set");
+      }
+      if(index == schedule.ruleCount) {
+        schedule.ruleCount++;
+      }
+    }
+    state.setLightSchedule(schedule);
+    break;
+  }
+  case ControlType::LightScheduleRuleDelete:
+  {
+    Configuration::LightScheduleConfig schedule = state.getSystem().lightScheduleConfig;
+    uint8_t index = request.ruleIndex;
+    if(index >= schedule.ruleCount) {
+      Serial.println("Invalid schedule rule index");
+      break;
+    }
 
-      config.setLightSchedule(systemConfig.lightScheduleConfig);
-      wordClock->disableSchedule();
+    memmove(&schedule.rules[index], &schedule.rules[index + 1], (schedule.ruleCount - index - 1) * sizeof(LightScheduler::Rule));
+    schedule.ruleCount--;
+    state.setLightSchedule(schedule);
+    break;
+  }
+  case ControlType::Location:
+  {
+    // applySystem() switches the location off again if the clock rejects it
+    Configuration::LocationConfig location = state.getSystem().locationConfig;
+    if(request.location.enabled) {
+      location = request.location;
     }
+    location.enabled = request.location.enabled;
+    state.setLocationConfig(location);
     break;
   }
   case ControlType::WiFiSetup:
   {
-    strlcpy(wifiConfig.ssid, params.at(FPSTR(WebUI::PARAM_WIFI_SSID)).c_str(), sizeof(wifiConfig.ssid));
-    strlcpy(wifiConfig.password, params.at(FPSTR(WebUI::PARAM_WIFI_PASS)).c_str(), sizeof(wifiConfig.password));
-    config.setWifiConfig(wifiConfig);
+    state.setWifiConfig(request.wifi);
+    // the AP restarts right after this request, nothing else is subscribed in setup mode
+    state.notify();
+    config.flush();
+    restartScheduler.schedule(millis());
+    break;
+  }
+  case ControlType::PullUpdate:
+  {
+    if (!pullUpdater.start(request.url, Defaults::FW_VERSION, millis()))
+    {
+      Serial.println("Update already running");
+    }
+    break;
+  }
+  case ControlType::TimeWarp:
+  {
+    if (request.timeWarp.speed <= 1 && request.timeWarp.epoch == 0)
+    {
+      wordClock->disableTimeWarp();
+    }
+    else
+    {
+      wordClock->enableTimeWarp(request.timeWarp.epoch, request.timeWarp.speed);
+    }
     break;
   }
   default:
@@ -372,47 +641,45 @@ void httpRequestCallback(ControlType type, const std::map<String, String> &param
   }
 }
 
-const std::map<String, String> httpResponseCallback(PageType page)
+void httpResponseCallback(PageState &page)
 {
-  std::map<String, String> params;
-  switch (page)
+  switch (page.page)
   {
-  case PageType::LIGHT:
-    params[FPSTR(WebUI::PARAM_ENABLED)] = lightConfig.state ? FPSTR(WebUI::VALUE_ON) : FPSTR(WebUI::VALUE_OFF);
-    params[FPSTR(WebUI::PARAM_COLOR)] = lightConfig.color;
-    params[FPSTR(WebUI::PARAM_BRIGHTNESS)] = String(lightConfig.brightness);
-    params[FPSTR(WebUI::PARAM_AUTO_BRIGHTNESS_ENABLED)] = lightConfig.autoBrightnessConfig.enabled ? FPSTR(WebUI::VALUE_ON) : FPSTR(WebUI::VALUE_OFF);
-    break;
   case PageType::SYSTEM:
-    params[FPSTR(WebUI::PARAM_BROKER_ENABLED)] = systemConfig.mqttConfig.enabled ? FPSTR(WebUI::VALUE_ON) : FPSTR(WebUI::VALUE_OFF);
-    params[FPSTR(WebUI::PARAM_BROKER_HOST)] = systemConfig.mqttConfig.host;
-    params[FPSTR(WebUI::PARAM_BROKER_PORT)] = String(systemConfig.mqttConfig.port);
-    params[FPSTR(WebUI::PARAM_BROKER_USER)] = systemConfig.mqttConfig.username;
-    params[FPSTR(WebUI::PARAM_BROKER_PASS)] = systemConfig.mqttConfig.password;
-    params[FPSTR(WebUI::PARAM_BROKER_DEFAULT_TOPIC)] = systemConfig.mqttConfig.topic;
-    params[FPSTR(WebUI::PARAM_CLOCKFACE_OPTION)] = systemConfig.mode == Configuration::ClockMode::Option_1 ? FPSTR(WebUI::VALUE_ON) : FPSTR(WebUI::VALUE_OFF);
-    break;
-  case PageType::TIME:
   {
-    char timeStr[6];
-    sprintf(timeStr, "%02d:%02d", lastHour, lastMinute);
-    params[FPSTR(WebUI::PARAM_TIME)] = timeStr;
-    params[FPSTR(WebUI::PARAM_NTP_ENABLED)] = systemConfig.ntpConfig.enabled ? FPSTR(WebUI::VALUE_ON) : FPSTR(WebUI::VALUE_OFF);
-    params[FPSTR(WebUI::PARAM_NTP_HOST)] = systemConfig.ntpConfig.server;
-    params[FPSTR(WebUI::PARAM_NTP_UPDATE_INTERVAL)] = String(systemConfig.ntpConfig.interval);
-    params[FPSTR(WebUI::PARAM_NTP_TIMEZONE)] = systemConfig.ntpConfig.timezone;
-    params[FPSTR(WebUI::PARAM_SCHEDULE_START)] = String(systemConfig.lightScheduleConfig.startTime); 
-    params[FPSTR(WebUI::PARAM_SCHEDULE_END)] = String(systemConfig.lightScheduleConfig.endTime);
-    params[FPSTR(WebUI::PARAM_SCHEDULE_ENABLED)] = systemConfig.lightScheduleConfig.enabled ? FPSTR(WebUI::VALUE_ON) : FPSTR(WebUI::VALUE_OFF);
+    const Configuration::WriteStats &stats = config.getWriteStats();
+    snprintf(page.system.configWrites, sizeof(page.system.configWrites), "%u bytes in %u flushes for %u changes (%u unchanged skipped), last %u bytes in %u ms",
+             stats.bytesWritten, stats.flushes, stats.changes, stats.unchanged + stats.skippedFlushes,
+             stats.lastFlushBytes, stats.lastFlushMicros / 1000);
     break;
   }
+  case PageType::TIME:
+    page.time.time.hour = lastHour;
+    page.time.time.minute = lastMinute;
+    page.time.sunrise = wordClock->getSunrise();
+    page.time.sunset = wordClock->getSunset();
+    break;
   case PageType::FWUPDATE:
-    params[FPSTR(WebUI::PARAM_FW_VERSION)] = Defaults::FW_VERSION;
+    page.firmware.version = Defaults::FW_VERSION;
+    page.firmware.update = otaWriter.getProgress();
     break;
   default:
     break;
   }
-  return params;
+}
+
+// what open pages show live, sent as deltas over /events
+void eventStateCallback(StateEvents::Values &values)
+{
+  const Configuration::LightConfig &light = state.getLight();
+  values.state = light.state;
+  values.autoBrightness = light.autoBrightnessConfig.enabled;
+  values.brightness = ledController.getBrightness();
+  memcpy(values.color, light.color, sizeof(values.color));
+  values.minutes = lastHour * 60 + lastMinute;
+  values.illuminance = ledController.getIlluminance();
+  values.renderMicros = ledController.getLastRenderDurationUs();
+  values.renderMaxMicros = ledController.getMaxRenderDurationUs();
 }
 
 void clockSchedulerCallback(SchedulerType type, uint8_t hour, uint8_t minute)
@@ -426,25 +693,31 @@ void clockSchedulerCallback(SchedulerType type, uint8_t hour, uint8_t minute)
     showCurrentTime(hour, minute);
     break;
   case SchedulerType::ScheduleStart:
+  {
     //Serial.printf("Schedule start: %d:%d\n", hour, minute);
-    ledController.setDark(false);
-    lightConfig.state = true;
-    config.setLightState(lightConfig.state);
-    showCurrentTime(hour, minute);
-    if(systemConfig.mqttConfig.enabled && haMqtt != nullptr)
+    const LightScheduler::Rule *rule = wordClock->getActiveScheduleRule();
+    if (rule != nullptr)
     {
-      haMqtt->toggleLightState(lightConfig.state);
+      if (rule->brightness > 0 && !state.getLight().autoBrightnessConfig.enabled)
+      {
+        state.setBrightness(rule->brightness);
+      }
+      if (rule->flags & LightScheduler::RULE_HAS_COLOR)
+      {
+        char color[8];
+        snprintf(color, sizeof(color), "#%02X%02X%02X", rule->color[0], rule->color[1], rule->color[2]);
+        state.setColor(color);
+      }
     }
+    state.setLightState(true);
+    break;
+  }
+  case SchedulerType::SunTimes:
+    pushSunTimesToMqtt();
     break;
   case SchedulerType::ScheduleEnd:
     //Serial.printf("Schedule end: %d:%d\n", hour, minute);
-    ledController.setDark();
-    lightConfig.state = false;
-    config.setLightState(lightConfig.state);
-    if(systemConfig.mqttConfig.enabled && haMqtt != nullptr)
-    {
-      haMqtt->toggleLightState(lightConfig.state);
-    }
+    state.setLightState(false);
     break;
   default:
     break;
@@ -456,18 +729,18 @@ void setup()
   Serial.begin(115200);
   Serial.printf("Starting with FW %s...\n", Defaults::FW_VERSION);
 
-  config = Configuration();
   config.init();
-  wifiConfig = config.getWifiConfig();
-  systemConfig = config.getSystemConfig();
-  lightConfig = config.getLightConfig();
+  state.load(config.getData());
+  state.subscribe(StateStore::ALL_FIELDS, persistState);
+  const Configuration::WifiConfig &wifiConfig = state.getWifi();
+  const Configuration::SystemConfig &systemConfig = state.getSystem();
+  const Configuration::LightConfig &lightConfig = state.getLight();
 
   wordClock = new WClock(rtc);
   if (!wordClock->init(clockSchedulerCallback))
   {
+    // not fatal, the clock runs on the software clock until network time arrives
     Serial.println("RTC may lack power or may be missing");
-    Serial.flush();
-    abort();
   }
 
   if (!LittleFS.begin(true))
@@ -493,6 +766,16 @@ void setup()
       wordClock->setTimeZone(systemConfig.ntpConfig.timezone);
     }
 
+    if (systemConfig.locationConfig.enabled)
+    {
+      wordClock->setLocation(systemConfig.locationConfig.latitude, systemConfig.locationConfig.longitude);
+    }
+
+    if (systemConfig.lightScheduleConfig.enabled)
+    {
+      wordClock->enableSchedule(systemConfig.lightScheduleConfig.rules, systemConfig.lightScheduleConfig.ruleCount);
+    }
+
     ledController = LED();
     ledController.init();
     if (lightConfig.autoBrightnessConfig.enabled)
@@ -508,8 +791,35 @@ void setup()
 
     timeConverter = new TimeConverterDE();
 
+    webui.setConfigCallbacks([]() { return config.getData(); },
+                             [](const ConfigJsonReader &imported)
+                             {
+                               ConfigData data = state.get();
+                               imported.applyTo(data);
+                               // through the state, so persistState cannot write the old values back before the restart
+                               state.update(data, StateStore::ALL_FIELDS);
+                               state.notify();
+                               return config.importData(state.get());
+                             });
+    // WiFi only changes through the setup AP
+    webui.setStateCallbacks([]() { return state.get(); },
+                            [](const ConfigJsonReader &patch)
+                            {
+                              // only what the request sent, the rest may have changed since it was parsed
+                              ConfigData data = state.get();
+                              patch.applyTo(data);
+                              state.update(data, patchedFields(patch) & ~StateStore::bit(StateStore::Wifi));
+                              return true;
+                            });
+    webui.setEventCallback(eventStateCallback);
+    webui.setRestartCallback([]() { restartScheduler.schedule(millis()); });
     webui.init(httpRequestCallback, httpResponseCallback, handleFWUpload, isUpdateSuccess);
 
+    state.subscribe(StateStore::LIGHT_FIELDS | StateStore::bit(StateStore::ClockMode), applyLight);
+    state.subscribe(StateStore::LIGHT_FIELDS, publishLight);
+    state.subscribe(StateStore::bit(StateStore::Mqtt) | StateStore::bit(StateStore::Ntp) |
+                    StateStore::bit(StateStore::Location) | StateStore::bit(StateStore::Schedule), applySystem);
+
     if (systemConfig.mqttConfig.enabled)
     {
       enableMqtt();      
@@ -538,8 +848,54 @@ void setup()
   ledController.test();
 }
 
+void loopPullUpdate()
+{
+#ifdef WOC_PULL_OTA_URL
+  // the fleet checks on its own, the first time a minute after boot
+  unsigned long now = millis();
+  unsigned long interval = pullChecked ? Defaults::PULL_OTA_INTERVAL_MS : Defaults::PULL_OTA_FIRST_CHECK_MS;
+  if (!pullUpdater.isBusy() && now - lastPullCheck >= interval)
+  {
+    lastPullCheck = now;
+    pullChecked = true;
+    pullUpdater.start(WOC_PULL_OTA_URL, Defaults::FW_VERSION, now);
+  }
+#endif
+  if (!pullUpdater.isBusy())
+  {
+    return;
+  }
+  pullUpdater.loop(millis());
+  if (pullUpdater.isBusy())
+  {
+    return;
+  }
+
+  OtaWriter::Progress progress = otaWriter.getProgress();
+  switch (pullUpdater.getStatus())
+  {
+  case PullUpdater::UpToDate:
+    Serial.printf("Firmware %s is up to date\n", Defaults::FW_VERSION);
+    break;
+  case PullUpdater::Done:
+    Serial.printf("Update downloaded, last image %u bytes at %u B/s, %u resumes\n",
+                  progress.received, progress.bytesPerSecond, pullUpdater.getResumes());
+    break;
+  default:
+    Serial.printf("Update failed: %s\n", pullUpdater.getFailure());
+    break;
+  }
+  if (pullUpdater.hasActivated())
+  {
+    restartScheduler.schedule(millis());
+  }
+}
+
 void loop()
 {
+  // web commands are applied here, on the main task, in setup mode as well
+  webui.loop();
+
   if (!isSetup && initialized)
   {
     // unsigned long now = millis();
@@ -551,9 +907,30 @@ void loop()
 
     wordClock->loop();
     ledController.loop();
-    if (systemConfig.mqttConfig.enabled && haMqtt != nullptr)
+    if (state.getSystem().mqttConfig.enabled && haMqtt != nullptr)
     {
       haMqtt->loop();
     }
+    loopPullUpdate();
+  }
+
+  // whatever the web UI, MQTT or the schedule changed in this iteration is applied once
+  state.notify();
+  config.loop();
+
+  if (restartScheduler.due(millis()))
+  {
+    if (resetOnRestart)
+    {
+      config.reset();
+      Serial.println("Configuration reset");
+    }
+    else
+    {
+      config.flush();
+    }
+    Serial.println("Restarting...");
+    Serial.flush();
+    ESP.restart();
   }
 }
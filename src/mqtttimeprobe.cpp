@@ -0,0 +1,36 @@
+#include "mqtttimeprobe.h"
+#include "timeformats.h"
+
+MqttTimeProbe::MqttTimeProbe()
+{
+}
+
+MqttTimeProbe::~MqttTimeProbe()
+{
+}
+
+bool MqttTimeProbe::poll(uint32_t nowMs, TimeSample &sample)
+{
+    if (!hasSample || delivered || nowMs - latest.localMs > MAX_AGE_MS)
+    {
+        return false;
+    }
+
+    sample = latest;
+    delivered = true;
+    return true;
+}
+
+bool MqttTimeProbe::push(const char *payload, uint32_t localMs)
+{
+    int64_t utcMs;
+    if (!TimeFormats::parseEpoch(payload, utcMs))
+    {
+        return false;
+    }
+
+    latest = {utcMs, localMs, ERROR_MS};
+    hasSample = true;
+    delivered = false;
+    return true;
+}
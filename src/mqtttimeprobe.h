@@ -0,0 +1,30 @@
+#ifndef MQTTTIMEPROBE_H
+#define MQTTTIMEPROBE_H
+
+#include <stdint.h>
+#include "itimeprobe.h"
+
+// Time published by Home Assistant over MQTT. The probe is passive: an
+// automation publishes the unix time to the time topic and every push is
+// offered to the next round while it is fresh.
+class MqttTimeProbe : public ITimeProbe
+{
+private:
+    static const uint32_t MAX_AGE_MS = 600000;
+    // payloads carry no round trip information, allow for broker and automation latency
+    static const uint32_t ERROR_MS = 1500;
+    TimeSample latest = {};
+    bool hasSample = false;
+    bool delivered = false;
+
+public:
+    MqttTimeProbe();
+    ~MqttTimeProbe();
+    const char *getName() const override { return "mqtt"; }
+    void request(uint32_t /* nowMs */) override { delivered = false; }
+    bool poll(uint32_t nowMs, TimeSample &sample) override;
+    // payload is the unix time in seconds, see TimeFormats::parseEpoch
+    bool push(const char *payload, uint32_t localMs);
+};
+
+#endif // MQTTTIMEPROBE_H
@@ -0,0 +1,166 @@
+#include "otawriter.h"
+#include <stdio.h>
+#include <string.h>
+#include <new>
+
+OtaWriter::OtaWriter(const Sink &sink) : sink(sink)
+{
+    memset(&manifest, 0, sizeof(manifest));
+}
+
+bool OtaWriter::begin(const Manifest &expected, uint32_t now)
+{
+    manifest = expected;
+    hash.reset();
+    buffered = 0;
+    received = 0;
+    sinkWrites = 0;
+    verified = false;
+    error = ErrorNone;
+    started = now;
+    lastWrite = now;
+    status = Receiving;
+    // only held for the duration of an update
+    buffer.reset(new (std::nothrow) uint8_t[SECTOR_SIZE]);
+    if (!buffer)
+    {
+        fail(ErrorMemory);
+        return false;
+    }
+    return true;
+}
+
+bool OtaWriter::write(const uint8_t *data, size_t length, uint32_t now)
+{
+    if (status != Receiving)
+    {
+        return false;
+    }
+    hash.update(data, length);
+    received += length;
+    lastWrite = now;
+    if (manifest.size > 0 && received > manifest.size)
+    {
+        fail(ErrorSize);
+        return false;
+    }
+
+    while (length > 0)
+    {
+        // aligned input that covers a whole sector skips the copy
+        if (buffered == 0 && length >= SECTOR_SIZE)
+        {
+            sinkWrites++;
+            if (!sink(data, SECTOR_SIZE))
+            {
+                fail(ErrorWrite);
+                return false;
+            }
+            data += SECTOR_SIZE;
+            length -= SECTOR_SIZE;
+            continue;
+        }
+        size_t take = SECTOR_SIZE - buffered < length ? SECTOR_SIZE - buffered : length;
+        memcpy(buffer.get() + buffered, data, take);
+        buffered += take;
+        data += take;
+        length -= take;
+        if (buffered == SECTOR_SIZE && !flushBuffer())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OtaWriter::flushBuffer()
+{
+    sinkWrites++;
+    if (!sink(buffer.get(), buffered))
+    {
+        fail(ErrorWrite);
+        return false;
+    }
+    buffered = 0;
+    return true;
+}
+
+bool OtaWriter::finish(uint32_t now)
+{
+    if (status != Receiving)
+    {
+        return false;
+    }
+    lastWrite = now;
+    if (buffered > 0 && !flushBuffer())
+    {
+        return false;
+    }
+    if (manifest.size > 0 && received != manifest.size)
+    {
+        fail(ErrorSize);
+        return false;
+    }
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    hash.finish(digest);
+    if (manifest.hasDigest)
+    {
+        if (memcmp(digest, manifest.sha256, sizeof(digest)) != 0)
+        {
+            fail(ErrorDigest);
+            return false;
+        }
+        verified = true;
+    }
+    status = Done;
+    release();
+    return true;
+}
+
+void OtaWriter::fail(Error reason)
+{
+    status = Failed;
+    error = reason;
+    release();
+}
+
+void OtaWriter::release()
+{
+    buffer.reset();
+    buffered = 0;
+}
+
+OtaWriter::Progress OtaWriter::getProgress() const
+{
+    Progress progress;
+    progress.status = status;
+    progress.error = error;
+    progress.received = received;
+    progress.total = manifest.size;
+    progress.verified = verified;
+    uint32_t elapsed = lastWrite - started;
+    progress.bytesPerSecond = elapsed > 0 ? (uint32_t)((uint64_t)received * 1000 / elapsed) : 0;
+    return progress;
+}
+
+size_t OtaWriter::formatStatus(const Progress &progress, char *buffer, size_t length)
+{
+    static const char *const STATUS_NAMES[] = {"idle", "receiving", "done", "failed"};
+    static const char *const ERROR_NAMES[] = {"none", "begin", "memory", "write", "size", "digest", "network", "patch"};
+
+    char percent[8] = "null";
+    if (progress.total > 0)
+    {
+        uint32_t value = (uint32_t)((uint64_t)progress.received * 100 / progress.total);
+        snprintf(percent, sizeof(percent), "%u", (unsigned)(value > 100 ? 100 : value));
+    }
+    int written = snprintf(buffer, length, "{\"status\":\"%s\",\"error\":\"%s\",\"received\":%u,\"total\":%u,\"percent\":%s,\"bytesPerSecond\":%u,\"verified\":%s}",
+                           STATUS_NAMES[progress.status], ERROR_NAMES[progress.error],
+                           (unsigned)progress.received, (unsigned)progress.total, percent,
+                           (unsigned)progress.bytesPerSecond, progress.verified ? "true" : "false");
+    if (written < 0 || (size_t)written >= length)
+    {
+        return 0;
+    }
+    return (size_t)written;
+}
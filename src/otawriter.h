@@ -0,0 +1,92 @@
+#ifndef OTAWRITER_H
+#define OTAWRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <memory>
+#include "sha256.h"
+
+// Sits between the upload and the flash: chunks of any size are gathered
+// into whole 4 KiB sectors before they are written, and hashed on the way
+// so the image can be checked against its manifest before it is activated.
+// One update at a time, from the upload handler or the pull updater.
+class OtaWriter
+{
+public:
+    // writes one buffer to flash, all of it or fails
+    using Sink = std::function<bool(const uint8_t *data, size_t length)>;
+
+    // flash erase unit, every write but the last is this long
+    static const size_t SECTOR_SIZE = 4096;
+    // {"status":"receiving","error":"digest","received":1234567,...} with every member
+    static const size_t STATUS_SIZE = 160;
+
+    enum Status : uint8_t {
+        Idle = 0,
+        Receiving,
+        Done,
+        Failed
+    };
+
+    enum Error : uint8_t {
+        ErrorNone = 0,
+        ErrorBegin,  // flash not ready
+        ErrorMemory, // no buffer
+        ErrorWrite,
+        ErrorSize,   // not what the manifest says
+        ErrorDigest,
+        ErrorNetwork, // the download broke off
+        ErrorPatch    // a delta patch for another firmware, or damaged
+    };
+
+    // what the image should be, size 0 and no digest if unknown
+    struct Manifest {
+        uint32_t size;
+        bool hasDigest;
+        uint8_t sha256[Sha256::DIGEST_SIZE];
+    };
+
+    struct Progress {
+        Status status;
+        Error error;
+        uint32_t received;
+        uint32_t total;          // 0 if unknown
+        uint32_t bytesPerSecond;
+        bool verified;           // matched the manifest digest
+    };
+
+    explicit OtaWriter(const Sink &sink);
+
+    // false if the buffer cannot be allocated
+    bool begin(const Manifest &manifest, uint32_t now);
+    // false once anything failed, the rest of the upload is ignored
+    bool write(const uint8_t *data, size_t length, uint32_t now);
+    // writes the last partial sector and checks size and digest, true if the image can be activated
+    bool finish(uint32_t now);
+    void fail(Error error);
+
+    Progress getProgress() const;
+    size_t getSinkWrites() const { return sinkWrites; }
+    // the progress as JSON for the status endpoint
+    static size_t formatStatus(const Progress &progress, char *buffer, size_t length);
+
+private:
+    Sink sink;
+    std::unique_ptr<uint8_t[]> buffer;
+    size_t buffered = 0;
+    Sha256 hash;
+    Manifest manifest;
+    Status status = Idle;
+    Error error = ErrorNone;
+    bool verified = false;
+    uint32_t received = 0;
+    uint32_t started = 0;
+    uint32_t lastWrite = 0;
+    size_t sinkWrites = 0;
+
+    bool flushBuffer();
+    void release();
+};
+
+#endif // OTAWRITER_H
@@ -0,0 +1,129 @@
+#include "pagecache.h"
+#include <stdio.h>
+#include <string.h>
+
+uint32_t PageCache::mix(uint32_t version, uint32_t value)
+{
+    // FNV-1a over the four bytes of value
+    uint32_t hash = version ^ 0x811C9DC5;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        hash ^= (value >> (8 * i)) & 0xFF;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void PageCache::formatETag(char *buffer, size_t length, uint32_t bootId, uint8_t page, Encoding encoding, uint32_t version)
+{
+    // the boot id keeps tags from before a restart, when versions start over, from matching
+    snprintf(buffer, length, "\"b%08lx-p%u%s-%08lx\"", static_cast<unsigned long>(bootId), page, encoding == Gzip ? "g" : "",
+             static_cast<unsigned long>(version));
+}
+
+bool PageCache::matchesETag(const char *ifNoneMatch, const char *etag)
+{
+    if (ifNoneMatch == nullptr || etag == nullptr)
+    {
+        return false;
+    }
+
+    size_t etagLength = strlen(etag);
+    const char *cursor = ifNoneMatch;
+    while (*cursor != '\0')
+    {
+        while (*cursor == ' ' || *cursor == ',')
+        {
+            cursor++;
+        }
+        if (*cursor == '*')
+        {
+            return true;
+        }
+        // weak comparison is fine for GET revalidation
+        if (strncmp(cursor, "W/", 2) == 0)
+        {
+            cursor += 2;
+        }
+        const char *end = strchr(cursor, ',');
+        size_t length = end != nullptr ? static_cast<size_t>(end - cursor) : strlen(cursor);
+        while (length > 0 && cursor[length - 1] == ' ')
+        {
+            length--;
+        }
+        if (length == etagLength && strncmp(cursor, etag, length) == 0)
+        {
+            return true;
+        }
+        if (end == nullptr)
+        {
+            break;
+        }
+        cursor = end;
+    }
+    return false;
+}
+
+std::shared_ptr<const PageCache::Body> PageCache::get(uint8_t page, Encoding encoding, uint32_t version) const
+{
+    if (page < MAX_PAGES && encoding < ENCODING_COUNT && slots[page][encoding].body && slots[page][encoding].version == version)
+    {
+        hits++;
+        return slots[page][encoding].body;
+    }
+    misses++;
+    return nullptr;
+}
+
+void PageCache::put(uint8_t page, Encoding encoding, uint32_t version, std::shared_ptr<const Body> body)
+{
+    if (page >= MAX_PAGES || encoding >= ENCODING_COUNT)
+    {
+        return;
+    }
+    slots[page][encoding].version = version;
+    slots[page][encoding].body = body;
+}
+
+void PageCache::clear()
+{
+    for (uint8_t i = 0; i < MAX_PAGES; i++)
+    {
+        for (uint8_t encoding = 0; encoding < ENCODING_COUNT; encoding++)
+        {
+            slots[i][encoding].body.reset();
+        }
+    }
+}
+
+PageCache::Capture::Capture(uint8_t page, Encoding encoding, uint32_t version, size_t expectedSize)
+    : page(page), encoding(encoding), version(version), body(std::make_shared<Body>())
+{
+    body->reserve(expectedSize < MAX_BODY_SIZE ? expectedSize : MAX_BODY_SIZE);
+}
+
+void PageCache::Capture::append(const uint8_t *data, size_t length)
+{
+    if (overflow)
+    {
+        return;
+    }
+    if (body->size() + length > MAX_BODY_SIZE)
+    {
+        overflow = true;
+        body.reset();
+        return;
+    }
+    body->insert(body->end(), data, data + length);
+}
+
+void PageCache::Capture::commit(PageCache &cache)
+{
+    if (overflow || !body)
+    {
+        return;
+    }
+    body->shrink_to_fit();
+    cache.put(page, encoding, version, body);
+    body.reset();
+}
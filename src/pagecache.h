@@ -0,0 +1,70 @@
+#ifndef PAGECACHE_H
+#define PAGECACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <vector>
+
+// Last rendered output per page and encoding, valid as long as the page
+// version it was rendered for. Bodies are shared so a response still streaming an old
+// version keeps it alive after the slot moved on.
+class PageCache
+{
+public:
+    using Body = std::vector<uint8_t>;
+
+    static const uint8_t MAX_PAGES = 4;
+    // each variant has its own slot and tag, they are different bodies
+    enum Encoding : uint8_t {
+        Identity,
+        Gzip,
+        ENCODING_COUNT
+    };
+    // larger pages are rendered every time
+    static const size_t MAX_BODY_SIZE = 16384;
+    // "b<boot>-p<page>[g]-<version>" with quotes
+    static const size_t ETAG_SIZE = 32;
+
+    // folds a value into a page version
+    static uint32_t mix(uint32_t version, uint32_t value);
+    static void formatETag(char *buffer, size_t length, uint32_t bootId, uint8_t page, Encoding encoding, uint32_t version);
+    // If-None-Match may list several tags, optionally weak, or be "*"
+    static bool matchesETag(const char *ifNoneMatch, const char *etag);
+
+    std::shared_ptr<const Body> get(uint8_t page, Encoding encoding, uint32_t version) const;
+    void put(uint8_t page, Encoding encoding, uint32_t version, std::shared_ptr<const Body> body);
+    void clear();
+
+    uint32_t getHits() const { return hits; }
+    uint32_t getMisses() const { return misses; }
+
+    // collects a response while it is sent, gives up once it gets too large
+    class Capture
+    {
+    public:
+        Capture(uint8_t page, Encoding encoding, uint32_t version, size_t expectedSize);
+        void append(const uint8_t *data, size_t length);
+        // stores the body if it was complete
+        void commit(PageCache &cache);
+
+    private:
+        uint8_t page;
+        Encoding encoding;
+        uint32_t version;
+        bool overflow = false;
+        std::shared_ptr<Body> body;
+    };
+
+private:
+    struct Slot {
+        uint32_t version;
+        std::shared_ptr<const Body> body;
+    };
+
+    Slot slots[MAX_PAGES][ENCODING_COUNT];
+    mutable uint32_t hits = 0;
+    mutable uint32_t misses = 0;
+};
+
+#endif // PAGECACHE_H
@@ -0,0 +1,196 @@
+#include "pagetemplate.h"
+#include <ctype.h>
+#include <string.h>
+
+// indexed by Variable, Literal and Unknown have no name
+static const char *const VARIABLE_NAMES[PageTemplate::VARIABLE_COUNT] = {
+    nullptr,
+    nullptr,
+    "INCLUDE_HEADER",
+    "PAGE_TITLE",
+    "ACTIVE_LIGHT",
+    "ACTIVE_TIME",
+    "ACTIVE_SYSTEM",
+};
+
+PageTemplate::Variable PageTemplate::findVariable(const char *name, size_t length)
+{
+    for (uint8_t i = IncludeHeader; i < VARIABLE_COUNT; i++)
+    {
+        if (strlen(VARIABLE_NAMES[i]) == length && memcmp(VARIABLE_NAMES[i], name, length) == 0)
+        {
+            return static_cast<Variable>(i);
+        }
+    }
+    return Unknown;
+}
+
+const char *PageTemplate::getName(Variable variable)
+{
+    return variable < VARIABLE_COUNT ? VARIABLE_NAMES[variable] : nullptr;
+}
+
+void PageTemplate::reset()
+{
+    tokens.clear();
+    size = 0;
+    literalStart = 0;
+    inName = false;
+    nameLength = 0;
+}
+
+void PageTemplate::addLiteral(uint32_t offset, uint32_t length)
+{
+    if (length == 0)
+    {
+        return;
+    }
+    // spans interrupted by "%%" or invalid names continue the previous literal
+    if (!tokens.empty() && tokens.back().variable == Literal && tokens.back().offset + tokens.back().length == offset)
+    {
+        tokens.back().length += length;
+        return;
+    }
+    tokens.push_back({offset, length, Literal});
+}
+
+void PageTemplate::addVariable(uint32_t offset, uint32_t length, Variable variable)
+{
+    tokens.push_back({offset, length, variable});
+}
+
+void PageTemplate::feed(const char *chunk, size_t length)
+{
+    for (size_t i = 0; i < length; i++, size++)
+    {
+        char c = chunk[i];
+        if (!inName)
+        {
+            if (c == '%')
+            {
+                inName = true;
+                nameStart = size;
+                nameLength = 0;
+            }
+            continue;
+        }
+
+        if (c == '%')
+        {
+            if (nameLength == 0)
+            {
+                // "%%" is a literal '%', keep the first one
+                addLiteral(literalStart, nameStart + 1 - literalStart);
+            }
+            else
+            {
+                addLiteral(literalStart, nameStart - literalStart);
+                addVariable(nameStart, size + 1 - nameStart, findVariable(name, nameLength));
+            }
+            literalStart = size + 1;
+            inName = false;
+        }
+        else if ((isalnum(static_cast<unsigned char>(c)) || c == '_') && nameLength < MAX_NAME)
+        {
+            name[nameLength++] = c;
+        }
+        else
+        {
+            // not a variable, the text up to here stays part of the literal
+            inName = false;
+        }
+    }
+}
+
+void PageTemplate::finish()
+{
+    addLiteral(literalStart, size - literalStart);
+    literalStart = size;
+    inName = false;
+}
+
+TemplateRenderer::TemplateRenderer(const PageTemplate &page, const PageTemplate &header, const char *headerText)
+    : page(page), header(header), headerText(headerText)
+{
+}
+
+size_t TemplateRenderer::read(uint8_t *buffer, size_t length)
+{
+    size_t written = 0;
+    while (written < length && !done)
+    {
+        if (pendingOffset < pendingLength)
+        {
+            size_t count = pendingLength - pendingOffset;
+            if (count > length - written)
+            {
+                count = length - written;
+            }
+            memcpy(buffer + written, pending + pendingOffset, count);
+            pendingOffset += count;
+            written += count;
+            continue;
+        }
+
+        const PageTemplate &current = inHeader ? header : page;
+        size_t &index = inHeader ? headerIndex : pageIndex;
+        if (index >= current.getTokenCount())
+        {
+            if (!inHeader)
+            {
+                done = true;
+                break;
+            }
+            inHeader = false;
+            pageIndex++;
+            continue;
+        }
+
+        const PageTemplate::Token &token = current.getTokens()[index];
+        if (token.variable == PageTemplate::Literal)
+        {
+            size_t count = token.length - progress;
+            if (count > length - written)
+            {
+                count = length - written;
+            }
+            if (inHeader)
+            {
+                memcpy(buffer + written, headerText + token.offset + progress, count);
+            }
+            else
+            {
+                count = readPage(token.offset + progress, buffer + written, count);
+                if (count == 0)
+                {
+                    done = true;
+                    failed = true;
+                    break;
+                }
+            }
+            written += count;
+            progress += count;
+            if (progress == token.length)
+            {
+                progress = 0;
+                index++;
+            }
+        }
+        else if (token.variable == PageTemplate::IncludeHeader && !inHeader && headerText != nullptr)
+        {
+            inHeader = true;
+            headerIndex = 0;
+        }
+        else
+        {
+            pendingLength = token.variable == PageTemplate::Unknown ? 0 : writeVariable(token.variable, pending, sizeof(pending));
+            if (pendingLength > sizeof(pending))
+            {
+                pendingLength = sizeof(pending);
+            }
+            pendingOffset = 0;
+            index++;
+        }
+    }
+    return written;
+}
@@ -0,0 +1,97 @@
+#ifndef PAGETEMPLATE_H
+#define PAGETEMPLATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// An HTML template split once into literal spans and %VARIABLE% ids. The
+// text itself stays where it is (flash or RAM), tokens only hold offsets.
+// "%%" stands for a single '%', names are letters, digits and '_'; anything
+// else between two '%' is left as text.
+class PageTemplate
+{
+public:
+    enum Variable : uint8_t {
+        Literal = 0,
+        Unknown,
+        IncludeHeader,
+        PageTitle,
+        ActiveLight,
+        ActiveTime,
+        ActiveSystem,
+        VARIABLE_COUNT
+    };
+
+    struct Token {
+        uint32_t offset;
+        uint32_t length;
+        Variable variable; // Literal: text at offset, otherwise the span it replaces
+    };
+
+    static const uint8_t MAX_NAME = 32;
+
+    static Variable findVariable(const char *name, size_t length);
+    static const char *getName(Variable variable);
+
+    // compiles from chunks of any size, the text is never needed as a whole
+    void reset();
+    void feed(const char *chunk, size_t length);
+    void finish();
+
+    const Token *getTokens() const { return tokens.data(); }
+    size_t getTokenCount() const { return tokens.size(); }
+    uint32_t getSize() const { return size; }
+    bool isEmpty() const { return tokens.empty(); }
+
+private:
+    std::vector<Token> tokens;
+    uint32_t size = 0;
+    uint32_t literalStart = 0;
+    bool inName = false;
+    uint32_t nameStart = 0;
+    uint8_t nameLength = 0;
+    char name[MAX_NAME];
+
+    void addLiteral(uint32_t offset, uint32_t length);
+    void addVariable(uint32_t offset, uint32_t length, Variable variable);
+};
+
+// Streams a compiled page, expanding IncludeHeader with a second template
+// whose text is held in RAM. Subclasses supply the page text and values.
+class TemplateRenderer
+{
+public:
+    // large enough for the longest value, e.g. the page title
+    static const size_t VALUE_SIZE = 64;
+
+    TemplateRenderer(const PageTemplate &page, const PageTemplate &header, const char *headerText);
+    virtual ~TemplateRenderer() {}
+
+    // fills up to length bytes, returns 0 once the page is complete
+    size_t read(uint8_t *buffer, size_t length);
+    // the page text could not be read, the output stopped early
+    bool hasFailed() const { return failed; }
+
+protected:
+    // returns the bytes read, 0 ends the page early
+    virtual size_t readPage(uint32_t offset, uint8_t *buffer, size_t length) = 0;
+    // writes the value (without terminator) and returns its length
+    virtual size_t writeVariable(PageTemplate::Variable variable, char *buffer, size_t length) = 0;
+
+private:
+    const PageTemplate &page;
+    const PageTemplate &header;
+    const char *headerText;
+    bool inHeader = false;
+    bool done = false;
+    bool failed = false;
+    size_t pageIndex = 0;
+    size_t headerIndex = 0;
+    uint32_t progress = 0;
+    char pending[VALUE_SIZE];
+    size_t pendingLength = 0;
+    size_t pendingOffset = 0;
+};
+
+#endif // PAGETEMPLATE_H
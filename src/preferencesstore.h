@@ -0,0 +1,42 @@
+#ifndef PREFERENCESSTORE_H
+#define PREFERENCESSTORE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "ikeyvaluestore.h"
+#include "legacyconfig.h"
+
+// IKeyValueStore on an opened Preferences namespace
+class PreferencesStore : public IKeyValueStore
+{
+private:
+    Preferences &preferences;
+
+public:
+    PreferencesStore(Preferences &preferences) : preferences(preferences) {}
+    size_t getLength(const char *key) override { return preferences.isKey(key) ? preferences.getBytesLength(key) : 0; }
+    size_t read(const char *key, void *buffer, size_t length) override { return preferences.getBytes(key, buffer, length); }
+    size_t write(const char *key, const void *buffer, size_t length) override { return preferences.putBytes(key, buffer, length); }
+    bool clear() override { return preferences.clear(); }
+};
+
+// ILegacyPreferences on an opened Preferences namespace
+class LegacyPreferences : public ILegacyPreferences
+{
+private:
+    Preferences &preferences;
+
+public:
+    LegacyPreferences(Preferences &preferences) : preferences(preferences) {}
+    bool isKey(const char *key) override { return preferences.isKey(key); }
+    bool getBool(const char *key, bool defaultValue) override { return preferences.getBool(key, defaultValue); }
+    uint8_t getUChar(const char *key, uint8_t defaultValue) override { return preferences.getUChar(key, defaultValue); }
+    uint16_t getUShort(const char *key, uint16_t defaultValue) override { return preferences.getUShort(key, defaultValue); }
+    uint32_t getUInt(const char *key, uint32_t defaultValue) override { return preferences.getUInt(key, defaultValue); }
+    uint32_t getULong(const char *key, uint32_t defaultValue) override { return preferences.getULong(key, defaultValue); }
+    float getFloat(const char *key, float defaultValue) override { return preferences.getFloat(key, defaultValue); }
+    size_t getBytesLength(const char *key) override { return preferences.isKey(key) ? preferences.getBytesLength(key) : 0; }
+    size_t getBytes(const char *key, void *buffer, size_t length) override { return preferences.getBytes(key, buffer, length); }
+};
+
+#endif // PREFERENCESSTORE_H
@@ -0,0 +1,516 @@
+#include "pullupdater.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// by Step
+static const char *const FILES[] = {"firmware.bin.json", "littlefs.bin.json", "firmware.bin", "littlefs.bin"};
+
+PullUpdater::PullUpdater(Stream &stream, OtaWriter &writer, const BeginCallback &beginCb, const EndCallback &endCb)
+    : stream(stream), writer(writer), beginCallback(beginCb), endCallback(endCb)
+{
+    host[0] = '\0';
+    basePath[0] = '\0';
+    currentVersion[0] = '\0';
+    memset(&firmware, 0, sizeof(firmware));
+    memset(&filesystem, 0, sizeof(filesystem));
+}
+
+bool PullUpdater::start(const char *baseUrl, const char *version, uint32_t now)
+{
+    // one update at a time, uploads included
+    if (isBusy() || writer.getProgress().status == OtaWriter::Receiving)
+    {
+        return false;
+    }
+    const char *path;
+    if (!parseUrl(baseUrl, host, sizeof(host), port, path) || strlen(path) >= sizeof(basePath))
+    {
+        return false;
+    }
+    strcpy(basePath, path);
+    size_t length = strlen(basePath);
+    if (length > 0 && basePath[length - 1] == '/')
+    {
+        basePath[length - 1] = '\0';
+    }
+    snprintf(currentVersion, sizeof(currentVersion), "%s", version);
+
+    hasFilesystem = false;
+    activated = false;
+    resumes = 0;
+    failure = nullptr;
+    status = Checking;
+    beginStep(FirmwareManifest, now);
+    return true;
+}
+
+uint32_t PullUpdater::imageOffset() const
+{
+    return writer.getProgress().received;
+}
+
+void PullUpdater::beginStep(Step next, uint32_t now)
+{
+    step = next;
+    phase = Connecting;
+    retryAt = now;
+    buffered = 0;
+    if (!isManifest())
+    {
+        const Manifest &manifest = imageManifest();
+        if (!beginCallback(imageType(), manifest.image.size))
+        {
+            fail("flash not ready");
+            return;
+        }
+        imageOpen = true;
+        if (!writer.begin(manifest.image, now))
+        {
+            fail("no memory");
+        }
+    }
+}
+
+void PullUpdater::loop(uint32_t now)
+{
+    if (!isBusy())
+    {
+        return;
+    }
+
+    if (phase == Connecting)
+    {
+        if (static_cast<int32_t>(now - retryAt) < 0)
+        {
+            return;
+        }
+        if (!stream.connect(host, port) || !sendRequest())
+        {
+            connectionLost(now);
+            return;
+        }
+        phase = Headers;
+        buffered = 0;
+        lastData = now;
+        return;
+    }
+
+    uint8_t chunk[READ_SIZE];
+    size_t budget = BYTES_PER_LOOP;
+    while (budget > 0 && isBusy() && phase != Connecting)
+    {
+        int count;
+        if (phase == Headers)
+        {
+            if (buffered >= sizeof(buffer) - 1)
+            {
+                fail("response headers too long");
+                return;
+            }
+            count = stream.read(reinterpret_cast<uint8_t *>(buffer) + buffered, sizeof(buffer) - 1 - buffered);
+        }
+        else
+        {
+            count = stream.read(chunk, budget < sizeof(chunk) ? budget : sizeof(chunk));
+        }
+
+        if (count < 0)
+        {
+            connectionLost(now);
+            return;
+        }
+        if (count == 0)
+        {
+            if (now - lastData > TIMEOUT_MS)
+            {
+                connectionLost(now);
+            }
+            return;
+        }
+        lastData = now;
+        budget = (size_t)count < budget ? budget - count : 0;
+
+        if (phase == Body)
+        {
+            consume(chunk, count, now);
+            continue;
+        }
+
+        buffered += count;
+        buffer[buffered] = '\0';
+        char *end = strstr(buffer, "\r\n\r\n");
+        if (end == nullptr)
+        {
+            continue;
+        }
+        size_t headerLength = end - buffer + 4;
+        size_t rest = buffered - headerLength;
+        if (!parseHeaders(headerLength) || !acceptResponse(now))
+        {
+            return;
+        }
+        phase = Body;
+        // whatever came with the headers is the start of the body
+        memmove(buffer, buffer + headerLength, rest);
+        buffered = 0;
+        if (isManifest())
+        {
+            consume(reinterpret_cast<const uint8_t *>(buffer), rest, now);
+        }
+        else if (rest > 0)
+        {
+            memcpy(chunk, buffer, rest);
+            consume(chunk, rest, now);
+        }
+    }
+}
+
+bool PullUpdater::sendRequest()
+{
+    char request[HEADER_SIZE];
+    int length;
+    uint32_t offset = isManifest() ? 0 : imageOffset();
+    if (offset > 0)
+    {
+        length = snprintf(request, sizeof(request), "GET %s/%s HTTP/1.1\r\nHost: %s\r\nRange: bytes=%u-\r\nConnection: close\r\n\r\n",
+                          basePath, FILES[step], host, (unsigned)offset);
+    }
+    else
+    {
+        length = snprintf(request, sizeof(request), "GET %s/%s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n",
+                          basePath, FILES[step], host);
+    }
+    if (length < 0 || (size_t)length >= sizeof(request))
+    {
+        return false;
+    }
+    return stream.write(reinterpret_cast<const uint8_t *>(request), length) == (size_t)length;
+}
+
+bool PullUpdater::parseHeaders(size_t length)
+{
+    buffer[length - 2] = '\0';
+    responseStatus = 0;
+    contentStart = 0;
+    contentLength = 0;
+    bool hasLength = false;
+
+    char *line = buffer;
+    if (strncmp(line, "HTTP/1.", 7) != 0)
+    {
+        fail("not HTTP");
+        return false;
+    }
+    responseStatus = atoi(line + 9);
+    while ((line = strstr(line, "\r\n")) != nullptr)
+    {
+        line += 2;
+        if (strncasecmp(line, "Content-Length:", 15) == 0)
+        {
+            contentLength = strtoul(line + 15, nullptr, 10);
+            hasLength = true;
+        }
+        else if (strncasecmp(line, "Content-Range:", 14) == 0)
+        {
+            uint32_t total;
+            const char *value = line + 14;
+            while (*value == ' ')
+            {
+                value++;
+            }
+            if (!parseContentRange(value, contentStart, total))
+            {
+                fail("bad Content-Range");
+                return false;
+            }
+        }
+        else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 && strstr(line, "chunked") != nullptr)
+        {
+            // not used for files
+            fail("chunked response");
+            return false;
+        }
+    }
+    if (!hasLength && responseStatus / 100 == 2)
+    {
+        fail("no Content-Length");
+        return false;
+    }
+    return true;
+}
+
+bool PullUpdater::acceptResponse(uint32_t now)
+{
+    if (isManifest())
+    {
+        if (responseStatus == 404 && step == FilesystemManifest)
+        {
+            // firmware only
+            stream.stop();
+            hasFilesystem = false;
+            status = Downloading;
+            beginStep(FirmwareImage, now);
+            return false;
+        }
+        if (responseStatus != 200 || contentLength == 0 || contentLength >= sizeof(buffer))
+        {
+            fail("no manifest");
+            return false;
+        }
+        return true;
+    }
+
+    uint32_t offset = imageOffset();
+    uint32_t size = imageManifest().image.size;
+    if (responseStatus == 206 && contentStart == offset && offset + contentLength == size)
+    {
+        skip = 0;
+        return true;
+    }
+    if (responseStatus == 200 && contentLength == size)
+    {
+        // the server ignored the range, what is already written is read past
+        skip = offset;
+        return true;
+    }
+    fail("unexpected image response");
+    return false;
+}
+
+void PullUpdater::consume(const uint8_t *data, size_t length, uint32_t now)
+{
+    if (isManifest())
+    {
+        // data may already be in place at the start of buffer
+        if (buffered + length > contentLength)
+        {
+            fail("manifest too long");
+            return;
+        }
+        memmove(buffer + buffered, data, length);
+        buffered += length;
+        if (buffered == contentLength)
+        {
+            buffer[buffered] = '\0';
+            completeStep(now);
+        }
+        return;
+    }
+
+    if (skip > 0)
+    {
+        size_t skipped = skip < length ? skip : length;
+        skip -= skipped;
+        data += skipped;
+        length -= skipped;
+    }
+    if (length > 0 && !writer.write(data, length, now))
+    {
+        fail("image rejected");
+        return;
+    }
+    if (imageOffset() == imageManifest().image.size)
+    {
+        completeStep(now);
+    }
+}
+
+void PullUpdater::completeStep(uint32_t now)
+{
+    stream.stop();
+    switch (step)
+    {
+    case FirmwareManifest:
+        if (!parseManifest(buffer, firmware))
+        {
+            fail("bad firmware manifest");
+            return;
+        }
+        if (strcmp(firmware.version, currentVersion) == 0)
+        {
+            status = UpToDate;
+            return;
+        }
+        beginStep(FilesystemManifest, now);
+        break;
+    case FilesystemManifest:
+        if (!parseManifest(buffer, filesystem))
+        {
+            fail("bad filesystem manifest");
+            return;
+        }
+        hasFilesystem = true;
+        status = Downloading;
+        beginStep(FirmwareImage, now);
+        break;
+    case FirmwareImage:
+    case FilesystemImage:
+    {
+        bool verified = writer.finish(now);
+        imageOpen = false;
+        if (!endCallback(imageType(), verified))
+        {
+            fail(verified ? "image not activated" : "image did not match the manifest");
+            return;
+        }
+        activated = true;
+        if (step == FirmwareImage && hasFilesystem)
+        {
+            beginStep(FilesystemImage, now);
+        }
+        else
+        {
+            status = Done;
+        }
+        break;
+    }
+    }
+}
+
+void PullUpdater::connectionLost(uint32_t now)
+{
+    stream.stop();
+    if (resumes >= MAX_RESUMES)
+    {
+        fail("connection lost");
+        return;
+    }
+    resumes++;
+    phase = Connecting;
+    retryAt = now + RETRY_DELAY_MS;
+    buffered = 0;
+}
+
+void PullUpdater::fail(const char *reason)
+{
+    stream.stop();
+    if (imageOpen)
+    {
+        // the partly written image is dropped
+        imageOpen = false;
+        if (writer.getProgress().status == OtaWriter::Receiving)
+        {
+            writer.fail(OtaWriter::ErrorNetwork);
+        }
+        endCallback(imageType(), false);
+    }
+    failure = reason;
+    status = Failed;
+}
+
+bool PullUpdater::parseUrl(const char *url, char *hostName, size_t hostSize, uint16_t &hostPort, const char *&path)
+{
+    static const char SCHEME[] = "http://";
+    if (url == nullptr || strncmp(url, SCHEME, sizeof(SCHEME) - 1) != 0)
+    {
+        return false;
+    }
+    const char *start = url + sizeof(SCHEME) - 1;
+    const char *end = start;
+    while (*end != '\0' && *end != ':' && *end != '/')
+    {
+        end++;
+    }
+    size_t length = end - start;
+    if (length == 0 || length >= hostSize)
+    {
+        return false;
+    }
+    memcpy(hostName, start, length);
+    hostName[length] = '\0';
+
+    hostPort = 80;
+    if (*end == ':')
+    {
+        char *after;
+        unsigned long value = strtoul(end + 1, &after, 10);
+        if (after == end + 1 || value == 0 || value > 65535 || (*after != '\0' && *after != '/'))
+        {
+            return false;
+        }
+        hostPort = (uint16_t)value;
+        end = after;
+    }
+    path = end;
+    return true;
+}
+
+// the value after "key": in a flat JSON object, nullptr if it is missing
+static const char *findValue(const char *json, const char *key)
+{
+    char pattern[16];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    const char *at = strstr(json, pattern);
+    if (at == nullptr)
+    {
+        return nullptr;
+    }
+    at += strlen(pattern);
+    while (*at == ' ' || *at == '\t' || *at == '\r' || *at == '\n')
+    {
+        at++;
+    }
+    if (*at != ':')
+    {
+        return nullptr;
+    }
+    at++;
+    while (*at == ' ' || *at == '\t' || *at == '\r' || *at == '\n')
+    {
+        at++;
+    }
+    return at;
+}
+
+// a string value without escapes, false if it does not fit
+static bool copyStringValue(const char *value, char *destination, size_t size)
+{
+    if (value == nullptr || *value != '"')
+    {
+        return false;
+    }
+    const char *end = strchr(value + 1, '"');
+    if (end == nullptr || (size_t)(end - value - 1) >= size)
+    {
+        return false;
+    }
+    memcpy(destination, value + 1, end - value - 1);
+    destination[end - value - 1] = '\0';
+    return true;
+}
+
+bool PullUpdater::parseManifest(const char *json, Manifest &manifest)
+{
+    memset(&manifest, 0, sizeof(manifest));
+    if (!copyStringValue(findValue(json, "version"), manifest.version, sizeof(manifest.version)))
+    {
+        return false;
+    }
+    const char *size = findValue(json, "size");
+    if (size == nullptr)
+    {
+        return false;
+    }
+    manifest.image.size = strtoul(size, nullptr, 10);
+    char digest[Sha256::HEX_SIZE];
+    if (manifest.image.size == 0 || !copyStringValue(findValue(json, "sha256"), digest, sizeof(digest)))
+    {
+        return false;
+    }
+    manifest.image.hasDigest = Sha256::parseHex(digest, manifest.image.sha256);
+    return manifest.image.hasDigest;
+}
+
+bool PullUpdater::parseContentRange(const char *value, uint32_t &start, uint32_t &total)
+{
+    unsigned long first, last, size;
+    if (sscanf(value, "bytes %lu-%lu/%lu", &first, &last, &size) != 3 || first > last || last >= size)
+    {
+        return false;
+    }
+    start = first;
+    total = size;
+    return true;
+}
@@ -0,0 +1,144 @@
+#ifndef PULLUPDATER_H
+#define PULLUPDATER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include "callbacktypes.h"
+#include "otawriter.h"
+
+// Fetches the images from a directory on a plain HTTP server:
+//
+//   firmware.bin.json  firmware.bin   required
+//   littlefs.bin.json  littlefs.bin   optional
+//
+// The manifests are the ones tools/otamanifest.py writes. Nothing is
+// downloaded if the firmware manifest has the running version. Images are
+// streamed into the OtaWriter a little per loop() call, and a dropped
+// connection is picked up again with a Range request where it broke off.
+// The transport is a plain byte stream, WiFiClient on the device.
+class PullUpdater
+{
+public:
+    class Stream
+    {
+    public:
+        virtual ~Stream() {}
+        virtual bool connect(const char *host, uint16_t port) = 0;
+        virtual size_t write(const uint8_t *data, size_t length) = 0;
+        // bytes read, 0 if nothing has arrived yet, -1 once the connection is closed
+        virtual int read(uint8_t *buffer, size_t length) = 0;
+        virtual void stop() = 0;
+    };
+
+    // prepares the flash for an image of size bytes, false if that is not possible
+    using BeginCallback = std::function<bool(UpdateType type, uint32_t size)>;
+    // verified is false if the image is incomplete or did not match, returns true if it was activated
+    using EndCallback = std::function<bool(UpdateType type, bool verified)>;
+
+    enum Status : uint8_t {
+        Idle = 0,
+        Checking,
+        Downloading,
+        UpToDate,
+        Done,
+        Failed
+    };
+
+    struct Manifest {
+        char version[32];
+        OtaWriter::Manifest image;
+    };
+
+    static const size_t URL_SIZE = 96;
+    // request and response headers, and the manifests
+    static const size_t HEADER_SIZE = 512;
+    static const size_t READ_SIZE = 1024;
+    // per loop() call, the clock keeps running while an image comes in
+    static const size_t BYTES_PER_LOOP = 8192;
+    static const uint8_t MAX_RESUMES = 5;
+    static const uint32_t RETRY_DELAY_MS = 2000;
+    // without a byte from the server
+    static const uint32_t TIMEOUT_MS = 10000;
+
+    PullUpdater(Stream &stream, OtaWriter &writer, const BeginCallback &beginCb, const EndCallback &endCb);
+
+    // baseUrl is http://host[:port]/directory, false if it cannot be used or an update is running
+    bool start(const char *baseUrl, const char *currentVersion, uint32_t now);
+    void loop(uint32_t now);
+
+    Status getStatus() const { return status; }
+    bool isBusy() const { return status == Checking || status == Downloading; }
+    // an image was activated, the device has to restart
+    bool hasActivated() const { return activated; }
+    uint8_t getResumes() const { return resumes; }
+    // why the last update failed, nullptr otherwise
+    const char *getFailure() const { return failure; }
+
+    static bool parseUrl(const char *url, char *host, size_t hostSize, uint16_t &port, const char *&path);
+    static bool parseManifest(const char *json, Manifest &manifest);
+    // "bytes 100-199/1000"
+    static bool parseContentRange(const char *value, uint32_t &start, uint32_t &total);
+
+private:
+    enum Step : uint8_t {
+        FirmwareManifest = 0,
+        FilesystemManifest,
+        FirmwareImage,
+        FilesystemImage
+    };
+
+    enum Phase : uint8_t {
+        Connecting,
+        Headers,
+        Body
+    };
+
+    Stream &stream;
+    OtaWriter &writer;
+    BeginCallback beginCallback;
+    EndCallback endCallback;
+
+    Status status = Idle;
+    Step step = FirmwareManifest;
+    Phase phase = Connecting;
+    char host[64];
+    uint16_t port = 80;
+    char basePath[URL_SIZE];
+    char currentVersion[32];
+    Manifest firmware;
+    Manifest filesystem;
+    bool hasFilesystem = false;
+    bool activated = false;
+    // begun and not ended yet
+    bool imageOpen = false;
+    uint8_t resumes = 0;
+    uint32_t retryAt = 0;
+    uint32_t lastData = 0;
+    const char *failure = nullptr;
+
+    // headers first, then the manifest body
+    char buffer[HEADER_SIZE];
+    size_t buffered = 0;
+    int responseStatus = 0;
+    uint32_t contentStart = 0;
+    uint32_t contentLength = 0;
+    // leading bytes of a full response to a range request that are already written
+    uint32_t skip = 0;
+
+    bool isManifest() const { return step == FirmwareManifest || step == FilesystemManifest; }
+    UpdateType imageType() const { return step == FirmwareImage ? UpdateType::FIRMWARE : UpdateType::FILESYSTEM; }
+    const Manifest &imageManifest() const { return step == FirmwareImage ? firmware : filesystem; }
+    uint32_t imageOffset() const;
+
+    void beginStep(Step next, uint32_t now);
+    bool sendRequest();
+    bool parseHeaders(size_t length);
+    bool acceptResponse(uint32_t now);
+    void consume(const uint8_t *data, size_t length, uint32_t now);
+    void completeStep(uint32_t now);
+    void connectionLost(uint32_t now);
+    void fail(const char *reason);
+};
+
+#endif // PULLUPDATER_H
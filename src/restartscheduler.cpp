@@ -0,0 +1,23 @@
+#include "restartscheduler.h"
+
+void RestartScheduler::schedule(uint32_t now, uint32_t graceMs)
+{
+    uint32_t at = now + graceMs;
+    uint32_t current = restartAt.load();
+    // only ever later, whichever request comes last
+    while ((!pending.load() || static_cast<int32_t>(at - current) > 0) &&
+           !restartAt.compare_exchange_weak(current, at))
+    {
+    }
+    pending.store(true);
+}
+
+bool RestartScheduler::due(uint32_t now) const
+{
+    if (!pending.load())
+    {
+        return false;
+    }
+    // wraps with millis() after 49 days
+    return static_cast<int32_t>(now - restartAt.load()) >= 0;
+}
@@ -0,0 +1,27 @@
+#ifndef RESTARTSCHEDULER_H
+#define RESTARTSCHEDULER_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Restarts are requested from web handlers on the AsyncTCP task and carried
+// out by the main loop once the grace period has passed, so the response
+// still goes out and nothing waits inside the network stack.
+class RestartScheduler
+{
+public:
+    // long enough for a response to be flushed
+    static const uint32_t GRACE_MS = 1000;
+
+    // safe from any task, a second request moves the restart further out
+    void schedule(uint32_t now, uint32_t graceMs = GRACE_MS);
+    bool isPending() const { return pending.load(); }
+    // main loop only, true once the grace period of a pending restart has passed
+    bool due(uint32_t now) const;
+
+private:
+    std::atomic<uint32_t> restartAt{0};
+    std::atomic<bool> pending{false};
+};
+
+#endif // RESTARTSCHEDULER_H
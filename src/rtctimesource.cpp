@@ -0,0 +1,26 @@
+#include "rtctimesource.h"
+
+RtcTimeSource::RtcTimeSource(RTC_DS3231 &rtc) : rtc(rtc)
+{
+}
+
+RtcTimeSource::~RtcTimeSource()
+{
+}
+
+bool RtcTimeSource::begin()
+{
+    return rtc.begin();
+}
+
+bool RtcTimeSource::now(time_t &utc)
+{
+    utc = rtc.now().unixtime();
+    return true;
+}
+
+bool RtcTimeSource::adjust(time_t utc)
+{
+    rtc.adjust(DateTime(static_cast<uint32_t>(utc)));
+    return true;
+}
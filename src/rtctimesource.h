@@ -0,0 +1,22 @@
+#ifndef RTCTIMESOURCE_H
+#define RTCTIMESOURCE_H
+
+#include <Arduino.h>
+#include <RTClib.h>
+#include "itimesource.h"
+
+// DS3231 backed time, the RTC keeps UTC
+class RtcTimeSource : public ITimeSource
+{
+private:
+    RTC_DS3231 &rtc;
+
+public:
+    RtcTimeSource(RTC_DS3231 &rtc);
+    ~RtcTimeSource();
+    bool begin() override;
+    bool now(time_t &utc) override;
+    bool adjust(time_t utc) override;
+};
+
+#endif // RTCTIMESOURCE_H
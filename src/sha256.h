@@ -0,0 +1,35 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Incremental SHA-256 (FIPS 180-4), fed as the data arrives so an image
+// can be verified without reading it back.
+class Sha256
+{
+public:
+    static const size_t DIGEST_SIZE = 32;
+    static const size_t HEX_SIZE = DIGEST_SIZE * 2 + 1;
+
+    Sha256() { reset(); }
+
+    void reset();
+    void update(const uint8_t *data, size_t length);
+    // the object has to be reset before it is used again
+    void finish(uint8_t digest[DIGEST_SIZE]);
+
+    // 64 hex digits, either case
+    static bool parseHex(const char *text, uint8_t digest[DIGEST_SIZE]);
+    static void toHex(const uint8_t digest[DIGEST_SIZE], char text[HEX_SIZE]);
+
+private:
+    uint32_t state[8];
+    uint64_t length;
+    uint8_t block[64];
+    size_t used;
+
+    void transform(const uint8_t *data);
+};
+
+#endif // SHA256_H
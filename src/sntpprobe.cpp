@@ -0,0 +1,75 @@
+#include "sntpprobe.h"
+#include "timeformats.h"
+
+SntpProbe::SntpProbe()
+{
+}
+
+SntpProbe::~SntpProbe()
+{
+    cancel();
+}
+
+void SntpProbe::request(uint32_t nowMs)
+{
+    cancel();
+    if (server == nullptr || *server == '\0' || !WiFi.isConnected())
+    {
+        return;
+    }
+
+    uint8_t packet[TimeFormats::NTP_PACKET_SIZE];
+    nonce = (static_cast<uint64_t>(esp_random()) << 32) | esp_random();
+    TimeFormats::buildNtpRequest(packet, nonce);
+
+    // resolves the name, the only blocking part of a query
+    if (!udp.beginPacket(server, NTP_PORT))
+    {
+        Serial.printf("Failed to resolve NTP server %s\n", server);
+        return;
+    }
+    udp.write(packet, sizeof(packet));
+    if (!udp.endPacket())
+    {
+        return;
+    }
+
+    sentMs = millis();
+    pending = true;
+}
+
+bool SntpProbe::poll(uint32_t nowMs, TimeSample &sample)
+{
+    if (!pending || udp.parsePacket() <= 0)
+    {
+        return false;
+    }
+
+    const uint32_t receivedMs = millis();
+    uint8_t packet[TimeFormats::NTP_PACKET_SIZE];
+    size_t length = udp.read(packet, sizeof(packet));
+
+    TimeFormats::NtpReply reply;
+    if (!TimeFormats::parseNtpReply(packet, length, nonce, reply))
+    {
+        // stray or invalid datagram, keep waiting for the real answer
+        return false;
+    }
+    pending = false;
+
+    // round trip minus the time the server held the request
+    uint32_t roundTrip = receivedMs - sentMs;
+    uint32_t held = static_cast<uint32_t>(reply.transmitMs - reply.receiveMs);
+    uint32_t delay = roundTrip > held ? roundTrip - held : 0;
+
+    sample.utcMs = reply.transmitMs + delay / 2;
+    sample.localMs = receivedMs;
+    sample.errorMs = delay / 2 + reply.rootDelayMs / 2 + reply.rootDispersionMs + 1;
+    return true;
+}
+
+void SntpProbe::cancel()
+{
+    pending = false;
+    udp.stop();
+}
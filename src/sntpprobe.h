@@ -0,0 +1,31 @@
+#ifndef SNTPPROBE_H
+#define SNTPPROBE_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "itimeprobe.h"
+
+// Queries a single NTP server over its own UDP socket, so several servers
+// can be asked at once instead of going through the system SNTP client.
+class SntpProbe : public ITimeProbe
+{
+private:
+    static const uint16_t NTP_PORT = 123;
+    const char *server = nullptr;
+    WiFiUDP udp;
+    uint64_t nonce = 0;
+    uint32_t sentMs = 0;
+    bool pending = false;
+
+public:
+    SntpProbe();
+    ~SntpProbe();
+    void setServer(const char *server) { this->server = server; }
+    const char *getName() const override { return server ? server : "ntp"; }
+    void request(uint32_t nowMs) override;
+    bool poll(uint32_t nowMs, TimeSample &sample) override;
+    void cancel() override;
+};
+
+#endif // SNTPPROBE_H
@@ -0,0 +1,76 @@
+#include "softwareclock.h"
+
+SoftwareClock::SoftwareClock(MillisFunction millisFn) : millisFn(millisFn)
+{
+}
+
+SoftwareClock::~SoftwareClock()
+{
+}
+
+bool SoftwareClock::now(time_t &utc)
+{
+    if (!valid)
+    {
+        return false;
+    }
+
+    uint32_t nowMs = millisFn();
+    if (nowMs - baseMs > REBASE_INTERVAL_MS)
+    {
+        rebase(nowMs);
+    }
+
+    utc = static_cast<time_t>(utcMsAt(nowMs) / 1000);
+    return true;
+}
+
+bool SoftwareClock::adjust(time_t utc)
+{
+    // a manual set says nothing about the drift, keep the estimate
+    baseUtcMs = static_cast<int64_t>(utc) * 1000;
+    baseMs = millisFn();
+    correctedMs = baseMs;
+    valid = true;
+    return true;
+}
+
+int64_t SoftwareClock::utcMsAt(uint32_t localMs) const
+{
+    int64_t elapsed = static_cast<int32_t>(localMs - baseMs);
+    return baseUtcMs + elapsed + elapsed * driftPpm / 1000000;
+}
+
+void SoftwareClock::correct(int64_t offsetMs, uint32_t localMs)
+{
+    if (valid)
+    {
+        // whatever offset built up since the last correction is drift the estimate missed
+        uint32_t elapsed = localMs - correctedMs;
+        if (elapsed >= MIN_DRIFT_INTERVAL_MS && elapsed < 0x80000000UL)
+        {
+            int64_t residualPpm = offsetMs * 1000000 / elapsed;
+            int64_t drift = driftPpm + residualPpm / 2;
+            if (drift > MAX_DRIFT_PPM)
+            {
+                drift = MAX_DRIFT_PPM;
+            }
+            else if (drift < -MAX_DRIFT_PPM)
+            {
+                drift = -MAX_DRIFT_PPM;
+            }
+            driftPpm = static_cast<int32_t>(drift);
+        }
+    }
+
+    baseUtcMs = utcMsAt(localMs) + offsetMs;
+    baseMs = localMs;
+    correctedMs = localMs;
+    valid = true;
+}
+
+void SoftwareClock::rebase(uint32_t nowMs)
+{
+    baseUtcMs = utcMsAt(nowMs);
+    baseMs = nowMs;
+}
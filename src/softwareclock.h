@@ -0,0 +1,40 @@
+#ifndef SOFTWARECLOCK_H
+#define SOFTWARECLOCK_H
+
+#include <stdint.h>
+#include "itimesource.h"
+#include "virtualtimesource.h"
+
+// UTC kept on millis() between synchronizations, used when there is no RTC.
+// Corrections step the clock and estimate the crystal drift, which is then
+// applied between corrections.
+class SoftwareClock : public ITimeSource
+{
+private:
+    static const int32_t MAX_DRIFT_PPM = 500;
+    static const uint32_t MIN_DRIFT_INTERVAL_MS = 900000; // 15 min, shorter spans are dominated by sample error
+    static const uint32_t REBASE_INTERVAL_MS = 86400000;  // keeps millis() deltas far from the 49 day wrap
+
+    MillisFunction millisFn;
+    int64_t baseUtcMs = 0;
+    uint32_t baseMs = 0;
+    uint32_t correctedMs = 0;
+    int32_t driftPpm = 0;
+    bool valid = false;
+    void rebase(uint32_t nowMs);
+
+public:
+    SoftwareClock(MillisFunction millisFn);
+    ~SoftwareClock();
+    bool begin() override { return true; }
+    // false until the first adjust or correction
+    bool now(time_t &utc) override;
+    bool adjust(time_t utc) override;
+    int64_t utcMsAt(uint32_t localMs) const;
+    // applies a measured offset (reference minus clock) taken at localMs
+    void correct(int64_t offsetMs, uint32_t localMs);
+    bool isValid() const { return valid; }
+    int32_t getDriftPpm() const { return driftPpm; }
+};
+
+#endif // SOFTWARECLOCK_H
@@ -0,0 +1,52 @@
+#include "solarcalculator.h"
+#include <math.h>
+#include "dsttable.h"
+
+static const double DEG_TO_RAD_FACTOR = M_PI / 180.0;
+// sun center 50 arc minutes below the horizon: refraction plus the solar radius
+static const double ZENITH = 90.833 * DEG_TO_RAD_FACTOR;
+
+SolarCalculator::SunTimes SolarCalculator::compute(int year, unsigned month, unsigned day, float latitude, float longitude)
+{
+    const int64_t days = DstTable::daysFromCivil(year, month, day);
+    const int dayOfYear = static_cast<int>(days - DstTable::daysFromCivil(year, 1, 1)) + 1;
+    const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+
+    // fractional year at noon
+    const double gamma = 2.0 * M_PI / (leap ? 366 : 365) * (dayOfYear - 1);
+    const double equationOfTime = 229.18 * (0.000075 + 0.001868 * cos(gamma) - 0.032077 * sin(gamma) -
+                                            0.014615 * cos(2 * gamma) - 0.040849 * sin(2 * gamma));
+    const double declination = 0.006918 - 0.399912 * cos(gamma) + 0.070257 * sin(gamma) - 0.006758 * cos(2 * gamma) +
+                               0.000907 * sin(2 * gamma) - 0.002697 * cos(3 * gamma) + 0.00148 * sin(3 * gamma);
+
+    const double lat = latitude * DEG_TO_RAD_FACTOR;
+    const double cosHourAngle = cos(ZENITH) / (cos(lat) * cos(declination)) - tan(lat) * tan(declination);
+
+    SunTimes times = {};
+    if (cosHourAngle > 1.0)
+    {
+        times.type = PolarNight;
+        return times;
+    }
+    if (cosHourAngle < -1.0)
+    {
+        times.type = PolarDay;
+        return times;
+    }
+
+    const double hourAngle = acos(cosHourAngle) / DEG_TO_RAD_FACTOR;
+    // minutes after UTC midnight, may fall on the previous or next UTC day
+    const double sunrise = 720.0 - 4.0 * (longitude + hourAngle) - equationOfTime;
+    const double sunset = 720.0 - 4.0 * (longitude - hourAngle) - equationOfTime;
+
+    const time_t midnight = static_cast<time_t>(days * 86400);
+    times.sunrise = midnight + static_cast<time_t>(lround(sunrise * 60.0));
+    times.sunset = midnight + static_cast<time_t>(lround(sunset * 60.0));
+    times.type = Normal;
+    return times;
+}
+
+bool SolarCalculator::isValidLocation(float latitude, float longitude)
+{
+    return latitude >= -90.0f && latitude <= 90.0f && longitude >= -180.0f && longitude <= 180.0f;
+}
@@ -0,0 +1,29 @@
+#ifndef SOLARCALCULATOR_H
+#define SOLARCALCULATOR_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Sunrise and sunset from latitude/longitude with the NOAA approximation,
+// good to about a minute between the polar circles. Meant to run once a day,
+// the results are cached by the caller.
+class SolarCalculator
+{
+public:
+    enum DayType : uint8_t {
+        Normal = 0,
+        PolarDay,  // the sun does not set
+        PolarNight // the sun does not rise
+    };
+
+    struct SunTimes {
+        time_t sunrise; // UTC, only valid for Normal days
+        time_t sunset;
+        DayType type;
+    };
+
+    static SunTimes compute(int year, unsigned month, unsigned day, float latitude, float longitude);
+    static bool isValidLocation(float latitude, float longitude);
+};
+
+#endif // SOLARCALCULATOR_H
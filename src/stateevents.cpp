@@ -0,0 +1,162 @@
+#include "stateevents.h"
+#include <stdio.h>
+#include <string.h>
+
+static const uint8_t ALL_FIELDS = (1 << StateEvents::FIELD_COUNT) - 1;
+
+StateEvents::StateEvents()
+{
+    memset(&current, 0, sizeof(current));
+    memset(&sent, 0, sizeof(sent));
+    forced = ALL_FIELDS;
+    pending = ALL_FIELDS;
+}
+
+uint8_t StateEvents::changedFields() const
+{
+    uint8_t changed = 0;
+    if (current.state != sent.state)
+    {
+        changed |= 1 << LightState;
+    }
+    if (current.brightness != sent.brightness)
+    {
+        changed |= 1 << Brightness;
+    }
+    if (current.autoBrightness != sent.autoBrightness)
+    {
+        changed |= 1 << AutoBrightness;
+    }
+    if (strncmp(current.color, sent.color, sizeof(current.color)) != 0)
+    {
+        changed |= 1 << Color;
+    }
+    if (current.minutes != sent.minutes)
+    {
+        changed |= 1 << Time;
+    }
+    int step = static_cast<int>(current.illuminance) - sent.illuminance;
+    if (step >= ILLUMINANCE_STEP || step <= -static_cast<int>(ILLUMINANCE_STEP))
+    {
+        changed |= 1 << Illuminance;
+    }
+    if (current.renderMicros != sent.renderMicros || current.renderMaxMicros != sent.renderMaxMicros)
+    {
+        changed |= 1 << Render;
+    }
+    return changed;
+}
+
+void StateEvents::update(const Values &values)
+{
+    current = values;
+    current.color[sizeof(current.color) - 1] = '\0';
+    // a value that went back to what clients have is not sent again
+    pending = forced | changedFields();
+}
+
+void StateEvents::markAll()
+{
+    forced = ALL_FIELDS;
+    pending = ALL_FIELDS;
+}
+
+size_t StateEvents::take(uint32_t now, char *buffer, size_t length)
+{
+    uint8_t due = forced;
+    if (now - lastState >= STATE_INTERVAL_MS)
+    {
+        due |= STATE_FIELDS;
+    }
+    if (now - lastSensor >= SENSOR_INTERVAL_MS)
+    {
+        due |= SENSOR_FIELDS;
+    }
+    due &= pending;
+    if (due == 0 || length < MESSAGE_SIZE)
+    {
+        return 0;
+    }
+
+    // MESSAGE_SIZE holds every field, nothing is cut off
+    size_t written = snprintf(buffer, length, "{");
+    const char *separator = "";
+    if (due & (1 << LightState))
+    {
+        written += snprintf(buffer + written, length - written, "%s\"state\":%s", separator, current.state ? "true" : "false");
+        separator = ",";
+    }
+    if (due & (1 << Brightness))
+    {
+        written += snprintf(buffer + written, length - written, "%s\"brightness\":%u", separator, current.brightness);
+        separator = ",";
+    }
+    if (due & (1 << AutoBrightness))
+    {
+        written += snprintf(buffer + written, length - written, "%s\"autoBrightness\":%s", separator, current.autoBrightness ? "true" : "false");
+        separator = ",";
+    }
+    if (due & (1 << Color))
+    {
+        written += snprintf(buffer + written, length - written, "%s\"color\":\"%s\"", separator, current.color);
+        separator = ",";
+    }
+    if (due & (1 << Time))
+    {
+        written += snprintf(buffer + written, length - written, "%s\"time\":\"%02u:%02u\"", separator, current.minutes / 60, current.minutes % 60);
+        separator = ",";
+    }
+    if (due & (1 << Illuminance))
+    {
+        written += snprintf(buffer + written, length - written, "%s\"illuminance\":%u", separator, current.illuminance);
+        separator = ",";
+    }
+    if (due & (1 << Render))
+    {
+        written += snprintf(buffer + written, length - written, "%s\"renderUs\":%lu,\"renderMaxUs\":%lu", separator, static_cast<unsigned long>(current.renderMicros), static_cast<unsigned long>(current.renderMaxMicros));
+        separator = ",";
+    }
+    written += snprintf(buffer + written, length - written, "}");
+
+    // what clients have now, per field
+    if (due & (1 << LightState))
+    {
+        sent.state = current.state;
+    }
+    if (due & (1 << Brightness))
+    {
+        sent.brightness = current.brightness;
+    }
+    if (due & (1 << AutoBrightness))
+    {
+        sent.autoBrightness = current.autoBrightness;
+    }
+    if (due & (1 << Color))
+    {
+        memcpy(sent.color, current.color, sizeof(sent.color));
+    }
+    if (due & (1 << Time))
+    {
+        sent.minutes = current.minutes;
+    }
+    if (due & (1 << Illuminance))
+    {
+        sent.illuminance = current.illuminance;
+    }
+    if (due & (1 << Render))
+    {
+        sent.renderMicros = current.renderMicros;
+        sent.renderMaxMicros = current.renderMaxMicros;
+    }
+    if (due & STATE_FIELDS)
+    {
+        lastState = now;
+    }
+    if (due & SENSOR_FIELDS)
+    {
+        lastSensor = now;
+    }
+    forced &= ~due;
+    pending &= ~due;
+    return written;
+}
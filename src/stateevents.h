@@ -0,0 +1,70 @@
+#ifndef STATEEVENTS_H
+#define STATEEVENTS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Builds the deltas for the /events stream. The current values are handed
+// in as often as convenient; fields that differ from what clients last got
+// are collected and go out together once their interval has passed, so a
+// burst of changes (a fading brightness, a noisy light sensor) ends up as
+// one small message.
+class StateEvents
+{
+public:
+    enum Field : uint8_t {
+        LightState = 0,
+        Brightness,
+        AutoBrightness,
+        Color,
+        Time,
+        Illuminance,
+        Render,
+        FIELD_COUNT
+    };
+
+    struct Values {
+        bool state;
+        bool autoBrightness;
+        uint8_t brightness;   // as shown, follows the sensor with auto brightness
+        char color[8];
+        uint16_t minutes;     // time of day
+        uint16_t illuminance; // raw sensor reading
+        uint32_t renderMicros;
+        uint32_t renderMaxMicros;
+    };
+
+    // light state and time, the sensor and render stats change all the time and go out less often
+    static const uint32_t STATE_INTERVAL_MS = 200;
+    static const uint32_t SENSOR_INTERVAL_MS = 2000;
+    // smaller sensor changes are noise
+    static const uint16_t ILLUMINANCE_STEP = 16;
+    // {"state":false,"brightness":255,...} with every field
+    static const size_t MESSAGE_SIZE = 192;
+
+    StateEvents();
+
+    void update(const Values &current);
+    // everything goes out with the next message, e.g. for a new client
+    void markAll();
+    bool hasPending() const { return pending != 0; }
+
+    // writes the pending fields that are due as JSON, returns 0 if there is nothing to send
+    size_t take(uint32_t now, char *buffer, size_t length);
+
+private:
+    static const uint8_t STATE_FIELDS = (1 << LightState) | (1 << Brightness) | (1 << AutoBrightness) | (1 << Color) | (1 << Time);
+    static const uint8_t SENSOR_FIELDS = (1 << Illuminance) | (1 << Render);
+
+    Values current;
+    Values sent;
+    uint8_t pending = 0;
+    // sent regardless of the values or the interval
+    uint8_t forced = 0;
+    uint32_t lastState = 0;
+    uint32_t lastSensor = 0;
+
+    uint8_t changedFields() const;
+};
+
+#endif // STATEEVENTS_H
@@ -0,0 +1,235 @@
+#include "statestore.h"
+#include <stddef.h>
+#include <string.h>
+
+StateStore::StateStore()
+{
+    ConfigData::setDefaults(data);
+}
+
+void StateStore::load(const ConfigData &loaded)
+{
+    data = loaded;
+    pending = 0;
+}
+
+bool StateStore::changed(Field field)
+{
+    versions[field]++;
+    version++;
+    pending |= bit(field);
+    return true;
+}
+
+bool StateStore::setLightState(bool state)
+{
+    if (data.light.state == state)
+    {
+        return false;
+    }
+    data.light.state = state;
+    return changed(LightState);
+}
+
+bool StateStore::setBrightness(uint8_t brightness)
+{
+    if (data.light.brightness == brightness)
+    {
+        return false;
+    }
+    data.light.brightness = brightness;
+    return changed(Brightness);
+}
+
+bool StateStore::setColor(const char *color)
+{
+    if (strncmp(data.light.color, color, sizeof(data.light.color)) == 0)
+    {
+        return false;
+    }
+    ConfigData::copyString(data.light.color, color, sizeof(data.light.color));
+    return changed(Color);
+}
+
+bool StateStore::setAutoBrightness(const ConfigData::AutoBrightnessConfig &config)
+{
+    if (data.light.autoBrightnessConfig == config)
+    {
+        return false;
+    }
+    data.light.autoBrightnessConfig = config;
+    return changed(AutoBrightness);
+}
+
+bool StateStore::setAutoBrightness(bool enabled)
+{
+    ConfigData::AutoBrightnessConfig config = data.light.autoBrightnessConfig;
+    config.enabled = enabled;
+    return setAutoBrightness(config);
+}
+
+bool StateStore::setClockMode(ConfigData::ClockMode mode)
+{
+    if (data.system.mode == mode)
+    {
+        return false;
+    }
+    data.system.mode = mode;
+    return changed(ClockMode);
+}
+
+bool StateStore::setMqttConfig(const ConfigData::MqttConfig &config)
+{
+    if (data.system.mqttConfig == config)
+    {
+        return false;
+    }
+    data.system.mqttConfig = config;
+    return changed(Mqtt);
+}
+
+bool StateStore::setNtpConfig(const ConfigData::NtpConfig &config)
+{
+    if (data.system.ntpConfig == config)
+    {
+        return false;
+    }
+    data.system.ntpConfig = config;
+    return changed(Ntp);
+}
+
+bool StateStore::setLocationConfig(const ConfigData::LocationConfig &config)
+{
+    if (data.system.locationConfig == config)
+    {
+        return false;
+    }
+    data.system.locationConfig = config;
+    return changed(Location);
+}
+
+bool StateStore::setLightSchedule(const ConfigData::LightScheduleConfig &schedule)
+{
+    if (data.system.lightScheduleConfig == schedule)
+    {
+        return false;
+    }
+    data.system.lightScheduleConfig = schedule;
+    return changed(Schedule);
+}
+
+bool StateStore::setWifiConfig(const ConfigData::WifiConfig &config)
+{
+    if (data.wifi == config)
+    {
+        return false;
+    }
+    data.wifi = config;
+    return changed(Wifi);
+}
+
+StateStore::FieldMask StateStore::update(const ConfigData &next, FieldMask fields)
+{
+    FieldMask result = 0;
+    if ((fields & bit(LightState)) && setLightState(next.light.state))
+    {
+        result |= bit(LightState);
+    }
+    if ((fields & bit(Brightness)) && setBrightness(next.light.brightness))
+    {
+        result |= bit(Brightness);
+    }
+    if ((fields & bit(Color)) && setColor(next.light.color))
+    {
+        result |= bit(Color);
+    }
+    if ((fields & bit(AutoBrightness)) && setAutoBrightness(next.light.autoBrightnessConfig))
+    {
+        result |= bit(AutoBrightness);
+    }
+    if ((fields & bit(ClockMode)) && setClockMode(next.system.mode))
+    {
+        result |= bit(ClockMode);
+    }
+    if ((fields & bit(Mqtt)) && setMqttConfig(next.system.mqttConfig))
+    {
+        result |= bit(Mqtt);
+    }
+    if ((fields & bit(Ntp)) && setNtpConfig(next.system.ntpConfig))
+    {
+        result |= bit(Ntp);
+    }
+    if ((fields & bit(Location)) && setLocationConfig(next.system.locationConfig))
+    {
+        result |= bit(Location);
+    }
+    if ((fields & bit(Schedule)) && setLightSchedule(next.system.lightScheduleConfig))
+    {
+        result |= bit(Schedule);
+    }
+    if ((fields & bit(Wifi)) && setWifiConfig(next.wifi))
+    {
+        result |= bit(Wifi);
+    }
+    return result;
+}
+
+StateStore::FieldMask StateStore::fieldsAt(size_t offset, size_t size)
+{
+    // where each field lives in ConfigData
+    static const struct {
+        size_t offset;
+        size_t size;
+        Field field;
+    } LAYOUT[] = {
+        {offsetof(ConfigData, light.state), sizeof(ConfigData::light.state), LightState},
+        {offsetof(ConfigData, light.brightness), sizeof(ConfigData::light.brightness), Brightness},
+        {offsetof(ConfigData, light.color), sizeof(ConfigData::light.color), Color},
+        {offsetof(ConfigData, light.autoBrightnessConfig), sizeof(ConfigData::light.autoBrightnessConfig), AutoBrightness},
+        {offsetof(ConfigData, system.mode), sizeof(ConfigData::system.mode), ClockMode},
+        {offsetof(ConfigData, system.mqttConfig), sizeof(ConfigData::system.mqttConfig), Mqtt},
+        {offsetof(ConfigData, system.ntpConfig), sizeof(ConfigData::system.ntpConfig), Ntp},
+        {offsetof(ConfigData, system.locationConfig), sizeof(ConfigData::system.locationConfig), Location},
+        {offsetof(ConfigData, system.lightScheduleConfig), sizeof(ConfigData::system.lightScheduleConfig), Schedule},
+        {offsetof(ConfigData, wifi), sizeof(ConfigData::wifi), Wifi},
+    };
+
+    FieldMask fields = 0;
+    for (const auto &entry : LAYOUT)
+    {
+        if (offset < entry.offset + entry.size && entry.offset < offset + size)
+        {
+            fields |= bit(entry.field);
+        }
+    }
+    return fields;
+}
+
+bool StateStore::subscribe(FieldMask interest, const Subscriber &subscriber)
+{
+    if (subscriptionCount >= MAX_SUBSCRIBERS || !subscriber)
+    {
+        return false;
+    }
+    subscriptions[subscriptionCount++] = {interest, subscriber};
+    return true;
+}
+
+void StateStore::notify()
+{
+    if (pending == 0)
+    {
+        return;
+    }
+
+    FieldMask delivered = pending;
+    pending = 0;
+    for (uint8_t i = 0; i < subscriptionCount; i++)
+    {
+        FieldMask relevant = delivered & subscriptions[i].interest;
+        if (relevant != 0)
+        {
+            subscriptions[i].callback(relevant, *this);
+        }
+    }
+}
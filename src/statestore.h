@@ -0,0 +1,92 @@
+#ifndef STATESTORE_H
+#define STATESTORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include "configdata.h"
+
+// Single owner of the clock's settings while running. Setters only record
+// what changed (with a version per field); notify() then hands every
+// subscriber the set of fields changed since the last call, once. A burst
+// of changes in one loop iteration therefore ends up as one render, one
+// flash commit and one MQTT publish per field.
+class StateStore
+{
+public:
+    enum Field : uint8_t {
+        LightState = 0,
+        Brightness,
+        Color,
+        AutoBrightness,
+        ClockMode,
+        Mqtt,
+        Ntp,
+        Location,
+        Schedule,
+        Wifi,
+        FIELD_COUNT
+    };
+
+    using FieldMask = uint16_t;
+    using Subscriber = std::function<void(FieldMask changed, const StateStore &state)>;
+
+    static const FieldMask ALL_FIELDS = (1 << FIELD_COUNT) - 1;
+    static const FieldMask LIGHT_FIELDS = (1 << LightState) | (1 << Brightness) | (1 << Color) | (1 << AutoBrightness);
+    static const uint8_t MAX_SUBSCRIBERS = 6;
+
+    static constexpr FieldMask bit(Field field) { return static_cast<FieldMask>(1 << field); }
+
+    StateStore();
+    // replaces everything without notifying, used at boot
+    void load(const ConfigData &data);
+
+    const ConfigData &get() const { return data; }
+    const ConfigData::LightConfig &getLight() const { return data.light; }
+    const ConfigData::SystemConfig &getSystem() const { return data.system; }
+    const ConfigData::WifiConfig &getWifi() const { return data.wifi; }
+
+    // setters return false if the value was already set
+    bool setLightState(bool state);
+    bool setBrightness(uint8_t brightness);
+    bool setColor(const char *color);
+    bool setAutoBrightness(const ConfigData::AutoBrightnessConfig &config);
+    bool setAutoBrightness(bool enabled);
+    bool setClockMode(ConfigData::ClockMode mode);
+    bool setMqttConfig(const ConfigData::MqttConfig &config);
+    bool setNtpConfig(const ConfigData::NtpConfig &config);
+    bool setLocationConfig(const ConfigData::LocationConfig &config);
+    bool setLightSchedule(const ConfigData::LightScheduleConfig &schedule);
+    bool setWifiConfig(const ConfigData::WifiConfig &config);
+    // sets the given fields from data in one go, returns the ones that changed
+    FieldMask update(const ConfigData &next, FieldMask fields);
+    // the fields stored in the given bytes of ConfigData
+    static FieldMask fieldsAt(size_t offset, size_t size);
+
+    // bumped on every change, usable as a cheap "anything new?" check
+    uint32_t getVersion() const { return version; }
+    uint32_t getVersion(Field field) const { return versions[field]; }
+
+    // interest limits which fields wake the subscriber, false if the table is full
+    bool subscribe(FieldMask interest, const Subscriber &subscriber);
+    // delivers pending changes, changes made by subscribers go out with the next call
+    void notify();
+    bool hasPendingChanges() const { return pending != 0; }
+
+private:
+    struct Subscription {
+        FieldMask interest;
+        Subscriber callback;
+    };
+
+    ConfigData data;
+    uint32_t versions[FIELD_COUNT] = {};
+    uint32_t version = 0;
+    FieldMask pending = 0;
+    Subscription subscriptions[MAX_SUBSCRIBERS];
+    uint8_t subscriptionCount = 0;
+
+    bool changed(Field field);
+};
+
+#endif // STATESTORE_H
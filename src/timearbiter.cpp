@@ -0,0 +1,255 @@
+#include "timearbiter.h"
+
+TimeArbiter::TimeArbiter(SoftwareClock &clock) : clock(clock)
+{
+}
+
+TimeArbiter::~TimeArbiter()
+{
+    clearProbes();
+}
+
+bool TimeArbiter::addProbe(ITimeProbe *probe)
+{
+    if (probe == nullptr || probeCount >= MAX_PROBES)
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < probeCount; i++)
+    {
+        if (probes[i].probe == probe)
+        {
+            return true;
+        }
+    }
+
+    ProbeState &state = probes[probeCount++];
+    state = {};
+    state.probe = probe;
+    state.score = INITIAL_SCORE;
+    return true;
+}
+
+void TimeArbiter::removeProbe(ITimeProbe *probe)
+{
+    for (uint8_t i = 0; i < probeCount; i++)
+    {
+        if (probes[i].probe == probe)
+        {
+            probe->cancel();
+            for (uint8_t j = i + 1; j < probeCount; j++)
+            {
+                probes[j - 1] = probes[j];
+            }
+            probeCount--;
+            return;
+        }
+    }
+}
+
+void TimeArbiter::clearProbes()
+{
+    for (uint8_t i = 0; i < probeCount; i++)
+    {
+        probes[i].probe->cancel();
+    }
+    probeCount = 0;
+    roundActive = false;
+}
+
+const TimeArbiter::ProbeState *TimeArbiter::getProbeState(uint8_t index) const
+{
+    if (index >= probeCount)
+    {
+        return nullptr;
+    }
+
+    return &probes[index];
+}
+
+void TimeArbiter::startRound(uint32_t nowMs)
+{
+    if (probeCount == 0)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < probeCount; i++)
+    {
+        probes[i].answered = false;
+        probes[i].probe->request(nowMs);
+    }
+    roundActive = true;
+    roundStartMs = nowMs;
+}
+
+bool TimeArbiter::loop(uint32_t nowMs, Estimate &estimate)
+{
+    if (!roundActive)
+    {
+        return false;
+    }
+
+    uint8_t pending = 0;
+    for (uint8_t i = 0; i < probeCount; i++)
+    {
+        ProbeState &state = probes[i];
+        if (state.answered)
+        {
+            continue;
+        }
+
+        if (state.probe->poll(nowMs, state.sample))
+        {
+            state.answered = true;
+            state.answers++;
+            state.offsetMs = state.sample.utcMs - clock.utcMsAt(state.sample.localMs);
+        }
+        else
+        {
+            pending++;
+        }
+    }
+
+    if (pending > 0 && nowMs - roundStartMs < ROUND_TIMEOUT_MS)
+    {
+        return false;
+    }
+
+    return finishRound(nowMs, estimate);
+}
+
+bool TimeArbiter::finishRound(uint32_t nowMs, Estimate &estimate)
+{
+    roundActive = false;
+
+    int64_t offsets[MAX_PROBES];
+    uint32_t errors[MAX_PROBES];
+    uint8_t voters = 0;
+    uint8_t answered = 0;
+    for (uint8_t i = 0; i < probeCount; i++)
+    {
+        ProbeState &state = probes[i];
+        if (!state.answered)
+        {
+            state.probe->cancel();
+            state.misses++;
+            state.truechimer = false;
+            lower(state);
+            continue;
+        }
+
+        answered++;
+        if (state.score >= MIN_VOTING_SCORE)
+        {
+            offsets[voters] = state.offsetMs;
+            errors[voters] = state.sample.errorMs;
+            voters++;
+        }
+    }
+
+    // with every answering probe below the threshold let them all vote, otherwise none could recover
+    if (voters == 0)
+    {
+        for (uint8_t i = 0; i < probeCount; i++)
+        {
+            if (probes[i].answered)
+            {
+                offsets[voters] = probes[i].offsetMs;
+                errors[voters] = probes[i].sample.errorMs;
+                voters++;
+            }
+        }
+    }
+
+    int64_t low, high;
+    uint8_t agreeing;
+    if (answered == 0 || !intersect(offsets, errors, voters, low, high, agreeing))
+    {
+        return false;
+    }
+
+    estimate.offsetMs = low + (high - low) / 2;
+    estimate.errorMs = static_cast<uint32_t>((high - low) / 2);
+    estimate.localMs = nowMs;
+    estimate.sources = agreeing;
+    estimate.voters = voters;
+
+    for (uint8_t i = 0; i < probeCount; i++)
+    {
+        ProbeState &state = probes[i];
+        if (!state.answered)
+        {
+            continue;
+        }
+
+        int64_t distance = state.offsetMs - estimate.offsetMs;
+        state.truechimer = (distance < 0 ? -distance : distance) <= static_cast<int64_t>(state.sample.errorMs);
+        if (state.truechimer)
+        {
+            raise(state);
+        }
+        else
+        {
+            lower(state);
+        }
+    }
+
+    clock.correct(estimate.offsetMs, nowMs);
+    return true;
+}
+
+bool TimeArbiter::intersect(const int64_t *offsets, const uint32_t *errors, uint8_t count, int64_t &low, int64_t &high, uint8_t &agreeing)
+{
+    struct Edge {
+        int64_t value;
+        int8_t type; // -1 opens an interval, +1 closes it
+    };
+
+    Edge edges[MAX_PROBES * 2];
+    uint8_t edgeCount = 0;
+    for (uint8_t i = 0; i < count && i < MAX_PROBES; i++)
+    {
+        edges[edgeCount++] = {offsets[i] - errors[i], -1};
+        edges[edgeCount++] = {offsets[i] + errors[i], 1};
+    }
+
+    // at most a dozen edges, insertion sort with opening edges first on ties so touching intervals overlap
+    for (uint8_t i = 1; i < edgeCount; i++)
+    {
+        Edge edge = edges[i];
+        uint8_t j = i;
+        for (; j > 0 && (edges[j - 1].value > edge.value || (edges[j - 1].value == edge.value && edges[j - 1].type > edge.type)); j--)
+        {
+            edges[j] = edges[j - 1];
+        }
+        edges[j] = edge;
+    }
+
+    uint8_t best = 0;
+    uint8_t overlapping = 0;
+    for (uint8_t i = 0; i < edgeCount; i++)
+    {
+        overlapping -= edges[i].type;
+        if (overlapping > best && i + 1 < edgeCount)
+        {
+            best = overlapping;
+            low = edges[i].value;
+            high = edges[i + 1].value;
+        }
+    }
+
+    agreeing = best;
+    return best > 0 && best > count / 2;
+}
+
+void TimeArbiter::raise(ProbeState &state)
+{
+    state.score += (100 - state.score + 3) / 4;
+}
+
+void TimeArbiter::lower(ProbeState &state)
+{
+    state.score -= (state.score + 3) / 4;
+}
@@ -0,0 +1,67 @@
+#ifndef TIMEARBITER_H
+#define TIMEARBITER_H
+
+#include <stdint.h>
+#include "itimeprobe.h"
+#include "softwareclock.h"
+
+// Queries all registered probes in parallel rounds and combines the answers
+// with Marzullo's intersection algorithm: the estimate is the interval most
+// sources agree on, sources outside of it are treated as falsetickers. Every
+// probe keeps a quality score, poorly scoring probes are still queried but
+// do not vote until they agree with the majority again.
+class TimeArbiter
+{
+public:
+    static const uint8_t MAX_PROBES = 6;
+    static const uint8_t MIN_VOTING_SCORE = 20;
+    static const uint8_t INITIAL_SCORE = 50;
+    static const uint32_t ROUND_TIMEOUT_MS = 3000;
+
+    struct ProbeState {
+        ITimeProbe *probe;
+        uint8_t score;   // 0-100
+        bool answered;   // in the current round
+        bool truechimer; // agreed with the last estimate
+        TimeSample sample;
+        int64_t offsetMs; // last answer relative to the software clock
+        uint32_t answers;
+        uint32_t misses;
+    };
+
+    struct Estimate {
+        int64_t offsetMs; // reference minus software clock
+        uint32_t errorMs;
+        uint32_t localMs;
+        uint8_t sources;  // agreeing probes
+        uint8_t voters;
+    };
+
+    TimeArbiter(SoftwareClock &clock);
+    ~TimeArbiter();
+    bool addProbe(ITimeProbe *probe);
+    void removeProbe(ITimeProbe *probe);
+    void clearProbes();
+    uint8_t getProbeCount() const { return probeCount; }
+    const ProbeState *getProbeState(uint8_t index) const;
+    // queries every probe, the result arrives through loop()
+    void startRound(uint32_t nowMs);
+    bool isRoundActive() const { return roundActive; }
+    // returns true when a round completed with an estimate, which is then
+    // already applied to the software clock
+    bool loop(uint32_t nowMs, Estimate &estimate);
+    // Marzullo over [offset - error, offset + error], true with a majority
+    static bool intersect(const int64_t *offsets, const uint32_t *errors, uint8_t count, int64_t &low, int64_t &high, uint8_t &agreeing);
+
+private:
+    SoftwareClock &clock;
+    ProbeState probes[MAX_PROBES];
+    uint8_t probeCount = 0;
+    bool roundActive = false;
+    uint32_t roundStartMs = 0;
+    bool finishRound(uint32_t nowMs, Estimate &estimate);
+    static void raise(ProbeState &state);
+    static void lower(ProbeState &state);
+};
+
+#endif // TIMEARBITER_H
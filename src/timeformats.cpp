@@ -0,0 +1,139 @@
+#include "timeformats.h"
+#include <stdio.h>
+#include <string.h>
+#include "dsttable.h"
+
+static const uint32_t NTP_UNIX_OFFSET = 2208988800UL; // 1900-01-01 to 1970-01-01
+static const int64_t MIN_VALID_UTC = 1577836800;        // 2020-01-01, anything older is a reset clock
+
+void TimeFormats::buildNtpRequest(uint8_t *packet, uint64_t nonce)
+{
+    memset(packet, 0, NTP_PACKET_SIZE);
+    packet[0] = 0x23; // LI 0, version 4, mode 3 (client)
+    for (int i = 0; i < 8; i++)
+    {
+        packet[40 + i] = static_cast<uint8_t>(nonce >> (56 - 8 * i));
+    }
+}
+
+bool TimeFormats::parseNtpReply(const uint8_t *packet, size_t length, uint64_t nonce, NtpReply &reply)
+{
+    if (length < NTP_PACKET_SIZE)
+    {
+        return false;
+    }
+
+    const uint8_t leap = packet[0] >> 6;
+    const uint8_t mode = packet[0] & 0x07;
+    reply.stratum = packet[1];
+    // leap 3 means the server itself is not synchronized, stratum 0 is a kiss-o'-death
+    if (mode != 4 || leap == 3 || reply.stratum == 0 || reply.stratum > 15)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+        if (packet[24 + i] != static_cast<uint8_t>(nonce >> (56 - 8 * i)))
+        {
+            return false;
+        }
+    }
+
+    reply.rootDelayMs = static_cast<uint32_t>((static_cast<uint64_t>(readUint32(packet + 4)) * 1000) >> 16);
+    reply.rootDispersionMs = static_cast<uint32_t>((static_cast<uint64_t>(readUint32(packet + 8)) * 1000) >> 16);
+    reply.receiveMs = ntpToUnixMs(readUint32(packet + 32), readUint32(packet + 36));
+    reply.transmitMs = ntpToUnixMs(readUint32(packet + 40), readUint32(packet + 44));
+    return reply.transmitMs >= MIN_VALID_UTC * 1000 && reply.transmitMs >= reply.receiveMs;
+}
+
+bool TimeFormats::parseHttpDate(const char *value, time_t &utc)
+{
+    static const char MONTHS[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char weekday[4], month[4], zone[4];
+    int day, year, hour, minute, second;
+    if (value == nullptr ||
+        sscanf(value, "%3s, %d %3s %d %d:%d:%d %3s", weekday, &day, month, &year, &hour, &minute, &second, zone) != 8)
+    {
+        return false;
+    }
+
+    const char *found = strstr(MONTHS, month);
+    if (strlen(month) != 3 || found == nullptr || (found - MONTHS) % 3 != 0 || strcmp(zone, "GMT") != 0)
+    {
+        return false;
+    }
+    if (day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60 || hour < 0 || minute < 0 || second < 0)
+    {
+        return false;
+    }
+
+    int64_t days = DstTable::daysFromCivil(year, (found - MONTHS) / 3 + 1, day);
+    int64_t seconds = days * 86400 + hour * 3600 + minute * 60 + second;
+    if (seconds < MIN_VALID_UTC)
+    {
+        return false;
+    }
+
+    utc = static_cast<time_t>(seconds);
+    return true;
+}
+
+bool TimeFormats::parseEpoch(const char *value, int64_t &utcMs)
+{
+    if (value == nullptr)
+    {
+        return false;
+    }
+
+    while (*value == ' ' || *value == '"')
+    {
+        value++;
+    }
+
+    int64_t seconds = 0;
+    int digits = 0;
+    while (*value >= '0' && *value <= '9' && digits < 12)
+    {
+        seconds = seconds * 10 + (*value++ - '0');
+        digits++;
+    }
+    if (digits == 0 || seconds < MIN_VALID_UTC)
+    {
+        return false;
+    }
+
+    int64_t millis = 0;
+    if (*value == '.')
+    {
+        value++;
+        for (int scale = 100; *value >= '0' && *value <= '9'; value++, scale /= 10)
+        {
+            millis += (*value - '0') * scale;
+        }
+    }
+
+    while (*value == ' ' || *value == '"' || *value == '\r' || *value == '\n')
+    {
+        value++;
+    }
+    if (*value != '\0')
+    {
+        return false;
+    }
+
+    utcMs = seconds * 1000 + millis;
+    return true;
+}
+
+int64_t TimeFormats::ntpToUnixMs(uint32_t seconds, uint32_t fraction)
+{
+    // era 1 starts in 2036, small values belong to it
+    int64_t full = seconds >= 0x80000000UL ? static_cast<int64_t>(seconds) : static_cast<int64_t>(seconds) + 0x100000000LL;
+    return (full - NTP_UNIX_OFFSET) * 1000 + ((static_cast<uint64_t>(fraction) * 1000) >> 32);
+}
+
+uint32_t TimeFormats::readUint32(const uint8_t *p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
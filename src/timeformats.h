@@ -0,0 +1,37 @@
+#ifndef TIMEFORMATS_H
+#define TIMEFORMATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+// Wire formats of the time probes, kept apart from the network code so they
+// can be checked on the host.
+class TimeFormats
+{
+public:
+    static const size_t NTP_PACKET_SIZE = 48;
+
+    struct NtpReply {
+        int64_t receiveMs;  // server time the request arrived, unix ms
+        int64_t transmitMs; // server time the reply left, unix ms
+        uint32_t rootDelayMs;
+        uint32_t rootDispersionMs;
+        uint8_t stratum;
+    };
+
+    // SNTP client request, the nonce is echoed back as the originate timestamp
+    static void buildNtpRequest(uint8_t *packet, uint64_t nonce);
+    // rejects replies that are not server replies to the given nonce or are kiss-o'-death
+    static bool parseNtpReply(const uint8_t *packet, size_t length, uint64_t nonce, NtpReply &reply);
+    // RFC 7231 IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+    static bool parseHttpDate(const char *value, time_t &utc);
+    // unix time in seconds with optional fraction, e.g. "1735689600.25"
+    static bool parseEpoch(const char *value, int64_t &utcMs);
+
+private:
+    static int64_t ntpToUnixMs(uint32_t seconds, uint32_t fraction);
+    static uint32_t readUint32(const uint8_t *p);
+};
+
+#endif // TIMEFORMATS_H
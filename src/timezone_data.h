@@ -1,24 +1,456 @@
+// generated by tools/gen_timezones.py from tzdata 2025b, do not edit
 #ifndef TIMEZONE_DATA_H
 #define TIMEZONE_DATA_H
 
-#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef PROGMEM
+#define PROGMEM
+#endif
 
 struct TzEntry {
-    const char* name;
-    const char* posixTz;
+    uint16_t name;    // offset into TZ_NAMES
+    uint16_t posixTz; // offset into TZ_RULES
 };
 
+// 446 zones, 93 distinct POSIX rules
+const size_t TZ_COUNT = 446;
+
+const char TZ_NAMES[] PROGMEM =
+    "Africa/Abidjan\000Africa/Accra\000Africa/Addis_Ababa\000Africa/Algiers\000Africa/Asmara\000Africa/Bamako\000Africa"
+    "/Bangui\000Africa/Banjul\000Africa/Bissau\000Africa/Blantyre\000Africa/Brazzaville\000Africa/Bujumbura\000Africa/C"
+    "airo\000Africa/Casablanca\000Africa/Ceuta\000Africa/Conakry\000Africa/Dakar\000Africa/Dar_es_Salaam\000Africa/Djib"
+    "outi\000Africa/Douala\000Africa/El_Aaiun\000Africa/Freetown\000Africa/Gaborone\000Africa/Harare\000Africa/Johannes"
+    "burg\000Africa/Juba\000Africa/Kampala\000Africa/Khartoum\000Africa/Kigali\000Africa/Kinshasa\000Africa/Lagos\000Afric"
+    "a/Libreville\000Africa/Lome\000Africa/Luanda\000Africa/Lubumbashi\000Africa/Lusaka\000Africa/Malabo\000Africa/Mapu"
+    "to\000Africa/Maseru\000Africa/Mbabane\000Africa/Mogadishu\000Africa/Monrovia\000Africa/Nairobi\000Africa/Ndjamena\000"
+    "Africa/Niamey\000Africa/Nouakchott\000Africa/Ouagadougou\000Africa/Porto-Novo\000Africa/Sao_Tome\000Africa/Trip"
+    "oli\000Africa/Tunis\000Africa/Windhoek\000America/Adak\000America/Anchorage\000America/Anguilla\000America/Antigua"
+    "\000America/Araguaina\000America/Argentina/Buenos_Aires\000America/Argentina/Catamarca\000America/Argentina/"
+    "Cordoba\000America/Argentina/Jujuy\000America/Argentina/La_Rioja\000America/Argentina/Mendoza\000America/Arg"
+    "entina/Rio_Gallegos\000America/Argentina/Salta\000America/Argentina/San_Juan\000America/Argentina/San_Lui"
+    "s\000America/Argentina/Tucuman\000America/Argentina/Ushuaia\000America/Aruba\000America/Asuncion\000America/Ati"
+    "kokan\000America/Bahia\000America/Bahia_Banderas\000America/Barbados\000America/Belem\000America/Belize\000America"
+    "/Blanc-Sablon\000America/Boa_Vista\000America/Bogota\000America/Boise\000America/Cambridge_Bay\000America/Campo"
+    "_Grande\000America/Cancun\000America/Caracas\000America/Cayenne\000America/Cayman\000America/Chicago\000America/Ch"
+    "ihuahua\000America/Ciudad_Juarez\000America/Costa_Rica\000America/Coyhaique\000America/Creston\000America/Cuiab"
+    "a\000America/Curacao\000America/Danmarkshavn\000America/Dawson\000America/Dawson_Creek\000America/Denver\000Americ"
+    "a/Detroit\000America/Dominica\000America/Edmonton\000America/Eirunepe\000America/El_Salvador\000America/Fort_Ne"
+    "lson\000America/Fortaleza\000America/Glace_Bay\000America/Goose_Bay\000America/Grand_Turk\000America/Grenada\000Am"
+    "erica/Guadeloupe\000America/Guatemala\000America/Guayaquil\000America/Guyana\000America/Halifax\000America/Hava"
+    "na\000America/Hermosillo\000America/Indiana/Indianapolis\000America/Indiana/Knox\000America/Indiana/Marengo\000"
+    "America/Indiana/Petersburg\000America/Indiana/Tell_City\000America/Indiana/Vevay\000America/Indiana/Vince"
+    "nnes\000America/Indiana/Winamac\000America/Inuvik\000America/Iqaluit\000America/Jamaica\000America/Juneau\000Ameri"
+    "ca/Kentucky/Louisville\000America/Kentucky/Monticello\000America/Kralendijk\000America/La_Paz\000America/Lim"
+    "a\000America/Los_Angeles\000America/Lower_Princes\000America/Maceio\000America/Managua\000America/Manaus\000Americ"
+    "a/Marigot\000America/Martinique\000America/Matamoros\000America/Mazatlan\000America/Menominee\000America/Merida"
+    "\000America/Metlakatla\000America/Mexico_City\000America/Miquelon\000America/Moncton\000America/Monterrey\000Ameri"
+    "ca/Montevideo\000America/Montserrat\000America/Nassau\000America/New_York\000America/Nome\000America/Noronha\000Am"
+    "erica/North_Dakota/Beulah\000America/North_Dakota/Center\000America/North_Dakota/New_Salem\000America/Nuu"
+    "k\000America/Ojinaga\000America/Panama\000America/Paramaribo\000America/Phoenix\000America/Port-au-Prince\000Ameri"
+    "ca/Port_of_Spain\000America/Porto_Velho\000America/Puerto_Rico\000America/Punta_Arenas\000America/Rankin_Inl"
+    "et\000America/Recife\000America/Regina\000America/Resolute\000America/Rio_Branco\000America/Santarem\000America/Sa"
+    "ntiago\000America/Santo_Domingo\000America/Sao_Paulo\000America/Scoresbysund\000America/Sitka\000America/St_Bar"
+    "thelemy\000America/St_Johns\000America/St_Kitts\000America/St_Lucia\000America/St_Thomas\000America/St_Vincent\000"
+    "America/Swift_Current\000America/Tegucigalpa\000America/Thule\000America/Tijuana\000America/Toronto\000America/"
+    "Tortola\000America/Vancouver\000America/Whitehorse\000America/Winnipeg\000America/Yakutat\000Antarctica/Casey\000A"
+    "ntarctica/Davis\000Antarctica/DumontDUrville\000Antarctica/Macquarie\000Antarctica/Mawson\000Antarctica/McMu"
+    "rdo\000Antarctica/Palmer\000Antarctica/Rothera\000Antarctica/Syowa\000Antarctica/Troll\000Antarctica/Vostok\000Arc"
+    "tic/Longyearbyen\000Asia/Aden\000Asia/Almaty\000Asia/Amman\000Asia/Anadyr\000Asia/Aqtau\000Asia/Aqtobe\000Asia/Ashgab"
+    "at\000Asia/Atyrau\000Asia/Baghdad\000Asia/Bahrain\000Asia/Baku\000Asia/Bangkok\000Asia/Barnaul\000Asia/Beirut\000Asia/Bi"
+    "shkek\000Asia/Brunei\000Asia/Chita\000Asia/Colombo\000Asia/Damascus\000Asia/Dhaka\000Asia/Dili\000Asia/Dubai\000Asia/Dus"
+    "hanbe\000Asia/Famagusta\000Asia/Gaza\000Asia/Hebron\000Asia/Ho_Chi_Minh\000Asia/Hong_Kong\000Asia/Hovd\000Asia/Irkuts"
+    "k\000Asia/Jakarta\000Asia/Jayapura\000Asia/Jerusalem\000Asia/Kabul\000Asia/Kamchatka\000Asia/Karachi\000Asia/Kathmand"
+    "u\000Asia/Khandyga\000Asia/Kolkata\000Asia/Krasnoyarsk\000Asia/Kuala_Lumpur\000Asia/Kuching\000Asia/Kuwait\000Asia/Ma"
+    "cau\000Asia/Magadan\000Asia/Makassar\000Asia/Manila\000Asia/Muscat\000Asia/Nicosia\000Asia/Novokuznetsk\000Asia/Novos"
+    "ibirsk\000Asia/Omsk\000Asia/Oral\000Asia/Phnom_Penh\000Asia/Pontianak\000Asia/Pyongyang\000Asia/Qatar\000Asia/Qostana"
+    "y\000Asia/Qyzylorda\000Asia/Riyadh\000Asia/Sakhalin\000Asia/Samarkand\000Asia/Seoul\000Asia/Shanghai\000Asia/Singapor"
+    "e\000Asia/Srednekolymsk\000Asia/Taipei\000Asia/Tashkent\000Asia/Tbilisi\000Asia/Tehran\000Asia/Thimphu\000Asia/Tokyo\000"
+    "Asia/Tomsk\000Asia/Ulaanbaatar\000Asia/Urumqi\000Asia/Ust-Nera\000Asia/Vientiane\000Asia/Vladivostok\000Asia/Yakut"
+    "sk\000Asia/Yangon\000Asia/Yekaterinburg\000Asia/Yerevan\000Atlantic/Azores\000Atlantic/Bermuda\000Atlantic/Canary\000"
+    "Atlantic/Cape_Verde\000Atlantic/Faroe\000Atlantic/Madeira\000Atlantic/Reykjavik\000Atlantic/South_Georgia\000At"
+    "lantic/St_Helena\000Atlantic/Stanley\000Australia/Adelaide\000Australia/Brisbane\000Australia/Broken_Hill\000Au"
+    "stralia/Darwin\000Australia/Eucla\000Australia/Hobart\000Australia/Lindeman\000Australia/Lord_Howe\000Australia"
+    "/Melbourne\000Australia/Perth\000Australia/Sydney\000Etc/GMT\000Etc/GMT+1\000Etc/GMT+10\000Etc/GMT+11\000Etc/GMT+12\000E"
+    "tc/GMT+2\000Etc/GMT+3\000Etc/GMT+4\000Etc/GMT+5\000Etc/GMT+6\000Etc/GMT+7\000Etc/GMT+8\000Etc/GMT+9\000Etc/GMT-1\000Etc/GMT"
+    "-10\000Etc/GMT-11\000Etc/GMT-12\000Etc/GMT-13\000Etc/GMT-14\000Etc/GMT-2\000Etc/GMT-3\000Etc/GMT-4\000Etc/GMT-5\000Etc/GMT-"
+    "6\000Etc/GMT-7\000Etc/GMT-8\000Etc/GMT-9\000Etc/UTC\000Europe/Amsterdam\000Europe/Andorra\000Europe/Astrakhan\000Europe/"
+    "Athens\000Europe/Belgrade\000Europe/Berlin\000Europe/Bratislava\000Europe/Brussels\000Europe/Bucharest\000Europe/B"
+    "udapest\000Europe/Busingen\000Europe/Chisinau\000Europe/Copenhagen\000Europe/Dublin\000Europe/Gibraltar\000Europe/"
+    "Guernsey\000Europe/Helsinki\000Europe/Isle_of_Man\000Europe/Istanbul\000Europe/Jersey\000Europe/Kaliningrad\000Eur"
+    "ope/Kirov\000Europe/Kyiv\000Europe/Lisbon\000Europe/Ljubljana\000Europe/London\000Europe/Luxembourg\000Europe/Madr"
+    "id\000Europe/Malta\000Europe/Mariehamn\000Europe/Minsk\000Europe/Monaco\000Europe/Moscow\000Europe/Oslo\000Europe/Par"
+    "is\000Europe/Podgorica\000Europe/Prague\000Europe/Riga\000Europe/Rome\000Europe/Samara\000Europe/San_Marino\000Europe"
+    "/Sarajevo\000Europe/Saratov\000Europe/Simferopol\000Europe/Skopje\000Europe/Sofia\000Europe/Stockholm\000Europe/Ta"
+    "llinn\000Europe/Tirane\000Europe/Ulyanovsk\000Europe/Vaduz\000Europe/Vatican\000Europe/Vienna\000Europe/Vilnius\000Eu"
+    "rope/Volgograd\000Europe/Warsaw\000Europe/Zagreb\000Europe/Zurich\000Indian/Antananarivo\000Indian/Chagos\000India"
+    "n/Christmas\000Indian/Cocos\000Indian/Comoro\000Indian/Kerguelen\000Indian/Mahe\000Indian/Maldives\000Indian/Mauri"
+    "tius\000Indian/Mayotte\000Indian/Reunion\000Pacific/Apia\000Pacific/Auckland\000Pacific/Bougainville\000Pacific/Ch"
+    "atham\000Pacific/Chuuk\000Pacific/Easter\000Pacific/Efate\000Pacific/Fakaofo\000Pacific/Fiji\000Pacific/Funafuti\000P"
+    "acific/Galapagos\000Pacific/Gambier\000Pacific/Guadalcanal\000Pacific/Guam\000Pacific/Honolulu\000Pacific/Kanto"
+    "n\000Pacific/Kiritimati\000Pacific/Kosrae\000Pacific/Kwajalein\000Pacific/Majuro\000Pacific/Marquesas\000Pacific/M"
+    "idway\000Pacific/Nauru\000Pacific/Niue\000Pacific/Norfolk\000Pacific/Noumea\000Pacific/Pago_Pago\000Pacific/Palau\000"
+    "Pacific/Pitcairn\000Pacific/Pohnpei\000Pacific/Port_Moresby\000Pacific/Rarotonga\000Pacific/Saipan\000Pacific/T"
+    "ahiti\000Pacific/Tarawa\000Pacific/Tongatapu\000Pacific/Wake\000Pacific/Wallis\000";
+
+const char TZ_RULES[] PROGMEM =
+    "GMT0\000EAT-3\000CET-1\000WAT-1\000CAT-2\000EET-2EEST,M4.5.5/0,M10.5.4/24\000<+01>-1\000CET-1CEST,M3.5.0,M10.5.0/3\000SA"
+    "ST-2\000EET-2\000HST10HDT,M3.2.0,M11.1.0\000AKST9AKDT,M3.2.0,M11.1.0\000AST4\000<-03>3\000EST5\000CST6\000<-04>4\000<-05>5\000"
+    "MST7MDT,M3.2.0,M11.1.0\000CST6CDT,M3.2.0,M11.1.0\000MST7\000EST5EDT,M3.2.0,M11.1.0\000AST4ADT,M3.2.0,M11.1.0"
+    "\000CST5CDT,M3.2.0/0,M11.1.0/1\000PST8PDT,M3.2.0,M11.1.0\000<-03>3<-02>,M3.2.0,M11.1.0\000<-02>2\000<-02>2<-01>"
+    ",M3.5.0/-1,M10.5.0/0\000<-04>4<-03>,M9.1.6/24,M4.1.6/24\000NST3:30NDT,M3.2.0,M11.1.0\000<+08>-8\000<+07>-7\000<"
+    "+10>-10\000AEST-10AEDT,M10.1.0,M4.1.0/3\000<+05>-5\000NZST-12NZDT,M9.5.0,M4.1.0/3\000<+03>-3\000<+00>0<+02>-2,M"
+    "3.5.0/1,M10.5.0/3\000<+12>-12\000<+04>-4\000EET-2EEST,M3.5.0/0,M10.5.0/0\000<+06>-6\000<+09>-9\000<+0530>-5:30\000EET"
+    "-2EEST,M3.5.0/3,M10.5.0/4\000EET-2EEST,M3.4.4/50,M10.4.4/50\000HKT-8\000WIB-7\000WIT-9\000IST-2IDT,M3.4.4/26,M1"
+    "0.5.0\000<+0430>-4:30\000PKT-5\000<+0545>-5:45\000IST-5:30\000CST-8\000<+11>-11\000WITA-8\000PST-8\000KST-9\000<+0330>-3:30\000JS"
+    "T-9\000<+0630>-6:30\000<-01>1<+00>,M3.5.0/0,M10.5.0/1\000WET0WEST,M3.5.0/1,M10.5.0\000<-01>1\000ACST-9:30ACDT,M"
+    "10.1.0,M4.1.0/3\000AEST-10\000ACST-9:30\000<+0845>-8:45\000<+1030>-10:30<+11>-11,M10.1.0,M4.1.0\000AWST-8\000<-10>"
+    "10\000<-11>11\000<-12>12\000<-06>6\000<-07>7\000<-08>8\000<-09>9\000<+13>-13\000<+14>-14\000<+02>-2\000UTC0\000EET-2EEST,M3.5.0,M"
+    "10.5.0/3\000IST-1GMT0,M10.5.0,M3.5.0/1\000GMT0BST,M3.5.0/1,M10.5.0\000MSK-3\000<+1245>-12:45<+1345>,M9.5.0/2"
+    ":45,M4.1.0/3:45\000<-06>6<-05>,M9.1.6/22,M4.1.6/22\000ChST-10\000HST10\000<-0930>9:30\000SST11\000<+11>-11<+12>,M1"
+    "0.1.0,M4.1.0/3\000";
 
-const TzEntry TIMEZONES[] PROGMEM = {
-    {"Europe/Berlin", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Europe/London", "GMT0BST,M3.5.0/1,M10.5.0"},
-    {"Europe/Paris", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Europe/Rome", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Atlantic/Reykjavik", "GMT0"},
-    {"Etc/UTC", "UTC0"}
-    // add more as needed: https://github.com/nayarsystems/posix_tz_db/blob/master/zones.json
+// sorted by name
+const TzEntry TZ_INDEX[TZ_COUNT] PROGMEM = {
+    {0, 0}, {15, 0}, {28, 5}, {47, 11}, {62, 5}, {76, 0},
+    {90, 17}, {104, 0}, {118, 0}, {132, 23}, {148, 17}, {167, 23},
+    {184, 29}, {197, 59}, {215, 67}, {228, 0}, {243, 0}, {256, 5},
+    {277, 5}, {293, 17}, {307, 59}, {323, 0}, {339, 23}, {355, 23},
+    {369, 94}, {389, 23}, {401, 5}, {416, 23}, {432, 23}, {446, 17},
+    {462, 17}, {475, 17}, {493, 0}, {505, 17}, {519, 23}, {537, 23},
+    {551, 17}, {565, 23}, {579, 94}, {593, 94}, {608, 5}, {625, 0},
+    {641, 5}, {656, 17}, {672, 17}, {686, 0}, {704, 0}, {723, 17},
+    {741, 0}, {757, 101}, {772, 11}, {785, 23}, {801, 107}, {814, 131},
+    {832, 156}, {849, 156}, {865, 161}, {883, 161}, {914, 161}, {942, 161},
+    {968, 161}, {992, 161}, {1019, 161}, {1045, 161}, {1076, 161}, {1100, 161},
+    {1127, 161}, {1154, 161}, {1180, 161}, {1206, 156}, {1220, 161}, {1237, 168},
+    {1254, 161}, {1268, 173}, {1291, 156}, {1308, 161}, {1322, 173}, {1337, 156},
+    {1358, 178}, {1376, 185}, {1391, 192}, {1405, 192}, {1427, 178}, {1448, 168},
+    {1463, 178}, {1479, 161}, {1495, 168}, {1510, 215}, {1526, 173}, {1544, 192},
+    {1566, 173}, {1585, 161}, {1603, 238}, {1619, 178}, {1634, 156}, {1650, 0},
+    {1671, 238}, {1686, 238}, {1707, 192}, {1722, 243}, {1738, 156}, {1755, 192},
+    {1772, 185}, {1789, 173}, {1809, 238}, {1829, 161}, {1847, 266}, {1865, 266},
+    {1883, 243}, {1902, 156}, {1918, 156}, {1937, 173}, {1955, 185}, {1973, 178},
+    {1988, 266}, {2004, 289}, {2019, 238}, {2038, 243}, {2067, 215}, {2088, 243},
+    {2112, 243}, {2139, 215}, {2165, 243}, {2187, 243}, {2213, 243}, {2237, 192},
+    {2252, 243}, {2268, 168}, {2284, 131}, {2299, 243}, {2327, 243}, {2355, 156},
+    {2374, 178}, {2389, 185}, {2402, 316}, {2422, 156}, {2444, 161}, {2459, 173},
+    {2475, 178}, {2490, 156}, {2506, 156}, {2525, 215}, {2543, 238}, {2560, 215},
+    {2578, 173}, {2593, 131}, {2612, 173}, {2632, 339}, {2649, 266}, {2665, 173},
+    {2683, 161}, {2702, 156}, {2721, 243}, {2736, 243}, {2753, 131}, {2766, 366},
+    {2782, 215}, {2810, 215}, {2838, 215}, {2869, 373}, {2882, 215}, {2898, 168},
+    {2913, 161}, {2932, 238}, {2948, 243}, {2971, 156}, {2993, 178}, {3013, 156},
+    {3033, 161}, {3054, 215}, {3075, 161}, {3090, 173}, {3105, 215}, {3122, 185},
+    {3141, 161}, {3158, 405}, {3175, 156}, {3197, 161}, {3215, 373}, {3236, 131},
+    {3250, 156}, {3272, 437}, {3289, 156}, {3306, 156}, {3323, 156}, {3341, 156},
+    {3360, 173}, {3382, 173}, {3402, 266}, {3416, 316}, {3432, 243}, {3448, 156},
+    {3464, 316}, {3482, 238}, {3501, 215}, {3518, 131}, {3534, 463}, {3551, 471},
+    {3568, 479}, {3594, 488}, {3615, 517}, {3633, 525}, {3652, 161}, {3670, 161},
+    {3689, 553}, {3706, 561}, {3723, 517}, {3741, 67}, {3761, 553}, {3771, 517},
+    {3783, 553}, {3794, 594}, {3806, 517}, {3817, 517}, {3829, 517}, {3843, 517},
+    {3855, 553}, {3868, 553}, {3881, 603}, {3891, 471}, {3904, 471}, {3917, 611},
+    {3929, 640}, {3942, 463}, {3954, 648}, {3965, 656}, {3978, 553}, {3992, 640},
+    {4003, 648}, {4013, 603}, {4024, 517}, {4038, 669}, {4053, 698}, {4063, 698},
+    {4075, 471}, {4092, 729}, {4107, 471}, {4117, 463}, {4130, 735}, {4143, 741},
+    {4157, 747}, {4172, 774}, {4183, 594}, {4198, 787}, {4211, 793}, {4226, 648},
+    {4240, 806}, {4253, 471}, {4270, 463}, {4288, 463}, {4301, 553}, {4313, 815},
+    {4324, 821}, {4337, 830}, {4351, 837}, {4363, 603}, {4375, 669}, {4388, 471},
+    {4406, 471}, {4423, 640}, {4433, 517}, {4443, 471}, {4459, 735}, {4474, 843},
+    {4489, 553}, {4500, 517}, {4514, 517}, {4529, 553}, {4541, 821}, {4555, 517},
+    {4570, 843}, {4581, 815}, {4595, 463}, {4610, 821}, {4629, 815}, {4641, 517},
+    {4655, 603}, {4668, 849}, {4680, 640}, {4693, 862}, {4704, 471}, {4715, 463},
+    {4732, 640}, {4744, 479}, {4758, 471}, {4773, 479}, {4790, 648}, {4803, 868},
+    {4815, 517}, {4834, 603}, {4847, 881}, {4863, 266}, {4880, 912}, {4896, 938},
+    {4916, 912}, {4931, 912}, {4948, 0}, {4967, 366}, {4990, 0}, {5009, 161},
+    {5026, 945}, {5045, 976}, {5064, 945}, {5086, 984}, {5103, 994}, {5119, 488},
+    {5136, 976}, {5155, 1007}, {5175, 488}, {5195, 1044}, {5211, 488}, {5228, 0},
+    {5236, 938}, {5246, 1051}, {5257, 1059}, {5268, 1067}, {5279, 366}, {5289, 161},
+    {5299, 178}, {5309, 185}, {5319, 1075}, {5329, 1082}, {5339, 1089}, {5349, 1096},
+    {5359, 59}, {5369, 479}, {5380, 821}, {5391, 594}, {5402, 1103}, {5413, 1112},
+    {5424, 1121}, {5434, 553}, {5444, 603}, {5454, 517}, {5464, 640}, {5474, 471},
+    {5484, 463}, {5494, 648}, {5504, 1129}, {5512, 67}, {5529, 67}, {5544, 603},
+    {5561, 669}, {5575, 67}, {5591, 67}, {5605, 67}, {5623, 67}, {5639, 669},
+    {5656, 67}, {5672, 67}, {5688, 1134}, {5704, 67}, {5722, 1161}, {5736, 67},
+    {5753, 1188}, {5769, 669}, {5785, 1188}, {5804, 553}, {5820, 1188}, {5834, 101},
+    {5853, 1213}, {5866, 669}, {5878, 912}, {5892, 67}, {5909, 1188}, {5923, 67},
+    {5941, 67}, {5955, 67}, {5968, 669}, {5985, 553}, {5998, 67}, {6012, 1213},
+    {6026, 67}, {6038, 67}, {6051, 67}, {6068, 67}, {6082, 669}, {6094, 67},
+    {6106, 603}, {6120, 67}, {6138, 67}, {6154, 603}, {6169, 1213}, {6187, 67},
+    {6201, 669}, {6214, 67}, {6231, 669}, {6246, 67}, {6260, 603}, {6277, 67},
+    {6290, 67}, {6305, 67}, {6319, 669}, {6334, 1213}, {6351, 67}, {6365, 67},
+    {6379, 67}, {6393, 5}, {6413, 640}, {6427, 471}, {6444, 868}, {6457, 5},
+    {6471, 517}, {6488, 603}, {6500, 517}, {6516, 603}, {6533, 5}, {6548, 603},
+    {6563, 1103}, {6576, 525}, {6593, 821}, {6614, 1219}, {6630, 479}, {6644, 1264},
+    {6659, 821}, {6673, 1103}, {6689, 594}, {6702, 594}, {6719, 1075}, {6737, 1096},
+    {6753, 821}, {6773, 1296}, {6786, 1304}, {6803, 1103}, {6818, 1112}, {6837, 821},
+    {6852, 594}, {6870, 594}, {6885, 1310}, {6903, 1322}, {6918, 594}, {6932, 1059},
+    {6945, 1328}, {6961, 821}, {6976, 1322}, {6994, 648}, {7008, 1089}, {7025, 821},
+    {7041, 479}, {7062, 1051}, {7080, 1296}, {7095, 1051}, {7110, 594}, {7125, 1103},
+    {7143, 594}, {7156, 594},
 };
 
-const size_t TZ_COUNT = sizeof(TIMEZONES) / sizeof(TzEntry);
+const char TZ_OPTIONS_HTML[] PROGMEM =
+    "<option value=\"Africa/Abidjan\">Africa/Abidjan</option><option value=\"Africa/Accra\">Africa/Accra<"
+    "/option><option value=\"Africa/Addis_Ababa\">Africa/Addis_Ababa</option><option value=\"Africa/Algi"
+    "ers\">Africa/Algiers</option><option value=\"Africa/Asmara\">Africa/Asmara</option><option value=\"A"
+    "frica/Bamako\">Africa/Bamako</option><option value=\"Africa/Bangui\">Africa/Bangui</option><option "
+    "value=\"Africa/Banjul\">Africa/Banjul</option><option value=\"Africa/Bissau\">Africa/Bissau</option>"
+    "<option value=\"Africa/Blantyre\">Africa/Blantyre</option><option value=\"Africa/Brazzaville\">Afric"
+    "a/Brazzaville</option><option value=\"Africa/Bujumbura\">Africa/Bujumbura</option><option value=\"A"
+    "frica/Cairo\">Africa/Cairo</option><option value=\"Africa/Casablanca\">Africa/Casablanca</option><o"
+    "ption value=\"Africa/Ceuta\">Africa/Ceuta</option><option value=\"Africa/Conakry\">Africa/Conakry</o"
+    "ption><option value=\"Africa/Dakar\">Africa/Dakar</option><option value=\"Africa/Dar_es_Salaam\">Afr"
+    "ica/Dar_es_Salaam</option><option value=\"Africa/Djibouti\">Africa/Djibouti</option><option value="
+    "\"Africa/Douala\">Africa/Douala</option><option value=\"Africa/El_Aaiun\">Africa/El_Aaiun</option><o"
+    "ption value=\"Africa/Freetown\">Africa/Freetown</option><option value=\"Africa/Gaborone\">Africa/Gab"
+    "orone</option><option value=\"Africa/Harare\">Africa/Harare</option><option value=\"Africa/Johannes"
+    "burg\">Africa/Johannesburg</option><option value=\"Africa/Juba\">Africa/Juba</option><option value="
+    "\"Africa/Kampala\">Africa/Kampala</option><option value=\"Africa/Khartoum\">Africa/Khartoum</option>"
+    "<option value=\"Africa/Kigali\">Africa/Kigali</option><option value=\"Africa/Kinshasa\">Africa/Kinsh"
+    "asa</option><option value=\"Africa/Lagos\">Africa/Lagos</option><option value=\"Africa/Libreville\">"
+    "Africa/Libreville</option><option value=\"Africa/Lome\">Africa/Lome</option><option value=\"Africa/"
+    "Luanda\">Africa/Luanda</option><option value=\"Africa/Lubumbashi\">Africa/Lubumbashi</option><optio"
+    "n value=\"Africa/Lusaka\">Africa/Lusaka</option><option value=\"Africa/Malabo\">Africa/Malabo</optio"
+    "n><option value=\"Africa/Maputo\">Africa/Maputo</option><option value=\"Africa/Maseru\">Africa/Maser"
+    "u</option><option value=\"Africa/Mbabane\">Africa/Mbabane</option><option value=\"Africa/Mogadishu\""
+    ">Africa/Mogadishu</option><option value=\"Africa/Monrovia\">Africa/Monrovia</option><option value="
+    "\"Africa/Nairobi\">Africa/Nairobi</option><option value=\"Africa/Ndjamena\">Africa/Ndjamena</option>"
+    "<option value=\"Africa/Niamey\">Africa/Niamey</option><option value=\"Africa/Nouakchott\">Africa/Nou"
+    "akchott</option><option value=\"Africa/Ouagadougou\">Africa/Ouagadougou</option><option value=\"Afr"
+    "ica/Porto-Novo\">Africa/Porto-Novo</option><option value=\"Africa/Sao_Tome\">Africa/Sao_Tome</optio"
+    "n><option value=\"Africa/Tripoli\">Africa/Tripoli</option><option value=\"Africa/Tunis\">Africa/Tuni"
+    "s</option><option value=\"Africa/Windhoek\">Africa/Windhoek</option><option value=\"America/Adak\">A"
+    "merica/Adak</option><option value=\"America/Anchorage\">America/Anchorage</option><option value=\"A"
+    "merica/Anguilla\">America/Anguilla</option><option value=\"America/Antigua\">America/Antigua</optio"
+    "n><option value=\"America/Araguaina\">America/Araguaina</option><option value=\"America/Argentina/B"
+    "uenos_Aires\">America/Argentina/Buenos_Aires</option><option value=\"America/Argentina/Catamarca\">"
+    "America/Argentina/Catamarca</option><option value=\"America/Argentina/Cordoba\">America/Argentina/"
+    "Cordoba</option><option value=\"America/Argentina/Jujuy\">America/Argentina/Jujuy</option><option "
+    "value=\"America/Argentina/La_Rioja\">America/Argentina/La_Rioja</option><option value=\"America/Arg"
+    "entina/Mendoza\">America/Argentina/Mendoza</option><option value=\"America/Argentina/Rio_Gallegos\""
+    ">America/Argentina/Rio_Gallegos</option><option value=\"America/Argentina/Salta\">America/Argentin"
+    "a/Salta</option><option value=\"America/Argentina/San_Juan\">America/Argentina/San_Juan</option><o"
+    "ption value=\"America/Argentina/San_Luis\">America/Argentina/San_Luis</option><option value=\"Ameri"
+    "ca/Argentina/Tucuman\">America/Argentina/Tucuman</option><option value=\"America/Argentina/Ushuaia"
+    "\">America/Argentina/Ushuaia</option><option value=\"America/Aruba\">America/Aruba</option><option "
+    "value=\"America/Asuncion\">America/Asuncion</option><option value=\"America/Atikokan\">America/Atiko"
+    "kan</option><option value=\"America/Bahia\">America/Bahia</option><option value=\"America/Bahia_Ban"
+    "deras\">America/Bahia_Banderas</option><option value=\"America/Barbados\">America/Barbados</option>"
+    "<option value=\"America/Belem\">America/Belem</option><option value=\"America/Belize\">America/Beliz"
+    "e</option><option value=\"America/Blanc-Sablon\">America/Blanc-Sablon</option><option value=\"Ameri"
+    "ca/Boa_Vista\">America/Boa_Vista</option><option value=\"America/Bogota\">America/Bogota</option><o"
+    "ption value=\"America/Boise\">America/Boise</option><option value=\"America/Cambridge_Bay\">America/"
+    "Cambridge_Bay</option><option value=\"America/Campo_Grande\">America/Campo_Grande</option><option "
+    "value=\"America/Cancun\">America/Cancun</option><option value=\"America/Caracas\">America/Caracas</o"
+    "ption><option value=\"America/Cayenne\">America/Cayenne</option><option value=\"America/Cayman\">Ame"
+    "rica/Cayman</option><option value=\"America/Chicago\">America/Chicago</option><option value=\"Ameri"
+    "ca/Chihuahua\">America/Chihuahua</option><option value=\"America/Ciudad_Juarez\">America/Ciudad_Jua"
+    "rez</option><option value=\"America/Costa_Rica\">America/Costa_Rica</option><option value=\"America"
+    "/Coyhaique\">America/Coyhaique</option><option value=\"America/Creston\">America/Creston</option><o"
+    "ption value=\"America/Cuiaba\">America/Cuiaba</option><option value=\"America/Curacao\">America/Cura"
+    "cao</option><option value=\"America/Danmarkshavn\">America/Danmarkshavn</option><option value=\"Ame"
+    "rica/Dawson\">America/Dawson</option><option value=\"America/Dawson_Creek\">America/Dawson_Creek</o"
+    "ption><option value=\"America/Denver\">America/Denver</option><option value=\"America/Detroit\">Amer"
+    "ica/Detroit</option><option value=\"America/Dominica\">America/Dominica</option><option value=\"Ame"
+    "rica/Edmonton\">America/Edmonton</option><option value=\"America/Eirunepe\">America/Eirunepe</optio"
+    "n><option value=\"America/El_Salvador\">America/El_Salvador</option><option value=\"America/Fort_Ne"
+    "lson\">America/Fort_Nelson</option><option value=\"America/Fortaleza\">America/Fortaleza</option><o"
+    "ption value=\"America/Glace_Bay\">America/Glace_Bay</option><option value=\"America/Goose_Bay\">Amer"
+    "ica/Goose_Bay</option><option value=\"America/Grand_Turk\">America/Grand_Turk</option><option valu"
+    "e=\"America/Grenada\">America/Grenada</option><option value=\"America/Guadeloupe\">America/Guadeloup"
+    "e</option><option value=\"America/Guatemala\">America/Guatemala</option><option value=\"America/Gua"
+    "yaquil\">America/Guayaquil</option><option value=\"America/Guyana\">America/Guyana</option><option "
+    "value=\"America/Halifax\">America/Halifax</option><option value=\"America/Havana\">America/Havana</o"
+    "ption><option value=\"America/Hermosillo\">America/Hermosillo</option><option value=\"America/India"
+    "na/Indianapolis\">America/Indiana/Indianapolis</option><option value=\"America/Indiana/Knox\">Ameri"
+    "ca/Indiana/Knox</option><option value=\"America/Indiana/Marengo\">America/Indiana/Marengo</option>"
+    "<option value=\"America/Indiana/Petersburg\">America/Indiana/Petersburg</option><option value=\"Ame"
+    "rica/Indiana/Tell_City\">America/Indiana/Tell_City</option><option value=\"America/Indiana/Vevay\">"
+    "America/Indiana/Vevay</option><option value=\"America/Indiana/Vincennes\">America/Indiana/Vincenne"
+    "s</option><option value=\"America/Indiana/Winamac\">America/Indiana/Winamac</option><option value="
+    "\"America/Inuvik\">America/Inuvik</option><option value=\"America/Iqaluit\">America/Iqaluit</option>"
+    "<option value=\"America/Jamaica\">America/Jamaica</option><option value=\"America/Juneau\">America/J"
+    "uneau</option><option value=\"America/Kentucky/Louisville\">America/Kentucky/Louisville</option><o"
+    "ption value=\"America/Kentucky/Monticello\">America/Kentucky/Monticello</option><option value=\"Ame"
+    "rica/Kralendijk\">America/Kralendijk</option><option value=\"America/La_Paz\">America/La_Paz</optio"
+    "n><option value=\"America/Lima\">America/Lima</option><option value=\"America/Los_Angeles\">America/"
+    "Los_Angeles</option><option value=\"America/Lower_Princes\">America/Lower_Princes</option><option "
+    "value=\"America/Maceio\">America/Maceio</option><option value=\"America/Managua\">America/Managua</o"
+    "ption><option value=\"America/Manaus\">America/Manaus</option><option value=\"America/Marigot\">Amer"
+    "ica/Marigot</option><option value=\"America/Martinique\">America/Martinique</option><option value="
+    "\"America/Matamoros\">America/Matamoros</option><option value=\"America/Mazatlan\">America/Mazatlan<"
+    "/option><option value=\"America/Menominee\">America/Menominee</option><option value=\"America/Merid"
+    "a\">America/Merida</option><option value=\"America/Metlakatla\">America/Metlakatla</option><option "
+    "value=\"America/Mexico_City\">America/Mexico_City</option><option value=\"America/Miquelon\">America"
+    "/Miquelon</option><option value=\"America/Moncton\">America/Moncton</option><option value=\"America"
+    "/Monterrey\">America/Monterrey</option><option value=\"America/Montevideo\">America/Montevideo</opt"
+    "ion><option value=\"America/Montserrat\">America/Montserrat</option><option value=\"America/Nassau\""
+    ">America/Nassau</option><option value=\"America/New_York\">America/New_York</option><option value="
+    "\"America/Nome\">America/Nome</option><option value=\"America/Noronha\">America/Noronha</option><opt"
+    "ion value=\"America/North_Dakota/Beulah\">America/North_Dakota/Beulah</option><option value=\"Ameri"
+    "ca/North_Dakota/Center\">America/North_Dakota/Center</option><option value=\"America/North_Dakota/"
+    "New_Salem\">America/North_Dakota/New_Salem</option><option value=\"America/Nuuk\">America/Nuuk</opt"
+    "ion><option value=\"America/Ojinaga\">America/Ojinaga</option><option value=\"America/Panama\">Ameri"
+    "ca/Panama</option><option value=\"America/Paramaribo\">America/Paramaribo</option><option value=\"A"
+    "merica/Phoenix\">America/Phoenix</option><option value=\"America/Port-au-Prince\">America/Port-au-P"
+    "rince</option><option value=\"America/Port_of_Spain\">America/Port_of_Spain</option><option value="
+    "\"America/Porto_Velho\">America/Porto_Velho</option><option value=\"America/Puerto_Rico\">America/Pu"
+    "erto_Rico</option><option value=\"America/Punta_Arenas\">America/Punta_Arenas</option><option valu"
+    "e=\"America/Rankin_Inlet\">America/Rankin_Inlet</option><option value=\"America/Recife\">America/Rec"
+    "ife</option><option value=\"America/Regina\">America/Regina</option><option value=\"America/Resolut"
+    "e\">America/Resolute</option><option value=\"America/Rio_Branco\">America/Rio_Branco</option><optio"
+    "n value=\"America/Santarem\">America/Santarem</option><option value=\"America/Santiago\">America/San"
+    "tiago</option><option value=\"America/Santo_Domingo\">America/Santo_Domingo</option><option value="
+    "\"America/Sao_Paulo\">America/Sao_Paulo</option><option value=\"America/Scoresbysund\">America/Score"
+    "sbysund</option><option value=\"America/Sitka\">America/Sitka</option><option value=\"America/St_Ba"
+    "rthelemy\">America/St_Barthelemy</option><option value=\"America/St_Johns\">America/St_Johns</optio"
+    "n><option value=\"America/St_Kitts\">America/St_Kitts</option><option value=\"America/St_Lucia\">Ame"
+    "rica/St_Lucia</option><option value=\"America/St_Thomas\">America/St_Thomas</option><option value="
+    "\"America/St_Vincent\">America/St_Vincent</option><option value=\"America/Swift_Current\">America/Sw"
+    "ift_Current</option><option value=\"America/Tegucigalpa\">America/Tegucigalpa</option><option valu"
+    "e=\"America/Thule\">America/Thule</option><option value=\"America/Tijuana\">America/Tijuana</option>"
+    "<option value=\"America/Toronto\">America/Toronto</option><option value=\"America/Tortola\">America/"
+    "Tortola</option><option value=\"America/Vancouver\">America/Vancouver</option><option value=\"Ameri"
+    "ca/Whitehorse\">America/Whitehorse</option><option value=\"America/Winnipeg\">America/Winnipeg</opt"
+    "ion><option value=\"America/Yakutat\">America/Yakutat</option><option value=\"Antarctica/Casey\">Ant"
+    "arctica/Casey</option><option value=\"Antarctica/Davis\">Antarctica/Davis</option><option value=\"A"
+    "ntarctica/DumontDUrville\">Antarctica/DumontDUrville</option><option value=\"Antarctica/Macquarie\""
+    ">Antarctica/Macquarie</option><option value=\"Antarctica/Mawson\">Antarctica/Mawson</option><optio"
+    "n value=\"Antarctica/McMurdo\">Antarctica/McMurdo</option><option value=\"Antarctica/Palmer\">Antarc"
+    "tica/Palmer</option><option value=\"Antarctica/Rothera\">Antarctica/Rothera</option><option value="
+    "\"Antarctica/Syowa\">Antarctica/Syowa</option><option value=\"Antarctica/Troll\">Antarctica/Troll</o"
+    "ption><option value=\"Antarctica/Vostok\">Antarctica/Vostok</option><option value=\"Arctic/Longyear"
+    "byen\">Arctic/Longyearbyen</option><option value=\"Asia/Aden\">Asia/Aden</option><option value=\"Asi"
+    "a/Almaty\">Asia/Almaty</option><option value=\"Asia/Amman\">Asia/Amman</option><option value=\"Asia/"
+    "Anadyr\">Asia/Anadyr</option><option value=\"Asia/Aqtau\">Asia/Aqtau</option><option value=\"Asia/Aq"
+    "tobe\">Asia/Aqtobe</option><option value=\"Asia/Ashgabat\">Asia/Ashgabat</option><option value=\"Asi"
+    "a/Atyrau\">Asia/Atyrau</option><option value=\"Asia/Baghdad\">Asia/Baghdad</option><option value=\"A"
+    "sia/Bahrain\">Asia/Bahrain</option><option value=\"Asia/Baku\">Asia/Baku</option><option value=\"Asi"
+    "a/Bangkok\">Asia/Bangkok</option><option value=\"Asia/Barnaul\">Asia/Barnaul</option><option value="
+    "\"Asia/Beirut\">Asia/Beirut</option><option value=\"Asia/Bishkek\">Asia/Bishkek</option><option valu"
+    "e=\"Asia/Brunei\">Asia/Brunei</option><option value=\"Asia/Chita\">Asia/Chita</option><option value="
+    "\"Asia/Colombo\">Asia/Colombo</option><option value=\"Asia/Damascus\">Asia/Damascus</option><option "
+    "value=\"Asia/Dhaka\">Asia/Dhaka</option><option value=\"Asia/Dili\">Asia/Dili</option><option value="
+    "\"Asia/Dubai\">Asia/Dubai</option><option value=\"Asia/Dushanbe\">Asia/Dushanbe</option><option valu"
+    "e=\"Asia/Famagusta\">Asia/Famagusta</option><option value=\"Asia/Gaza\">Asia/Gaza</option><option va"
+    "lue=\"Asia/Hebron\">Asia/Hebron</option><option value=\"Asia/Ho_Chi_Minh\">Asia/Ho_Chi_Minh</option>"
+    "<option value=\"Asia/Hong_Kong\">Asia/Hong_Kong</option><option value=\"Asia/Hovd\">Asia/Hovd</optio"
+    "n><option value=\"Asia/Irkutsk\">Asia/Irkutsk</option><option value=\"Asia/Jakarta\">Asia/Jakarta</o"
+    "ption><option value=\"Asia/Jayapura\">Asia/Jayapura</option><option value=\"Asia/Jerusalem\">Asia/Je"
+    "rusalem</option><option value=\"Asia/Kabul\">Asia/Kabul</option><option value=\"Asia/Kamchatka\">Asi"
+    "a/Kamchatka</option><option value=\"Asia/Karachi\">Asia/Karachi</option><option value=\"Asia/Kathma"
+    "ndu\">Asia/Kathmandu</option><option value=\"Asia/Khandyga\">Asia/Khandyga</option><option value=\"A"
+    "sia/Kolkata\">Asia/Kolkata</option><option value=\"Asia/Krasnoyarsk\">Asia/Krasnoyarsk</option><opt"
+    "ion value=\"Asia/Kuala_Lumpur\">Asia/Kuala_Lumpur</option><option value=\"Asia/Kuching\">Asia/Kuchin"
+    "g</option><option value=\"Asia/Kuwait\">Asia/Kuwait</option><option value=\"Asia/Macau\">Asia/Macau<"
+    "/option><option value=\"Asia/Magadan\">Asia/Magadan</option><option value=\"Asia/Makassar\">Asia/Mak"
+    "assar</option><option value=\"Asia/Manila\">Asia/Manila</option><option value=\"Asia/Muscat\">Asia/M"
+    "uscat</option><option value=\"Asia/Nicosia\">Asia/Nicosia</option><option value=\"Asia/Novokuznetsk"
+    "\">Asia/Novokuznetsk</option><option value=\"Asia/Novosibirsk\">Asia/Novosibirsk</option><option va"
+    "lue=\"Asia/Omsk\">Asia/Omsk</option><option value=\"Asia/Oral\">Asia/Oral</option><option value=\"Asi"
+    "a/Phnom_Penh\">Asia/Phnom_Penh</option><option value=\"Asia/Pontianak\">Asia/Pontianak</option><opt"
+    "ion value=\"Asia/Pyongyang\">Asia/Pyongyang</option><option value=\"Asia/Qatar\">Asia/Qatar</option>"
+    "<option value=\"Asia/Qostanay\">Asia/Qostanay</option><option value=\"Asia/Qyzylorda\">Asia/Qyzylord"
+    "a</option><option value=\"Asia/Riyadh\">Asia/Riyadh</option><option value=\"Asia/Sakhalin\">Asia/Sak"
+    "halin</option><option value=\"Asia/Samarkand\">Asia/Samarkand</option><option value=\"Asia/Seoul\">A"
+    "sia/Seoul</option><option value=\"Asia/Shanghai\">Asia/Shanghai</option><option value=\"Asia/Singap"
+    "ore\">Asia/Singapore</option><option value=\"Asia/Srednekolymsk\">Asia/Srednekolymsk</option><optio"
+    "n value=\"Asia/Taipei\">Asia/Taipei</option><option value=\"Asia/Tashkent\">Asia/Tashkent</option><o"
+    "ption value=\"Asia/Tbilisi\">Asia/Tbilisi</option><option value=\"Asia/Tehran\">Asia/Tehran</option>"
+    "<option value=\"Asia/Thimphu\">Asia/Thimphu</option><option value=\"Asia/Tokyo\">Asia/Tokyo</option>"
+    "<option value=\"Asia/Tomsk\">Asia/Tomsk</option><option value=\"Asia/Ulaanbaatar\">Asia/Ulaanbaatar<"
+    "/option><option value=\"Asia/Urumqi\">Asia/Urumqi</option><option value=\"Asia/Ust-Nera\">Asia/Ust-N"
+    "era</option><option value=\"Asia/Vientiane\">Asia/Vientiane</option><option value=\"Asia/Vladivosto"
+    "k\">Asia/Vladivostok</option><option value=\"Asia/Yakutsk\">Asia/Yakutsk</option><option value=\"Asi"
+    "a/Yangon\">Asia/Yangon</option><option value=\"Asia/Yekaterinburg\">Asia/Yekaterinburg</option><opt"
+    "ion value=\"Asia/Yerevan\">Asia/Yerevan</option><option value=\"Atlantic/Azores\">Atlantic/Azores</o"
+    "ption><option value=\"Atlantic/Bermuda\">Atlantic/Bermuda</option><option value=\"Atlantic/Canary\">"
+    "Atlantic/Canary</option><option value=\"Atlantic/Cape_Verde\">Atlantic/Cape_Verde</option><option "
+    "value=\"Atlantic/Faroe\">Atlantic/Faroe</option><option value=\"Atlantic/Madeira\">Atlantic/Madeira<"
+    "/option><option value=\"Atlantic/Reykjavik\">Atlantic/Reykjavik</option><option value=\"Atlantic/So"
+    "uth_Georgia\">Atlantic/South_Georgia</option><option value=\"Atlantic/St_Helena\">Atlantic/St_Helen"
+    "a</option><option value=\"Atlantic/Stanley\">Atlantic/Stanley</option><option value=\"Australia/Ade"
+    "laide\">Australia/Adelaide</option><option value=\"Australia/Brisbane\">Australia/Brisbane</option>"
+    "<option value=\"Australia/Broken_Hill\">Australia/Broken_Hill</option><option value=\"Australia/Dar"
+    "win\">Australia/Darwin</option><option value=\"Australia/Eucla\">Australia/Eucla</option><option va"
+    "lue=\"Australia/Hobart\">Australia/Hobart</option><option value=\"Australia/Lindeman\">Australia/Lin"
+    "deman</option><option value=\"Australia/Lord_Howe\">Australia/Lord_Howe</option><option value=\"Aus"
+    "tralia/Melbourne\">Australia/Melbourne</option><option value=\"Australia/Perth\">Australia/Perth</o"
+    "ption><option value=\"Australia/Sydney\">Australia/Sydney</option><option value=\"Etc/GMT\">Etc/GMT<"
+    "/option><option value=\"Etc/GMT+1\">Etc/GMT+1</option><option value=\"Etc/GMT+10\">Etc/GMT+10</optio"
+    "n><option value=\"Etc/GMT+11\">Etc/GMT+11</option><option value=\"Etc/GMT+12\">Etc/GMT+12</option><o"
+    "ption value=\"Etc/GMT+2\">Etc/GMT+2</option><option value=\"Etc/GMT+3\">Etc/GMT+3</option><option va"
+    "lue=\"Etc/GMT+4\">Etc/GMT+4</option><option value=\"Etc/GMT+5\">Etc/GMT+5</option><option value=\"Etc"
+    "/GMT+6\">Etc/GMT+6</option><option value=\"Etc/GMT+7\">Etc/GMT+7</option><option value=\"Etc/GMT+8\">"
+    "Etc/GMT+8</option><option value=\"Etc/GMT+9\">Etc/GMT+9</option><option value=\"Etc/GMT-1\">Etc/GMT-"
+    "1</option><option value=\"Etc/GMT-10\">Etc/GMT-10</option><option value=\"Etc/GMT-11\">Etc/GMT-11</o"
+    "ption><option value=\"Etc/GMT-12\">Etc/GMT-12</option><option value=\"Etc/GMT-13\">Etc/GMT-13</optio"
+    "n><option value=\"Etc/GMT-14\">Etc/GMT-14</option><option value=\"Etc/GMT-2\">Etc/GMT-2</option><opt"
+    "ion value=\"Etc/GMT-3\">Etc/GMT-3</option><option value=\"Etc/GMT-4\">Etc/GMT-4</option><option valu"
+    "e=\"Etc/GMT-5\">Etc/GMT-5</option><option value=\"Etc/GMT-6\">Etc/GMT-6</option><option value=\"Etc/G"
+    "MT-7\">Etc/GMT-7</option><option value=\"Etc/GMT-8\">Etc/GMT-8</option><option value=\"Etc/GMT-9\">Et"
+    "c/GMT-9</option><option value=\"Etc/UTC\">Etc/UTC</option><option value=\"Europe/Amsterdam\">Europe/"
+    "Amsterdam</option><option value=\"Europe/Andorra\">Europe/Andorra</option><option value=\"Europe/As"
+    "trakhan\">Europe/Astrakhan</option><option value=\"Europe/Athens\">Europe/Athens</option><option va"
+    "lue=\"Europe/Belgrade\">Europe/Belgrade</option><option value=\"Europe/Berlin\">Europe/Berlin</optio"
+    "n><option value=\"Europe/Bratislava\">Europe/Bratislava</option><option value=\"Europe/Brussels\">Eu"
+    "rope/Brussels</option><option value=\"Europe/Bucharest\">Europe/Bucharest</option><option value=\"E"
+    "urope/Budapest\">Europe/Budapest</option><option value=\"Europe/Busingen\">Europe/Busingen</option>"
+    "<option value=\"Europe/Chisinau\">Europe/Chisinau</option><option value=\"Europe/Copenhagen\">Europe"
+    "/Copenhagen</option><option value=\"Europe/Dublin\">Europe/Dublin</option><option value=\"Europe/Gi"
+    "braltar\">Europe/Gibraltar</option><option value=\"Europe/Guernsey\">Europe/Guernsey</option><optio"
+    "n value=\"Europe/Helsinki\">Europe/Helsinki</option><option value=\"Europe/Isle_of_Man\">Europe/Isle"
+    "_of_Man</option><option value=\"Europe/Istanbul\">Europe/Istanbul</option><option value=\"Europe/Je"
+    "rsey\">Europe/Jersey</option><option value=\"Europe/Kaliningrad\">Europe/Kaliningrad</option><optio"
+    "n value=\"Europe/Kirov\">Europe/Kirov</option><option value=\"Europe/Kyiv\">Europe/Kyiv</option><opt"
+    "ion value=\"Europe/Lisbon\">Europe/Lisbon</option><option value=\"Europe/Ljubljana\">Europe/Ljubljan"
+    "a</option><option value=\"Europe/London\">Europe/London</option><option value=\"Europe/Luxembourg\">"
+    "Europe/Luxembourg</option><option value=\"Europe/Madrid\">Europe/Madrid</option><option value=\"Eur"
+    "ope/Malta\">Europe/Malta</option><option value=\"Europe/Mariehamn\">Europe/Mariehamn</option><optio"
+    "n value=\"Europe/Minsk\">Europe/Minsk</option><option value=\"Europe/Monaco\">Europe/Monaco</option>"
+    "<option value=\"Europe/Moscow\">Europe/Moscow</option><option value=\"Europe/Oslo\">Europe/Oslo</opt"
+    "ion><option value=\"Europe/Paris\">Europe/Paris</option><option value=\"Europe/Podgorica\">Europe/Po"
+    "dgorica</option><option value=\"Europe/Prague\">Europe/Prague</option><option value=\"Europe/Riga\">"
+    "Europe/Riga</option><option value=\"Europe/Rome\">Europe/Rome</option><option value=\"Europe/Samara"
+    "\">Europe/Samara</option><option value=\"Europe/San_Marino\">Europe/San_Marino</option><option valu"
+    "e=\"Europe/Sarajevo\">Europe/Sarajevo</option><option value=\"Europe/Saratov\">Europe/Saratov</optio"
+    "n><option value=\"Europe/Simferopol\">Europe/Simferopol</option><option value=\"Europe/Skopje\">Euro"
+    "pe/Skopje</option><option value=\"Europe/Sofia\">Europe/Sofia</option><option value=\"Europe/Stockh"
+    "olm\">Europe/Stockholm</option><option value=\"Europe/Tallinn\">Europe/Tallinn</option><option valu"
+    "e=\"Europe/Tirane\">Europe/Tirane</option><option value=\"Europe/Ulyanovsk\">Europe/Ulyanovsk</optio"
+    "n><option value=\"Europe/Vaduz\">Europe/Vaduz</option><option value=\"Europe/Vatican\">Europe/Vatica"
+    "n</option><option value=\"Europe/Vienna\">Europe/Vienna</option><option value=\"Europe/Vilnius\">Eur"
+    "ope/Vilnius</option><option value=\"Europe/Volgograd\">Europe/Volgograd</option><option value=\"Eur"
+    "ope/Warsaw\">Europe/Warsaw</option><option value=\"Europe/Zagreb\">Europe/Zagreb</option><option va"
+    "lue=\"Europe/Zurich\">Europe/Zurich</option><option value=\"Indian/Antananarivo\">Indian/Antananariv"
+    "o</option><option value=\"Indian/Chagos\">Indian/Chagos</option><option value=\"Indian/Christmas\">I"
+    "ndian/Christmas</option><option value=\"Indian/Cocos\">Indian/Cocos</option><option value=\"Indian/"
+    "Comoro\">Indian/Comoro</option><option value=\"Indian/Kerguelen\">Indian/Kerguelen</option><option "
+    "value=\"Indian/Mahe\">Indian/Mahe</option><option value=\"Indian/Maldives\">Indian/Maldives</option>"
+    "<option value=\"Indian/Mauritius\">Indian/Mauritius</option><option value=\"Indian/Mayotte\">Indian/"
+    "Mayotte</option><option value=\"Indian/Reunion\">Indian/Reunion</option><option value=\"Pacific/Api"
+    "a\">Pacific/Apia</option><option value=\"Pacific/Auckland\">Pacific/Auckland</option><option value="
+    "\"Pacific/Bougainville\">Pacific/Bougainville</option><option value=\"Pacific/Chatham\">Pacific/Chat"
+    "ham</option><option value=\"Pacific/Chuuk\">Pacific/Chuuk</option><option value=\"Pacific/Easter\">P"
+    "acific/Easter</option><option value=\"Pacific/Efate\">Pacific/Efate</option><option value=\"Pacific"
+    "/Fakaofo\">Pacific/Fakaofo</option><option value=\"Pacific/Fiji\">Pacific/Fiji</option><option valu"
+    "e=\"Pacific/Funafuti\">Pacific/Funafuti</option><option value=\"Pacific/Galapagos\">Pacific/Galapago"
+    "s</option><option value=\"Pacific/Gambier\">Pacific/Gambier</option><option value=\"Pacific/Guadalc"
+    "anal\">Pacific/Guadalcanal</option><option value=\"Pacific/Guam\">Pacific/Guam</option><option valu"
+    "e=\"Pacific/Honolulu\">Pacific/Honolulu</option><option value=\"Pacific/Kanton\">Pacific/Kanton</opt"
+    "ion><option value=\"Pacific/Kiritimati\">Pacific/Kiritimati</option><option value=\"Pacific/Kosrae\""
+    ">Pacific/Kosrae</option><option value=\"Pacific/Kwajalein\">Pacific/Kwajalein</option><option valu"
+    "e=\"Pacific/Majuro\">Pacific/Majuro</option><option value=\"Pacific/Marquesas\">Pacific/Marquesas</o"
+    "ption><option value=\"Pacific/Midway\">Pacific/Midway</option><option value=\"Pacific/Nauru\">Pacifi"
+    "c/Nauru</option><option value=\"Pacific/Niue\">Pacific/Niue</option><option value=\"Pacific/Norfolk"
+    "\">Pacific/Norfolk</option><option value=\"Pacific/Noumea\">Pacific/Noumea</option><option value=\"P"
+    "acific/Pago_Pago\">Pacific/Pago_Pago</option><option value=\"Pacific/Palau\">Pacific/Palau</option>"
+    "<option value=\"Pacific/Pitcairn\">Pacific/Pitcairn</option><option value=\"Pacific/Pohnpei\">Pacifi"
+    "c/Pohnpei</option><option value=\"Pacific/Port_Moresby\">Pacific/Port_Moresby</option><option valu"
+    "e=\"Pacific/Rarotonga\">Pacific/Rarotonga</option><option value=\"Pacific/Saipan\">Pacific/Saipan</o"
+    "ption><option value=\"Pacific/Tahiti\">Pacific/Tahiti</option><option value=\"Pacific/Tarawa\">Pacif"
+    "ic/Tarawa</option><option value=\"Pacific/Tongatapu\">Pacific/Tongatapu</option><option value=\"Pac"
+    "ific/Wake\">Pacific/Wake</option><option value=\"Pacific/Wallis\">Pacific/Wallis</option>";
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,54 @@
+#include "timezones.h"
+#include <string.h>
+#include "timezone_data.h"
+
+const char *TimeZones::findPosixTz(const char *name)
+{
+    if (name == nullptr)
+    {
+        return nullptr;
+    }
+
+    size_t low = 0;
+    size_t high = TZ_COUNT;
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        int cmp = strcmp(name, TZ_NAMES + TZ_INDEX[mid].name);
+        if (cmp == 0)
+        {
+            return TZ_RULES + TZ_INDEX[mid].posixTz;
+        }
+
+        if (cmp < 0)
+        {
+            high = mid;
+        }
+        else
+        {
+            low = mid + 1;
+        }
+    }
+
+    return nullptr;
+}
+
+size_t TimeZones::count()
+{
+    return TZ_COUNT;
+}
+
+const char *TimeZones::getName(size_t index)
+{
+    return index < TZ_COUNT ? TZ_NAMES + TZ_INDEX[index].name : nullptr;
+}
+
+const char *TimeZones::optionsHtml()
+{
+    return TZ_OPTIONS_HTML;
+}
+
+size_t TimeZones::optionsHtmlLength()
+{
+    return sizeof(TZ_OPTIONS_HTML) - 1;
+}
@@ -0,0 +1,21 @@
+#ifndef TIMEZONES_H
+#define TIMEZONES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Lookup into the generated timezone tables (see tools/gen_timezones.py).
+class TimeZones
+{
+public:
+    // binary search by IANA name, returns the POSIX TZ string or nullptr
+    static const char *findPosixTz(const char *name);
+    static bool isValid(const char *name) { return findPosixTz(name) != nullptr; }
+    static size_t count();
+    static const char *getName(size_t index);
+    // prebuilt <option> list of all zones, without a selection
+    static const char *optionsHtml();
+    static size_t optionsHtmlLength();
+};
+
+#endif // TIMEZONES_H
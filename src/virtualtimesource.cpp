@@ -0,0 +1,54 @@
+#include "virtualtimesource.h"
+
+VirtualTimeSource::VirtualTimeSource(MillisFunction millisFn) : millisFn(millisFn)
+{
+}
+
+VirtualTimeSource::~VirtualTimeSource()
+{
+}
+
+bool VirtualTimeSource::now(time_t &utc)
+{
+    if (millisFn == nullptr)
+    {
+        utc = base;
+        return true;
+    }
+
+    uint64_t elapsed = static_cast<uint32_t>(millisFn() - baseMillis);
+    utc = base + static_cast<time_t>(elapsed * speed / 1000);
+    return true;
+}
+
+bool VirtualTimeSource::adjust(time_t utc)
+{
+    jumpTo(utc);
+    return true;
+}
+
+void VirtualTimeSource::jumpTo(time_t utc)
+{
+    base = utc;
+    baseMillis = millisFn ? millisFn() : 0;
+}
+
+void VirtualTimeSource::advance(uint32_t seconds)
+{
+    rebase();
+    base += seconds;
+}
+
+void VirtualTimeSource::setSpeed(uint16_t speed)
+{
+    // keep the virtual time continuous across speed changes
+    rebase();
+    this->speed = speed > 0 ? speed : 1;
+}
+
+void VirtualTimeSource::rebase()
+{
+    time_t current;
+    now(current);
+    jumpTo(current);
+}
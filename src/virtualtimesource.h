@@ -0,0 +1,33 @@
+#ifndef VIRTUALTIMESOURCE_H
+#define VIRTUALTIMESOURCE_H
+
+#include <stdint.h>
+#include "itimesource.h"
+
+using MillisFunction = uint32_t (*)();
+
+// Time that runs at a multiple of real time or is stepped manually, used for
+// time-warp testing on the device and for replaying days on the host.
+class VirtualTimeSource : public ITimeSource
+{
+private:
+    MillisFunction millisFn;
+    time_t base = 0;
+    uint32_t baseMillis = 0;
+    uint16_t speed = 1;
+    void rebase();
+
+public:
+    // a null millis function gives a clock that only moves through advance()
+    VirtualTimeSource(MillisFunction millisFn = nullptr);
+    ~VirtualTimeSource();
+    bool begin() override { return true; }
+    bool now(time_t &utc) override;
+    bool adjust(time_t utc) override;
+    void jumpTo(time_t utc);
+    void advance(uint32_t seconds);
+    void setSpeed(uint16_t speed);
+    uint16_t getSpeed() const { return speed; }
+};
+
+#endif // VIRTUALTIMESOURCE_H
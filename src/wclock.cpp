@@ -1,25 +1,41 @@
 #include "wclock.h"
 
-WClock::WClock(RTC_DS3231 &rtc) : rtc(rtc)
+WClock::WClock(RTC_DS3231 &rtc) : rtcSource(rtc), virtualSource(millisSource), softwareClock(millisSource),
+                                  clockSource(&rtcSource), holdoverSource(&rtcSource), arbiter(softwareClock)
 {
 }
 
 WClock::~WClock()
 {
-    schedulerCallback = nullptr;
+    ticker.setCallback(nullptr);
+}
+
+uint32_t WClock::millisSource()
+{
+    return millis();
 }
 
 bool WClock::init(const SchedulerCallback &schedulerCb)
 {
-    schedulerCallback = schedulerCb;
-    if (!rtc.begin())
+    ticker.setCallback(schedulerCb);
+    bool rtcFound = rtcSource.begin();
+    if (!rtcFound)
     {
-        Serial.println("Couldn't find RTC");
-        return false;
+        Serial.println("Couldn't find RTC, keeping time in software");
+        holdoverSource = &softwareClock;
+    }
+    clockSource = holdoverSource;
+
+    time_t utc;
+    if (clockSource->now(utc))
+    {
+        // the software clock carries the RTC time between network syncs
+        softwareClock.adjust(utc);
+        ticker.sync(utc);
     }
 
     initialized = true;
-    return true;
+    return rtcFound;
 }
 
 uint8_t WClock::getHour()
@@ -29,7 +45,7 @@ uint8_t WClock::getHour()
         return 0;
     }
 
-    return timeinfo.tm_hour;
+    return ticker.getLocalTime().tm_hour;
 }
 
 uint8_t WClock::getMinute()
@@ -39,42 +55,53 @@ uint8_t WClock::getMinute()
         return 0;
     }
 
-    return timeinfo.tm_min;
+    return ticker.getLocalTime().tm_min;
 }
 
-void WClock::enableSchedule(long start, long end)
+bool WClock::enableSchedule(const LightScheduler::Rule *rules, uint8_t count)
 {
     if (!initialized)
     {
-        return;
+        return false;
     }
 
-    long hourStart = start / 3600;
-    long minuteStart = (start % 3600) / 60;
-    long hourEnd = end / 3600;
-    long minuteEnd = (end % 3600) / 60;
-
-    if (!initialized || hourStart > 23 || hourEnd > 23 || minuteStart > 59 || minuteEnd > 59)
+    bool valid = ticker.enableSchedule(rules, count);
+    if (!valid)
     {
         Serial.println("Invalid schedule parameters");
-        return;
     }
-
-    scheduleStartHour = hourStart;
-    scheduleStartMinute = minuteStart;
-    scheduleEndHour = hourEnd;
-    scheduleEndMinute = minuteEnd;
-    scheduleEnabled = true;
+    return valid;
 }
 
 void WClock::disableSchedule()
 {
-    scheduleEnabled = false;
-    scheduleRunning = false;
-    scheduleStartHour = 0;
-    scheduleStartMinute = 0;
-    scheduleEndHour = 0;
-    scheduleEndMinute = 0;
+    ticker.disableSchedule();
+}
+
+const LightScheduler::Rule *WClock::getActiveScheduleRule()
+{
+    return ticker.getActiveScheduleRule();
+}
+
+bool WClock::setLocation(float latitude, float longitude)
+{
+    if (!ticker.setLocation(latitude, longitude))
+    {
+        Serial.println("Invalid location");
+        return false;
+    }
+
+    time_t utc;
+    if (initialized && clockSource->now(utc))
+    {
+        ticker.sync(utc);
+    }
+    return true;
+}
+
+void WClock::clearLocation()
+{
+    ticker.clearLocation();
 }
 
 void WClock::setTime(uint8_t hour, uint8_t minute)
@@ -85,10 +112,19 @@ void WClock::setTime(uint8_t hour, uint8_t minute)
         return;
     }
 
-    timeinfo.tm_hour = hour;
-    timeinfo.tm_min = minute;
-    timeinfo.tm_sec = 0;
-    rtc.adjust(DateTime(timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday, timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec));
+    // keep the local date, the ticker resolves the UTC instant for the active timezone
+    struct tm local = ticker.getLocalTime();
+    local.tm_hour = hour;
+    local.tm_min = minute;
+    local.tm_sec = 0;
+    time_t utc = ticker.toUtc(local);
+
+    clockSource->adjust(utc);
+    if (clockSource != &softwareClock)
+    {
+        softwareClock.adjust(utc);
+    }
+    ticker.adjust(utc);
 }
 
 void WClock::setTimeZone(const char *timezone)
@@ -99,23 +135,34 @@ void WClock::setTimeZone(const char *timezone)
     }
     this->timezone = timezone;
 
-    char buf[64];
-    for(const TzEntry &tz : TIMEZONES)
+    const char *rule = TimeZones::findPosixTz(timezone);
+    if (rule == nullptr)
     {
-        strcpy_P(buf, (char*)pgm_read_ptr(&(tz.name)));
+        Serial.println("Invalid timezone");
+        return;
+    }
 
-        if(strcmp(timezone, buf) == 0) {
-            //Serial.print("Setting timezone to ");
-            //Serial.println(buf);
-            strcpy_P(buf, (char*)pgm_read_ptr(&(tz.posixTz)));
-            //Serial.println(buf);
-            setenv("TZ", buf, 1);
-            tzset();
-            return;
-        }
+    // rules are deduplicated in flash, so an unchanged zone is a pointer compare
+    if (rule == posixTz)
+    {
+        return;
     }
 
-    Serial.println("Invalid timezone");
+    //Serial.printf("Setting timezone to %s (%s)\n", timezone, rule);
+    if (!ticker.setTimeZone(rule))
+    {
+        Serial.println("Unsupported timezone rule");
+        return;
+    }
+    posixTz = rule;
+
+    // local time moved, redraw on the next tick
+    time_t utc;
+    if (clockSource->now(utc))
+    {
+        ticker.sync(utc);
+        ticker.refresh();
+    }
 }
 
 void WClock::enableNTP(const char *timezone, const char *ntpServer, long ntpUpdateInterval)
@@ -125,12 +172,21 @@ void WClock::enableNTP(const char *timezone, const char *ntpServer, long ntpUpda
         return;
     }
 
-    this->ntpServer = ntpServer;
     this->ntpUpdateInterval = ntpUpdateInterval;
-    this->timezone = timezone;
+    setTimeZone(timezone);
+
+    ntpProbes[0].setServer(ntpServer);
+    ntpProbes[1].setServer(NTP_SERVER_2);
+    ntpProbes[2].setServer(NTP_SERVER_3);
+    for (SntpProbe &probe : ntpProbes)
+    {
+        arbiter.addProbe(&probe);
+    }
+    arbiter.addProbe(&httpProbe);
     ntpEnabled = true;
 
-    updateInternal(true);
+    lastNTPtime = millis();
+    arbiter.startRound(lastNTPtime);
 }
 
 void WClock::disableNTP()
@@ -140,68 +196,67 @@ void WClock::disableNTP()
 
 void WClock::synchronizeNTP()
 {
-    if (!initialized)
+    if (!initialized || arbiter.isRoundActive())
     {
         return;
     }
 
-    updateInternal(true);
+    lastNTPtime = millis();
+    arbiter.startRound(lastNTPtime);
 }
 
-bool WClock::updateInternal(bool ntpUpdate)
+void WClock::applyEstimate(const TimeArbiter::Estimate &estimate)
 {
-    if (ntpUpdate)
+    time_t utc;
+    if (!softwareClock.now(utc))
     {
-        fetchNTPTime();
-        setTimeZone(timezone);
-        if (fetchLocalTime(timeinfo)) {
-            rtc.adjust(DateTime(timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday, timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec));
-            Serial.println("Synced time from NTP");
-            return true;
-        }
+        return;
     }
-    else
+
+    if (holdoverSource == &rtcSource)
     {
-        DateTime now = rtc.now();
-        timeinfo.tm_year = now.year() - 1900;
-        timeinfo.tm_mon = now.month() - 1;
-        timeinfo.tm_mday = now.day();
-        timeinfo.tm_hour = now.hour();
-        timeinfo.tm_min = now.minute();
-        timeinfo.tm_sec = now.second();
-        // Serial.println("Synced time from RTC");
-        return true;
+        rtcSource.adjust(utc);
     }
-
-    return false;
+    if (clockSource == holdoverSource)
+    {
+        // most syncs correct by milliseconds, the schedule must not fire again for them
+        ticker.adjust(utc);
+    }
+    Serial.printf("Synced time from %u of %u sources (+/- %u ms)\n", estimate.sources, estimate.voters, estimate.errorMs);
 }
 
-void WClock::fetchNTPTime()
+void WClock::enableTimeWarp(time_t utc, uint16_t speed)
 {
     if (!initialized)
     {
         return;
     }
 
-    configTime(0, timeinfo.tm_isdst == 0 ? 0 : 3600, this->ntpServer, NTP_SERVER_2, NTP_SERVER_3);
-}
-
-bool WClock::fetchLocalTime(struct tm &timeinfo) {
-
-    if (getLocalTime(&timeinfo, ntpTimeout))
+    if (utc == 0)
     {
-        // Serial.println("Successfully obtained time");
-        // Serial.println(&timeinfo, "%d.%m.%Y %H:%M:%S %Z");
-        lastNTPtime = millis();
-        return true;
+        clockSource->now(utc);
     }
-    else
+
+    virtualSource.jumpTo(utc);
+    virtualSource.setSpeed(speed);
+    clockSource = &virtualSource;
+    ticker.refresh();
+    // poll fast enough to see every minute up to 100x, beyond that the schedule catches up
+    timeInfoUpdateInterval = TIMEINFO_UPDATE_INTERVAL / virtualSource.getSpeed();
+    if (timeInfoUpdateInterval < TIMEWARP_UPDATE_INTERVAL_MIN)
     {
-        Serial.println("Failed to get local time");
-        // DateTime now = rtc.now();
-        // Serial.println(now.timestamp(now.TIMESTAMP_FULL));
-        return false;
+        timeInfoUpdateInterval = TIMEWARP_UPDATE_INTERVAL_MIN;
     }
+    ticker.resyncSchedule();
+    Serial.printf("Time warp at %ux\n", virtualSource.getSpeed());
+}
+
+void WClock::disableTimeWarp()
+{
+    clockSource = holdoverSource;
+    timeInfoUpdateInterval = TIMEINFO_UPDATE_INTERVAL;
+    ticker.refresh();
+    ticker.resyncSchedule();
 }
 
 void WClock::loop()
@@ -211,43 +266,39 @@ void WClock::loop()
         return;
     }
 
-    long now = millis();
-    if (now - lastTimeInfoUpdate > TIMEINFO_UPDATE_INTERVAL)
+    uint32_t now = millis();
+    if (now - lastTimeInfoUpdate > timeInfoUpdateInterval)
     {
         lastTimeInfoUpdate = now;
-        updateInternal();
 
-        if (timeinfo.tm_hour != lastHour || timeinfo.tm_min != lastMinute)
+        time_t utc;
+        if (clockSource->now(utc))
         {
-            lastHour = timeinfo.tm_hour;
-            lastMinute = timeinfo.tm_min;
-            if (schedulerCallback)
-            {
-                schedulerCallback(SchedulerType::Timestamp, timeinfo.tm_hour, timeinfo.tm_min);
-            }
+            ticker.tick(utc);
         }
+    }
 
-        if (scheduleEnabled && !scheduleRunning && timeinfo.tm_hour == scheduleStartHour && timeinfo.tm_min == scheduleStartMinute)
-        {
-            if (schedulerCallback)
-            {
-                schedulerCallback(SchedulerType::ScheduleStart, timeinfo.tm_hour, timeinfo.tm_min);
-                scheduleRunning = true;
-            }
-        }
-        if (scheduleEnabled && timeinfo.tm_hour == scheduleEndHour && timeinfo.tm_min == scheduleEndMinute)
-        {
-            if (schedulerCallback)
-            {
-                schedulerCallback(SchedulerType::ScheduleEnd, timeinfo.tm_hour, timeinfo.tm_min);
-                scheduleRunning = false;
-            }
-        }
+    if (!ntpEnabled)
+    {
+        return;
     }
 
-    if (ntpEnabled && millis() - lastNTPtime > ntpUpdateInterval * 60000) // minutes to ms
+    if (!arbiter.isRoundActive() && now - lastNTPtime > ntpUpdateInterval * 60000) // minutes to ms
     {
         lastNTPtime = now;
-        updateInternal(true);
+        arbiter.startRound(now);
     }
-}
\ No newline at end of file
+
+    TimeArbiter::Estimate estimate;
+    bool roundActive = arbiter.isRoundActive();
+    if (arbiter.loop(millis(), estimate))
+    {
+        applyEstimate(estimate);
+    }
+    else if (roundActive && !arbiter.isRoundActive())
+    {
+        // no majority or no answers, try again soon instead of waiting a full interval
+        Serial.println("Failed to get network time");
+        lastNTPtime = now - ntpUpdateInterval * 60000 + SYNC_RETRY_INTERVAL;
+    }
+}
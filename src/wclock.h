@@ -6,51 +6,73 @@
 #include <time.h>
 #include <RTClib.h>
 #include "callbacktypes.h"
-#include "timezone_data.h"
-
-using SchedulerCallback = std::function<void(SchedulerType type, uint8_t hour, uint8_t minute)>;
+#include "timezones.h"
+#include "lightscheduler.h"
+#include "clockticker.h"
+#include "rtctimesource.h"
+#include "virtualtimesource.h"
+#include "softwareclock.h"
+#include "timearbiter.h"
+#include "sntpprobe.h"
+#include "httpdateprobe.h"
 
 class WClock
 {
 private:
-    static constexpr const char *NTP_SERVER_2 = "1.pool.ntp.org";
-    static constexpr const char *NTP_SERVER_3 = "2.pool.ntp.org";
     // static const long NTP_UPDATE_INTERVAL = 21600000;
     static const int TIMEINFO_UPDATE_INTERVAL = 1000;
-    SchedulerCallback schedulerCallback;
-    static const u16_t ntpTimeout = 15000;
-    const char *ntpServer;
+    static const int TIMEWARP_UPDATE_INTERVAL_MIN = 10;
+    static const uint32_t SYNC_RETRY_INTERVAL = 60000;
+    static constexpr const char *NTP_SERVER_2 = "1.pool.ntp.org";
+    static constexpr const char *NTP_SERVER_3 = "2.pool.ntp.org";
     const char *timezone;
-    RTC_DS3231 rtc;
+    const char *posixTz = nullptr;
+    RtcTimeSource rtcSource;
+    VirtualTimeSource virtualSource;
+    SoftwareClock softwareClock;
+    ITimeSource *clockSource;
+    ITimeSource *holdoverSource;
+    TimeArbiter arbiter;
+    SntpProbe ntpProbes[3];
+    HttpDateProbe httpProbe;
+    ClockTicker ticker;
     bool ntpEnabled = false;
-    struct tm timeinfo;
     long ntpUpdateInterval = 21600; // seconds, 6h
     uint32_t lastNTPtime = 0;
     uint32_t lastTimeInfoUpdate = 0;
-    bool scheduleEnabled = false;
-    bool scheduleRunning = false;
-    uint8_t scheduleStartHour = 0;
-    uint8_t scheduleStartMinute = 0;
-    uint8_t scheduleEndHour = 0;
-    uint8_t scheduleEndMinute = 0;
-    uint8_t lastHour = 0;
-    uint8_t lastMinute = 0;
-    void fetchNTPTime();
-    bool fetchLocalTime(struct tm &timeinfo);
+    uint32_t timeInfoUpdateInterval = TIMEINFO_UPDATE_INTERVAL;
     bool initialized = false;
-    bool updateInternal(bool ntpUpdate = false);
+    void applyEstimate(const TimeArbiter::Estimate &estimate);
+    static uint32_t millisSource();
 
 public:
     WClock(RTC_DS3231 &rtc);
     ~WClock();
+    // false if there is no RTC, the clock then keeps time in software
     bool init(const SchedulerCallback &schedulerCb);
     void setTime(uint8_t hour, uint8_t minute);
     void setTimeZone(const char *timezone);
     void enableNTP(const char *timezone, const char *ntpServer, long ntpUpdateInterval);
     void synchronizeNTP();
     void disableNTP();
-    void enableSchedule(long start, long end);
+    // extra references such as the Home Assistant time, polled along with NTP
+    bool addTimeProbe(ITimeProbe *probe) { return arbiter.addProbe(probe); }
+    void removeTimeProbe(ITimeProbe *probe) { arbiter.removeProbe(probe); }
+    const TimeArbiter &getArbiter() const { return arbiter; }
+    bool hasRTC() { return holdoverSource == &rtcSource; }
+    bool enableSchedule(const LightScheduler::Rule *rules, uint8_t count);
     void disableSchedule();
+    const LightScheduler::Rule *getActiveScheduleRule();
+    // enables sunrise/sunset anchored rules, the sun times are computed once per local day
+    bool setLocation(float latitude, float longitude);
+    void clearLocation();
+    // local minutes since midnight, -1 without a location or during polar day/night
+    int16_t getSunrise() { return ticker.getSunrise(); }
+    int16_t getSunset() { return ticker.getSunset(); }
+    // runs the clock from a virtual source at speed x real time, starting at utc (0 = now)
+    void enableTimeWarp(time_t utc, uint16_t speed);
+    void disableTimeWarp();
+    bool isTimeWarpEnabled() { return clockSource == &virtualSource; }
     uint8_t getHour();
     uint8_t getMinute();
     void loop();
@@ -0,0 +1,125 @@
+#include "webrequest.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+WebRequest::WebRequest(ControlType type)
+{
+    memset(static_cast<void *>(this), 0, sizeof(*this));
+    this->type = type;
+}
+
+bool WebRequest::parseColor(const char *text, uint8_t rgb[3])
+{
+    if (text == nullptr || text[0] != '#' || strlen(text) != 7)
+    {
+        return false;
+    }
+    for (uint8_t i = 1; i < 7; i++)
+    {
+        if (!isxdigit(static_cast<unsigned char>(text[i])))
+        {
+            return false;
+        }
+    }
+
+    unsigned long value = strtoul(text + 1, nullptr, 16);
+    rgb[0] = (value >> 16) & 0xFF;
+    rgb[1] = (value >> 8) & 0xFF;
+    rgb[2] = value & 0xFF;
+    return true;
+}
+
+bool WebRequest::parseTimeOfDay(const char *text, TimeOfDay &time)
+{
+    if (text == nullptr || strlen(text) != 5 || text[2] != ':' ||
+        !isdigit(static_cast<unsigned char>(text[0])) || !isdigit(static_cast<unsigned char>(text[1])) ||
+        !isdigit(static_cast<unsigned char>(text[3])) || !isdigit(static_cast<unsigned char>(text[4])))
+    {
+        return false;
+    }
+
+    uint8_t hour = (text[0] - '0') * 10 + (text[1] - '0');
+    uint8_t minute = (text[3] - '0') * 10 + (text[4] - '0');
+    if (hour >= 24 || minute >= 60)
+    {
+        return false;
+    }
+    time.hour = hour;
+    time.minute = minute;
+    return true;
+}
+
+bool WebRequest::parseScheduleEdge(const char *anchor, const char *time, const char *offset, Anchor &kind, uint16_t &value)
+{
+    if (anchor == nullptr || strcmp(anchor, "time") == 0)
+    {
+        TimeOfDay parsed;
+        if (!parseTimeOfDay(time, parsed))
+        {
+            return false;
+        }
+        kind = AnchorTime;
+        value = parsed.hour * 60 + parsed.minute;
+        return true;
+    }
+
+    if (strcmp(anchor, "sunrise") == 0)
+    {
+        kind = AnchorSunrise;
+    }
+    else if (strcmp(anchor, "sunset") == 0)
+    {
+        kind = AnchorSunset;
+    }
+    else
+    {
+        return false;
+    }
+
+    // e.g. -30 for half an hour before sunset, a missing offset means the event itself
+    long minutes = 0;
+    if (offset != nullptr)
+    {
+        char *end = nullptr;
+        minutes = strtol(offset, &end, 10);
+        if (end == offset || *end != '\0')
+        {
+            return false;
+        }
+    }
+    if (minutes < -LightScheduler::MAX_ANCHOR_OFFSET || minutes > LightScheduler::MAX_ANCHOR_OFFSET)
+    {
+        return false;
+    }
+    value = static_cast<uint16_t>(static_cast<int16_t>(minutes));
+    return true;
+}
+
+uint8_t WebRequest::anchorFlags(Anchor start, Anchor end)
+{
+    uint8_t flags = 0;
+    if (start == AnchorSunrise)
+    {
+        flags |= LightScheduler::RULE_START_SUNRISE;
+    }
+    else if (start == AnchorSunset)
+    {
+        flags |= LightScheduler::RULE_START_SUNSET;
+    }
+    if (end == AnchorSunrise)
+    {
+        flags |= LightScheduler::RULE_END_SUNRISE;
+    }
+    else if (end == AnchorSunset)
+    {
+        flags |= LightScheduler::RULE_END_SUNSET;
+    }
+    return flags;
+}
+
+PageState::PageState(PageType page)
+{
+    memset(static_cast<void *>(this), 0, sizeof(*this));
+    this->page = page;
+}
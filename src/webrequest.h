@@ -0,0 +1,96 @@
+#ifndef WEBREQUEST_H
+#define WEBREQUEST_H
+
+#include <stdint.h>
+#include "callbacktypes.h"
+#include "configdata.h"
+#include "lightscheduler.h"
+#include "otawriter.h"
+#include "pullupdater.h"
+
+// A validated command from the web UI. The handler fills the member that
+// belongs to type, so the application reads typed values instead of
+// looking up and converting strings.
+struct WebRequest
+{
+    enum Anchor : uint8_t {
+        AnchorTime = 0,
+        AnchorSunrise,
+        AnchorSunset
+    };
+
+    struct TimeOfDay {
+        uint8_t hour;
+        uint8_t minute;
+    };
+
+    // rule is ready to store, index may equal the rule count to append one
+    struct ScheduleRule {
+        bool enabled;
+        uint8_t index;
+        LightScheduler::Rule rule;
+    };
+
+    struct TimeWarp {
+        uint16_t speed;
+        int64_t epoch;
+    };
+
+    ControlType type;
+    union {
+        bool enabled;                          // LightStatus, AutoBrightness
+        uint8_t brightness;                    // Brightness
+        char color[8];                         // Color, "#RRGGBB"
+        ConfigData::ClockMode clockMode;       // ClockFace
+        TimeOfDay time;                        // Time
+        ConfigData::MqttConfig mqtt;           // HaIntegration
+        ConfigData::NtpConfig ntp;             // NTPSync
+        ScheduleRule schedule;                 // LightSchedule
+        uint8_t ruleIndex;                     // LightScheduleRuleDelete
+        ConfigData::LocationConfig location;   // Location
+        ConfigData::WifiConfig wifi;           // WiFiSetup
+        TimeWarp timeWarp;                     // TimeWarp
+        char url[PullUpdater::URL_SIZE];       // PullUpdate, the image directory
+    };
+
+    // payload is zeroed, strings are empty
+    explicit WebRequest(ControlType type);
+
+    static bool parseColor(const char *text, uint8_t rgb[3]);
+    static bool parseTimeOfDay(const char *text, TimeOfDay &time);
+    // an edge is a time of day ("HH:MM", anchor "time" or nullptr) or a signed
+    // offset in minutes from sunrise/sunset; value is in the Rule encoding
+    static bool parseScheduleEdge(const char *anchor, const char *time, const char *offset, Anchor &kind, uint16_t &value);
+    static uint8_t anchorFlags(Anchor start, Anchor end);
+};
+
+// Values that are not part of the configuration, captured by the main loop
+// for the web handlers. The pages themselves are static and filled in by the browser.
+struct PageState
+{
+    struct TimePage {
+        WebRequest::TimeOfDay time;
+        int16_t sunrise; // minutes since midnight, negative if unknown
+        int16_t sunset;
+    };
+
+    struct SystemPage {
+        char configWrites[128];
+    };
+
+    struct FirmwarePage {
+        const char *version;
+        OtaWriter::Progress update;
+    };
+
+    PageType page;
+    union {
+        TimePage time;
+        SystemPage system;
+        FirmwarePage firmware;
+    };
+
+    explicit PageState(PageType page);
+};
+
+#endif // WEBREQUEST_H
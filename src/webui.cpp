@@ -1,4 +1,7 @@
 #include "webui.h"
+#include <memory>
+#include <new>
+#include <type_traits>
 
 // paths
 const char WebUI::PATH_NAVIGATION_HTML[] PROGMEM = "/navigation.html";
@@ -10,6 +13,15 @@ const char WebUI::PATH_WIFI_HTML[] PROGMEM = "/wifimanager.html";
 const char WebUI::PATH_CSS[] PROGMEM = "/style.css";
 const char WebUI::PATH_JS[] PROGMEM = "/index.js";
 const char WebUI::PATH_ICON[] PROGMEM = "/favicon.ico";
+const char WebUI::PATH_TIMEZONES[] PROGMEM = "/timezones";
+const char WebUI::PATH_API_CONFIG[] PROGMEM = "/api/config";
+const char WebUI::PATH_API_STATE[] PROGMEM = "/api/v1/state";
+const char WebUI::PATH_API_UPDATE[] PROGMEM = "/api/v1/update";
+const char WebUI::PATH_API_UPDATE_PULL[] PROGMEM = "/api/v1/update/pull";
+const char WebUI::PATH_API_ADMISSION[] PROGMEM = "/api/v1/admission";
+const char WebUI::PATH_EVENTS[] PROGMEM = "/events";
+const char WebUI::SUFFIX_GZIP[] PROGMEM = ".gz";
+const char WebUI::SUFFIX_GZIP_TEMPLATE[] PROGMEM = ".gzt";
 
 // page titles
 const char WebUI::LIGHT_PAGE_TITLE[] PROGMEM = "Light Settings";
@@ -17,50 +29,34 @@ const char WebUI::SYSTEM_PAGE_TITLE[] PROGMEM = "System Configuration";
 const char WebUI::TIME_PAGE_TITLE[] PROGMEM = "Time Configuration";
 const char WebUI::FIRMWARE_PAGE_TITLE[] PROGMEM = "Firmware Update";
 
-// processor variables
-const char WebUI::PROC_PAGE_TITLE[] PROGMEM = "%PAGE_TITLE%";
-const char WebUI::PROC_ACTIVE_LIGHT[] PROGMEM = "%ACTIVE_LIGHT%";
-const char WebUI::PROC_ACTIVE_TIME[] PROGMEM = "%ACTIVE_TIME%";
-const char WebUI::PROC_ACTIVE_SYSTEM[] PROGMEM = "%ACTIVE_SYSTEM%";
-const char WebUI::PROC_LIGHT_STATE[] PROGMEM = "LIGHT_STATE";
-const char WebUI::PROC_LIGHT_COLOR[] PROGMEM = "LIGHT_COLOR";
-const char WebUI::PROC_LIGHT_BRIGHTNESS[] PROGMEM = "LIGHT_BRIGHTNESS";
-const char WebUI::PROC_AUTO_BRIGHTNESS_ENABLED[] PROGMEM = "AUTO_BRIGHTNESS_ENABLED";
-const char WebUI::PROC_TIME[] PROGMEM = "CURRENT_TIME"; 
-const char WebUI::PROC_NTP_ENABLED[] PROGMEM = "NTP_ENABLED";
-const char WebUI::PROC_NTP_HOST[] PROGMEM = "NTP_HOST";
-const char WebUI::PROC_NTP_UPDATE_INTERVAL[] PROGMEM = "NTP_UPDATE_INTERVAL";
-const char WebUI::PROC_NTP_TIMEZONE[] PROGMEM = "NTP_TIMEZONE";
-const char WebUI::PROC_BROKER_ENABLED[] PROGMEM = "BROKER_ENABLED";
-const char WebUI::PROC_BROKER_HOST[] PROGMEM = "BROKER_HOST";
-const char WebUI::PROC_BROKER_PORT[] PROGMEM = "BROKER_PORT";
-const char WebUI::PROC_BROKER_USER[] PROGMEM = "BROKER_USER";
-const char WebUI::PROC_BROKER_PASS[] PROGMEM = "BROKER_PASS";
-const char WebUI::PROC_BROKER_DEFAULT_TOPIC[] PROGMEM = "BROKER_DEFAULT_TOPIC";
-const char WebUI::PROC_SCHEDULE_ENABLED[] PROGMEM = "SCHEDULE_ENABLED";
-const char WebUI::PROC_SCHEDULE_START[] PROGMEM = "SCHEDULE_START";
-const char WebUI::PROC_SCHEDULE_END[] PROGMEM = "SCHEDULE_END";
-const char WebUI::PROC_CLOCKFACE[] PROGMEM = "CLOCKFACE";
-const char WebUI::PROC_CLOCKFACE_OPTION_STATE[] PROGMEM = "CLOCKFACE_OPTION_STATE";
-const char WebUI::PROC_FW_VERS[] PROGMEM = "FW_VERSION";
-
 // values
 const char WebUI::VALUE_SUCCESS[] PROGMEM = "Success";
 const char WebUI::VALUE_ERROR[] PROGMEM = "Error!";
-const char WebUI::VALUE_CHECKED[] PROGMEM = "checked";
 const char WebUI::VALUE_ACTIVE[] PROGMEM = "active";
 const char WebUI::VALUE_EMPTY[] PROGMEM = "";
 const char WebUI::VALUE_FIRMWARE[] PROGMEM = "firmware";
 const char WebUI::VALUE_FILESYS[] PROGMEM = "filesystem";
+const char WebUI::VALUE_DELTA[] PROGMEM = "delta";
 
 const char WebUI::CONTENT_TEXT[] PROGMEM = "text/plain";
 const char WebUI::CONTENT_HTML[] PROGMEM = "text/html";
+const char WebUI::CONTENT_JSON[] PROGMEM = "application/json";
+const char WebUI::CONTENT_CSS[] PROGMEM = "text/css";
+const char WebUI::CONTENT_JS[] PROGMEM = "application/javascript";
+const char WebUI::CONTENT_ICON[] PROGMEM = "image/x-icon";
 const char WebUI::CONTENT_CACHE[] PROGMEM = "max-age=86400";
 
 const char WebUI::PARAM_FW_Type[] PROGMEM = "updateType";
+const char WebUI::PARAM_FW_SIZE[] PROGMEM = "size";
+const char WebUI::PARAM_FW_SHA256[] PROGMEM = "sha256";
+const char WebUI::PARAM_FW_URL[] PROGMEM = "url";
+const char WebUI::PARAM_SECRETS[] PROGMEM = "secrets";
 
 const char WebUI::VALUE_ON[] PROGMEM = "1";
 const char WebUI::VALUE_OFF[] PROGMEM = "0";
+const char WebUI::VALUE_ANCHOR_TIME[] PROGMEM = "time";
+const char WebUI::VALUE_ANCHOR_SUNRISE[] PROGMEM = "sunrise";
+const char WebUI::VALUE_ANCHOR_SUNSET[] PROGMEM = "sunset";
 
 const char WebUI::PARAM_WIFI_SSID[] PROGMEM = "ssid";
 const char WebUI::PARAM_WIFI_PASS[] PROGMEM = "wifi-pass";
@@ -84,12 +80,28 @@ const char WebUI::PARAM_NTP_TIMEZONE[] PROGMEM = "ntpTimezone";
 const char WebUI::PARAM_SCHEDULE_ENABLED[] PROGMEM = "scheduleEnabled";
 const char WebUI::PARAM_SCHEDULE_START[] PROGMEM = "scheduleStart";
 const char WebUI::PARAM_SCHEDULE_END[] PROGMEM = "scheduleEnd";
+const char WebUI::PARAM_SCHEDULE_RULE[] PROGMEM = "scheduleRule";
+const char WebUI::PARAM_SCHEDULE_DAYS[] PROGMEM = "scheduleDays";
+const char WebUI::PARAM_SCHEDULE_BRIGHTNESS[] PROGMEM = "scheduleBrightness";
+const char WebUI::PARAM_SCHEDULE_COLOR[] PROGMEM = "scheduleColor";
+const char WebUI::PARAM_SCHEDULE_START_ANCHOR[] PROGMEM = "scheduleStartAnchor";
+const char WebUI::PARAM_SCHEDULE_END_ANCHOR[] PROGMEM = "scheduleEndAnchor";
+const char WebUI::PARAM_SCHEDULE_START_OFFSET[] PROGMEM = "scheduleStartOffset";
+const char WebUI::PARAM_SCHEDULE_END_OFFSET[] PROGMEM = "scheduleEndOffset";
+const char WebUI::PARAM_LOCATION_ENABLED[] PROGMEM = "locationEnabled";
+const char WebUI::PARAM_LATITUDE[] PROGMEM = "latitude";
+const char WebUI::PARAM_LONGITUDE[] PROGMEM = "longitude";
+const char WebUI::PARAM_SUNRISE[] PROGMEM = "sunrise";
+const char WebUI::PARAM_SUNSET[] PROGMEM = "sunset";
 const char WebUI::PARAM_CLOCKFACE[] PROGMEM = "clockFace";        
 const char WebUI::PARAM_CLOCKFACE_OPTION[] PROGMEM = "clockFaceOption";
 const char WebUI::PARAM_FW_VERSION[] PROGMEM = "fwVersion";
+const char WebUI::PARAM_CONFIG_WRITES[] PROGMEM = "configWrites";
+const char WebUI::PARAM_TIMEWARP_SPEED[] PROGMEM = "speed";
+const char WebUI::PARAM_TIMEWARP_EPOCH[] PROGMEM = "epoch";
 
 
-WebUI::WebUI(AsyncWebServer &srv) : server(srv)
+WebUI::WebUI(AsyncWebServer &srv) : server(srv), events(PATH_EVENTS)
 {
 }
 
@@ -101,6 +113,8 @@ WebUI::~WebUI()
     requestCallback = nullptr;
     responseCallback = nullptr;
     updateCallback = nullptr;
+    delete pendingPatch.exchange(nullptr);
+    delete pendingImport.exchange(nullptr);
 }
 
 void WebUI::init(const RequestCallback &requestCb,
@@ -119,160 +133,449 @@ void WebUI::init(const RequestCallback &requestCb,
     requestCallback = requestCb;
     responseCallback = responseCb;
     updateCallback = updateCb;
+    publishSnapshot();
+
+    // a filesystem update restarts the device, so the templates only change at boot
+    bootId = esp_random();
+    loadTemplates();
+    initAssets();
 
     server.on("/", HTTP_GET, [this](AsyncWebServerRequest *request)
               { request->redirect("/light"); });
-    server.on("/light", HTTP_GET, [this](AsyncWebServerRequest *request)
-              { 
-                const std::map<String, String> params = responseCallback(PageType::LIGHT);
-                request->send(
-                    LittleFS,
-                    FPSTR(PATH_LIGHT_HTML),
-                    FPSTR(CONTENT_HTML),
-                    false,
-                    [this, params](const String &var) -> String
-                    {
-                        return this->pageProcessor(var, PageType::LIGHT, params);
-                    }); 
-                });
+    server.on("/light", HTTP_GET, admitted(AdmissionControl::Pages, [this](AsyncWebServerRequest *request)
+              { this->sendPage(request, PageType::LIGHT, PATH_LIGHT_HTML); }));
 
     // Handle light status toggle
-    server.on("/toggleLight", HTTP_GET, [this](AsyncWebServerRequest *request)
-              { this->handleToggleLight(request); });
+    server.on("/toggleLight", HTTP_GET, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+              { this->handleToggleLight(request); }));
 
     // Handle light color change
-    server.on("/setLightColor", HTTP_GET, [this](AsyncWebServerRequest *request)
-              { this->handleSetLightColor(request); });
+    server.on("/setLightColor", HTTP_GET, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+              { this->handleSetLightColor(request); }));
 
     // Handle auto-brightness toggle
-    server.on("/setAutoBrightness", HTTP_GET, [this](AsyncWebServerRequest *request)
-              { this->handleSetAutoBrightness(request); });
+    server.on("/setAutoBrightness", HTTP_GET, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+              { this->handleSetAutoBrightness(request); }));
 
     // Handle brightness adjustment
-    server.on("/setBrightness", HTTP_GET, [this](AsyncWebServerRequest *request)
-              { this->handleSetBrightness(request); });
+    server.on("/setBrightness", HTTP_GET, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+              { this->handleSetBrightness(request); }));
 
-    server.on("/time", HTTP_GET, [this](AsyncWebServerRequest *request)
-              { 
-                const std::map<String, String> params = responseCallback(PageType::TIME);
-                // TODO: call responseCallback to get the details only once and provide parameter list to page processor
-                request->send(
-                    LittleFS,
-                    FPSTR(PATH_TIME_HTML),
-                    FPSTR(CONTENT_HTML),
-                    false,
-                    [this, params](const String &var) -> String
-                    {
-                        return this->pageProcessor(var, PageType::TIME, params);
-                    }); });
+    server.on("/time", HTTP_GET, admitted(AdmissionControl::Pages, [this](AsyncWebServerRequest *request)
+              { this->sendPage(request, PageType::TIME, PATH_TIME_HTML); }));
+
+    // full option list straight from flash, the time page only renders the selected zone
+    server.on(PATH_TIMEZONES, HTTP_GET, admitted(AdmissionControl::Assets, [this](AsyncWebServerRequest *request)
+              {
+                AsyncWebServerResponse *response = request->beginResponse(200, CONTENT_HTML, (const uint8_t *)TimeZones::optionsHtml(), TimeZones::optionsHtmlLength());
+                response->addHeader("Cache-Control", CONTENT_CACHE);
+                request->send(response); }));
 
     // server.on("/getCurrentTime", HTTP_GET, [this](AsyncWebServerRequest *request)
     //           { request->send(200, FPSTR(CONTENT_TEXT), "12:30"); });
-    server.on("/setTime", HTTP_POST, [this](AsyncWebServerRequest *request)
-    { this->handleSetTime(request); });
+    server.on("/setTime", HTTP_POST, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+    { this->handleSetTime(request); }));
 
-    server.on("/setLightSchedule", HTTP_POST, [this](AsyncWebServerRequest *request)
-    { this->handleSetLightSchedule(request); });
+    server.on("/setLightSchedule", HTTP_POST, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+    { this->handleSetLightSchedule(request); }));
 
-    server.on("/setNTPConfig", HTTP_POST, [this](AsyncWebServerRequest *request)
-    { this->handleSetNTPConfig(request); });
+    server.on("/deleteLightScheduleRule", HTTP_POST, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+    { this->handleDeleteLightScheduleRule(request); }));
 
-    server.on("/system", HTTP_GET, [this](AsyncWebServerRequest *request)
-              { 
-                const std::map<String, String> params = responseCallback(PageType::SYSTEM);
-                request->send(
-                    LittleFS,
-                    FPSTR(PATH_SYSTEM_HTML),
-                    FPSTR(CONTENT_HTML),
-                    false,
-                    [this, params](const String &var) -> String
-                    {
-                        return this->pageProcessor(var, PageType::SYSTEM, params);
-                    }); });
-
-    server.on("/setHaIntegration", HTTP_POST, [this](AsyncWebServerRequest *request)
-              { this->handleSetHAIntegration(request); });
-
-    server.on("/setClockFace", HTTP_POST, [this](AsyncWebServerRequest *request)
-              { this->handleSetClockFace(request); });
-
-    server.on("/resetConfig", HTTP_POST, [this](AsyncWebServerRequest *request)
-              { requestCallback(ControlType::ResetConfig, std::map<String, String>()); });
-
-    server.on("/update", HTTP_GET, [this](AsyncWebServerRequest *request)
-              { 
-                const std::map<String, String> params = responseCallback(PageType::FWUPDATE);
-                request->send(
-                    LittleFS,
-                    FPSTR(PATH_FIRMWARE_HTML),
-                    FPSTR(CONTENT_HTML),
-                    false,
-                    [this, params](const String &var) -> String
-                    {
-                        return this->pageProcessor(var, PageType::FWUPDATE, params);
-                    }); });
+    server.on("/setNTPConfig", HTTP_POST, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+    { this->handleSetNTPConfig(request); }));
+
+    server.on("/setLocation", HTTP_POST, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+    { this->handleSetLocation(request); }));
+
+    server.on("/system", HTTP_GET, admitted(AdmissionControl::Pages, [this](AsyncWebServerRequest *request)
+              { this->sendPage(request, PageType::SYSTEM, PATH_SYSTEM_HTML); }));
+
+    server.on("/setHaIntegration", HTTP_POST, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+              { this->handleSetHAIntegration(request); }));
+
+    server.on("/setClockFace", HTTP_POST, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+              { this->handleSetClockFace(request); }));
+
+    server.on("/resetConfig", HTTP_POST, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+              { this->sendQueued(request, WebRequest(ControlType::ResetConfig)); }));
+
+    if (configExportCallback && configImportCallback)
+    {
+        server.on(PATH_API_CONFIG, HTTP_GET, admitted(AdmissionControl::Api, [this](AsyncWebServerRequest *request)
+                  { this->handleConfigExport(request); }));
+        server.on(PATH_API_CONFIG, HTTP_POST, [this](AsyncWebServerRequest *request)
+                  { this->handleConfigImport(request); }, nullptr, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+                  { this->handleConfigImportBody(request, data, len, index, total); });
+    }
+
+    if (stateCallback && statePatchCallback)
+    {
+        server.on(PATH_API_STATE, HTTP_GET, admitted(AdmissionControl::Api, [this](AsyncWebServerRequest *request)
+                  { this->sendState(request, readSnapshot(&Snapshot::state)); }));
+        server.on(PATH_API_STATE, HTTP_PATCH, [this](AsyncWebServerRequest *request)
+                  { this->handleStatePatch(request); }, nullptr, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+                  { readConfigBody(request, data, len, index, total); });
+    }
+
+    server.on("/update", HTTP_GET, admitted(AdmissionControl::Pages, [this](AsyncWebServerRequest *request)
+              { this->sendPage(request, PageType::FWUPDATE, PATH_FIRMWARE_HTML); }));
 
     server.on("/update", HTTP_POST, [this](AsyncWebServerRequest *request)
               { handleFirmwareUpdate(request); }, [this](AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final)
               { 
                 UpdateType type = UpdateType::FIRMWARE;
-                if (index == 0 && request->hasParam(FPSTR(PARAM_FW_Type), true)) {  
-                    //const AsyncWebParameter *p = request->getParam(PARAM_FW_Type, true);  
-                    //Serial.printf("POST[%s]: %s\n", p->name().c_str(), p->value().c_str());
-                    const String tParam = request->getParam(FPSTR(PARAM_FW_Type), true)->value();
-                    //Serial.printf("Update type: %s\n", tParam.c_str());
-                    if(tParam == FPSTR(VALUE_FIRMWARE)) {
-                        type = UpdateType::FIRMWARE;
-                    } else if(tParam == FPSTR(VALUE_FILESYS)) {
+                OtaWriter::Manifest manifest = {};
+                if (index == 0) {
+                    // the outcome stays with the request, only the handler answers
+                    UploadResult *started = static_cast<UploadResult *>(malloc(sizeof(UploadResult)));
+                    if (started == nullptr) {
+                        return;
+                    }
+                    *started = UploadPending;
+                    request->_tempObject = started;
+                }
+                UploadResult *result = static_cast<UploadResult *>(request->_tempObject);
+                if (result == nullptr || *result != UploadPending) {
+                    // refused with the first chunk, the rest is read and dropped
+                    return;
+                }
+                if (index == 0) {
+                    // the form fields come before the file
+                    const char *typeParam = getValue(request, PARAM_FW_Type, true);
+                    if (typeParam != nullptr && strcmp_P(typeParam, VALUE_FILESYS) == 0) {
                         type = UpdateType::FILESYSTEM;
-                    } else {
+                    } else if (typeParam != nullptr && strcmp_P(typeParam, VALUE_DELTA) == 0) {
+                        // the patch carries size and digest of the image it makes
+                        type = UpdateType::DELTA;
+                    } else if (typeParam != nullptr && strcmp_P(typeParam, VALUE_FIRMWARE) != 0) {
                         Serial.println("Invalid update type");
-                        request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+                        *result = UploadRejected;
+                        return;
+                    }
+                    const char *sizeParam = getValue(request, PARAM_FW_SIZE, true);
+                    if (sizeParam != nullptr) {
+                        manifest.size = strtoul(sizeParam, nullptr, 10);
                     }
+                    const char *digestParam = getValue(request, PARAM_FW_SHA256, true);
+                    if (digestParam != nullptr && digestParam[0] != '\0') {
+                        manifest.hasDigest = Sha256::parseHex(digestParam, manifest.sha256);
+                        if (!manifest.hasDigest) {
+                            Serial.println("Invalid SHA-256");
+                            *result = UploadRejected;
+                            return;
+                        }
+                    }
+                }
+                if (!updateCallback(type, manifest, filename, index, data, len, final)) {
+                    *result = UploadBusy;
+                    return;
                 }
-                //Serial.printf("Type: %u, Update: %s, Index: %u, Len: %u, Final: %u\n", type, filename.c_str(), index, len, final);
-                updateCallback(type, filename, index, data, len, final); });
+                if (final) {
+                    // taken here on the task that wrote the image, the handler only reads the request
+                    *result = updateSuccessCallback() ? UploadSucceeded : UploadFailed;
+                } });
+
+    server.on(PATH_API_UPDATE, HTTP_GET, [this](AsyncWebServerRequest *request)
+              { this->sendUpdateStatus(request); });
+    // not admission controlled, it has to answer when everything else is refused
+    server.on(PATH_API_ADMISSION, HTTP_GET, [this](AsyncWebServerRequest *request)
+              { this->sendAdmissionStats(request); });
+    server.on(PATH_API_UPDATE_PULL, HTTP_POST, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+              { this->handlePullUpdate(request); }));
+
+#ifdef WOC_TIME_WARP
+    server.on("/debug/timewarp", HTTP_POST, admitted(AdmissionControl::Commands, [this](AsyncWebServerRequest *request)
+              { this->handleTimeWarp(request); }));
+#endif
+
+    if (eventStateCallback)
+    {
+        // further clients get a 404, which EventSource does not retry
+        events.setFilter([this](AsyncWebServerRequest *)
+                         { return events.count() < MAX_EVENT_CLIENTS; });
+        events.onConnect([this](AsyncEventSourceClient *)
+                         { eventClientJoined = true; });
+        server.addHandler(&events);
+    }
 
     // Other routes with sanitized handlers
     server.onNotFound([](AsyncWebServerRequest *request)
                       { request->send(404, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR)); });
 
     // Serve Static CSS and JS only
-    server.serveStatic(PATH_CSS, LittleFS, PATH_CSS).setCacheControl(CONTENT_CACHE);
-    server.serveStatic(PATH_JS, LittleFS, PATH_JS).setCacheControl(CONTENT_CACHE);
-    server.serveStatic(PATH_ICON, LittleFS, PATH_ICON).setCacheControl(CONTENT_CACHE);
+    serveAsset(PATH_CSS, ASSET_CSS);
+    serveAsset(PATH_JS, ASSET_JS);
+    serveAsset(PATH_ICON, ASSET_ICON);
     server.begin();
 }
 
+void WebUI::setConfigCallbacks(const ConfigExportCallback &exportCb, const ConfigImportCallback &importCb)
+{
+    configExportCallback = exportCb;
+    configImportCallback = importCb;
+}
+
+void WebUI::setEventCallback(const EventStateCallback &eventCb)
+{
+    eventStateCallback = eventCb;
+}
+
+void WebUI::setRestartCallback(const RestartCallback &restartCb)
+{
+    restartCallback = restartCb;
+}
+
+void WebUI::loop()
+{
+    QueuedRequest queued;
+    while (commands.pop(queued))
+    {
+        int8_t slot = latestWinsSlot(queued.command.type);
+        if (slot >= 0 && queued.generation != latestGeneration[slot].load())
+        {
+            // superseded by a newer command of the same type
+            continue;
+        }
+        if (requestCallback)
+        {
+            requestCallback(queued.command);
+        }
+        snapshotStale = true;
+    }
+
+    ConfigJsonReader *patch = pendingPatch.exchange(nullptr);
+    if (patch != nullptr)
+    {
+        if (!statePatchCallback(*patch))
+        {
+            Serial.println("State patch not applied");
+        }
+        delete patch;
+        snapshotStale = true;
+    }
+
+    ConfigJsonReader *imported = pendingImport.exchange(nullptr);
+    if (imported != nullptr)
+    {
+        // WiFi, MQTT and the schedule are only set up at boot
+        if (configImportCallback(*imported))
+        {
+            restartCallback();
+        }
+        else
+        {
+            Serial.println("Config import not applied");
+        }
+        delete imported;
+        snapshotStale = true;
+    }
+
+    if (snapshotStale || millis() - lastSnapshot >= SNAPSHOT_INTERVAL)
+    {
+        publishSnapshot();
+    }
+    sendEvents();
+}
+
+void WebUI::publishSnapshot()
+{
+    const uint8_t next = publishedSnapshot.load() ^ 1;
+    if (readingSnapshot.load() == next)
+    {
+        // a handler still copies from the previous one, the next loop tries again
+        return;
+    }
+    Snapshot &snapshot = snapshots[next];
+    if (stateCallback)
+    {
+        snapshot.state = stateCallback();
+    }
+    if (configExportCallback)
+    {
+        snapshot.config = configExportCallback();
+    }
+    if (responseCallback)
+    {
+        responseCallback(snapshot.time);
+        responseCallback(snapshot.system);
+        responseCallback(snapshot.firmware);
+    }
+    publishedSnapshot.store(next);
+    lastSnapshot = millis();
+    snapshotStale = false;
+}
+
+// called from the AsyncTCP task, the copy is taken from a slot loop() is not filling
+template <typename T>
+T WebUI::readSnapshot(T Snapshot::*member)
+{
+    uint8_t current = publishedSnapshot.load();
+    while (true)
+    {
+        readingSnapshot.store(current);
+        const uint8_t published = publishedSnapshot.load();
+        if (published == current)
+        {
+            break;
+        }
+        current = published;
+    }
+    T copy = snapshots[current].*member;
+    readingSnapshot.store(-1);
+    return copy;
+}
+
+int8_t WebUI::latestWinsSlot(ControlType type)
+{
+    // only the last value of these matters, e.g. while a slider is dragged
+    switch (type)
+    {
+    case ControlType::LightStatus:
+        return 0;
+    case ControlType::Color:
+        return 1;
+    case ControlType::Brightness:
+        return 2;
+    case ControlType::AutoBrightness:
+        return 3;
+    case ControlType::ClockFace:
+        return 4;
+    default:
+        return -1;
+    }
+}
+
+bool WebUI::queueRequest(const WebRequest &command)
+{
+    int8_t slot = latestWinsSlot(command.type);
+    uint32_t generation = slot >= 0 ? latestGeneration[slot].fetch_add(1) + 1 : 0;
+    if (commands.push(QueuedRequest(command, generation)))
+    {
+        return true;
+    }
+    // a dropped command must not supersede the one still queued, unless a newer one took its place
+    if (slot >= 0)
+    {
+        latestGeneration[slot].compare_exchange_strong(generation, generation - 1);
+    }
+    return false;
+}
+
+void WebUI::sendQueued(AsyncWebServerRequest *request, const WebRequest &command)
+{
+    if (!queueRequest(command))
+    {
+        Serial.println("Command queue full");
+        sendBusy(request);
+        return;
+    }
+    request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
+}
+
+void WebUI::sendBusy(AsyncWebServerRequest *request)
+{
+    AsyncWebServerResponse *response = request->beginResponse(503, CONTENT_TEXT, VALUE_ERROR);
+    response->addHeader("Retry-After", "1");
+    request->send(response);
+}
+
+ArRequestHandlerFunction WebUI::admitted(AdmissionControl::RouteClass route, const ArRequestHandlerFunction &handler)
+{
+    return [this, route, handler](AsyncWebServerRequest *request)
+    {
+        if (!admit(request, route))
+        {
+            sendBusy(request);
+            return;
+        }
+        handler(request);
+    };
+}
+
+bool WebUI::admit(AsyncWebServerRequest *request, AdmissionControl::RouteClass route)
+{
+    AdmissionControl::Verdict verdict = admission.admit(route, currentHeap());
+    if (verdict != AdmissionControl::Admitted)
+    {
+        Serial.printf("Request %s refused: reason %u\n", request->url().c_str(), (unsigned)verdict);
+        return false;
+    }
+    // the request holds its memory until the response is out and the connection is closed
+    request->onDisconnect([this, route]()
+                          { admission.release(route); });
+    return true;
+}
+
+AdmissionControl::Heap WebUI::currentHeap()
+{
+    return {ESP.getFreeHeap(), ESP.getMaxAllocHeap()};
+}
+
+void WebUI::sendAdmissionStats(AsyncWebServerRequest *request)
+{
+    char stats[AdmissionControl::STATS_SIZE];
+    if (admission.formatStats(currentHeap(), stats, sizeof(stats)) == 0)
+    {
+        request->send(500, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+        return;
+    }
+    AsyncWebServerResponse *response = request->beginResponse(200, CONTENT_JSON, stats);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
+void WebUI::sendEvents()
+{
+    if (!eventStateCallback || events.count() == 0)
+    {
+        return;
+    }
+    if (eventClientJoined.exchange(false))
+    {
+        // a new client starts from the full state
+        stateEvents.markAll();
+    }
+
+    StateEvents::Values values;
+    eventStateCallback(values);
+    stateEvents.update(values);
+    // while clients fall behind, changes keep collecting in the next message
+    if (events.avgPacketsWaiting() >= MAX_EVENTS_WAITING)
+    {
+        return;
+    }
+    char message[StateEvents::MESSAGE_SIZE];
+    if (stateEvents.take(millis(), message, sizeof(message)) > 0)
+    {
+        events.send(message, "state", ++eventId);
+    }
+}
+
+void WebUI::setStateCallbacks(const ConfigExportCallback &stateCb, const StatePatchCallback &patchCb)
+{
+    stateCallback = stateCb;
+    statePatchCallback = patchCb;
+}
+
 void WebUI::initHostAP(const RequestCallback &requestCb)
 {
     requestCallback = requestCb;
 
-    server.on("/", HTTP_GET, [this](AsyncWebServerRequest *request)
-              { request->send(
-                    LittleFS,
-                    FPSTR(PATH_WIFI_HTML),
-                    FPSTR(CONTENT_HTML)); });
+    initAssets();
+    serveAsset("/", ASSET_WIFI);
 
     server.on("/", HTTP_POST, [this](AsyncWebServerRequest *request)
               {
-        String ssid, password;
-
-        if(request->hasParam(FPSTR(PARAM_WIFI_SSID), true)) {
-            std::map<String, String> params;
-            params[FPSTR(PARAM_ENABLED)] = FPSTR(VALUE_ON);
-            params[FPSTR(PARAM_WIFI_SSID)] = request->getParam(FPSTR(PARAM_WIFI_SSID), true)->value();
-            if(request->hasParam(FPSTR(PARAM_WIFI_PASS), true)) {
-                params[FPSTR(PARAM_WIFI_PASS)] = request->getParam(FPSTR(PARAM_WIFI_PASS), true)->value();
-            } else {
-                params[FPSTR(PARAM_WIFI_PASS)] = String();
-            }
-
-            // Use the callback with the received SSID and password
-            requestCallback(ControlType::WiFiSetup, params);
-            request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
-            delay(3000);
-            ESP.restart();
+        const char *ssid = getValue(request, PARAM_WIFI_SSID, true);
+        if(ssid != nullptr) {
+            const char *password = getValue(request, PARAM_WIFI_PASS, true);
+            WebRequest setup(ControlType::WiFiSetup);
+            ConfigData::copyString(setup.wifi.ssid, ssid, sizeof(setup.wifi.ssid));
+            ConfigData::copyString(setup.wifi.password, password != nullptr ? password : "", sizeof(setup.wifi.password));
+
+            // the main loop stores it and restarts into station mode
+            sendQueued(request, setup);
         } else {
                 Serial.println("Missing SSID parameter");
                 request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
@@ -280,15 +583,56 @@ void WebUI::initHostAP(const RequestCallback &requestCb)
         } });
 
     // Serve Static CSS and JS only
-    server.serveStatic(PATH_CSS, LittleFS, PATH_CSS).setCacheControl(CONTENT_CACHE);
-    server.serveStatic(PATH_JS, LittleFS, PATH_JS).setCacheControl(CONTENT_CACHE);
-    server.serveStatic(PATH_ICON, LittleFS, PATH_ICON).setCacheControl(CONTENT_CACHE);
+    serveAsset(PATH_CSS, ASSET_CSS);
+    serveAsset(PATH_JS, ASSET_JS);
+    serveAsset(PATH_ICON, ASSET_ICON);
     server.begin();
 }
 
+void WebUI::sendUpdateStatus(AsyncWebServerRequest *request)
+{
+    PageState firmware = readSnapshot(&Snapshot::firmware);
+    char status[OtaWriter::STATUS_SIZE];
+    OtaWriter::formatStatus(firmware.firmware.update, status, sizeof(status));
+    AsyncWebServerResponse *response = request->beginResponse(200, CONTENT_JSON, status);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
+void WebUI::handlePullUpdate(AsyncWebServerRequest *request)
+{
+    // the download runs from the main loop, progress is in /api/v1/update
+    const char *urlParam = getValue(request, PARAM_FW_URL, true);
+    char host[64];
+    uint16_t port;
+    const char *path;
+    if (urlParam == nullptr || strlen(urlParam) >= PullUpdater::URL_SIZE ||
+        !PullUpdater::parseUrl(urlParam, host, sizeof(host), port, path))
+    {
+        Serial.println("Invalid update URL");
+        request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+        return;
+    }
+    WebRequest command(ControlType::PullUpdate);
+    ConfigData::copyString(command.url, urlParam, sizeof(command.url));
+    sendQueued(request, command);
+}
+
 void WebUI::handleFirmwareUpdate(AsyncWebServerRequest *request)
 {
-    if (updateSuccessCallback())
+    const UploadResult *result = static_cast<const UploadResult *>(request->_tempObject);
+    if (result != nullptr && *result == UploadRejected)
+    {
+        request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+        return;
+    }
+    if (result != nullptr && *result == UploadBusy)
+    {
+        // a pull update is writing, the upload can be sent again once it is done
+        request->send(409, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+        return;
+    }
+    if (result != nullptr && *result == UploadSucceeded)
     {
         Serial.println("Update successful");
         // String responseHtml = "<html><body><h1>Update Successful</h1><p>The device will restart shortly. Please wait...</p><script>setTimeout(function(){ window.location.reload(); }, 10000);</script></body></html>";
@@ -298,9 +642,7 @@ void WebUI::handleFirmwareUpdate(AsyncWebServerRequest *request)
         // response->addHeader("Connection", "close");
         // request->send(response);
         request->redirect("/system");
-        Serial.println("Restarting...");
-        delay(2000);
-        ESP.restart();
+        restartCallback();
     }
     else
     {
@@ -309,20 +651,335 @@ void WebUI::handleFirmwareUpdate(AsyncWebServerRequest *request)
     }
 }
 
-void WebUI::handleToggleLight(AsyncWebServerRequest *request)
+// One page view: the snapshot, the open template file and the render position.
+// Literal spans are read from flash by offset, the text is never scanned again.
+// Renderer is TemplateRenderer for the plain page or GzipRenderer for the .gzt.
+template <typename Renderer>
+class WebUI::PageStream : public Renderer
 {
-    if (request->hasParam(FPSTR(PARAM_ENABLED)))
+public:
+    // data is the built-in page, file is only used without it
+    template <typename Template, typename Header>
+    PageStream(PageType page, const File &file, const uint8_t *data, const Template &pageTemplate, const Template &header, const Header *headerData)
+        : Renderer(pageTemplate, header, headerData), page(page), file(file), data(data)
     {
-        String statusParam = request->getParam(FPSTR(PARAM_ENABLED))->value();
+    }
 
-        // Validate status parameter
-        if (statusParam == FPSTR(VALUE_OFF) || statusParam == FPSTR(VALUE_ON))
+    const PageType page;
+    std::unique_ptr<PageCache::Capture> capture;
+
+protected:
+    size_t readPage(uint32_t offset, uint8_t *buffer, size_t length) override
+    {
+        if (data != nullptr)
+        {
+            // spans come from the compiled template, always inside the data
+            memcpy(buffer, data + offset, length);
+            return length;
+        }
+        if (file.position() != offset && !file.seek(offset))
+        {
+            return 0;
+        }
+        return file.read(buffer, length);
+    }
+
+    size_t writeVariable(PageTemplate::Variable variable, char *buffer, size_t length) override
+    {
+        return WebUI::writeVariable(variable, page, buffer, length);
+    }
+
+private:
+    File file;
+    const uint8_t *data;
+};
+
+bool WebUI::acceptsGzip(AsyncWebServerRequest *request)
+{
+    const AsyncWebHeader *acceptEncoding = request->getHeader("Accept-Encoding");
+    return acceptEncoding != nullptr && acceptEncoding->value().indexOf("gzip") >= 0;
+}
+
+void WebUI::addPageHeaders(AsyncWebServerResponse *response, const char *etag, bool gzip)
+{
+    if (etag[0] != '\0')
+    {
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", "no-cache");
+    }
+    if (gzip)
+    {
+        response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("Vary", "Accept-Encoding");
+}
+
+void WebUI::sendPage(AsyncWebServerRequest *request, PageType page, const char *path)
+{
+    bool gzip = acceptsGzip(request) && !gzipTemplates[page].isEmpty() && !navigationGzip.isEmpty();
+    const PageCache::Encoding encoding = gzip ? PageCache::Gzip : PageCache::Identity;
+    // the pages only change with the image, state comes from PATH_API_STATE
+    const uint32_t version = 0;
+    char etag[PageCache::ETAG_SIZE];
+    PageCache::formatETag(etag, sizeof(etag), bootId, page, encoding, version);
+
+    // the browser still shows this version
+    const AsyncWebHeader *ifNoneMatch = request->getHeader("If-None-Match");
+    if (ifNoneMatch != nullptr && PageCache::matchesETag(ifNoneMatch->value().c_str(), etag))
+    {
+        AsyncWebServerResponse *response = request->beginResponse(304);
+        addPageHeaders(response, etag, false);
+        request->send(response);
+        return;
+    }
+
+    std::shared_ptr<const PageCache::Body> body = pageCache.get(page, encoding, version);
+    if (body)
+    {
+        AsyncWebServerResponse *response = request->beginResponse(FPSTR(CONTENT_HTML), body->size(), [body](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+                                                                  {
+                                                                      size_t length = body->size() - index < maxLen ? body->size() - index : maxLen;
+                                                                      memcpy(buffer, body->data() + index, length);
+                                                                      return length; });
+        addPageHeaders(response, etag, gzip);
+        request->send(response);
+        return;
+    }
+
+    if (gzip)
+    {
+        const EmbeddedAssets::Asset *embedded = embeddedGzipPages[page];
+        File file;
+        if (embedded == nullptr && !(file = LittleFS.open(String(FPSTR(path)) + FPSTR(SUFFIX_GZIP_TEMPLATE), "r")))
+        {
+            Serial.printf("Page %s not available\n", path);
+            request->send(500, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+            return;
+        }
+        std::shared_ptr<PageStream<GzipRenderer>> stream = std::make_shared<PageStream<GzipRenderer>>(page, file, embedded != nullptr ? embedded->data : nullptr,
+                                                                                                        gzipTemplates[page], navigationGzip, navigationGzipText);
+        sendStream(request, stream, version, etag, (embedded != nullptr ? embedded->length : file.size()) + navigationGzipLength, true);
+        return;
+    }
+
+    const EmbeddedAssets::Asset *embedded = embeddedPages[page];
+    File file;
+    if (pageTemplates[page].isEmpty() || (embedded == nullptr && !(file = LittleFS.open(path, "r"))))
+    {
+        Serial.printf("Page %s not available\n", path);
+        request->send(500, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+        return;
+    }
+    std::shared_ptr<PageStream<TemplateRenderer>> stream = std::make_shared<PageStream<TemplateRenderer>>(page, file, embedded != nullptr ? embedded->data : nullptr,
+                                                                                                            pageTemplates[page], navigationTemplate, navigationText);
+    sendStream(request, stream, version, etag, pageTemplates[page].getSize() + navigationLength, false);
+}
+
+template <typename Renderer>
+void WebUI::sendStream(AsyncWebServerRequest *request, const std::shared_ptr<PageStream<Renderer>> &stream, uint32_t version, const char *etag, size_t expectedSize, bool gzip)
+{
+    if (ESP.getMaxAllocHeap() > 2 * PageCache::MAX_BODY_SIZE)
+    {
+        stream->capture.reset(new PageCache::Capture(stream->page, gzip ? PageCache::Gzip : PageCache::Identity, version, expectedSize));
+    }
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse(FPSTR(CONTENT_HTML), [this, stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+                                                                     {
+                                                                         size_t length = stream->read(buffer, maxLen);
+                                                                         if (stream->capture)
+                                                                         {
+                                                                             stream->capture->append(buffer, length);
+                                                                             if (length == 0 && !stream->hasFailed())
+                                                                             {
+                                                                                 stream->capture->commit(pageCache);
+                                                                             }
+                                                                         }
+                                                                         return length; });
+    addPageHeaders(response, etag, gzip);
+    request->send(response);
+}
+
+void WebUI::initAssets()
+{
+    const char *const paths[ASSET_COUNT] = {PATH_CSS, PATH_JS, PATH_ICON, PATH_WIFI_HTML};
+    const char *const types[ASSET_COUNT] = {CONTENT_CSS, CONTENT_JS, CONTENT_ICON, CONTENT_HTML};
+    for (uint8_t i = 0; i < ASSET_COUNT; i++)
+    {
+        assets[i].path = paths[i];
+        assets[i].contentType = types[i];
+        assets[i].embedded = EmbeddedAssets::find(paths[i]);
+        assets[i].embeddedGzip = findEmbedded(paths[i], SUFFIX_GZIP);
+        // checked once, not on every request
+        String gzipPath = String(FPSTR(paths[i])) + FPSTR(SUFFIX_GZIP);
+        assets[i].gzipPath = assets[i].embeddedGzip == nullptr && LittleFS.exists(gzipPath) ? gzipPath : String();
+    }
+}
+
+void WebUI::serveAsset(const char *route, Asset asset)
+{
+    server.on(route, HTTP_GET, admitted(AdmissionControl::Assets, [this, asset](AsyncWebServerRequest *request)
+              {
+                  const StaticAsset &file = assets[asset];
+                  bool gzip = (file.embeddedGzip != nullptr || !file.gzipPath.isEmpty()) && acceptsGzip(request);
+                  const EmbeddedAssets::Asset *embedded = gzip ? file.embeddedGzip : file.embedded;
+                  AsyncWebServerResponse *response;
+                  if (embedded != nullptr)
+                  {
+                      // straight from flash, the hash was computed at build time
+                      const AsyncWebHeader *ifNoneMatch = request->getHeader("If-None-Match");
+                      bool notModified = ifNoneMatch != nullptr && PageCache::matchesETag(ifNoneMatch->value().c_str(), embedded->etag);
+                      response = notModified ? request->beginResponse(304)
+                                             : request->beginResponse(200, file.contentType, embedded->data, embedded->length);
+                      response->addHeader("ETag", embedded->etag);
+                      gzip = gzip && !notModified;
+                  }
+                  else
+                  {
+                      response = gzip ? request->beginResponse(LittleFS, file.gzipPath, FPSTR(file.contentType))
+                                      : request->beginResponse(LittleFS, FPSTR(file.path), FPSTR(file.contentType));
+                  }
+                  if (gzip)
+                  {
+                      response->addHeader("Content-Encoding", "gzip");
+                  }
+                  // the wifi page is sent on "/" and changes with the filesystem image
+                  if (asset != ASSET_WIFI)
+                  {
+                      response->addHeader("Cache-Control", FPSTR(CONTENT_CACHE));
+                  }
+                  response->addHeader("Vary", "Accept-Encoding");
+                  request->send(response); }));
+}
+
+const EmbeddedAssets::Asset *WebUI::findEmbedded(const char *path, const char *suffix)
+{
+    if (EmbeddedAssets::count() == 0)
+    {
+        return nullptr;
+    }
+    return EmbeddedAssets::find((String(FPSTR(path)) + FPSTR(suffix)).c_str());
+}
+
+void WebUI::loadTemplates()
+{
+    const EmbeddedAssets::Asset *navigation = EmbeddedAssets::find(PATH_NAVIGATION_HTML);
+    if (navigation != nullptr)
+    {
+        navigationText = reinterpret_cast<const char *>(navigation->data);
+        navigationLength = navigation->length;
+    }
+    else
+    {
+        navigationHtml = readFile(PATH_NAVIGATION_HTML);
+        navigationText = navigationHtml.c_str();
+        navigationLength = navigationHtml.length();
+    }
+    navigationTemplate.reset();
+    navigationTemplate.feed(navigationText, navigationLength);
+    navigationTemplate.finish();
+
+    const EmbeddedAssets::Asset *navigationGzipAsset = findEmbedded(PATH_NAVIGATION_HTML, SUFFIX_GZIP_TEMPLATE);
+    if (loadGzipTemplate(PATH_NAVIGATION_HTML, navigationGzip, navigationGzipAsset, &navigationGzipData))
+    {
+        navigationGzipText = navigationGzipAsset != nullptr ? navigationGzipAsset->data : navigationGzipData.data();
+        navigationGzipLength = navigationGzipAsset != nullptr ? navigationGzipAsset->length : navigationGzipData.size();
+    }
+
+    // indexed by PageType
+    const char *const paths[PAGE_COUNT] = {PATH_LIGHT_HTML, PATH_TIME_HTML, PATH_SYSTEM_HTML, PATH_FIRMWARE_HTML};
+    for (uint8_t page = 0; page < PAGE_COUNT; page++)
+    {
+        embeddedPages[page] = EmbeddedAssets::find(paths[page]);
+        embeddedGzipPages[page] = findEmbedded(paths[page], SUFFIX_GZIP_TEMPLATE);
+        loadTemplate(paths[page], pageTemplates[page], embeddedPages[page]);
+        loadGzipTemplate(paths[page], gzipTemplates[page], embeddedGzipPages[page]);
+    }
+}
+
+bool WebUI::loadTemplate(const char *path, PageTemplate &compiled, const EmbeddedAssets::Asset *embedded)
+{
+    compiled.reset();
+    if (embedded != nullptr)
+    {
+        compiled.feed(reinterpret_cast<const char *>(embedded->data), embedded->length);
+        compiled.finish();
+        return true;
+    }
+
+    File file = LittleFS.open(path, "r");
+    if (!file)
+    {
+        Serial.printf("Template %s missing\n", path);
+        return false;
+    }
+
+    char chunk[128];
+    size_t length;
+    while ((length = file.read(reinterpret_cast<uint8_t *>(chunk), sizeof(chunk))) > 0)
+    {
+        compiled.feed(chunk, length);
+    }
+    compiled.finish();
+    file.close();
+    return true;
+}
+
+bool WebUI::loadGzipTemplate(const char *path, GzipTemplate &compiled, const EmbeddedAssets::Asset *embedded, std::vector<uint8_t> *content)
+{
+    compiled.reset();
+    if (embedded != nullptr)
+    {
+        compiled.feed(embedded->data, embedded->length);
+        if (!compiled.finish())
         {
-            std::map<String, String> params;
-            params[FPSTR(PARAM_ENABLED)] = statusParam;
-            requestCallback(ControlType::LightStatus, params);
+            Serial.printf("Template %s is invalid\n", embedded->path);
+            return false;
+        }
+        return true;
+    }
+
+    String gzipPath = String(FPSTR(path)) + FPSTR(SUFFIX_GZIP_TEMPLATE);
+    File file = LittleFS.open(gzipPath, "r");
+    if (!file)
+    {
+        // images built without tools/webassets.py only have the plain pages
+        return false;
+    }
 
-            request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
+    uint8_t chunk[128];
+    size_t length;
+    while ((length = file.read(chunk, sizeof(chunk))) > 0)
+    {
+        compiled.feed(chunk, length);
+        if (content != nullptr)
+        {
+            content->insert(content->end(), chunk, chunk + length);
+        }
+    }
+    file.close();
+    if (!compiled.finish())
+    {
+        Serial.printf("Template %s is invalid\n", gzipPath.c_str());
+        if (content != nullptr)
+        {
+            content->clear();
+        }
+        return false;
+    }
+    return true;
+}
+
+void WebUI::handleToggleLight(AsyncWebServerRequest *request)
+{
+    const char *statusParam = getValue(request, PARAM_ENABLED, false);
+    if (statusParam != nullptr)
+    {
+        // Validate status parameter
+        if (strcmp_P(statusParam, VALUE_OFF) == 0 || strcmp_P(statusParam, VALUE_ON) == 0)
+        {
+            WebRequest command(ControlType::LightStatus);
+            command.enabled = strcmp_P(statusParam, VALUE_ON) == 0;
+            sendQueued(request, command);
         }
         else
         {
@@ -339,37 +996,16 @@ void WebUI::handleToggleLight(AsyncWebServerRequest *request)
 
 void WebUI::handleSetLightColor(AsyncWebServerRequest *request)
 {
-    if (request->hasParam(FPSTR(PARAM_COLOR)))
+    const char *colorParam = getValue(request, PARAM_COLOR, false);
+    if (colorParam != nullptr)
     {
-        String colorParam = request->getParam(FPSTR(PARAM_COLOR))->value();
-        // Validate color format (expecting #RRGGBB)
-        if (colorParam.length() == 7 && colorParam[0] == '#')
+        uint8_t rgb[3];
+        if (WebRequest::parseColor(colorParam, rgb))
         {
-            bool valid = true;
-            for (size_t i = 1; i < colorParam.length(); i++)
-            {
-                char c = colorParam[i];
-                if (!isxdigit(c))
-                {
-                    valid = false;
-                    break;
-                }
-            }
-
-            if (valid)
-            {
-                std::map<String, String> params;
-                params[FPSTR(PARAM_COLOR)] = colorParam;
-                requestCallback(ControlType::Color, params);
-                request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
-                return;
-            }
-            else
-            {
-                Serial.println("Invalid color format");
-                request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
-                return;
-            }
+            WebRequest command(ControlType::Color);
+            ConfigData::copyString(command.color, colorParam, sizeof(command.color));
+            sendQueued(request, command);
+            return;
         }
         else
         {
@@ -388,18 +1024,15 @@ void WebUI::handleSetLightColor(AsyncWebServerRequest *request)
 
 void WebUI::handleSetAutoBrightness(AsyncWebServerRequest *request)
 {
-    if (request->hasParam(FPSTR(PARAM_ENABLED)))
+    const char *enabledParam = getValue(request, PARAM_ENABLED, false);
+    if (enabledParam != nullptr)
     {
-        String enabledParam = request->getParam(FPSTR(PARAM_ENABLED))->value();
-
         // Validate enabled parameter
-        if (enabledParam == FPSTR(VALUE_OFF) || enabledParam == FPSTR(VALUE_ON))
+        if (strcmp_P(enabledParam, VALUE_OFF) == 0 || strcmp_P(enabledParam, VALUE_ON) == 0)
         {
-            std::map<String, String> params;
-            params[FPSTR(PARAM_AUTO_BRIGHTNESS_ENABLED)] = enabledParam;
-
-            requestCallback(ControlType::AutoBrightness, params);
-            request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
+            WebRequest command(ControlType::AutoBrightness);
+            command.enabled = strcmp_P(enabledParam, VALUE_ON) == 0;
+            sendQueued(request, command);
             return;
         }
         else
@@ -419,18 +1052,16 @@ void WebUI::handleSetAutoBrightness(AsyncWebServerRequest *request)
 
 void WebUI::handleSetBrightness(AsyncWebServerRequest *request)
 {
-    if (request->hasParam(FPSTR(PARAM_VALUE)))
+    const char *valueParam = getValue(request, PARAM_VALUE, false);
+    if (valueParam != nullptr)
     {
-        String valueParam = request->getParam(FPSTR(PARAM_VALUE))->value();
-
         // Validate brightness value (should be an integer between 0 and 255)
-        int brightness = valueParam.toInt();
+        int brightness = atoi(valueParam);
         if (brightness >= 0 && brightness <= 255)
         {
-            std::map<String, String> params;
-            params[FPSTR(PARAM_BRIGHTNESS)] = valueParam;
-            requestCallback(ControlType::Brightness, params);
-            request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
+            WebRequest command(ControlType::Brightness);
+            command.brightness = brightness;
+            sendQueued(request, command);
             return;
         }
         else
@@ -450,30 +1081,14 @@ void WebUI::handleSetBrightness(AsyncWebServerRequest *request)
 
 void WebUI::handleSetTime(AsyncWebServerRequest *request) {
     //printAllParams(request);
-    if (request->hasParam(FPSTR(PARAM_TIME), true)) {
-        String timeParam = request->getParam(FPSTR(PARAM_TIME), true)->value();
+    const char *timeParam = getValue(request, PARAM_TIME, true);
+    if (timeParam != nullptr) {
         // Validate time format (expecting HH:MM)
-        if (timeParam.length() == 5 && timeParam[2] == ':') {
-            bool valid = true;
-            for (size_t i = 0; i < timeParam.length(); i++) {
-                char c = timeParam[i];
-                if (i == 2) {
-                    continue;
-                }
-                if (!isdigit(c)) {
-                    valid = false;
-                    break;
-                }
-            }
-
-            if (valid) {
-                std::map<String, String> params;
-                params[FPSTR(PARAM_TIME)] = timeParam;
-                requestCallback(ControlType::Time, params);
-                request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
-                return;
-            } 
-        } 
+        WebRequest command(ControlType::Time);
+        if (WebRequest::parseTimeOfDay(timeParam, command.time)) {
+            sendQueued(request, command);
+            return;
+        }
 
         Serial.println("Invalid time format");
         request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
@@ -488,73 +1103,50 @@ void WebUI::handleSetTime(AsyncWebServerRequest *request) {
 
 void WebUI::handleSetLightSchedule(AsyncWebServerRequest *request)
 {
-    if (request->hasParam(FPSTR(PARAM_ENABLED), true))
+    const char *scheduleEnabledParam = getValue(request, PARAM_ENABLED, true);
+    if (scheduleEnabledParam != nullptr)
     {
-        String scheduleEnabledParam = request->getParam(FPSTR(PARAM_ENABLED), true)->value();
-        if (scheduleEnabledParam == FPSTR(VALUE_OFF)) {
-            std::map<String, String> params;
-            params[FPSTR(PARAM_SCHEDULE_ENABLED)] = FPSTR(VALUE_OFF);
-            params[FPSTR(PARAM_SCHEDULE_START)] = String();
-            params[FPSTR(PARAM_SCHEDULE_END)] = String();
-            requestCallback(ControlType::LightSchedule, params);
-            request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
+        WebRequest command(ControlType::LightSchedule);
+        if (strcmp_P(scheduleEnabledParam, VALUE_OFF) == 0) {
+            sendQueued(request, command);
             return;
-        } else if (scheduleEnabledParam == FPSTR(VALUE_ON)) {
-            if (!request->hasParam(FPSTR(PARAM_SCHEDULE_START), true) || !request->hasParam(FPSTR(PARAM_SCHEDULE_END), true)) {
-                Serial.println("Missing parameters");
-                request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
-                return;
-            }
-            String scheduleStart = request->getParam(FPSTR(PARAM_SCHEDULE_START), true)->value();
-            String scheduleEnd = request->getParam(FPSTR(PARAM_SCHEDULE_END), true)->value();
-            //Serial.printf("Start: %s, End: %s\n", scheduleStart.c_str(), scheduleEnd.c_str());
-
-            // Validate schedule format (expecting HH:MM)
-            if (scheduleStart.length() == 5 && scheduleStart[2] == ':' && scheduleEnd.length() == 5 && scheduleEnd[2] == ':') {
-                bool valid = true;
-                for (size_t i = 0; i < scheduleStart.length(); i++) {
-                    char c = scheduleStart[i];
-                    if (i == 2) {
-                        continue;
-                    }
-                    if (!isdigit(c)) {
-                        valid = false;
-                        break;
-                    }
-                }
-
-                for (size_t i = 0; i < scheduleEnd.length(); i++) {
-                    char c = scheduleEnd[i];
-                    if (i == 2) {
-                        continue;
-                    }
-                    if (!isdigit(c)) {
-                        valid = false;
-                        break;
-                    }
-                }
-
-                if (valid) {
-                    uint32_t startHour = scheduleStart.substring(0, 2).toInt();
-                    uint32_t startMinute = scheduleStart.substring(3, 5).toInt();
-                    uint32_t endHour = scheduleEnd.substring(0, 2).toInt();
-                    uint32_t endMinute = scheduleEnd.substring(3, 5).toInt();
-    
-                    if(startHour < 24 || startMinute < 60 || endHour < 24 || endMinute < 60 ) {
-                        uint32_t startSeconds = startHour * 3600UL + startMinute * 60UL;
-                        uint32_t endSeconds = endHour * 3600UL + endMinute * 60UL;
-        
-                        std::map<String, String> params;
-                        params[FPSTR(PARAM_SCHEDULE_ENABLED)] = FPSTR(VALUE_ON);
-                        params[FPSTR(PARAM_SCHEDULE_START)] = String(startSeconds);
-                        params[FPSTR(PARAM_SCHEDULE_END)] = String(endSeconds);
-                        requestCallback(ControlType::LightSchedule, params);
-                        request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
-                        return;
+        } else if (strcmp_P(scheduleEnabledParam, VALUE_ON) == 0) {
+            // each edge is either a time of day (HH:MM) or an offset in minutes from sunrise/sunset
+            LightScheduler::Rule &rule = command.schedule.rule;
+            WebRequest::Anchor startAnchor, endAnchor;
+            if (WebRequest::parseScheduleEdge(getValue(request, PARAM_SCHEDULE_START_ANCHOR, true), getValue(request, PARAM_SCHEDULE_START, true),
+                                              getValue(request, PARAM_SCHEDULE_START_OFFSET, true), startAnchor, rule.start) &&
+                WebRequest::parseScheduleEdge(getValue(request, PARAM_SCHEDULE_END_ANCHOR, true), getValue(request, PARAM_SCHEDULE_END, true),
+                                              getValue(request, PARAM_SCHEDULE_END_OFFSET, true), endAnchor, rule.end) &&
+                (startAnchor != endAnchor || rule.start != rule.end)) {
+                // optional per-rule settings, defaults describe a daily on/off rule
+                const char *ruleParam = getValue(request, PARAM_SCHEDULE_RULE, true);
+                const char *daysParam = getValue(request, PARAM_SCHEDULE_DAYS, true);
+                const char *brightnessParam = getValue(request, PARAM_SCHEDULE_BRIGHTNESS, true);
+                const char *colorParam = getValue(request, PARAM_SCHEDULE_COLOR, true);
+                long index = ruleParam != nullptr ? atol(ruleParam) : 0;
+                long days = daysParam != nullptr ? atol(daysParam) : LightScheduler::ALL_DAYS;
+                long brightness = brightnessParam != nullptr ? atol(brightnessParam) : 0;
+                bool hasColor = colorParam != nullptr && colorParam[0] != '\0';
+                bool optionsValid = index >= 0 && index < LightScheduler::MAX_RULES &&
+                                    days > 0 && days <= LightScheduler::ALL_DAYS &&
+                                    brightness >= 0 && brightness <= 255 &&
+                                    (!hasColor || WebRequest::parseColor(colorParam, rule.color));
+
+                if (optionsValid) {
+                    command.schedule.enabled = true;
+                    command.schedule.index = index;
+                    rule.weekdays = days;
+                    rule.brightness = brightness;
+                    rule.flags = LightScheduler::RULE_ENABLED | WebRequest::anchorFlags(startAnchor, endAnchor);
+                    if (hasColor) {
+                        rule.flags |= LightScheduler::RULE_HAS_COLOR;
                     }
+                    sendQueued(request, command);
+                    return;
                 }
-            } 
-        } 
+            }
+        }
         Serial.println("Invalid schedule value");
         request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
         return;
@@ -565,40 +1157,93 @@ void WebUI::handleSetLightSchedule(AsyncWebServerRequest *request)
     }
 }
 
+const char *WebUI::getValue(AsyncWebServerRequest *request, const char *name, bool post)
+{
+    const AsyncWebParameter *param = request->getParam(FPSTR(name), post);
+    return param != nullptr ? param->value().c_str() : nullptr;
+}
+
+void WebUI::handleSetLocation(AsyncWebServerRequest *request)
+{
+    const char *locationEnabledParam = getValue(request, PARAM_ENABLED, true);
+    if (locationEnabledParam != nullptr)
+    {
+        WebRequest command(ControlType::Location);
+        const char *latitude = getValue(request, PARAM_LATITUDE, true);
+        const char *longitude = getValue(request, PARAM_LONGITUDE, true);
+        if (strcmp_P(locationEnabledParam, VALUE_OFF) == 0)
+        {
+            sendQueued(request, command);
+            return;
+        }
+        else if (strcmp_P(locationEnabledParam, VALUE_ON) == 0 && latitude != nullptr && longitude != nullptr &&
+                 latitude[0] != '\0' && longitude[0] != '\0')
+        {
+            command.location.enabled = true;
+            command.location.latitude = atof(latitude);
+            command.location.longitude = atof(longitude);
+            if (SolarCalculator::isValidLocation(command.location.latitude, command.location.longitude))
+            {
+                sendQueued(request, command);
+                return;
+            }
+        }
+
+        Serial.println("Invalid location parameters");
+        request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+        return;
+    }
+    Serial.println("Invalid request");
+    request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+}
+
+void WebUI::handleDeleteLightScheduleRule(AsyncWebServerRequest *request)
+{
+    const char *ruleParam = getValue(request, PARAM_SCHEDULE_RULE, true);
+    if (ruleParam != nullptr)
+    {
+        long rule = atol(ruleParam);
+        if (isdigit(ruleParam[0]) && rule < LightScheduler::MAX_RULES)
+        {
+            WebRequest command(ControlType::LightScheduleRuleDelete);
+            command.ruleIndex = rule;
+            sendQueued(request, command);
+            return;
+        }
+
+        Serial.println("Invalid schedule rule");
+        request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+        return;
+    }
+    Serial.println("Missing schedule rule parameter");
+    request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+}
+
 void WebUI::handleSetNTPConfig(AsyncWebServerRequest *request)
 {
-    if (request->hasParam(FPSTR(PARAM_ENABLED), true))
+    const char *ntpEnabledParam = getValue(request, PARAM_ENABLED, true);
+    if (ntpEnabledParam != nullptr)
     {
-        String ntpEnabledParam = request->getParam(FPSTR(PARAM_ENABLED), true)->value();
-        if (ntpEnabledParam == FPSTR(VALUE_OFF))
+        WebRequest command(ControlType::NTPSync);
+        if (strcmp_P(ntpEnabledParam, VALUE_OFF) == 0)
         {
-            std::map<String, String> params;
-            params[FPSTR(PARAM_NTP_ENABLED)] = FPSTR(VALUE_OFF);
-            params[FPSTR(PARAM_NTP_HOST)] = String();
-            params[FPSTR(PARAM_NTP_UPDATE_INTERVAL)] = String();
-            params[FPSTR(PARAM_NTP_TIMEZONE)] = String();
-            requestCallback(ControlType::NTPSync, params);
-            request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
+            sendQueued(request, command);
             return;
         }
-        else if (ntpEnabledParam == FPSTR(VALUE_ON))
+        else if (strcmp_P(ntpEnabledParam, VALUE_ON) == 0)
         {
-            if(request->hasParam(FPSTR(PARAM_NTP_HOST), true) && request->hasParam(FPSTR(PARAM_NTP_UPDATE_INTERVAL), true) && request->hasParam(FPSTR(PARAM_NTP_TIMEZONE), true))
+            const char *ntpHost = getValue(request, PARAM_NTP_HOST, true);
+            const char *ntpInterval = getValue(request, PARAM_NTP_UPDATE_INTERVAL, true);
+            const char *ntpTimezone = getValue(request, PARAM_NTP_TIMEZONE, true);
+            if (ntpHost != nullptr && ntpInterval != nullptr && ntpTimezone != nullptr &&
+                ntpHost[0] != '\0' && ntpInterval[0] != '\0' && TimeZones::isValid(ntpTimezone))
             {
-                String ntpHost = request->getParam(FPSTR(PARAM_NTP_HOST), true)->value();
-                String ntpInterval = request->getParam(FPSTR(PARAM_NTP_UPDATE_INTERVAL), true)->value();
-                String ntpTimezone = request->getParam(FPSTR(PARAM_NTP_TIMEZONE), true)->value();
-                if (ntpHost.length() > 0 && ntpInterval.length() > 0 && ntpTimezone.length() > 0)
-                {
-                    std::map<String, String> params;
-                    params[FPSTR(PARAM_NTP_ENABLED)] = FPSTR(VALUE_ON);
-                    params[FPSTR(PARAM_NTP_HOST)] = ntpHost;
-                    params[FPSTR(PARAM_NTP_UPDATE_INTERVAL)] = ntpInterval;
-                    params[FPSTR(PARAM_NTP_TIMEZONE)] = ntpTimezone;
-                    requestCallback(ControlType::NTPSync, params);
-                    request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
-                    return;
-                }
+                command.ntp.enabled = true;
+                ConfigData::copyString(command.ntp.server, ntpHost, sizeof(command.ntp.server));
+                ConfigData::copyString(command.ntp.timezone, ntpTimezone, sizeof(command.ntp.timezone));
+                command.ntp.interval = strtoul(ntpInterval, nullptr, 10);
+                sendQueued(request, command);
+                return;
             }
         }
             
@@ -614,81 +1259,40 @@ void WebUI::handleSetNTPConfig(AsyncWebServerRequest *request)
 void WebUI::handleSetHAIntegration(AsyncWebServerRequest *request)
 {
     //printAllParams(request);
-    if (request->hasParam(FPSTR(PARAM_ENABLED), true))
-    {
-        String haIntegrationParam = request->getParam(FPSTR(PARAM_ENABLED), true)->value();
-        if (haIntegrationParam == FPSTR(VALUE_OFF))
-        {
-            std::map<String, String> params;
-            params[FPSTR(PARAM_ENABLED)] = FPSTR(VALUE_OFF);
-            params[FPSTR(PARAM_BROKER_HOST)] = String();
-            params[FPSTR(PARAM_BROKER_PORT)] = String();
-            params[FPSTR(PARAM_BROKER_USER)] = String();
-            params[FPSTR(PARAM_BROKER_PASS)] = String();
-            params[FPSTR(PARAM_BROKER_DEFAULT_TOPIC)] = String();
-            requestCallback(ControlType::HaIntegration, params);
-            request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
+    const char *haIntegrationParam = getValue(request, PARAM_ENABLED, true);
+    if (haIntegrationParam != nullptr)
+    {
+        WebRequest command(ControlType::HaIntegration);
+        if (strcmp_P(haIntegrationParam, VALUE_OFF) == 0)
+        {
+            sendQueued(request, command);
             return;
         }
-        else if (haIntegrationParam == FPSTR(VALUE_ON))
+        else if (strcmp_P(haIntegrationParam, VALUE_ON) == 0)
         {
-            // TODO: check if parameters exist
-            if (!request->hasParam(FPSTR(PARAM_BROKER_HOST), true) ||
-                !request->hasParam(FPSTR(PARAM_BROKER_PORT), true) ||
-                !request->hasParam(FPSTR(PARAM_BROKER_DEFAULT_TOPIC), true))
+            const char *mqttHost = getValue(request, PARAM_BROKER_HOST, true);
+            const char *mqttPort = getValue(request, PARAM_BROKER_PORT, true);
+            const char *mqttTopic = getValue(request, PARAM_BROKER_DEFAULT_TOPIC, true);
+            if (mqttHost == nullptr || mqttPort == nullptr || mqttTopic == nullptr)
             {
                 Serial.println("Missing parameters");
                 request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
                 return;
             }
 
-            String mqttHost = request->getParam(FPSTR(PARAM_BROKER_HOST), true)->value();
-            String mqttPort = request->getParam(FPSTR(PARAM_BROKER_PORT), true)->value();
-            String mqttTopic = request->getParam(FPSTR(PARAM_BROKER_DEFAULT_TOPIC), true)->value();
-            if (mqttHost.length() > 0)
+            if (mqttHost[0] != '\0')
             {
-                std::map<String, String> params;
-                params[FPSTR(PARAM_ENABLED)] = FPSTR(VALUE_ON);
-                params[FPSTR(PARAM_BROKER_HOST)] = mqttHost;
-                if (mqttPort.length() > 0)
-                {
-                    params[FPSTR(PARAM_BROKER_PORT)] = mqttPort;
-                }
-                else
-                {
-                    params[FPSTR(PARAM_BROKER_PORT)] = Defaults::DEFAULT_MQTT_PORT;
-                }
-
-                params[FPSTR(PARAM_BROKER_USER)] = String();
-                if (request->hasParam(FPSTR(PARAM_BROKER_USER), true))
-                {
-                    String mqttUsername = request->getParam(FPSTR(PARAM_BROKER_USER), true)->value();
-                    if (mqttUsername.length() > 0)
-                    {
-                        params[FPSTR(PARAM_BROKER_USER)] = mqttUsername;
-                    }
-                }
-
-                params[FPSTR(PARAM_BROKER_PASS)] = String();
-                if (request->hasParam(FPSTR(PARAM_BROKER_PASS), true))
-                {
-                    String mqttPassword = request->getParam(FPSTR(PARAM_BROKER_PASS), true)->value();
-                    if (mqttPassword.length() > 0)
-                    {
-                        params[FPSTR(PARAM_BROKER_PASS)] = mqttPassword;
-                    }
-                }
-
-                if (mqttTopic.length() > 0)
-                {
-                    params[FPSTR(PARAM_BROKER_DEFAULT_TOPIC)] = mqttTopic;
-                }
-                else
-                {
-                    params[FPSTR(PARAM_BROKER_DEFAULT_TOPIC)] = Defaults::DEFAULT_MQTT_TOPIC;
-                }
-                requestCallback(ControlType::HaIntegration, params);
-                request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
+                // user and password stay empty if not given
+                const char *mqttUsername = getValue(request, PARAM_BROKER_USER, true);
+                const char *mqttPassword = getValue(request, PARAM_BROKER_PASS, true);
+                ConfigData::MqttConfig &mqtt = command.mqtt;
+                mqtt.enabled = true;
+                ConfigData::copyString(mqtt.host, mqttHost, sizeof(mqtt.host));
+                mqtt.port = mqttPort[0] != '\0' ? atoi(mqttPort) : Defaults::DEFAULT_MQTT_PORT;
+                ConfigData::copyString(mqtt.username, mqttUsername != nullptr ? mqttUsername : "", sizeof(mqtt.username));
+                ConfigData::copyString(mqtt.password, mqttPassword != nullptr ? mqttPassword : "", sizeof(mqtt.password));
+                ConfigData::copyString(mqtt.topic, mqttTopic[0] != '\0' ? mqttTopic : Defaults::DEFAULT_MQTT_TOPIC, sizeof(mqtt.topic));
+                sendQueued(request, command);
                 return;
             }
             else
@@ -716,15 +1320,14 @@ void WebUI::handleSetHAIntegration(AsyncWebServerRequest *request)
 void WebUI::handleSetClockFace(AsyncWebServerRequest *request)
 {
     // TODO: accept different clock faces (eg, languages, styles or sizes from the dropdown)
-    if (request->hasParam(FPSTR(PARAM_OPTION), true))
+    const char *option = getValue(request, PARAM_OPTION, true);
+    if (option != nullptr)
     {
-        String option = request->getParam(FPSTR(PARAM_OPTION), true)->value();
-        if (option == FPSTR(VALUE_OFF) || option == FPSTR(VALUE_ON))
+        if (strcmp_P(option, VALUE_OFF) == 0 || strcmp_P(option, VALUE_ON) == 0)
         {
-            std::map<String, String> params;
-            params[FPSTR(PARAM_OPTION)] = option;
-            requestCallback(ControlType::ClockFace, params);
-            request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
+            WebRequest command(ControlType::ClockFace);
+            command.clockMode = strcmp_P(option, VALUE_ON) == 0 ? ConfigData::Option_1 : ConfigData::Regular;
+            sendQueued(request, command);
             return;
         }
         else
@@ -742,222 +1345,229 @@ void WebUI::handleSetClockFace(AsyncWebServerRequest *request)
     }
 }
 
-String WebUI::pageProcessor(const String &var, PageType page, const std::map<String, String> &params)
+#ifdef WOC_TIME_WARP
+void WebUI::handleTimeWarp(AsyncWebServerRequest *request)
 {
-    if (var == "INCLUDE_HEADER")
-    {
-        return headerProcessor(page);
-    }
+    // speed 1 without an epoch returns to the RTC
+    const char *speedParam = getValue(request, PARAM_TIMEWARP_SPEED, true);
+    const char *epochParam = getValue(request, PARAM_TIMEWARP_EPOCH, true);
+    long speed = speedParam != nullptr ? atol(speedParam) : 1;
+    long long epoch = epochParam != nullptr ? atoll(epochParam) : 0;
 
-    switch (page)
+    if (speed < 1 || speed > 3600 || epoch < 0)
     {
-    case PageType::LIGHT:
-        return lightPageProcessor(var, params);
-    case PageType::SYSTEM:
-        return systemPageProcessor(var, params);
-    case PageType::FWUPDATE:
-        return firmwarePageProcessor(var, params);
-    case PageType::TIME:
-        return timePageProcessor(var, params);
-    default:
-        return String();
+        Serial.println("Invalid time warp parameters");
+        request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+        return;
     }
+
+    WebRequest command(ControlType::TimeWarp);
+    command.timeWarp.speed = speed;
+    command.timeWarp.epoch = epoch;
+    sendQueued(request, command);
 }
+#endif
 
-String WebUI::headerProcessor(PageType page)
+size_t WebUI::writeVariable(PageTemplate::Variable variable, PageType page, char *buffer, size_t length)
 {
-    String headerContent = readFile(PATH_NAVIGATION_HTML);
-    if (headerContent.length() == 0)
+    int written = 0;
+    switch (variable)
     {
-        return String();
-    }
-
-    String pageTitle;
-    switch (page)
+    case PageTemplate::PageTitle:
     {
-    case PageType::LIGHT:
-        pageTitle = FPSTR(LIGHT_PAGE_TITLE);
+        const char *title = "Unknown";
+        switch (page)
+        {
+        case PageType::LIGHT:
+            title = LIGHT_PAGE_TITLE;
+            break;
+        case PageType::SYSTEM:
+            title = SYSTEM_PAGE_TITLE;
+            break;
+        case PageType::TIME:
+            title = TIME_PAGE_TITLE;
+            break;
+        case PageType::FWUPDATE:
+            title = FIRMWARE_PAGE_TITLE;
+            break;
+        default:
+            break;
+        }
+        written = snprintf(buffer, length, "%s", title);
         break;
-    case PageType::SYSTEM:
-        pageTitle = FPSTR(SYSTEM_PAGE_TITLE);
+    }
+    case PageTemplate::ActiveLight:
+        written = snprintf(buffer, length, "%s", page == PageType::LIGHT ? VALUE_ACTIVE : VALUE_EMPTY);
         break;
-    case PageType::TIME:
-        pageTitle = FPSTR(TIME_PAGE_TITLE);
+    case PageTemplate::ActiveTime:
+        written = snprintf(buffer, length, "%s", page == PageType::TIME ? VALUE_ACTIVE : VALUE_EMPTY);
         break;
-    case PageType::FWUPDATE:
-        pageTitle = FPSTR(FIRMWARE_PAGE_TITLE);
+    case PageTemplate::ActiveSystem:
+        written = snprintf(buffer, length, "%s", page == PageType::SYSTEM ? VALUE_ACTIVE : VALUE_EMPTY);
         break;
     default:
-        pageTitle = "Unknown";
         break;
     }
 
-    headerContent.replace(FPSTR(PROC_PAGE_TITLE), pageTitle);
-    headerContent.replace(FPSTR(PROC_ACTIVE_LIGHT), (page == PageType::LIGHT) ? FPSTR(VALUE_ACTIVE) : FPSTR(VALUE_EMPTY));
-    headerContent.replace(FPSTR(PROC_ACTIVE_TIME), (page == PageType::TIME) ? FPSTR(VALUE_ACTIVE) : FPSTR(VALUE_EMPTY));
-    headerContent.replace(FPSTR(PROC_ACTIVE_SYSTEM), (page == PageType::SYSTEM) ? FPSTR(VALUE_ACTIVE) : FPSTR(VALUE_EMPTY));
-
-    return headerContent;
+    if (written <= 0)
+    {
+        return 0;
+    }
+    // snprintf reports the untruncated length
+    return static_cast<size_t>(written) < length ? written : length - 1;
 }
 
-String WebUI::lightPageProcessor(const String &var, const std::map<String, String> &params)
+String WebUI::readFile(const char *path)
 {
-    if (var == FPSTR(PROC_LIGHT_STATE))
-    {
-        return params.at(FPSTR(PARAM_ENABLED)) == FPSTR(VALUE_ON) ? FPSTR(VALUE_CHECKED) : FPSTR(VALUE_EMPTY);
-    }
-    else if (var == FPSTR(PROC_LIGHT_COLOR))
-    {
-        return params.at(FPSTR(PARAM_COLOR)); 
-    }
-    else if (var == FPSTR(PROC_AUTO_BRIGHTNESS_ENABLED))
-    {
-        return params.at(FPSTR(PARAM_AUTO_BRIGHTNESS_ENABLED)) == FPSTR(VALUE_ON) ? FPSTR(VALUE_CHECKED) : FPSTR(VALUE_EMPTY);
-    }
-    else if (var == FPSTR(PROC_LIGHT_BRIGHTNESS))
-    {
-        return params.at(FPSTR(PARAM_BRIGHTNESS));
-    }
-    else
+    File file = LittleFS.open(path, "r");
+    if (!file)
     {
         return String();
     }
+
+    String fileContent = file.readString();
+    file.close();
+    return fileContent;
 }
 
-String WebUI::timePageProcessor(const String &var, const std::map<String, String> &params)
+void WebUI::handleConfigExport(AsyncWebServerRequest *request)
 {
-    //std::map<String, String> params = responseCallback(DetailsType::TimeConfig);
-    if (var == FPSTR(PROC_TIME))
-    {
-        return params.at(FPSTR(PARAM_TIME));
-    }
-    else if (var == FPSTR(PROC_NTP_ENABLED))
-    {
-        return params.at(FPSTR(PARAM_NTP_ENABLED)) == FPSTR(VALUE_ON) ? FPSTR(VALUE_CHECKED) : FPSTR(VALUE_EMPTY);
-    }
-    else if (var == FPSTR(PROC_NTP_HOST))
-    {
-        return params.at(FPSTR(PARAM_NTP_HOST));
-    }
-    else if (var == FPSTR(PROC_NTP_TIMEZONE))
+    // passwords only on request, e.g. for a full backup
+    bool secrets = request->hasParam(FPSTR(PARAM_SECRETS)) && request->getParam(FPSTR(PARAM_SECRETS))->value() == "1";
+    std::shared_ptr<ConfigJsonWriter> writer = std::make_shared<ConfigJsonWriter>(readSnapshot(&Snapshot::config), secrets);
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse(FPSTR(CONTENT_JSON), [writer](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+                                                                     { return writer->read(buffer, maxLen); });
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
+void WebUI::handleConfigImportBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+{
+    readConfigBody(request, data, len, index, total);
+}
+
+void WebUI::readConfigBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+{
+    if (index == 0)
     {
-        const String currentTz = params.at(FPSTR(PARAM_NTP_TIMEZONE));
-        String options;
-        char buffer[64];  // Adjust size based on your longest timezone string
-        
-        for(size_t i = 0; i < TZ_COUNT; i++) {
-            // Read name and posixTz from PROGMEM one at a time
-            strcpy_P(buffer, (char*)pgm_read_ptr(&(TIMEZONES[i].name)));
-            options += F("<option value=\"");
-            options += buffer;
-            options += F("\"");            
-            if(String(buffer) == currentTz) {
-                options += F(" selected");
-            }            
-            options += F(">");
-            options += buffer;
-            options += F("</option>");
-            
-            // Optional: yield to prevent watchdog timer from triggering
-            //if(i % 5 == 0) yield();
+        // the reader is the expensive part, the slot is taken before it exists
+        if (total > MAX_CONFIG_IMPORT_SIZE || !admit(request, AdmissionControl::Api))
+        {
+            return;
         }
-        return options;
-    }
-    else if (var == FPSTR(PROC_NTP_UPDATE_INTERVAL))
-    {
-        return params.at(FPSTR(PARAM_NTP_UPDATE_INTERVAL));
-    }
-    else if (var == FPSTR(PROC_SCHEDULE_ENABLED))
-    {
-        return params.at(FPSTR(PARAM_SCHEDULE_ENABLED)) == FPSTR(VALUE_ON) ? FPSTR(VALUE_CHECKED) : FPSTR(VALUE_EMPTY);
-    }
-    else if (var == FPSTR(PROC_SCHEDULE_START))
-    {
-        uint32_t seconds = params.at(FPSTR(PARAM_SCHEDULE_START)).toInt();
-        int hours = seconds / 3600;
-        int minutes = (seconds % 3600) / 60;
-        char buffer[6]; // "HH:mm" + null terminator
-        sprintf(buffer, "%02d:%02d", hours, minutes);
-        return String(buffer);
-    }
-    else if (var == FPSTR(PROC_SCHEDULE_END))
-    {
-        uint32_t seconds = params.at(FPSTR(PARAM_SCHEDULE_END)).toInt();
-        int hours = seconds / 3600;
-        int minutes = (seconds % 3600) / 60;
-        char buffer[6]; // "HH:mm" + null terminator
-        sprintf(buffer, "%02d:%02d", hours, minutes);
-        return String(buffer);
+        // the server releases _tempObject with free()
+        static_assert(std::is_trivially_destructible<ConfigJsonReader>::value, "ConfigJsonReader is released without its destructor");
+        void *memory = malloc(sizeof(ConfigJsonReader));
+        if (memory == nullptr)
+        {
+            return;
+        }
+        // the keys it sees are laid over the current values by loop(), nothing is read here
+        request->_tempObject = new (memory) ConfigJsonReader();
     }
-    else
+
+    ConfigJsonReader *reader = static_cast<ConfigJsonReader *>(request->_tempObject);
+    if (reader != nullptr)
     {
-        return String();
+        reader->feed(reinterpret_cast<const char *>(data), len);
     }
 }
 
-String WebUI::systemPageProcessor(const String &var, const std::map<String, String> &params)
+// no reader: the body was empty or too large, or it was not admitted
+void WebUI::sendMissingBody(AsyncWebServerRequest *request)
 {
-    //std::map<String, String> params = responseCallback(DetailsType::SystemConfig);
-    if (var == FPSTR(PROC_BROKER_ENABLED))
-    {
-        return params.at(FPSTR(PARAM_BROKER_ENABLED)) == FPSTR(VALUE_ON) ? FPSTR(VALUE_CHECKED) : FPSTR(VALUE_EMPTY);
-    }
-    else if (var == FPSTR(PROC_BROKER_HOST))
+    if (request->contentLength() == 0 || request->contentLength() > MAX_CONFIG_IMPORT_SIZE)
     {
-        return params.at(FPSTR(PARAM_BROKER_HOST));
+        request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+        return;
     }
-    else if (var == FPSTR(PROC_BROKER_PORT))
+    sendBusy(request);
+}
+
+void WebUI::handleConfigImport(AsyncWebServerRequest *request)
+{
+    ConfigJsonReader *reader = static_cast<ConfigJsonReader *>(request->_tempObject);
+    if (reader == nullptr)
     {
-        return params.at(FPSTR(PARAM_BROKER_PORT));
+        sendMissingBody(request);
+        return;
     }
-    else if (var == FPSTR(PROC_BROKER_USER))
+    if (!reader->finish())
     {
-        if (params.at(FPSTR(PARAM_BROKER_USER)).length() > 0)
-            return params.at(FPSTR(PARAM_BROKER_USER));
+        Serial.printf("Config import rejected: error %u at byte %u\n", reader->getError(), (unsigned)reader->getPosition());
+        request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+        return;
     }
-    else if (var == FPSTR(PROC_BROKER_DEFAULT_TOPIC))
+    // applied and committed by loop(), the flash is not written from the AsyncTCP task
+    ConfigJsonReader *imported = new ConfigJsonReader(*reader);
+    ConfigJsonReader *expected = nullptr;
+    if (!pendingImport.compare_exchange_strong(expected, imported))
     {
-        return params.at(FPSTR(PARAM_BROKER_DEFAULT_TOPIC));
+        delete imported;
+        sendBusy(request);
+        return;
     }
-    // else if (var == FPSTR(PROC_CLOCKFACE))
-    // {
-    //     return params.at(FPSTR(PARAM_CLOCKFACE));
-    // }
-    else if (var == FPSTR(PROC_CLOCKFACE_OPTION_STATE))
+    request->send(200, FPSTR(CONTENT_TEXT), FPSTR(VALUE_SUCCESS));
+}
+
+void WebUI::sendState(AsyncWebServerRequest *request, const ConfigData &data)
+{
+    // read-only runtime values after the settings, passwords are never sent
+    const PageState time = readSnapshot(&Snapshot::time);
+    const PageState system = readSnapshot(&Snapshot::system);
+    const PageState firmware = readSnapshot(&Snapshot::firmware);
+
+    char sunrise[8] = "null";
+    char sunset[8] = "null";
+    if (time.time.sunrise >= 0)
     {
-        return params.at(FPSTR(PARAM_CLOCKFACE_OPTION)) == FPSTR(VALUE_ON) ? FPSTR(VALUE_CHECKED) : FPSTR(VALUE_EMPTY);
+        snprintf(sunrise, sizeof(sunrise), "\"%02d:%02d\"", time.time.sunrise / 60, time.time.sunrise % 60);
     }
-    else
+    if (time.time.sunset >= 0)
     {
-        return String();
+        snprintf(sunset, sizeof(sunset), "\"%02d:%02d\"", time.time.sunset / 60, time.time.sunset % 60);
     }
-
-    return String();
+    char extra[ConfigJsonWriter::EXTRA_SIZE];
+    snprintf(extra, sizeof(extra), "\"time\":{\"current\":\"%02u:%02u\",\"sunrise\":%s,\"sunset\":%s},\"configWrites\":\"%s\",\"firmware\":\"%s\"",
+             time.time.time.hour, time.time.time.minute, sunrise, sunset, system.system.configWrites,
+             firmware.firmware.version != nullptr ? firmware.firmware.version : VALUE_EMPTY);
+
+    std::shared_ptr<ConfigJsonWriter> writer = std::make_shared<ConfigJsonWriter>(data, false, extra);
+    AsyncWebServerResponse *response = request->beginChunkedResponse(FPSTR(CONTENT_JSON), [writer](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+                                                                     { return writer->read(buffer, maxLen); });
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
 }
 
-String WebUI::firmwarePageProcessor(const String &var, const std::map<String, String> &params)
+void WebUI::handleStatePatch(AsyncWebServerRequest *request)
 {
-    if (var == FPSTR(PROC_FW_VERS))
+    // the whole body is parsed and validated before anything is applied
+    ConfigJsonReader *reader = static_cast<ConfigJsonReader *>(request->_tempObject);
+    if (reader == nullptr)
     {
-        return params.at(FPSTR(PARAM_FW_VERSION));
+        sendMissingBody(request);
+        return;
     }
-    else
+    if (!reader->finish())
     {
-        return String();
+        Serial.printf("State patch rejected: error %u at byte %u\n", reader->getError(), (unsigned)reader->getPosition());
+        request->send(400, FPSTR(CONTENT_TEXT), FPSTR(VALUE_ERROR));
+        return;
     }
-}
-
-String WebUI::readFile(const char *path)
-{
-    File file = LittleFS.open(path, "r");
-    if (!file)
+    // applied by loop(), one patch at a time
+    ConfigJsonReader *patch = new ConfigJsonReader(*reader);
+    ConfigJsonReader *expected = nullptr;
+    if (!pendingPatch.compare_exchange_strong(expected, patch))
     {
-        return String();
+        delete patch;
+        sendBusy(request);
+        return;
     }
-
-    String fileContent = file.readString();
-    file.close();
-    return fileContent;
+    // the state as it will be once loop() has applied the patch
+    ConfigData data = readSnapshot(&Snapshot::state);
+    reader->applyTo(data);
+    sendState(request, data);
 }
 
 void WebUI::printAllParams(AsyncWebServerRequest *request)
@@ -8,15 +8,41 @@
 #include <AsyncTCP.h>
 #include <LittleFS.h>
 #include <functional>
-#include <map>
+#include <vector>
+#include <atomic>
 #include "configuration.h"
 #include "callbacktypes.h"
-#include "timezone_data.h"
+#include "webrequest.h"
+#include "pagetemplate.h"
+#include "gziptemplate.h"
+#include "embeddedassets.h"
+#include "pagecache.h"
+#include "timezones.h"
+#include "solarcalculator.h"
+#include "configjson.h"
+#include "stateevents.h"
+#include "commandqueue.h"
+#include "admissioncontrol.h"
 
-using RequestCallback = std::function<void(ControlType type, const std::map<String, String>& params)>;
-using ResponseCallback = std::function<std::map<String, String>(PageType page)>;
-using UpdateCallback = std::function<void(UpdateType type, const String &filename, size_t index, uint8_t *data, size_t len, bool final)>;
+// called from loop() on the main task, never from a web handler
+using RequestCallback = std::function<void(const WebRequest &request)>;
+// fills the snapshot for state.page, called from loop() like the export callbacks
+using ResponseCallback = std::function<void(PageState &state)>;
+// manifest is what the upload form says about the image, only set with index 0;
+// returns false while something else owns the flash, the rest of the upload is then dropped
+using UpdateCallback = std::function<bool(UpdateType type, const OtaWriter::Manifest &manifest, const String &filename, size_t index, uint8_t *data, size_t len, bool final)>;
+// asked right after the last chunk, on the task that wrote the upload
 using UpdateSuccessCallback = std::function<bool()>;
+using ConfigExportCallback = std::function<ConfigData()>;
+// replaces the configuration from loop(), the restart follows if it returns true;
+// keys missing from the document keep their current values, see ConfigJsonReader::applyTo
+using ConfigImportCallback = std::function<bool(const ConfigJsonReader &imported)>;
+// applies a validated state change from loop(), only the keys the request sent
+using StatePatchCallback = std::function<bool(const ConfigJsonReader &patch)>;
+// fills the values pushed to /events
+using EventStateCallback = std::function<void(StateEvents::Values &values)>;
+// asks the main loop to restart once the response is out, must not block
+using RestartCallback = std::function<void()>;
 
 class WebUI
 {
@@ -26,28 +52,165 @@ class WebUI
         RequestCallback requestCallback;
         UpdateCallback updateCallback;
         ResponseCallback responseCallback;
+        ConfigExportCallback configExportCallback;
+        ConfigImportCallback configImportCallback;
+        ConfigExportCallback stateCallback;
+        StatePatchCallback statePatchCallback;
+        EventStateCallback eventStateCallback;
+        RestartCallback restartCallback;
 
-        // Page Processor functions
-        String lightPageProcessor(const String &var, const std::map<String, String> &params);
-        String timePageProcessor(const String &var, const std::map<String, String> &params);
-        String systemPageProcessor(const String &var, const std::map<String, String> &params);
-        String firmwarePageProcessor(const String &var, const std::map<String, String> &params);
-        String headerProcessor(PageType page);
-        String pageProcessor(const String &var, PageType page, const std::map<String, String> &params);
+        // live state for open pages, deltas go out from loop()
+        AsyncEventSource events;
+        StateEvents stateEvents;
+        std::atomic<bool> eventClientJoined{false};
+        uint32_t eventId = 0;
+
+        // commands from the AsyncTCP task, applied by loop() on the main task
+        struct QueuedRequest {
+            WebRequest command;
+            // for the latest-wins types, older commands of the same type are dropped
+            uint32_t generation;
+            QueuedRequest() : command(ControlType::LightStatus), generation(0) {}
+            QueuedRequest(const WebRequest &request, uint32_t gen) : command(request), generation(gen) {}
+        };
+        static const size_t COMMAND_QUEUE_SIZE = 16;
+        static const uint8_t LATEST_WINS_COUNT = 5;
+        CommandQueue<QueuedRequest, COMMAND_QUEUE_SIZE> commands;
+        std::atomic<uint32_t> latestGeneration[LATEST_WINS_COUNT] = {};
+        // a validated state patch waiting for loop(), owned by whoever takes it
+        std::atomic<ConfigJsonReader *> pendingPatch{nullptr};
+        // a validated configuration import, the same for /api/config
+        std::atomic<ConfigJsonReader *> pendingImport{nullptr};
+
+        // what the handlers serve, filled by loop() so they read nothing the main task owns
+        struct Snapshot {
+            ConfigData state;
+            ConfigData config;
+            PageState time{PageType::TIME};
+            PageState system{PageType::SYSTEM};
+            PageState firmware{PageType::FWUPDATE};
+        };
+        static const unsigned long SNAPSHOT_INTERVAL = 250;
+        Snapshot snapshots[2];
+        std::atomic<uint8_t> publishedSnapshot{0};
+        // the slot a handler is copying from, loop() leaves it alone until it is done
+        std::atomic<int8_t> readingSnapshot{-1};
+        unsigned long lastSnapshot = 0;
+        bool snapshotStale = true;
+        void publishSnapshot();
+        template <typename T>
+        T readSnapshot(T Snapshot::*member);
+
+        // the outcome of one /update upload, kept in the request's _tempObject
+        enum UploadResult : uint8_t {
+            UploadPending,
+            UploadSucceeded,
+            UploadFailed,
+            // bad form fields, nothing was written
+            UploadRejected,
+            // the flash was taken, e.g. by a pull update
+            UploadBusy
+        };
+
+        // requests in flight per route class, 503 once memory runs short
+        AdmissionControl admission;
+
+        // page templates, compiled once in init()
+        template <typename Renderer>
+        class PageStream;
+        static const uint8_t PAGE_COUNT = PageType::FWUPDATE + 1;
+        PageTemplate pageTemplates[PAGE_COUNT];
+        PageTemplate navigationTemplate;
+        String navigationHtml;
+        // gzip variants from tools/webassets.py, empty if the image has none
+        GzipTemplate gzipTemplates[PAGE_COUNT];
+        GzipTemplate navigationGzip;
+        std::vector<uint8_t> navigationGzipData;
+        // built-in copies (WOC_EMBEDDED_ASSETS), nullptr when read from LittleFS
+        const EmbeddedAssets::Asset *embeddedPages[PAGE_COUNT] = {};
+        const EmbeddedAssets::Asset *embeddedGzipPages[PAGE_COUNT] = {};
+        // the navigation text used for rendering, in RAM or built in
+        const char *navigationText = nullptr;
+        size_t navigationLength = 0;
+        const uint8_t *navigationGzipText = nullptr;
+        size_t navigationGzipLength = 0;
+        PageCache pageCache;
+        uint32_t bootId = 0;
+
+        // files sent as they are, with a precompressed copy if the image has one
+        enum Asset : uint8_t {
+            ASSET_CSS,
+            ASSET_JS,
+            ASSET_ICON,
+            ASSET_WIFI,
+            ASSET_COUNT
+        };
+        struct StaticAsset {
+            const char *path;
+            const char *contentType;
+            String gzipPath;
+            const EmbeddedAssets::Asset *embedded;
+            const EmbeddedAssets::Asset *embeddedGzip;
+        };
+        StaticAsset assets[ASSET_COUNT];
+
+        void loadTemplates();
+        bool loadTemplate(const char *path, PageTemplate &compiled, const EmbeddedAssets::Asset *embedded);
+        bool loadGzipTemplate(const char *path, GzipTemplate &compiled, const EmbeddedAssets::Asset *embedded, std::vector<uint8_t> *content = nullptr);
+        static const EmbeddedAssets::Asset *findEmbedded(const char *path, const char *suffix);
+        static size_t writeVariable(PageTemplate::Variable variable, PageType page, char *buffer, size_t length);
+        void initAssets();
+        void serveAsset(const char *route, Asset asset);
+        static bool acceptsGzip(AsyncWebServerRequest *request);
+        static void addPageHeaders(AsyncWebServerResponse *response, const char *etag, bool gzip);
+        template <typename Renderer>
+        void sendStream(AsyncWebServerRequest *request, const std::shared_ptr<PageStream<Renderer>> &stream, uint32_t version, const char *etag, size_t expectedSize, bool gzip);
+
+        // slot in latestGeneration, -1 for commands that all have to be applied
+        static int8_t latestWinsSlot(ControlType type);
+        bool queueRequest(const WebRequest &command);
+        // 200 once queued, 503 with Retry-After if the queue is full
+        void sendQueued(AsyncWebServerRequest *request, const WebRequest &command);
+        static void sendBusy(AsyncWebServerRequest *request);
+        // wraps a handler so it only runs when admitted, sendBusy() otherwise
+        ArRequestHandlerFunction admitted(AdmissionControl::RouteClass route, const ArRequestHandlerFunction &handler);
+        // claims a slot until the connection closes, false if the request is not admitted
+        bool admit(AsyncWebServerRequest *request, AdmissionControl::RouteClass route);
+        static AdmissionControl::Heap currentHeap();
+        void sendAdmissionStats(AsyncWebServerRequest *request);
+        void sendMissingBody(AsyncWebServerRequest *request);
+        void sendEvents();
 
         // Helper functions
+        void sendPage(AsyncWebServerRequest *request, PageType page, const char *path);
         void handleFirmwareUpdate(AsyncWebServerRequest *request);
+        void sendUpdateStatus(AsyncWebServerRequest *request);
+        void handlePullUpdate(AsyncWebServerRequest *request);
         void handleToggleLight(AsyncWebServerRequest *request);
         void handleSetLightColor(AsyncWebServerRequest *request);
         void handleSetAutoBrightness(AsyncWebServerRequest *request);
         void handleSetBrightness(AsyncWebServerRequest *request);
         void handleSetTime(AsyncWebServerRequest *request);
         void handleSetLightSchedule(AsyncWebServerRequest *request);
+        void handleDeleteLightScheduleRule(AsyncWebServerRequest *request);
         void handleSetNTPConfig(AsyncWebServerRequest *request);
+        void handleSetLocation(AsyncWebServerRequest *request);
         void handleSetHAIntegration(AsyncWebServerRequest *request);
         void handleSetClockFace(AsyncWebServerRequest *request);
+        void handleConfigExport(AsyncWebServerRequest *request);
+        void handleConfigImport(AsyncWebServerRequest *request);
+        void handleConfigImportBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+        void handleStatePatch(AsyncWebServerRequest *request);
+        void sendState(AsyncWebServerRequest *request, const ConfigData &data);
+        // the body handler for both config import and state patches, seeded with the current data
+        void readConfigBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+#ifdef WOC_TIME_WARP
+        void handleTimeWarp(AsyncWebServerRequest *request);
+#endif
         void printAllParams(AsyncWebServerRequest *request);
         String readFile(const char* path);
+        // nullptr if the parameter is missing, valid for the lifetime of the request
+        static const char *getValue(AsyncWebServerRequest *request, const char *name, bool post);
 
         // paths
         static const char PATH_NAVIGATION_HTML[] PROGMEM;
@@ -59,6 +222,15 @@ class WebUI
         static const char PATH_CSS[] PROGMEM;
         static const char PATH_JS[] PROGMEM;
         static const char PATH_ICON[] PROGMEM;
+        static const char PATH_TIMEZONES[] PROGMEM;
+        static const char PATH_API_CONFIG[] PROGMEM;
+        static const char PATH_API_STATE[] PROGMEM;
+        static const char PATH_API_UPDATE[] PROGMEM;
+        static const char PATH_API_UPDATE_PULL[] PROGMEM;
+        static const char PATH_API_ADMISSION[] PROGMEM;
+        static const char PATH_EVENTS[] PROGMEM;
+        static const char SUFFIX_GZIP[] PROGMEM;
+        static const char SUFFIX_GZIP_TEMPLATE[] PROGMEM;
 
         // page titles
         static const char LIGHT_PAGE_TITLE[] PROGMEM;
@@ -66,55 +238,44 @@ class WebUI
         static const char TIME_PAGE_TITLE[] PROGMEM;
         static const char FIRMWARE_PAGE_TITLE[] PROGMEM;
 
-        // processor variables
-        static const char PROC_PAGE_TITLE[] PROGMEM;
-        static const char PROC_FW_VERS[] PROGMEM;
-
-        static const char PROC_ACTIVE_LIGHT[] PROGMEM;
-        static const char PROC_ACTIVE_TIME[] PROGMEM;
-        static const char PROC_ACTIVE_SYSTEM[] PROGMEM;
-
-        static const char PROC_LIGHT_STATE[] PROGMEM;
-        static const char PROC_LIGHT_COLOR[] PROGMEM;
-        static const char PROC_LIGHT_BRIGHTNESS[] PROGMEM;
-        static const char PROC_AUTO_BRIGHTNESS_ENABLED[] PROGMEM;
-        static const char PROC_TIME[] PROGMEM;
-        static const char PROC_NTP_ENABLED[] PROGMEM;
-        static const char PROC_NTP_HOST[] PROGMEM;
-        static const char PROC_NTP_UPDATE_INTERVAL[] PROGMEM;
-        static const char PROC_NTP_TIMEZONE[] PROGMEM;
-        static const char PROC_BROKER_ENABLED[] PROGMEM;
-        static const char PROC_BROKER_HOST[] PROGMEM;
-        static const char PROC_BROKER_PORT[] PROGMEM;
-        static const char PROC_BROKER_USER[] PROGMEM;
-        static const char PROC_BROKER_PASS[] PROGMEM;
-        static const char PROC_BROKER_DEFAULT_TOPIC[] PROGMEM;
-        static const char PROC_SCHEDULE_ENABLED[] PROGMEM;
-        static const char PROC_SCHEDULE_START[] PROGMEM;
-        static const char PROC_SCHEDULE_END[] PROGMEM;
-        static const char PROC_CLOCKFACE[] PROGMEM;
-        static const char PROC_CLOCKFACE_OPTION_STATE[] PROGMEM;
-
         // values
         static const char VALUE_SUCCESS[] PROGMEM;
         static const char VALUE_ERROR[] PROGMEM;
         static const char VALUE_ACTIVE[] PROGMEM;
-        static const char VALUE_CHECKED[] PROGMEM;
         static const char VALUE_EMPTY[] PROGMEM;
         static const char VALUE_FIRMWARE[] PROGMEM;
         static const char VALUE_FILESYS[] PROGMEM;
+        static const char VALUE_DELTA[] PROGMEM;
 
         static const char CONTENT_TEXT[] PROGMEM;
         static const char CONTENT_HTML[] PROGMEM;
+        static const char CONTENT_JSON[] PROGMEM;
+        static const char CONTENT_CSS[] PROGMEM;
+        static const char CONTENT_JS[] PROGMEM;
+        static const char CONTENT_ICON[] PROGMEM;
         static const char CONTENT_CACHE[] PROGMEM;
         //static constexpr const char* CONTENT_CACHE = "max-age=3600";
 
         static const char PARAM_FW_Type[] PROGMEM;
+        static const char PARAM_FW_SIZE[] PROGMEM;
+        static const char PARAM_FW_SHA256[] PROGMEM;
+        static const char PARAM_FW_URL[] PROGMEM;
+        static const char PARAM_SECRETS[] PROGMEM;
+
+        // larger bodies are rejected before parsing, a full export is well below 4 KiB
+        static const size_t MAX_CONFIG_IMPORT_SIZE = 8192;
+        // every event client holds a connection and a send queue on the AsyncTCP heap
+        static const size_t MAX_EVENT_CLIENTS = 3;
+        // average messages queued per client before deltas are held back
+        static const size_t MAX_EVENTS_WAITING = 4;
 
     public:
 
         static const char VALUE_ON[] PROGMEM;
         static const char VALUE_OFF[] PROGMEM;
+        static const char VALUE_ANCHOR_TIME[] PROGMEM;
+        static const char VALUE_ANCHOR_SUNRISE[] PROGMEM;
+        static const char VALUE_ANCHOR_SUNSET[] PROGMEM;
 
         static const char PARAM_WIFI_SSID[] PROGMEM;
         static const char PARAM_WIFI_PASS[] PROGMEM;
@@ -138,9 +299,25 @@ class WebUI
         static const char PARAM_SCHEDULE_ENABLED[] PROGMEM;
         static const char PARAM_SCHEDULE_START[] PROGMEM;
         static const char PARAM_SCHEDULE_END[] PROGMEM;
+        static const char PARAM_SCHEDULE_RULE[] PROGMEM;
+        static const char PARAM_SCHEDULE_DAYS[] PROGMEM;
+        static const char PARAM_SCHEDULE_BRIGHTNESS[] PROGMEM;
+        static const char PARAM_SCHEDULE_COLOR[] PROGMEM;
+        static const char PARAM_SCHEDULE_START_ANCHOR[] PROGMEM;
+        static const char PARAM_SCHEDULE_END_ANCHOR[] PROGMEM;
+        static const char PARAM_SCHEDULE_START_OFFSET[] PROGMEM;
+        static const char PARAM_SCHEDULE_END_OFFSET[] PROGMEM;
+        static const char PARAM_LOCATION_ENABLED[] PROGMEM;
+        static const char PARAM_LATITUDE[] PROGMEM;
+        static const char PARAM_LONGITUDE[] PROGMEM;
+        static const char PARAM_SUNRISE[] PROGMEM;
+        static const char PARAM_SUNSET[] PROGMEM;
         static const char PARAM_CLOCKFACE[] PROGMEM;        
         static const char PARAM_CLOCKFACE_OPTION[] PROGMEM;
         static const char PARAM_FW_VERSION[] PROGMEM;
+        static const char PARAM_CONFIG_WRITES[] PROGMEM;
+        static const char PARAM_TIMEWARP_SPEED[] PROGMEM;
+        static const char PARAM_TIMEWARP_EPOCH[] PROGMEM;
         
         WebUI(AsyncWebServer &server);
         ~WebUI();
@@ -149,6 +326,16 @@ class WebUI
                   const UpdateCallback &updateCb, 
                   const UpdateSuccessCallback &updateSuccessCb);
         void initHostAP(const RequestCallback &wrequestCb);
+        // enables /api/config, call before init()
+        void setConfigCallbacks(const ConfigExportCallback &exportCb, const ConfigImportCallback &importCb);
+        // enables /events, call before init()
+        void setEventCallback(const EventStateCallback &eventCb);
+        // needed by firmware updates and config imports, call before init()
+        void setRestartCallback(const RestartCallback &restartCb);
+        // applies queued commands and sends pending state events, call from the main loop
+        void loop();
+        // enables GET and PATCH /api/v1/state, call before init()
+        void setStateCallbacks(const ConfigExportCallback &stateCb, const StatePatchCallback &patchCb);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef WIFICLIENTSTREAM_H
+#define WIFICLIENTSTREAM_H
+
+#include <WiFi.h>
+#include "pullupdater.h"
+
+// PullUpdater over a plain TCP connection
+class WiFiClientStream : public PullUpdater::Stream
+{
+public:
+    // blocks the loop at most this long, the server is on the LAN
+    static const int32_t CONNECT_TIMEOUT_MS = 3000;
+
+    bool connect(const char *host, uint16_t port) override
+    {
+        client.stop();
+        return client.connect(host, port, CONNECT_TIMEOUT_MS) == 1;
+    }
+
+    size_t write(const uint8_t *data, size_t length) override
+    {
+        return client.write(data, length);
+    }
+
+    int read(uint8_t *buffer, size_t length) override
+    {
+        int available = client.available();
+        if (available > 0)
+        {
+            return client.read(buffer, (size_t)available < length ? available : length);
+        }
+        return client.connected() ? 0 : -1;
+    }
+
+    void stop() override
+    {
+        client.stop();
+    }
+
+private:
+    WiFiClient client;
+};
+
+#endif // WIFICLIENTSTREAM_H
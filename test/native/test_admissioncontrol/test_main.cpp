@@ -0,0 +1,95 @@
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include "admissioncontrol.h"
+
+static const AdmissionControl::Heap PLENTY = {200000, 100000};
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_cap_per_route_class(void) {
+    AdmissionControl admission;
+    uint8_t limit = AdmissionControl::DEFAULT_LIMITS[AdmissionControl::Pages].maxInFlight;
+    for (uint8_t i = 0; i < limit; i++) {
+        TEST_ASSERT_EQUAL(AdmissionControl::Admitted, admission.admit(AdmissionControl::Pages, PLENTY));
+    }
+    TEST_ASSERT_EQUAL(AdmissionControl::Busy, admission.admit(AdmissionControl::Pages, PLENTY));
+    // other classes have their own slots
+    TEST_ASSERT_EQUAL(AdmissionControl::Admitted, admission.admit(AdmissionControl::Commands, PLENTY));
+
+    admission.release(AdmissionControl::Pages);
+    TEST_ASSERT_EQUAL(AdmissionControl::Admitted, admission.admit(AdmissionControl::Pages, PLENTY));
+    TEST_ASSERT_EQUAL(limit, admission.getInFlight(AdmissionControl::Pages));
+    TEST_ASSERT_EQUAL(limit + 1, admission.getAdmitted(AdmissionControl::Pages));
+    TEST_ASSERT_EQUAL(1, admission.getRejected(AdmissionControl::Pages));
+    TEST_ASSERT_EQUAL(1, admission.getRejected(AdmissionControl::Busy));
+}
+
+void test_heap_floor_includes_cost(void) {
+    AdmissionControl admission;
+    uint32_t cost = AdmissionControl::DEFAULT_LIMITS[AdmissionControl::Pages].heapCost;
+    AdmissionControl::Heap heap = {AdmissionControl::MIN_FREE_HEAP + cost - 1, 100000};
+    TEST_ASSERT_EQUAL(AdmissionControl::LowHeap, admission.admit(AdmissionControl::Pages, heap));
+    // a cheaper request still fits
+    TEST_ASSERT_EQUAL(AdmissionControl::Admitted, admission.admit(AdmissionControl::Commands, heap));
+    heap.freeHeap++;
+    TEST_ASSERT_EQUAL(AdmissionControl::Admitted, admission.admit(AdmissionControl::Pages, heap));
+    TEST_ASSERT_EQUAL(1, admission.getRejected(AdmissionControl::LowHeap));
+}
+
+void test_largest_block_floor(void) {
+    AdmissionControl admission;
+    AdmissionControl::Heap heap = {200000, AdmissionControl::MIN_LARGEST_BLOCK - 1};
+    TEST_ASSERT_EQUAL(AdmissionControl::Fragmented, admission.admit(AdmissionControl::Assets, heap));
+    TEST_ASSERT_EQUAL(0, admission.getInFlight(AdmissionControl::Assets));
+    heap.largestBlock++;
+    TEST_ASSERT_EQUAL(AdmissionControl::Admitted, admission.admit(AdmissionControl::Assets, heap));
+    TEST_ASSERT_EQUAL(1, admission.getRejected(AdmissionControl::Fragmented));
+}
+
+void test_custom_limits_and_release(void) {
+    const AdmissionControl::Limits limits[AdmissionControl::ROUTE_CLASSES] = {{1, 100}, {1, 100}, {1, 100}, {1, 100}};
+    AdmissionControl admission(limits, 1000, 500);
+    AdmissionControl::Heap heap = {1100, 500};
+    TEST_ASSERT_EQUAL(AdmissionControl::Admitted, admission.admit(AdmissionControl::Api, heap));
+    TEST_ASSERT_EQUAL(AdmissionControl::Busy, admission.admit(AdmissionControl::Api, heap));
+    // a release without an admission does not free a slot twice
+    admission.release(AdmissionControl::Api);
+    admission.release(AdmissionControl::Api);
+    TEST_ASSERT_EQUAL(0, admission.getInFlight(AdmissionControl::Api));
+    TEST_ASSERT_EQUAL(AdmissionControl::Admitted, admission.admit(AdmissionControl::Api, heap));
+    TEST_ASSERT_EQUAL(AdmissionControl::Busy, admission.admit(AdmissionControl::Api, heap));
+}
+
+void test_stats_json(void) {
+    AdmissionControl admission;
+    admission.admit(AdmissionControl::Pages, PLENTY);
+    admission.admit(AdmissionControl::Api, {30000, 100000});
+    char stats[AdmissionControl::STATS_SIZE];
+    TEST_ASSERT_GREATER_THAN(0, admission.formatStats({150000, 90000}, stats, sizeof(stats)));
+    TEST_ASSERT_EQUAL_STRING("{\"freeHeap\":150000,\"largestBlock\":90000,\"lowestFreeHeap\":30000,\"minFreeHeap\":32768,\"minLargestBlock\":8192,"
+                             "\"rejected\":{\"busy\":0,\"heap\":1,\"block\":0},\"routes\":{"
+                             "\"pages\":{\"inFlight\":1,\"limit\":3,\"cost\":6144,\"admitted\":1,\"rejected\":0},"
+                             "\"api\":{\"inFlight\":0,\"limit\":4,\"cost\":4096,\"admitted\":0,\"rejected\":1},"
+                             "\"commands\":{\"inFlight\":0,\"limit\":4,\"cost\":1024,\"admitted\":0,\"rejected\":0},"
+                             "\"assets\":{\"inFlight\":0,\"limit\":6,\"cost\":2048,\"admitted\":0,\"rejected\":0}}}",
+                             stats);
+
+    // every counter at its widest still fits
+    const AdmissionControl::Limits widest[AdmissionControl::ROUTE_CLASSES] = {{255, 65535}, {255, 65535}, {255, 65535}, {255, 65535}};
+    AdmissionControl full(widest, UINT32_MAX - 65535, UINT32_MAX);
+    TEST_ASSERT_GREATER_THAN(0, full.formatStats({UINT32_MAX, UINT32_MAX}, stats, sizeof(stats)));
+    TEST_ASSERT_EQUAL(0, admission.formatStats(PLENTY, stats, 64));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_cap_per_route_class);
+    RUN_TEST(test_heap_floor_includes_cost);
+    RUN_TEST(test_largest_block_floor);
+    RUN_TEST(test_custom_limits_and_release);
+    RUN_TEST(test_stats_json);
+    return UNITY_END();
+}
@@ -0,0 +1,101 @@
+#include <unity.h>
+#include <thread>
+#include <vector>
+#include "commandqueue.h"
+
+struct Command {
+    uint8_t producer;
+    uint32_t sequence;
+};
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_fifo_and_full(void) {
+    CommandQueue<uint32_t, 4> queue;
+    uint32_t value;
+    TEST_ASSERT_FALSE(queue.pop(value));
+
+    for (uint32_t round = 0; round < 3; round++) {
+        for (uint32_t i = 0; i < 4; i++) {
+            TEST_ASSERT_TRUE(queue.push(round * 10 + i));
+        }
+        TEST_ASSERT_FALSE(queue.push(99));
+        for (uint32_t i = 0; i < 4; i++) {
+            TEST_ASSERT_TRUE(queue.pop(value));
+            TEST_ASSERT_EQUAL_UINT32(round * 10 + i, value);
+        }
+        TEST_ASSERT_FALSE(queue.pop(value));
+    }
+}
+
+void test_interleaved_wraps_around(void) {
+    CommandQueue<uint32_t, 8> queue;
+    uint32_t next = 0;
+    uint32_t expected = 0;
+    uint32_t value;
+    for (int i = 0; i < 1000; i++) {
+        queue.push(next++);
+        queue.push(next++);
+        TEST_ASSERT_TRUE(queue.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(expected++, value);
+        if (i % 3 == 0) {
+            TEST_ASSERT_TRUE(queue.pop(value));
+            TEST_ASSERT_EQUAL_UINT32(expected++, value);
+        }
+        while (next - expected >= 7) {
+            TEST_ASSERT_TRUE(queue.pop(value));
+            TEST_ASSERT_EQUAL_UINT32(expected++, value);
+        }
+    }
+}
+
+// several producers against one consumer: nothing lost, each producer's order kept
+void test_concurrent_producers(void) {
+    static const int PRODUCERS = 4;
+    static const uint32_t COUNT = 50000;
+    CommandQueue<Command, 16> queue;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&queue, p]() {
+            for (uint32_t i = 0; i < COUNT; i++) {
+                while (!queue.push({static_cast<uint8_t>(p), i})) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    uint32_t next[PRODUCERS] = {};
+    uint32_t received = 0;
+    bool ordered = true;
+    Command command;
+    while (received < PRODUCERS * COUNT) {
+        if (!queue.pop(command)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered = ordered && command.sequence == next[command.producer];
+        next[command.producer] = command.sequence + 1;
+        received++;
+    }
+    for (std::thread &producer : producers) {
+        producer.join();
+    }
+
+    TEST_ASSERT_TRUE(ordered);
+    for (int p = 0; p < PRODUCERS; p++) {
+        TEST_ASSERT_EQUAL_UINT32(COUNT, next[p]);
+    }
+    TEST_ASSERT_FALSE(queue.pop(command));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_and_full);
+    RUN_TEST(test_interleaved_wraps_around);
+    RUN_TEST(test_concurrent_producers);
+    return UNITY_END();
+}
@@ -0,0 +1,210 @@
+#include <unity.h>
+#include <algorithm>
+#include <string>
+#include <string.h>
+#include "configjson.h"
+
+static ConfigData makeConfig() {
+    ConfigData data;
+    ConfigData::setDefaults(data);
+    ConfigData::copyString(data.wifi.ssid, "clock \"net\"", sizeof(data.wifi.ssid));
+    ConfigData::copyString(data.wifi.password, "wifi-secret", sizeof(data.wifi.password));
+    data.system.mqttConfig.enabled = true;
+    ConfigData::copyString(data.system.mqttConfig.host, "broker.lan", sizeof(data.system.mqttConfig.host));
+    ConfigData::copyString(data.system.mqttConfig.password, "mqtt-secret", sizeof(data.system.mqttConfig.password));
+    data.system.locationConfig.latitude = 52.52f;
+    data.system.locationConfig.longitude = 13.405f;
+
+    LightScheduler::Rule &daily = data.system.lightScheduleConfig.rules[0];
+    daily.start = 7 * 60;
+    daily.end = 22 * 60;
+    daily.weekdays = LightScheduler::ALL_DAYS;
+    daily.flags = LightScheduler::RULE_ENABLED | LightScheduler::RULE_HAS_COLOR;
+    daily.color[0] = 0xFF;
+    daily.color[2] = 0x10;
+    LightScheduler::Rule &dusk = data.system.lightScheduleConfig.rules[1];
+    dusk.start = static_cast<uint16_t>(-30);
+    dusk.end = 23 * 60;
+    dusk.weekdays = 0x41;
+    dusk.flags = LightScheduler::RULE_ENABLED | LightScheduler::RULE_START_SUNSET;
+    data.system.lightScheduleConfig.ruleCount = 2;
+    data.system.lightScheduleConfig.enabled = true;
+    data.light.brightness = 42;
+    return data;
+}
+
+static std::string exportJson(const ConfigData &data, bool secrets, size_t chunk, const char *extra = nullptr) {
+    ConfigJsonWriter writer(data, secrets, extra);
+    std::string json;
+    uint8_t buffer[512];
+    size_t length;
+    while ((length = writer.read(buffer, chunk)) > 0) {
+        if (length > chunk) {
+            return std::string();
+        }
+        json.append(reinterpret_cast<char *>(buffer), length);
+    }
+    return json;
+}
+
+static bool importJson(const std::string &json, ConfigData &data, size_t chunk, ConfigJsonReader::Error *error = nullptr) {
+    ConfigJsonReader reader(data);
+    bool ok = true;
+    for (size_t offset = 0; offset < json.size() && ok; offset += chunk) {
+        ok = reader.feed(json.data() + offset, std::min(chunk, json.size() - offset));
+    }
+    ok = ok && reader.finish();
+    if (error != nullptr) {
+        *error = reader.getError();
+    }
+    if (ok) {
+        data = reader.getData();
+    }
+    return ok;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_roundtrip_any_chunk_size(void) {
+    ConfigData original = makeConfig();
+    std::string reference = exportJson(original, true, 512);
+    TEST_ASSERT_EQUAL_INT('{', reference.front());
+    TEST_ASSERT_EQUAL_INT('}', reference.back());
+
+    const size_t chunks[] = {1, 2, 7, 64, 512};
+    for (size_t chunk : chunks) {
+        TEST_ASSERT_TRUE(reference == exportJson(original, true, chunk));
+
+        ConfigData imported;
+        ConfigData::setDefaults(imported);
+        TEST_ASSERT_TRUE(importJson(reference, imported, chunk));
+        TEST_ASSERT_TRUE(original == imported);
+    }
+}
+
+void test_secrets_excluded_and_kept_on_import(void) {
+    ConfigData original = makeConfig();
+    std::string json = exportJson(original, false, 64);
+    TEST_ASSERT_TRUE(json.find("secret") == std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"ssid\":\"clock \\\"net\\\"\"") != std::string::npos);
+
+    ConfigData target = makeConfig();
+    ConfigData::copyString(target.system.mqttConfig.host, "old.lan", sizeof(target.system.mqttConfig.host));
+    TEST_ASSERT_TRUE(importJson(json, target, 16));
+    TEST_ASSERT_EQUAL_STRING("broker.lan", target.system.mqttConfig.host);
+    TEST_ASSERT_EQUAL_STRING("mqtt-secret", target.system.mqttConfig.password);
+    TEST_ASSERT_EQUAL_STRING("wifi-secret", target.wifi.password);
+}
+
+void test_partial_document(void) {
+    ConfigData data = makeConfig();
+    std::string json = "{ \"light\": {\"brightness\": 200, \"color\": \"#00ff00\"},\n"
+                       "  \"unknown\": {\"nested\": [1, {\"a\": null}], \"x\": \"\\u00e4\"},\n"
+                       "  \"schedule\": {\"rules\": [{\"start\": 360, \"end\": 480, \"weekdays\": 31}]} }";
+    TEST_ASSERT_TRUE(importJson(json, data, 3));
+    TEST_ASSERT_EQUAL_UINT8(200, data.light.brightness);
+    TEST_ASSERT_EQUAL_STRING("#00ff00", data.light.color);
+    TEST_ASSERT_EQUAL_UINT8(1, data.system.lightScheduleConfig.ruleCount);
+    TEST_ASSERT_EQUAL_UINT16(360, data.system.lightScheduleConfig.rules[0].start);
+    TEST_ASSERT_EQUAL_UINT8(LightScheduler::RULE_ENABLED, data.system.lightScheduleConfig.rules[0].flags);
+    TEST_ASSERT_TRUE(data.system.mqttConfig.enabled);
+}
+
+void test_patch_applies_only_sent_keys(void) {
+    // parsed without the current values, laid over them later
+    ConfigJsonReader reader;
+    std::string json = "{\"light\":{\"brightness\":200},\"mqtt\":{\"port\":8883},\"schedule\":{\"rules\":[]}}";
+    TEST_ASSERT_TRUE(reader.feed(json.data(), json.size()));
+    TEST_ASSERT_TRUE(reader.finish());
+
+    size_t sent = 0;
+    for (size_t i = 0; i < ConfigJson::CONFIG_FIELD_COUNT; i++) {
+        sent += reader.isPresent(i) ? 1 : 0;
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, sent);
+
+    // changed elsewhere after the patch was parsed
+    ConfigData current = makeConfig();
+    ConfigData::copyString(current.light.color, "#123456", sizeof(current.light.color));
+    current.light.state = false;
+    reader.applyTo(current);
+
+    TEST_ASSERT_EQUAL_UINT8(200, current.light.brightness);
+    TEST_ASSERT_EQUAL_STRING("#123456", current.light.color);
+    TEST_ASSERT_FALSE(current.light.state);
+    TEST_ASSERT_EQUAL_UINT16(8883, current.system.mqttConfig.port);
+    TEST_ASSERT_EQUAL_STRING("broker.lan", current.system.mqttConfig.host);
+    TEST_ASSERT_TRUE(current.system.mqttConfig.enabled);
+    TEST_ASSERT_EQUAL_UINT8(0, current.system.lightScheduleConfig.ruleCount);
+    TEST_ASSERT_TRUE(current.system.lightScheduleConfig.enabled == makeConfig().system.lightScheduleConfig.enabled);
+    TEST_ASSERT_EQUAL_STRING("clock \"net\"", current.wifi.ssid);
+}
+
+void test_extra_members_are_appended_and_ignored(void) {
+    ConfigData original = makeConfig();
+    std::string plain = exportJson(original, false, 64);
+    std::string json = exportJson(original, false, 5, "\"time\":{\"current\":\"12:34\",\"sunrise\":null}");
+    TEST_ASSERT_TRUE(json == plain.substr(0, plain.size() - 1) + ",\"time\":{\"current\":\"12:34\",\"sunrise\":null}}");
+
+    ConfigData imported = makeConfig();
+    TEST_ASSERT_TRUE(importJson(json, imported, 7));
+    TEST_ASSERT_TRUE(original == imported);
+}
+
+void test_rejects_invalid_documents(void) {
+    struct Case {
+        const char *json;
+        ConfigJsonReader::Error error;
+    };
+    const Case cases[] = {
+        {"[1]", ConfigJsonReader::Syntax},
+        {"{\"light\":{\"brightness\":256}}", ConfigJsonReader::InvalidValue},
+        {"{\"light\":{\"brightness\":\"12\"}}", ConfigJsonReader::InvalidValue},
+        {"{\"light\":{\"color\":\"red\"}}", ConfigJsonReader::InvalidValue},
+        {"{\"light\":{\"state\":1}}", ConfigJsonReader::InvalidValue},
+        {"{\"wifi\":{\"ssid\":\"0123456789012345678901234567890123\"}}", ConfigJsonReader::TooLong},
+        {"{\"format\":2}", ConfigJsonReader::Unsupported},
+        {"{\"location\":{\"latitude\":91}}", ConfigJsonReader::InvalidValue},
+        {"{\"schedule\":{\"rules\":[{\"start\":10,\"end\":10}]}}", ConfigJsonReader::InvalidValue},
+        {"{\"schedule\":{\"rules\":{}}}", ConfigJsonReader::InvalidValue},
+        {"{\"light\":{\"state\":true}", ConfigJsonReader::Incomplete},
+        {"{\"light\":{\"state\":true}}}", ConfigJsonReader::Syntax},
+        {"{\"light\" {}}", ConfigJsonReader::Syntax},
+        {"{\"a\":[[[[[[[[1]]]]]]]]}", ConfigJsonReader::TooDeep},
+    };
+
+    for (const Case &c : cases) {
+        ConfigData data = makeConfig();
+        ConfigData before = data;
+        ConfigJsonReader::Error error;
+        TEST_ASSERT_FALSE_MESSAGE(importJson(c.json, data, 5, &error), c.json);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(c.error, error, c.json);
+        TEST_ASSERT_TRUE(before == data);
+    }
+}
+
+void test_too_many_rules(void) {
+    std::string json = "{\"schedule\":{\"rules\":[";
+    for (size_t i = 0; i <= LightScheduler::MAX_RULES; i++) {
+        json += i ? ",{}" : "{}";
+    }
+    json += "]}}";
+    ConfigData data = makeConfig();
+    ConfigJsonReader::Error error;
+    TEST_ASSERT_FALSE(importJson(json, data, 8, &error));
+    TEST_ASSERT_EQUAL_INT(ConfigJsonReader::TooManyRules, error);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_roundtrip_any_chunk_size);
+    RUN_TEST(test_secrets_excluded_and_kept_on_import);
+    RUN_TEST(test_partial_document);
+    RUN_TEST(test_patch_applies_only_sent_keys);
+    RUN_TEST(test_extra_members_are_appended_and_ignored);
+    RUN_TEST(test_rejects_invalid_documents);
+    RUN_TEST(test_too_many_rules);
+    return UNITY_END();
+}
@@ -0,0 +1,222 @@
+#include <unity.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include "configstore.h"
+
+// NVS stand-in, counts the key lookups that cost a page scan on the real partition
+class MockNvs : public IKeyValueStore {
+public:
+    std::map<std::string, std::vector<uint8_t>> entries;
+    uint32_t lookups = 0;
+    uint32_t reads = 0;
+    uint32_t writes = 0;
+
+    size_t getLength(const char *key) override {
+        lookups++;
+        auto it = entries.find(key);
+        return it == entries.end() ? 0 : it->second.size();
+    }
+    size_t read(const char *key, void *buffer, size_t length) override {
+        lookups++;
+        reads++;
+        auto it = entries.find(key);
+        if (it == entries.end() || it->second.size() > length) {
+            return 0;
+        }
+        memcpy(buffer, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+    size_t write(const char *key, const void *buffer, size_t length) override {
+        writes++;
+        const uint8_t *bytes = static_cast<const uint8_t *>(buffer);
+        entries[key].assign(bytes, bytes + length);
+        return length;
+    }
+    bool clear() override {
+        entries.clear();
+        return true;
+    }
+};
+
+static ConfigData makeConfig() {
+    ConfigData data;
+    ConfigData::setDefaults(data);
+    ConfigData::copyString(data.wifi.ssid, "clocknet", sizeof(data.wifi.ssid));
+    ConfigData::copyString(data.system.mqttConfig.host, "broker.lan", sizeof(data.system.mqttConfig.host));
+    data.system.mqttConfig.enabled = true;
+    data.system.lightScheduleConfig.ruleCount = 1;
+    data.system.lightScheduleConfig.rules[0].start = 7 * 60;
+    data.system.lightScheduleConfig.rules[0].end = 22 * 60;
+    data.light.brightness = 42;
+    return data;
+}
+
+static ConfigStore::Header readHeader(MockNvs &nvs) {
+    ConfigStore::Header header;
+    memcpy(&header, nvs.entries[ConfigStore::KEY].data(), sizeof(header));
+    return header;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_roundtrip(void) {
+    MockNvs nvs;
+    ConfigStore store(nvs);
+    ConfigData saved = makeConfig();
+    TEST_ASSERT_EQUAL_UINT32(sizeof(ConfigStore::Header) + sizeof(ConfigData), store.save(saved));
+
+    ConfigData loaded;
+    TEST_ASSERT_EQUAL_INT(ConfigStore::Loaded, store.load(loaded));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(&saved, &loaded, sizeof(saved)));
+    TEST_ASSERT_EQUAL_UINT32(1, nvs.reads);
+}
+
+void test_missing(void) {
+    MockNvs nvs;
+    ConfigStore store(nvs);
+    ConfigData data;
+    TEST_ASSERT_EQUAL_INT(ConfigStore::Missing, store.load(data));
+}
+
+void test_crc_mismatch(void) {
+    MockNvs nvs;
+    ConfigStore store(nvs);
+    store.save(makeConfig());
+    nvs.entries[ConfigStore::KEY].back() ^= 0x01;
+
+    ConfigData data;
+    TEST_ASSERT_EQUAL_INT(ConfigStore::Corrupt, store.load(data));
+}
+
+void test_bad_magic_and_truncation(void) {
+    MockNvs nvs;
+    ConfigStore store(nvs);
+    ConfigData data;
+
+    store.save(makeConfig());
+    nvs.entries[ConfigStore::KEY][0] ^= 0xFF;
+    TEST_ASSERT_EQUAL_INT(ConfigStore::Corrupt, store.load(data));
+
+    store.save(makeConfig());
+    nvs.entries[ConfigStore::KEY].resize(sizeof(ConfigStore::Header) + 10);
+    TEST_ASSERT_EQUAL_INT(ConfigStore::Corrupt, store.load(data));
+
+    nvs.entries[ConfigStore::KEY].resize(3);
+    TEST_ASSERT_EQUAL_INT(ConfigStore::Corrupt, store.load(data));
+}
+
+void test_newer_version_unsupported(void) {
+    MockNvs nvs;
+    ConfigStore store(nvs);
+    store.save(makeConfig());
+    ConfigStore::Header header = readHeader(nvs);
+    header.version = ConfigStore::VERSION + 1;
+    memcpy(nvs.entries[ConfigStore::KEY].data(), &header, sizeof(header));
+
+    ConfigData data;
+    TEST_ASSERT_EQUAL_INT(ConfigStore::Unsupported, store.load(data));
+}
+
+void test_erase(void) {
+    MockNvs nvs;
+    ConfigStore store(nvs);
+    store.save(makeConfig());
+    TEST_ASSERT_TRUE(store.erase());
+
+    ConfigData data;
+    TEST_ASSERT_EQUAL_INT(ConfigStore::Missing, store.load(data));
+}
+
+void test_crc32_reference(void) {
+    const char *check = "123456789";
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, ConfigStore::crc32(reinterpret_cast<const uint8_t *>(check), 9));
+}
+
+void test_equality_ignores_padding_and_string_tail(void) {
+    ConfigData a = makeConfig();
+    ConfigData b;
+    memset(&b, 0xA5, sizeof(b));
+    b.system = a.system;
+    b.light = a.light;
+    b.wifi = a.wifi;
+    TEST_ASSERT_TRUE(a == b);
+
+    // garbage behind the terminator or in unused rule slots is not a change
+    b.wifi.ssid[20] = 'x';
+    memset(b.system.lightScheduleConfig.rules + 5, 0x5A, sizeof(LightScheduler::Rule));
+    TEST_ASSERT_TRUE(a == b);
+
+    b.system.mqttConfig.port++;
+    TEST_ASSERT_TRUE(a != b);
+    b = a;
+    b.system.lightScheduleConfig.rules[0].end++;
+    TEST_ASSERT_FALSE(a == b);
+    b = a;
+    ConfigData::copyString(b.light.color, "#00FF00", sizeof(b.light.color));
+    TEST_ASSERT_TRUE(a.system == b.system);
+    TEST_ASSERT_FALSE(a.light == b.light);
+}
+
+// boot-time load: one blob read against the 25 lookups of the former per-key layout
+void test_benchmark_boot_load(void) {
+    const int iterations = 20000;
+    const char *legacyKeys[] = {"is_init", "clock_mode", "wifi_ssid", "wifi_pass", "mqtt_nbld", "mqtt_host", "mqtt_port",
+                                "mqtt_user", "mqtt_pass", "mqtt_tpc", "ntp_nbld", "ntp_tz", "ntp_srv", "ntp_upd_itvl",
+                                "loc_nbld", "loc_lat", "loc_lon", "ls_nbld", "ls_rules", "ab_nbld", "ab_thrsh_hi",
+                                "ab_thrsh_lo", "lght_brightn", "lght_color", "lght_state"};
+    const size_t keyCount = sizeof(legacyKeys) / sizeof(legacyKeys[0]);
+
+    MockNvs legacy;
+    uint8_t value[64] = {};
+    for (size_t i = 0; i < keyCount; i++) {
+        legacy.write(legacyKeys[i], value, sizeof(value));
+    }
+    MockNvs nvs;
+    ConfigStore store(nvs);
+    store.save(makeConfig());
+
+    ConfigData data;
+    uint8_t buffer[64];
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (size_t k = 0; k < keyCount; k++) {
+            legacy.read(legacyKeys[k], buffer, sizeof(buffer));
+        }
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        TEST_ASSERT_EQUAL_INT(ConfigStore::Loaded, store.load(data));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double perKey = std::chrono::duration<double, std::micro>(middle - begin).count() / iterations;
+    double blob = std::chrono::duration<double, std::micro>(end - middle).count() / iterations;
+    // host timings exclude flash latency, the lookup count is what matters on the device
+    char message[192];
+    snprintf(message, sizeof(message), "per-key: %u lookups %.2f us, blob: %u lookups %.2f us incl. CRC (%u bytes)",
+             legacy.lookups / iterations, perKey, nvs.lookups / iterations, blob,
+             (unsigned)(sizeof(ConfigStore::Header) + sizeof(ConfigData)));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32(iterations, nvs.reads);
+    TEST_ASSERT_LESS_OR_EQUAL(2 * iterations, nvs.lookups);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_roundtrip);
+    RUN_TEST(test_missing);
+    RUN_TEST(test_crc_mismatch);
+    RUN_TEST(test_bad_magic_and_truncation);
+    RUN_TEST(test_newer_version_unsupported);
+    RUN_TEST(test_erase);
+    RUN_TEST(test_crc32_reference);
+    RUN_TEST(test_equality_ignores_padding_and_string_tail);
+    RUN_TEST(test_benchmark_boot_load);
+    return UNITY_END();
+}
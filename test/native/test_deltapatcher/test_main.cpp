@@ -0,0 +1,343 @@
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include "deltapatcher.h"
+
+static std::vector<uint8_t> makeImage(size_t length) {
+    std::vector<uint8_t> image(length);
+    uint32_t value = 12345;
+    for (size_t i = 0; i < length; i++) {
+        value = value * 1103515245 + 12345;
+        image[i] = (uint8_t)(value >> 16);
+    }
+    return image;
+}
+
+// tools/deltapatch.py diff of fixtureOld() and fixtureNew(), keeps the tool and the device in step
+static const uint8_t FIXTURE_PATCH[] = {
+    0x57, 0x44, 0x4c, 0x54, 0x01, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x28, 0x04, 0x00, 0x00,
+    0x19, 0x69, 0x93, 0xf0, 0xc2, 0xff, 0x42, 0xff, 0xcf, 0x45, 0xbc, 0xb6, 0x72, 0x17, 0xd1, 0x6b,
+    0x8a, 0x9a, 0x2a, 0x37, 0xf7, 0x25, 0x23, 0xa4, 0x13, 0x05, 0xae, 0x42, 0xd7, 0x02, 0x31, 0xcf,
+    0x3c, 0x66, 0x3c, 0x53, 0xec, 0x94, 0x23, 0x74, 0x3c, 0x25, 0x85, 0xf6, 0x0a, 0x67, 0x1b, 0xb1,
+    0x4c, 0x08, 0xdc, 0x04, 0x65, 0xaa, 0x1f, 0xad, 0x1d, 0x5b, 0x44, 0x08, 0x00, 0x00, 0x00, 0xa4,
+    0x02, 0x3f, 0x01, 0x01, 0x3f, 0x01, 0x01, 0x3f, 0x01, 0x01, 0x3f, 0x01, 0x01, 0x24, 0x00, 0x4c,
+    0x28, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+    0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1c, 0x1c, 0x1d, 0x1e,
+    0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x44, 0x2c, 0x01, 0x00, 0x00, 0xd4, 0x05,
+    0x33, 0x01, 0x01, 0x3f, 0x01, 0x01, 0x3f, 0x01, 0x01, 0x3f, 0x01, 0x01, 0x3f, 0x01, 0x01, 0x3f,
+    0x01, 0x01, 0x3f, 0x01, 0x01, 0x3f, 0x01, 0x01, 0x3f, 0x01, 0x01, 0x3f, 0x01, 0x01, 0x3f, 0x01,
+    0x01, 0x20, 0x00, 0x45
+};
+
+static std::vector<uint8_t> fixtureOld() {
+    return makeImage(1024);
+}
+
+// 40 bytes inserted at 300, then every 64th byte bumped like a moved address
+static std::vector<uint8_t> fixtureNew() {
+    std::vector<uint8_t> old = fixtureOld();
+    std::vector<uint8_t> image(old.begin(), old.begin() + 300);
+    for (uint8_t i = 0; i < 40; i++) {
+        image.push_back(i);
+    }
+    image.insert(image.end(), old.begin() + 300, old.end());
+    for (size_t i = 7; i < image.size(); i += 64) {
+        image[i]++;
+    }
+    return image;
+}
+
+// writes patches the way tools/deltapatch.py does, for cases the fixture does not cover
+class PatchBuilder {
+public:
+    std::vector<uint8_t> bytes;
+
+    PatchBuilder(uint32_t oldSize, const std::vector<uint8_t> &image) {
+        const uint8_t magic[] = {'W', 'D', 'L', 'T', 1, 0, 0, 0};
+        bytes.assign(magic, magic + sizeof(magic));
+        le32(oldSize);
+        le32(image.size());
+        bytes.resize(bytes.size() + DeltaPatcher::MD5_SIZE, 0);
+        uint8_t digest[Sha256::DIGEST_SIZE];
+        Sha256 hash;
+        hash.update(image.data(), image.size());
+        hash.finish(digest);
+        bytes.insert(bytes.end(), digest, digest + sizeof(digest));
+    }
+
+    void literal(const uint8_t *data, size_t length) {
+        bytes.push_back('L');
+        varint(length);
+        bytes.insert(bytes.end(), data, data + length);
+    }
+
+    void diff(uint32_t offset, const uint8_t *old, const uint8_t *image, size_t length) {
+        bytes.push_back('D');
+        le32(offset);
+        varint(length);
+        size_t pos = 0;
+        while (pos < length) {
+            size_t zeros = pos;
+            while (zeros < length && old[zeros] == image[zeros]) {
+                zeros++;
+            }
+            size_t end = zeros;
+            while (end < length && old[end] != image[end]) {
+                end++;
+            }
+            varint(zeros - pos);
+            varint(end - zeros);
+            for (size_t k = zeros; k < end; k++) {
+                bytes.push_back((uint8_t)(image[k] - old[k]));
+            }
+            pos = end;
+        }
+    }
+
+    void end() { bytes.push_back('E'); }
+
+    void le32(uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            bytes.push_back((uint8_t)(value >> (8 * i)));
+        }
+    }
+
+    void varint(uint32_t value) {
+        while (value >= 0x80) {
+            bytes.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back((uint8_t)value);
+    }
+};
+
+struct Target {
+    std::vector<uint8_t> old;
+    std::vector<uint8_t> image;
+    size_t largestRead = 0;
+    size_t largestOutput = 0;
+    bool headerSeen = false;
+    bool acceptHeader = true;
+    bool failRead = false;
+    bool failOutput = false;
+
+    DeltaPatcher patcher{
+        [this](const DeltaPatcher::Header &header) {
+            headerSeen = true;
+            return acceptHeader && header.oldSize == old.size();
+        },
+        [this](uint32_t offset, uint8_t *buffer, size_t length) {
+            if (failRead || offset + length > old.size()) {
+                return false;
+            }
+            largestRead = length > largestRead ? length : largestRead;
+            memcpy(buffer, old.data() + offset, length);
+            return true;
+        },
+        [this](const uint8_t *data, size_t length) {
+            largestOutput = length > largestOutput ? length : largestOutput;
+            image.insert(image.end(), data, data + length);
+            return !failOutput;
+        }};
+
+    explicit Target(const std::vector<uint8_t> &oldImage) : old(oldImage) { patcher.begin(); }
+
+    bool feed(const uint8_t *patch, size_t length, size_t chunk) {
+        for (size_t offset = 0; offset < length; offset += chunk) {
+            if (!patcher.write(patch + offset, length - offset < chunk ? length - offset : chunk)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_applies_tool_patch_in_any_chunks(void) {
+    std::vector<uint8_t> expected = fixtureNew();
+    const size_t chunks[] = {1, 3, 64, 4096};
+    for (size_t chunk : chunks) {
+        Target target(fixtureOld());
+        TEST_ASSERT_TRUE(target.feed(FIXTURE_PATCH, sizeof(FIXTURE_PATCH), chunk));
+        TEST_ASSERT_TRUE(target.patcher.finish());
+        TEST_ASSERT_EQUAL(expected.size(), target.image.size());
+        TEST_ASSERT_EQUAL_MEMORY(expected.data(), target.image.data(), expected.size());
+
+        uint8_t digest[Sha256::DIGEST_SIZE];
+        Sha256 hash;
+        hash.update(target.image.data(), target.image.size());
+        hash.finish(digest);
+        TEST_ASSERT_EQUAL_MEMORY(target.patcher.getHeader().newSha256, digest, sizeof(digest));
+    }
+}
+
+void test_memory_stays_bounded(void) {
+    // a 256 KiB image with a block moved to the front, then copied with small changes
+    std::vector<uint8_t> old = makeImage(256 * 1024);
+    std::vector<uint8_t> image(old.begin() + 200000, old.begin() + 210000);
+    image.insert(image.end(), old.begin(), old.end());
+    for (size_t i = 10000; i < image.size(); i += 97) {
+        image[i] ^= 0x10;
+    }
+
+    PatchBuilder patch(old.size(), image);
+    patch.diff(200000, old.data() + 200000, image.data(), 10000);
+    patch.diff(0, old.data(), image.data() + 10000, old.size());
+    patch.end();
+
+    Target target(old);
+    TEST_ASSERT_TRUE(target.feed(patch.bytes.data(), patch.bytes.size(), 1436));
+    TEST_ASSERT_TRUE(target.patcher.finish());
+    TEST_ASSERT_TRUE(target.image == image);
+    TEST_ASSERT_LESS_THAN(image.size() / 10, patch.bytes.size());
+    TEST_ASSERT_LESS_OR_EQUAL(DeltaPatcher::OLD_BUFFER_SIZE, target.largestRead);
+    TEST_ASSERT_LESS_OR_EQUAL(DeltaPatcher::OUTPUT_BUFFER_SIZE, target.largestOutput);
+    TEST_ASSERT_LESS_THAN(1024, sizeof(DeltaPatcher));
+}
+
+void test_rejects_other_base(void) {
+    Target target(fixtureOld());
+    target.acceptHeader = false;
+    TEST_ASSERT_FALSE(target.feed(FIXTURE_PATCH, sizeof(FIXTURE_PATCH), 100));
+    TEST_ASSERT_TRUE(target.headerSeen);
+    TEST_ASSERT_EQUAL(DeltaPatcher::ErrorBase, target.patcher.getError());
+    TEST_ASSERT_EQUAL(0, target.image.size());
+    TEST_ASSERT_FALSE(target.patcher.finish());
+}
+
+void test_rejects_malformed_patches(void) {
+    std::vector<uint8_t> old = fixtureOld();
+
+    // not a patch at all, the header callback is never asked
+    std::vector<uint8_t> garbage(FIXTURE_PATCH, FIXTURE_PATCH + sizeof(FIXTURE_PATCH));
+    garbage[0] = 'X';
+    Target notPatch(old);
+    TEST_ASSERT_FALSE(notPatch.feed(garbage.data(), garbage.size(), 4096));
+    TEST_ASSERT_FALSE(notPatch.headerSeen);
+    TEST_ASSERT_EQUAL(DeltaPatcher::ErrorFormat, notPatch.patcher.getError());
+
+    // a diff beyond the end of the old image
+    std::vector<uint8_t> image(old.begin(), old.begin() + 100);
+    PatchBuilder outside(old.size(), image);
+    outside.diff(old.size() - 50, old.data(), image.data(), 100);
+    outside.end();
+    Target beyond(old);
+    TEST_ASSERT_FALSE(beyond.feed(outside.bytes.data(), outside.bytes.size(), 4096));
+    TEST_ASSERT_EQUAL(DeltaPatcher::ErrorFormat, beyond.patcher.getError());
+
+    // cut off
+    Target truncated(old);
+    TEST_ASSERT_TRUE(truncated.feed(FIXTURE_PATCH, sizeof(FIXTURE_PATCH) - 20, 4096));
+    TEST_ASSERT_FALSE(truncated.patcher.finish());
+    TEST_ASSERT_EQUAL(DeltaPatcher::ErrorFormat, truncated.patcher.getError());
+
+    // data after the end record
+    std::vector<uint8_t> trailing(FIXTURE_PATCH, FIXTURE_PATCH + sizeof(FIXTURE_PATCH));
+    trailing.push_back('L');
+    Target after(old);
+    TEST_ASSERT_FALSE(after.feed(trailing.data(), trailing.size(), 4096));
+    TEST_ASSERT_EQUAL(DeltaPatcher::ErrorFormat, after.patcher.getError());
+}
+
+void test_size_must_match_header(void) {
+    std::vector<uint8_t> old = fixtureOld();
+    std::vector<uint8_t> image(old.begin(), old.begin() + 100);
+
+    PatchBuilder longer(old.size(), image);
+    longer.literal(old.data(), 101);
+    longer.end();
+    Target tooLong(old);
+    TEST_ASSERT_FALSE(tooLong.feed(longer.bytes.data(), longer.bytes.size(), 4096));
+    TEST_ASSERT_EQUAL(DeltaPatcher::ErrorSize, tooLong.patcher.getError());
+
+    PatchBuilder shorter(old.size(), image);
+    shorter.literal(old.data(), 99);
+    shorter.end();
+    Target tooShort(old);
+    TEST_ASSERT_TRUE(tooShort.feed(shorter.bytes.data(), shorter.bytes.size(), 4096));
+    TEST_ASSERT_FALSE(tooShort.patcher.finish());
+    TEST_ASSERT_EQUAL(DeltaPatcher::ErrorSize, tooShort.patcher.getError());
+}
+
+void test_read_and_output_errors(void) {
+    Target unreadable(fixtureOld());
+    unreadable.failRead = true;
+    TEST_ASSERT_FALSE(unreadable.feed(FIXTURE_PATCH, sizeof(FIXTURE_PATCH), 4096));
+    TEST_ASSERT_EQUAL(DeltaPatcher::ErrorRead, unreadable.patcher.getError());
+
+    Target unwritable(fixtureOld());
+    unwritable.failOutput = true;
+    TEST_ASSERT_FALSE(unwritable.feed(FIXTURE_PATCH, sizeof(FIXTURE_PATCH), 4096));
+    TEST_ASSERT_EQUAL(DeltaPatcher::ErrorOutput, unwritable.patcher.getError());
+
+    // begin() starts over
+    unwritable.failOutput = false;
+    unwritable.image.clear();
+    unwritable.patcher.begin();
+    TEST_ASSERT_TRUE(unwritable.feed(FIXTURE_PATCH, sizeof(FIXTURE_PATCH), 4096));
+    TEST_ASSERT_TRUE(unwritable.patcher.finish());
+    TEST_ASSERT_TRUE(unwritable.image == fixtureNew());
+}
+
+void test_benchmark_apply(void) {
+    // a 1.5 MiB firmware where a third of the code moved by 4 KiB and every 50th byte changed
+    std::vector<uint8_t> old = makeImage(1536 * 1024);
+    std::vector<uint8_t> image(old.begin(), old.begin() + 512 * 1024);
+    std::vector<uint8_t> added = makeImage(4096 + 512 * 1024);
+    image.insert(image.end(), added.begin() + 512 * 1024, added.end());
+    image.insert(image.end(), old.begin() + 512 * 1024, old.end());
+    for (size_t i = 0; i < image.size(); i += 50) {
+        image[i] += 4;
+    }
+
+    PatchBuilder patch(old.size(), image);
+    patch.diff(0, old.data(), image.data(), 512 * 1024);
+    patch.literal(image.data() + 512 * 1024, 4096);
+    patch.diff(512 * 1024, old.data() + 512 * 1024, image.data() + 512 * 1024 + 4096, old.size() - 512 * 1024);
+    patch.end();
+
+    const int rounds = 10;
+    volatile uint8_t flash = 0;
+    std::vector<uint8_t> patched;
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        patched.clear();
+        DeltaPatcher patcher(
+            [](const DeltaPatcher::Header &) { return true; },
+            [&old](uint32_t offset, uint8_t *buffer, size_t length) { memcpy(buffer, old.data() + offset, length); return true; },
+            [&patched](const uint8_t *data, size_t length) { patched.insert(patched.end(), data, data + length); return true; });
+        patcher.begin();
+        for (size_t offset = 0; offset < patch.bytes.size(); offset += 1436) {
+            size_t length = patch.bytes.size() - offset < 1436 ? patch.bytes.size() - offset : 1436;
+            patcher.write(patch.bytes.data() + offset, length);
+        }
+        TEST_ASSERT_TRUE(patcher.finish());
+        flash = flash + patched.back();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    double megabytes = (double)image.size() * rounds / (1024 * 1024);
+    char message[128];
+    snprintf(message, sizeof(message), "%u byte patch for a %u byte image (%.1f %%), %.1f MiB/s applied",
+             (unsigned)patch.bytes.size(), (unsigned)image.size(), 100.0 * patch.bytes.size() / image.size(), megabytes / seconds);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(patched == image);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_applies_tool_patch_in_any_chunks);
+    RUN_TEST(test_memory_stays_bounded);
+    RUN_TEST(test_rejects_other_base);
+    RUN_TEST(test_rejects_malformed_patches);
+    RUN_TEST(test_size_must_match_header);
+    RUN_TEST(test_read_and_output_errors);
+    RUN_TEST(test_benchmark_apply);
+    return UNITY_END();
+}
@@ -0,0 +1,168 @@
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include "dsttable.h"
+#include "timezones.h"
+
+static const time_t YEAR_2025 = 1735689600; // 2025-01-01 00:00 UTC
+static const time_t YEAR_2027 = 1798761600; // 2027-01-01 00:00 UTC
+
+static void useLibcZone(const char *posixTz) {
+    setenv("TZ", posixTz, 1);
+    tzset();
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_berlin_transitions(void) {
+    DstTable table;
+    TEST_ASSERT_TRUE(table.setRule(TimeZones::findPosixTz("Europe/Berlin")));
+    table.build(2025);
+    TEST_ASSERT_EQUAL_UINT8(4, table.getTransitionCount());
+    // 2025-03-30 01:00 UTC and 2025-10-26 01:00 UTC
+    TEST_ASSERT_EQUAL_INT64(1743296400, table.getTransition(0)->at);
+    TEST_ASSERT_EQUAL_INT32(7200, table.getTransition(0)->offset);
+    TEST_ASSERT_EQUAL_INT64(1761440400, table.getTransition(1)->at);
+    TEST_ASSERT_EQUAL_INT32(3600, table.getTransition(1)->offset);
+
+    TEST_ASSERT_EQUAL_INT32(3600, table.offsetAt(1743296399));
+    TEST_ASSERT_EQUAL_INT32(7200, table.offsetAt(1743296400));
+}
+
+void test_southern_hemisphere_starts_in_dst(void) {
+    DstTable table;
+    TEST_ASSERT_TRUE(table.setRule(TimeZones::findPosixTz("Australia/Sydney")));
+    TEST_ASSERT_TRUE(table.isDstAt(YEAR_2025));
+    TEST_ASSERT_EQUAL_INT32(11 * 3600, table.offsetAt(YEAR_2025));
+    TEST_ASSERT_FALSE(table.isDstAt(YEAR_2025 + 180 * 86400));
+}
+
+void test_malformed_rules_are_rejected(void) {
+    DstTable table;
+    TEST_ASSERT_FALSE(table.setRule(nullptr));
+    TEST_ASSERT_FALSE(table.setRule(""));
+    TEST_ASSERT_FALSE(table.setRule("CET"));
+    TEST_ASSERT_FALSE(table.setRule("CET-1CEST,M3.5.0"));
+    TEST_ASSERT_FALSE(table.setRule("CET-1CEST,M13.5.0,M10.5.0/3"));
+    TEST_ASSERT_TRUE(table.setRule("<+0545>-5:45"));
+    TEST_ASSERT_EQUAL_INT32(5 * 3600 + 45 * 60, table.offsetAt(YEAR_2025));
+}
+
+void test_all_zones_match_libc(void) {
+    struct tm expected, actual;
+    for (size_t i = 0; i < TimeZones::count(); i++) {
+        const char *name = TimeZones::getName(i);
+        const char *rule = TimeZones::findPosixTz(name);
+        DstTable table;
+        TEST_ASSERT_TRUE_MESSAGE(table.setRule(rule), name);
+        useLibcZone(rule);
+
+        for (time_t utc = YEAR_2025; utc < YEAR_2027; utc += 1800) {
+            localtime_r(&utc, &expected);
+            table.toLocal(utc, actual);
+            if (expected.tm_hour != actual.tm_hour || expected.tm_min != actual.tm_min ||
+                expected.tm_sec != actual.tm_sec || expected.tm_mday != actual.tm_mday ||
+                expected.tm_mon != actual.tm_mon || expected.tm_year != actual.tm_year ||
+                expected.tm_wday != actual.tm_wday || expected.tm_yday != actual.tm_yday ||
+                expected.tm_isdst != actual.tm_isdst) {
+                char message[160];
+                snprintf(message, sizeof(message), "%s (%s) differs at %lld", name, rule, (long long)utc);
+                TEST_FAIL_MESSAGE(message);
+            }
+        }
+    }
+}
+
+void test_dates_match_gmtime(void) {
+    // toLocal works out the date itself, check it far from the table years as well
+    DstTable table;
+    TEST_ASSERT_TRUE(table.setRule("UTC0"));
+    struct tm expected, actual;
+    for (time_t utc = -2208988800LL; utc < 7258118400LL; utc += 86400 * 7 + 3599) {
+        gmtime_r(&utc, &expected);
+        table.toLocal(utc, actual);
+        TEST_ASSERT_EQUAL_INT(expected.tm_year, actual.tm_year);
+        TEST_ASSERT_EQUAL_INT(expected.tm_mon, actual.tm_mon);
+        TEST_ASSERT_EQUAL_INT(expected.tm_mday, actual.tm_mday);
+        TEST_ASSERT_EQUAL_INT(expected.tm_wday, actual.tm_wday);
+        TEST_ASSERT_EQUAL_INT(expected.tm_yday, actual.tm_yday);
+        TEST_ASSERT_EQUAL_INT(expected.tm_hour, actual.tm_hour);
+        TEST_ASSERT_EQUAL_INT(expected.tm_sec, actual.tm_sec);
+    }
+}
+
+void test_to_utc_round_trips(void) {
+    const char *zones[] = {"Europe/Berlin", "America/New_York", "Australia/Lord_Howe", "Europe/Dublin", "America/Santiago"};
+    for (const char *name : zones) {
+        DstTable table;
+        table.setRule(TimeZones::findPosixTz(name));
+
+        for (time_t utc = YEAR_2025; utc < YEAR_2027; utc += 900) {
+            struct tm local, back;
+            table.toLocal(utc, local);
+            time_t resolved = table.toUtc(local);
+            table.toLocal(resolved, back);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(local.tm_hour, back.tm_hour, name);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(local.tm_min, back.tm_min, name);
+            // repeated wall times resolve to their first occurrence
+            TEST_ASSERT_TRUE_MESSAGE(resolved <= utc, name);
+        }
+    }
+}
+
+void test_to_utc_skips_gap(void) {
+    DstTable table;
+    table.setRule(TimeZones::findPosixTz("Europe/Berlin"));
+    // 2025-03-30 02:30 does not exist and becomes 03:30 CEST
+    struct tm local = {};
+    local.tm_year = 125;
+    local.tm_mon = 2;
+    local.tm_mday = 30;
+    local.tm_hour = 2;
+    local.tm_min = 30;
+    TEST_ASSERT_EQUAL_INT64(1743298200, table.toUtc(local));
+}
+
+void test_benchmark_lookup(void) {
+    DstTable table;
+    table.setRule(TimeZones::findPosixTz("Europe/Berlin"));
+    useLibcZone(TimeZones::findPosixTz("Europe/Berlin"));
+    const uint32_t iterations = 2000000;
+    struct tm local;
+    long checksum = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        table.toLocal(YEAR_2025 + i * 37, local);
+        checksum += local.tm_min;
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        time_t utc = YEAR_2025 + i * 37;
+        localtime_r(&utc, &local);
+        checksum -= local.tm_min;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double table_ns = std::chrono::duration<double, std::nano>(middle - begin).count() / iterations;
+    double libc_ns = std::chrono::duration<double, std::nano>(end - middle).count() / iterations;
+    char message[128];
+    snprintf(message, sizeof(message), "toLocal %.1f ns, localtime_r %.1f ns per call", table_ns, libc_ns);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_INT32(0, checksum);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_berlin_transitions);
+    RUN_TEST(test_southern_hemisphere_starts_in_dst);
+    RUN_TEST(test_malformed_rules_are_rejected);
+    RUN_TEST(test_all_zones_match_libc);
+    RUN_TEST(test_dates_match_gmtime);
+    RUN_TEST(test_to_utc_round_trips);
+    RUN_TEST(test_to_utc_skips_gap);
+    RUN_TEST(test_benchmark_lookup);
+    return UNITY_END();
+}
@@ -0,0 +1,237 @@
+#include <unity.h>
+#include <string>
+#include <vector>
+#include <string.h>
+#include "gziptemplate.h"
+#include "configstore.h"
+
+using Bytes = std::vector<uint8_t>;
+
+static void put16(Bytes &out, uint16_t value) {
+    out.push_back(value & 0xFF);
+    out.push_back(value >> 8);
+}
+
+static void put32(Bytes &out, uint32_t value) {
+    put16(out, value & 0xFFFF);
+    put16(out, value >> 16);
+}
+
+static uint32_t crc(const std::string &text) {
+    return ConfigStore::crc32(reinterpret_cast<const uint8_t *>(text.data()), text.size());
+}
+
+// builds a .gzt like scripts/webassets.py, with stored blocks standing in for the deflated spans;
+// parts starting with '%' are variables
+static Bytes buildGzt(const std::vector<std::string> &parts) {
+    Bytes table, data;
+    for (const std::string &part : parts) {
+        if (part[0] == '%') {
+            table.push_back(1);
+            table.push_back(part.size() - 1);
+            table.insert(table.end(), part.begin() + 1, part.end());
+            continue;
+        }
+        Bytes segment;
+        segment.push_back(0);
+        put16(segment, part.size());
+        put16(segment, ~part.size());
+        segment.insert(segment.end(), part.begin(), part.end());
+        table.push_back(0);
+        put32(table, segment.size());
+        put32(table, part.size());
+        put32(table, crc(part));
+        data.insert(data.end(), segment.begin(), segment.end());
+    }
+    Bytes file = {'W', 'G', 'Z', 'T'};
+    put16(file, GzipTemplate::VERSION);
+    put16(file, parts.size());
+    file.insert(file.end(), table.begin(), table.end());
+    file.insert(file.end(), data.begin(), data.end());
+    return file;
+}
+
+static bool load(GzipTemplate &compiled, const Bytes &file, size_t chunk) {
+    compiled.reset();
+    for (size_t offset = 0; offset < file.size(); offset += chunk) {
+        compiled.feed(file.data() + offset, file.size() - offset < chunk ? file.size() - offset : chunk);
+    }
+    return compiled.finish();
+}
+
+class TestRenderer : public GzipRenderer {
+public:
+    TestRenderer(const GzipTemplate &page, const Bytes &file, const GzipTemplate &header, const uint8_t *headerData)
+        : GzipRenderer(page, header, headerData), file(file) {}
+
+protected:
+    size_t readPage(uint32_t offset, uint8_t *buffer, size_t length) override {
+        if (offset >= file.size()) {
+            return 0;
+        }
+        size_t count = file.size() - offset < length ? file.size() - offset : length;
+        memcpy(buffer, file.data() + offset, count);
+        return count;
+    }
+
+    size_t writeVariable(PageTemplate::Variable variable, char *buffer, size_t length) override {
+        const char *value = "";
+        switch (variable) {
+        case PageTemplate::PageTitle: value = "Light Settings"; break;
+        case PageTemplate::ActiveTime: value = "#FF8000"; break;
+        case PageTemplate::ActiveSystem: value = "checked"; break;
+        default: break;
+        }
+        size_t count = strlen(value) < length ? strlen(value) : length;
+        memcpy(buffer, value, count);
+        return count;
+    }
+
+private:
+    const Bytes &file;
+};
+
+static Bytes render(GzipRenderer &renderer, size_t chunk) {
+    Bytes output;
+    uint8_t buffer[512];
+    size_t length;
+    while ((length = renderer.read(buffer, chunk)) > 0) {
+        output.insert(output.end(), buffer, buffer + length);
+    }
+    return output;
+}
+
+// inflates a gzip member made of stored blocks only, checking the trailer; "!" on any error
+static std::string inflateStored(const Bytes &gz) {
+    if (gz.size() < 18 || gz[0] != 0x1F || gz[1] != 0x8B || gz[2] != 8 || gz[3] != 0) {
+        return "!";
+    }
+    std::string text;
+    size_t position = 10;
+    for (;;) {
+        if (position + 5 > gz.size() || (gz[position] & 0xFE) != 0) {
+            return "!";
+        }
+        bool final = gz[position] & 1;
+        uint16_t length = gz[position + 1] | (gz[position + 2] << 8);
+        uint16_t check = gz[position + 3] | (gz[position + 4] << 8);
+        if (static_cast<uint16_t>(~check) != length || position + 5 + length > gz.size()) {
+            return "!";
+        }
+        text.append(reinterpret_cast<const char *>(gz.data() + position + 5), length);
+        position += 5 + length;
+        if (final) {
+            break;
+        }
+    }
+    if (position + 8 != gz.size()) {
+        return "!";
+    }
+    uint32_t storedCrc = gz[position] | (gz[position + 1] << 8) | (gz[position + 2] << 16) | (static_cast<uint32_t>(gz[position + 3]) << 24);
+    uint32_t storedSize = gz[position + 4] | (gz[position + 5] << 8) | (gz[position + 6] << 16) | (static_cast<uint32_t>(gz[position + 7]) << 24);
+    if (storedCrc != crc(text) || storedSize != text.size()) {
+        return "!";
+    }
+    return text;
+}
+
+static const std::vector<std::string> HEADER = {"<h1>", "%PAGE_TITLE", "</h1>"};
+static const std::vector<std::string> PAGE = {"<html>", "%INCLUDE_HEADER", "<input value=\"", "%ACTIVE_TIME", "\" ", "%ACTIVE_SYSTEM",
+                                              ">", "%NOT_A_VARIABLE", "<p>100%</p>", "%ACTIVE_LIGHT", "</html>"};
+static const char EXPECTED[] = "<html><h1>Light Settings</h1><input value=\"#FF8000\" checked><p>100%</p></html>";
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_crc_combine(void) {
+    const std::string a = "<html><head>", b = "<title>Word Clock</title>";
+    TEST_ASSERT_EQUAL_HEX32(crc(a + b), GzipTemplate::crc32Combine(crc(a), crc(b), b.size()));
+    TEST_ASSERT_EQUAL_HEX32(crc(b), GzipTemplate::crc32Combine(0, crc(b), b.size()));
+    TEST_ASSERT_EQUAL_HEX32(crc(a), GzipTemplate::crc32Combine(crc(a), 0, 0));
+
+    std::string large(70000, 'x');
+    TEST_ASSERT_EQUAL_HEX32(crc(a + large), GzipTemplate::crc32Combine(crc(a), crc(large), large.size()));
+}
+
+void test_segments(void) {
+    Bytes file = buildGzt(PAGE);
+    for (size_t chunk = 1; chunk <= file.size(); chunk += 7) {
+        GzipTemplate page;
+        TEST_ASSERT_TRUE(load(page, file, chunk));
+        TEST_ASSERT_EQUAL_UINT32(PAGE.size(), page.getSegmentCount());
+        const GzipTemplate::Segment *segments = page.getSegments();
+        TEST_ASSERT_EQUAL_INT(PageTemplate::IncludeHeader, segments[1].variable);
+        TEST_ASSERT_EQUAL_INT(PageTemplate::Unknown, segments[7].variable);
+        TEST_ASSERT_EQUAL_INT(PageTemplate::Literal, segments[8].variable);
+        TEST_ASSERT_EQUAL_UINT32(11, segments[8].rawLength);
+        TEST_ASSERT_EQUAL_HEX32(crc("<p>100%</p>"), segments[8].crc);
+        // the stored block in the file starts with its header, then the text
+        TEST_ASSERT_EQUAL_MEMORY("<p>100%</p>", file.data() + segments[8].offset + 5, 11);
+        TEST_ASSERT_EQUAL_UINT32(file.size(), segments[10].offset + segments[10].length);
+    }
+}
+
+void test_invalid_files(void) {
+    GzipTemplate page;
+    Bytes file = buildGzt(PAGE);
+
+    Bytes truncated(file.begin(), file.end() - 1);
+    TEST_ASSERT_FALSE(load(page, truncated, 64));
+    TEST_ASSERT_TRUE(page.isEmpty());
+
+    Bytes longer = file;
+    longer.push_back(0);
+    TEST_ASSERT_FALSE(load(page, longer, 64));
+
+    Bytes magic = file;
+    magic[0] = 'X';
+    TEST_ASSERT_FALSE(load(page, magic, 64));
+
+    Bytes version = file;
+    version[4] = GzipTemplate::VERSION + 1;
+    TEST_ASSERT_FALSE(load(page, version, 64));
+
+    Bytes kind = file;
+    kind[8] = 7;
+    TEST_ASSERT_FALSE(load(page, kind, 64));
+
+    TEST_ASSERT_TRUE(load(page, file, 64));
+}
+
+void test_render(void) {
+    Bytes headerFile = buildGzt(HEADER);
+    Bytes pageFile = buildGzt(PAGE);
+    GzipTemplate header, page;
+    TEST_ASSERT_TRUE(load(header, headerFile, 4096));
+    TEST_ASSERT_TRUE(load(page, pageFile, 4096));
+
+    for (size_t chunk = 1; chunk <= 512; chunk = chunk * 2 + 1) {
+        TestRenderer renderer(page, pageFile, header, headerFile.data());
+        TEST_ASSERT_EQUAL_STRING(EXPECTED, inflateStored(render(renderer, chunk)).c_str());
+        TEST_ASSERT_FALSE(renderer.hasFailed());
+        uint8_t rest[8];
+        TEST_ASSERT_EQUAL_UINT32(0, renderer.read(rest, sizeof(rest)));
+    }
+}
+
+void test_read_failure(void) {
+    Bytes pageFile = buildGzt(PAGE);
+    GzipTemplate header, page;
+    TEST_ASSERT_TRUE(load(page, pageFile, 4096));
+
+    Bytes shortFile(pageFile.begin(), pageFile.end() - 4);
+    TestRenderer renderer(page, shortFile, header, nullptr);
+    Bytes output = render(renderer, 4096);
+    TEST_ASSERT_TRUE(renderer.hasFailed());
+    TEST_ASSERT_EQUAL_STRING("!", inflateStored(output).c_str());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc_combine);
+    RUN_TEST(test_segments);
+    RUN_TEST(test_invalid_files);
+    RUN_TEST(test_render);
+    RUN_TEST(test_read_failure);
+    return UNITY_END();
+}
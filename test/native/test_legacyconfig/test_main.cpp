@@ -0,0 +1,201 @@
+#include <unity.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <string.h>
+#include "legacyconfig.h"
+#include "defaults.h"
+
+// One Preferences namespace, every value kept as the bytes NVS would hold
+class FakePreferences : public ILegacyPreferences {
+public:
+    std::map<std::string, std::vector<uint8_t>> entries;
+
+    template <typename T>
+    void put(const char *key, T value) {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+        entries[key].assign(bytes, bytes + sizeof(value));
+    }
+    void putBytes(const char *key, const void *buffer, size_t length) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(buffer);
+        entries[key].assign(bytes, bytes + length);
+    }
+    void putString(const char *key, const char *value) {
+        putBytes(key, value, strlen(value) + 1);
+    }
+
+    bool isKey(const char *key) override { return entries.count(key) > 0; }
+    bool getBool(const char *key, bool defaultValue) override { return get(key, defaultValue); }
+    uint8_t getUChar(const char *key, uint8_t defaultValue) override { return get(key, defaultValue); }
+    uint16_t getUShort(const char *key, uint16_t defaultValue) override { return get(key, defaultValue); }
+    uint32_t getUInt(const char *key, uint32_t defaultValue) override { return get(key, defaultValue); }
+    uint32_t getULong(const char *key, uint32_t defaultValue) override { return get(key, defaultValue); }
+    float getFloat(const char *key, float defaultValue) override { return get(key, defaultValue); }
+    size_t getBytesLength(const char *key) override {
+        auto it = entries.find(key);
+        return it == entries.end() ? 0 : it->second.size();
+    }
+    size_t getBytes(const char *key, void *buffer, size_t length) override {
+        auto it = entries.find(key);
+        if (it == entries.end() || it->second.size() > length) {
+            return 0;
+        }
+        memcpy(buffer, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+
+private:
+    template <typename T>
+    T get(const char *key, T defaultValue) {
+        auto it = entries.find(key);
+        if (it == entries.end() || it->second.size() != sizeof(T)) {
+            return defaultValue;
+        }
+        T value;
+        memcpy(&value, it->second.data(), sizeof(T));
+        return value;
+    }
+};
+
+static FakePreferences systemPrefs;
+static FakePreferences lightPrefs;
+
+void setUp(void) {
+    systemPrefs.entries.clear();
+    lightPrefs.entries.clear();
+}
+
+void tearDown(void) {}
+
+void test_uninitialised_namespace_is_not_migrated(void) {
+    systemPrefs.putString(LegacyConfig::WIFI_SSID_KEY, "clocknet");
+    ConfigData data;
+    memset(&data, 0x5A, sizeof(data));
+    ConfigData before = data;
+
+    TEST_ASSERT_FALSE(LegacyConfig::read(systemPrefs, lightPrefs, data));
+    TEST_ASSERT_EQUAL_MEMORY(&before, &data, sizeof(data));
+}
+
+void test_reads_system_namespace(void) {
+    systemPrefs.put(LegacyConfig::IS_INITIALIZED_KEY, true);
+    systemPrefs.put(LegacyConfig::CLOCK_MODE_KEY, static_cast<uint32_t>(ConfigData::Option_1));
+    systemPrefs.putString(LegacyConfig::WIFI_SSID_KEY, "clocknet");
+    systemPrefs.putString(LegacyConfig::WIFI_PASSWORD_KEY, "secret");
+    systemPrefs.put(LegacyConfig::MQTT_ENABLED_KEY, true);
+    systemPrefs.putString(LegacyConfig::MQTT_HOST_KEY, "broker.lan");
+    systemPrefs.put(LegacyConfig::MQTT_PORT_KEY, static_cast<uint32_t>(8883));
+    systemPrefs.putString(LegacyConfig::MQTT_TOPIC_KEY, "hall");
+    systemPrefs.put(LegacyConfig::NTP_ENABLED_KEY, false);
+    systemPrefs.putString(LegacyConfig::NTP_TIMEZONE_KEY, "Europe/Berlin");
+    systemPrefs.put(LegacyConfig::NTP_UPDATE_INTERVAL_KEY, static_cast<uint32_t>(120));
+    systemPrefs.put(LegacyConfig::LOCATION_ENABLED_KEY, true);
+    systemPrefs.put(LegacyConfig::LOCATION_LATITUDE_KEY, 52.52f);
+    systemPrefs.put(LegacyConfig::LOCATION_LONGITUDE_KEY, 13.40f);
+
+    ConfigData data;
+    TEST_ASSERT_TRUE(LegacyConfig::read(systemPrefs, lightPrefs, data));
+    TEST_ASSERT_EQUAL_INT(ConfigData::Option_1, data.system.mode);
+    TEST_ASSERT_EQUAL_STRING("clocknet", data.wifi.ssid);
+    TEST_ASSERT_EQUAL_STRING("secret", data.wifi.password);
+    TEST_ASSERT_TRUE(data.system.mqttConfig.enabled);
+    TEST_ASSERT_EQUAL_STRING("broker.lan", data.system.mqttConfig.host);
+    TEST_ASSERT_EQUAL_UINT16(8883, data.system.mqttConfig.port);
+    TEST_ASSERT_EQUAL_STRING("", data.system.mqttConfig.username);
+    TEST_ASSERT_EQUAL_STRING("hall", data.system.mqttConfig.topic);
+    TEST_ASSERT_FALSE(data.system.ntpConfig.enabled);
+    TEST_ASSERT_EQUAL_STRING("Europe/Berlin", data.system.ntpConfig.timezone);
+    TEST_ASSERT_EQUAL_STRING(Defaults::DEFAULT_NTP_SERVER, data.system.ntpConfig.server);
+    TEST_ASSERT_EQUAL_UINT32(120, data.system.ntpConfig.interval);
+    TEST_ASSERT_TRUE(data.system.locationConfig.enabled);
+    TEST_ASSERT_EQUAL_FLOAT(52.52f, data.system.locationConfig.latitude);
+    TEST_ASSERT_EQUAL_FLOAT(13.40f, data.system.locationConfig.longitude);
+
+    // the light namespace is empty, so everything from it is a default
+    TEST_ASSERT_EQUAL_UINT8(Defaults::DEFAULT_LIGHT_BRIGHTNESS, data.light.brightness);
+    TEST_ASSERT_EQUAL_STRING(Defaults::DEFAULT_LIGHT_COLOR, data.light.color);
+    TEST_ASSERT_EQUAL_UINT8(0, data.system.lightScheduleConfig.ruleCount);
+}
+
+void test_light_keys_come_from_light_namespace(void) {
+    systemPrefs.put(LegacyConfig::IS_INITIALIZED_KEY, true);
+    lightPrefs.put(LegacyConfig::LIGHT_BRIGHTNESS_KEY, static_cast<uint8_t>(77));
+    lightPrefs.put(LegacyConfig::LIGHT_STATE_KEY, false);
+    lightPrefs.putString(LegacyConfig::LIGHT_COLOR_KEY, "#FF8000");
+    lightPrefs.put(LegacyConfig::AUTO_BRIGHTNESS_ENABLED_KEY, false);
+    lightPrefs.put(LegacyConfig::AUTO_BRIGHTNESS_THRESH_HIGH_KEY, static_cast<uint16_t>(3000));
+    lightPrefs.put(LegacyConfig::AUTO_BRIGHTNESS_THRESH_LOW_KEY, static_cast<uint16_t>(200));
+    lightPrefs.put(LegacyConfig::LIGHT_SCHEDULE_ENABLED_KEY, true);
+    // the same keys in the wrong namespace must not be picked up
+    systemPrefs.put(LegacyConfig::LIGHT_BRIGHTNESS_KEY, static_cast<uint8_t>(11));
+    systemPrefs.put(LegacyConfig::LIGHT_SCHEDULE_ENABLED_KEY, false);
+
+    ConfigData data;
+    TEST_ASSERT_TRUE(LegacyConfig::read(systemPrefs, lightPrefs, data));
+    TEST_ASSERT_EQUAL_UINT8(77, data.light.brightness);
+    TEST_ASSERT_FALSE(data.light.state);
+    TEST_ASSERT_EQUAL_STRING("#FF8000", data.light.color);
+    TEST_ASSERT_FALSE(data.light.autoBrightnessConfig.enabled);
+    TEST_ASSERT_EQUAL_UINT16(3000, data.light.autoBrightnessConfig.illuminanceThresholdHigh);
+    TEST_ASSERT_EQUAL_UINT16(200, data.light.autoBrightnessConfig.illuminanceThresholdLow);
+    TEST_ASSERT_TRUE(data.system.lightScheduleConfig.enabled);
+}
+
+void test_schedule_rules_blob(void) {
+    systemPrefs.put(LegacyConfig::IS_INITIALIZED_KEY, true);
+    LightScheduler::Rule rules[2] = {};
+    rules[0] = {7 * 60, 22 * 60, LightScheduler::ALL_DAYS, 80, {0, 0, 0}, LightScheduler::RULE_ENABLED};
+    rules[1] = {23 * 60, 6 * 60, 0x3E, 10, {0, 0, 0}, LightScheduler::RULE_ENABLED};
+    lightPrefs.putBytes(LegacyConfig::LIGHT_SCHEDULE_RULES_KEY, rules, sizeof(rules));
+    // rules win over the older start/end pair
+    lightPrefs.put(LegacyConfig::LIGHT_SCHEDULE_START_TIME_KEY, static_cast<uint32_t>(3600));
+
+    ConfigData data;
+    TEST_ASSERT_TRUE(LegacyConfig::read(systemPrefs, lightPrefs, data));
+    TEST_ASSERT_EQUAL_UINT8(2, data.system.lightScheduleConfig.ruleCount);
+    TEST_ASSERT_EQUAL_MEMORY(rules, data.system.lightScheduleConfig.rules, sizeof(rules));
+}
+
+void test_schedule_start_end_pair(void) {
+    systemPrefs.put(LegacyConfig::IS_INITIALIZED_KEY, true);
+    lightPrefs.put(LegacyConfig::LIGHT_SCHEDULE_START_TIME_KEY, static_cast<uint32_t>(6 * 3600 + 30 * 60));
+    lightPrefs.put(LegacyConfig::LIGHT_SCHEDULE_END_TIME_KEY, static_cast<uint32_t>(23 * 3600));
+    // a rules blob of the wrong size is ignored
+    uint8_t junk[5] = {1, 2, 3, 4, 5};
+    lightPrefs.putBytes(LegacyConfig::LIGHT_SCHEDULE_RULES_KEY, junk, sizeof(junk));
+
+    ConfigData data;
+    TEST_ASSERT_TRUE(LegacyConfig::read(systemPrefs, lightPrefs, data));
+    const ConfigData::LightScheduleConfig &schedule = data.system.lightScheduleConfig;
+    TEST_ASSERT_EQUAL_UINT8(1, schedule.ruleCount);
+    TEST_ASSERT_EQUAL_UINT16(6 * 60 + 30, schedule.rules[0].start);
+    TEST_ASSERT_EQUAL_UINT16(23 * 60, schedule.rules[0].end);
+    TEST_ASSERT_EQUAL_UINT8(LightScheduler::ALL_DAYS, schedule.rules[0].weekdays);
+    TEST_ASSERT_EQUAL_UINT8(LightScheduler::RULE_ENABLED, schedule.rules[0].flags);
+
+    // an empty pair means no schedule
+    lightPrefs.put(LegacyConfig::LIGHT_SCHEDULE_END_TIME_KEY, static_cast<uint32_t>(6 * 3600 + 30 * 60));
+    TEST_ASSERT_TRUE(LegacyConfig::read(systemPrefs, lightPrefs, data));
+    TEST_ASSERT_EQUAL_UINT8(0, data.system.lightScheduleConfig.ruleCount);
+}
+
+void test_oversized_string_falls_back_to_default(void) {
+    systemPrefs.put(LegacyConfig::IS_INITIALIZED_KEY, true);
+    std::string longZone(sizeof(ConfigData::NtpConfig::timezone) + 4, 'x');
+    systemPrefs.putString(LegacyConfig::NTP_TIMEZONE_KEY, longZone.c_str());
+
+    ConfigData data;
+    TEST_ASSERT_TRUE(LegacyConfig::read(systemPrefs, lightPrefs, data));
+    TEST_ASSERT_EQUAL_STRING(Defaults::DEFAULT_NTP_TIMEZONE, data.system.ntpConfig.timezone);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_uninitialised_namespace_is_not_migrated);
+    RUN_TEST(test_reads_system_namespace);
+    RUN_TEST(test_light_keys_come_from_light_namespace);
+    RUN_TEST(test_schedule_rules_blob);
+    RUN_TEST(test_schedule_start_end_pair);
+    RUN_TEST(test_oversized_string_falls_back_to_default);
+    return UNITY_END();
+}
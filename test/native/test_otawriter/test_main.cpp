@@ -0,0 +1,235 @@
+#include <unity.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include "otawriter.h"
+
+static std::string hexDigest(const uint8_t *data, size_t length, size_t chunk) {
+    Sha256 hash;
+    for (size_t offset = 0; offset < length; offset += chunk) {
+        hash.update(data + offset, length - offset < chunk ? length - offset : chunk);
+    }
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    hash.finish(digest);
+    char text[Sha256::HEX_SIZE];
+    Sha256::toHex(digest, text);
+    return text;
+}
+
+static std::vector<uint8_t> makeImage(size_t length) {
+    std::vector<uint8_t> image(length);
+    uint32_t value = 12345;
+    for (size_t i = 0; i < length; i++) {
+        value = value * 1103515245 + 12345;
+        image[i] = (uint8_t)(value >> 16);
+    }
+    return image;
+}
+
+static OtaWriter::Manifest manifestFor(const std::vector<uint8_t> &image) {
+    OtaWriter::Manifest manifest;
+    manifest.size = image.size();
+    manifest.hasDigest = true;
+    Sha256 hash;
+    hash.update(image.data(), image.size());
+    hash.finish(manifest.sha256);
+    return manifest;
+}
+
+struct FlashRecorder {
+    std::vector<uint8_t> flash;
+    std::vector<size_t> writes;
+    bool failing = false;
+
+    OtaWriter::Sink sink() {
+        return [this](const uint8_t *data, size_t length) {
+            if (failing) {
+                return false;
+            }
+            flash.insert(flash.end(), data, data + length);
+            writes.push_back(length);
+            return true;
+        };
+    }
+};
+
+static void writeInChunks(OtaWriter &writer, const std::vector<uint8_t> &image, size_t chunk) {
+    for (size_t offset = 0; offset < image.size(); offset += chunk) {
+        size_t length = image.size() - offset < chunk ? image.size() - offset : chunk;
+        writer.write(image.data() + offset, length, offset / 1000);
+    }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_sha256_vectors(void) {
+    TEST_ASSERT_EQUAL_STRING("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+                             hexDigest((const uint8_t *)"", 0, 1).c_str());
+    TEST_ASSERT_EQUAL_STRING("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+                             hexDigest((const uint8_t *)"abc", 3, 1).c_str());
+    const char *twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    for (size_t chunk = 1; chunk <= 64; chunk++) {
+        TEST_ASSERT_EQUAL_STRING("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+                                 hexDigest((const uint8_t *)twoBlocks, strlen(twoBlocks), chunk).c_str());
+    }
+    std::vector<uint8_t> million(1000000, 'a');
+    TEST_ASSERT_EQUAL_STRING("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+                             hexDigest(million.data(), million.size(), 1436).c_str());
+}
+
+void test_sha256_hex(void) {
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    TEST_ASSERT_TRUE(Sha256::parseHex("BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD", digest));
+    char text[Sha256::HEX_SIZE];
+    Sha256::toHex(digest, text);
+    TEST_ASSERT_EQUAL_STRING("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", text);
+    TEST_ASSERT_FALSE(Sha256::parseHex("ba7816bf", digest));
+    TEST_ASSERT_FALSE(Sha256::parseHex("xa7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", digest));
+    TEST_ASSERT_FALSE(Sha256::parseHex(nullptr, digest));
+}
+
+void test_writes_whole_sectors(void) {
+    std::vector<uint8_t> image = makeImage(3 * OtaWriter::SECTOR_SIZE + 1000);
+    FlashRecorder recorder;
+    OtaWriter writer(recorder.sink());
+    TEST_ASSERT_TRUE(writer.begin(manifestFor(image), 0));
+    writeInChunks(writer, image, 1436);
+    TEST_ASSERT_TRUE(writer.finish(5000));
+
+    TEST_ASSERT_EQUAL(4, recorder.writes.size());
+    for (size_t i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(OtaWriter::SECTOR_SIZE, recorder.writes[i]);
+    }
+    TEST_ASSERT_EQUAL(1000, recorder.writes[3]);
+    TEST_ASSERT_TRUE(recorder.flash == image);
+
+    OtaWriter::Progress progress = writer.getProgress();
+    TEST_ASSERT_EQUAL(OtaWriter::Done, progress.status);
+    TEST_ASSERT_TRUE(progress.verified);
+    TEST_ASSERT_EQUAL(image.size(), progress.received);
+    TEST_ASSERT_EQUAL(image.size() * 1000 / 5000, progress.bytesPerSecond);
+}
+
+void test_large_chunks_skip_the_buffer(void) {
+    std::vector<uint8_t> image = makeImage(5 * OtaWriter::SECTOR_SIZE);
+    FlashRecorder recorder;
+    OtaWriter writer(recorder.sink());
+    TEST_ASSERT_TRUE(writer.begin(manifestFor(image), 0));
+    // one sector unaligned, then aligned again
+    writer.write(image.data(), 100, 0);
+    writer.write(image.data() + 100, 2 * OtaWriter::SECTOR_SIZE, 0);
+    writer.write(image.data() + 100 + 2 * OtaWriter::SECTOR_SIZE, image.size() - 100 - 2 * OtaWriter::SECTOR_SIZE, 0);
+    TEST_ASSERT_TRUE(writer.finish(0));
+    TEST_ASSERT_EQUAL(5, recorder.writes.size());
+    TEST_ASSERT_TRUE(recorder.flash == image);
+}
+
+void test_digest_mismatch_fails(void) {
+    std::vector<uint8_t> image = makeImage(10000);
+    OtaWriter::Manifest manifest = manifestFor(image);
+    image[5000] ^= 0x01;
+    FlashRecorder recorder;
+    OtaWriter writer(recorder.sink());
+    TEST_ASSERT_TRUE(writer.begin(manifest, 0));
+    writeInChunks(writer, image, 512);
+    TEST_ASSERT_FALSE(writer.finish(0));
+    OtaWriter::Progress progress = writer.getProgress();
+    TEST_ASSERT_EQUAL(OtaWriter::Failed, progress.status);
+    TEST_ASSERT_EQUAL(OtaWriter::ErrorDigest, progress.error);
+    TEST_ASSERT_FALSE(progress.verified);
+}
+
+void test_size_and_write_errors(void) {
+    std::vector<uint8_t> image = makeImage(10000);
+    OtaWriter::Manifest manifest = manifestFor(image);
+    FlashRecorder recorder;
+    OtaWriter writer(recorder.sink());
+
+    // too short
+    TEST_ASSERT_TRUE(writer.begin(manifest, 0));
+    writer.write(image.data(), 9000, 0);
+    TEST_ASSERT_FALSE(writer.finish(0));
+    TEST_ASSERT_EQUAL(OtaWriter::ErrorSize, writer.getProgress().error);
+
+    // too long, rejected as soon as it goes past the size
+    TEST_ASSERT_TRUE(writer.begin(manifest, 0));
+    writer.write(image.data(), image.size(), 0);
+    TEST_ASSERT_FALSE(writer.write(image.data(), 1, 0));
+    TEST_ASSERT_EQUAL(OtaWriter::ErrorSize, writer.getProgress().error);
+
+    // the flash refuses
+    recorder.failing = true;
+    TEST_ASSERT_TRUE(writer.begin(manifest, 0));
+    TEST_ASSERT_FALSE(writer.write(image.data(), image.size(), 0));
+    TEST_ASSERT_FALSE(writer.write(image.data(), 10, 0));
+    TEST_ASSERT_EQUAL(OtaWriter::Failed, writer.getProgress().status);
+    TEST_ASSERT_EQUAL(OtaWriter::ErrorWrite, writer.getProgress().error);
+
+    // without a manifest anything goes
+    recorder.failing = false;
+    OtaWriter::Manifest unknown = {};
+    TEST_ASSERT_TRUE(writer.begin(unknown, 0));
+    writer.write(image.data(), 123, 0);
+    TEST_ASSERT_TRUE(writer.finish(0));
+    TEST_ASSERT_FALSE(writer.getProgress().verified);
+}
+
+void test_status_json(void) {
+    char buffer[OtaWriter::STATUS_SIZE];
+    OtaWriter::Progress progress = {OtaWriter::Receiving, OtaWriter::ErrorNone, 524288, 1048576, 65536, false};
+    OtaWriter::formatStatus(progress, buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_STRING("{\"status\":\"receiving\",\"error\":\"none\",\"received\":524288,\"total\":1048576,"
+                             "\"percent\":50,\"bytesPerSecond\":65536,\"verified\":false}", buffer);
+
+    progress = {OtaWriter::Failed, OtaWriter::ErrorDigest, 4294967295u, 0, 4294967295u, false};
+    TEST_ASSERT_TRUE(OtaWriter::formatStatus(progress, buffer, sizeof(buffer)) > 0);
+    TEST_ASSERT_EQUAL_STRING("{\"status\":\"failed\",\"error\":\"digest\",\"received\":4294967295,\"total\":0,"
+                             "\"percent\":null,\"bytesPerSecond\":4294967295,\"verified\":false}", buffer);
+    TEST_ASSERT_EQUAL(0, OtaWriter::formatStatus(progress, buffer, 20));
+}
+
+void test_benchmark_buffered_writes(void) {
+    // a 1.5 MiB image in TCP segment sized chunks, as the upload handler sees it
+    std::vector<uint8_t> image = makeImage(1536 * 1024);
+    OtaWriter::Manifest manifest = manifestFor(image);
+    const size_t chunk = 1436;
+    const size_t direct = (image.size() + chunk - 1) / chunk;
+    const int rounds = 20;
+    size_t buffered = 0;
+    volatile uint8_t flash = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        OtaWriter writer([&flash](const uint8_t *data, size_t length) { flash = flash + data[length - 1]; return true; });
+        writer.begin(manifest, 0);
+        writeInChunks(writer, image, chunk);
+        TEST_ASSERT_TRUE(writer.finish(0));
+        buffered = writer.getSinkWrites();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    double megabytes = (double)image.size() * rounds / (1024 * 1024);
+    char message[128];
+    snprintf(message, sizeof(message), "%u flash writes instead of %u, %.1f MiB/s buffered and hashed",
+             (unsigned)buffered, (unsigned)direct, megabytes / seconds);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL(image.size() / OtaWriter::SECTOR_SIZE, buffered);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sha256_vectors);
+    RUN_TEST(test_sha256_hex);
+    RUN_TEST(test_writes_whole_sectors);
+    RUN_TEST(test_large_chunks_skip_the_buffer);
+    RUN_TEST(test_digest_mismatch_fails);
+    RUN_TEST(test_size_and_write_errors);
+    RUN_TEST(test_status_json);
+    RUN_TEST(test_benchmark_buffered_writes);
+    return UNITY_END();
+}
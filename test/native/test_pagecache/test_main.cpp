@@ -0,0 +1,125 @@
+#include <unity.h>
+#include <string.h>
+#include "pagecache.h"
+
+static void fill(PageCache::Capture &capture, size_t length) {
+    uint8_t chunk[256];
+    memset(chunk, 'x', sizeof(chunk));
+    while (length > 0) {
+        size_t count = length < sizeof(chunk) ? length : sizeof(chunk);
+        capture.append(chunk, count);
+        length -= count;
+    }
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_etag_format(void) {
+    char etag[PageCache::ETAG_SIZE];
+    PageCache::formatETag(etag, sizeof(etag), 0xDEADBEEF, 2, PageCache::Identity, 0x1234);
+    TEST_ASSERT_EQUAL_STRING("\"bdeadbeef-p2-00001234\"", etag);
+    PageCache::formatETag(etag, sizeof(etag), 0xDEADBEEF, 2, PageCache::Gzip, 0x1234);
+    TEST_ASSERT_EQUAL_STRING("\"bdeadbeef-p2g-00001234\"", etag);
+
+    PageCache::formatETag(etag, sizeof(etag), 0xFFFFFFFF, 255, PageCache::Gzip, 0xFFFFFFFF);
+    TEST_ASSERT_EQUAL_UINT32(strlen("\"bffffffff-p255g-ffffffff\""), strlen(etag));
+}
+
+void test_etag_matching(void) {
+    const char *etag = "\"b1-p0-2\"";
+    TEST_ASSERT_TRUE(PageCache::matchesETag("\"b1-p0-2\"", etag));
+    TEST_ASSERT_TRUE(PageCache::matchesETag("W/\"b1-p0-2\"", etag));
+    TEST_ASSERT_TRUE(PageCache::matchesETag("\"other\", \"b1-p0-2\"", etag));
+    TEST_ASSERT_TRUE(PageCache::matchesETag("\"other\" , W/\"b1-p0-2\" ", etag));
+    TEST_ASSERT_TRUE(PageCache::matchesETag("*", etag));
+    TEST_ASSERT_FALSE(PageCache::matchesETag("\"b1-p0-20\"", etag));
+    TEST_ASSERT_FALSE(PageCache::matchesETag("\"b1-p0-\"", etag));
+    TEST_ASSERT_FALSE(PageCache::matchesETag("", etag));
+    TEST_ASSERT_FALSE(PageCache::matchesETag(nullptr, etag));
+}
+
+void test_versions(void) {
+    PageCache cache;
+    TEST_ASSERT_NULL(cache.get(0, PageCache::Identity, 1).get());
+
+    PageCache::Capture capture(0, PageCache::Identity, 1, 100);
+    capture.append(reinterpret_cast<const uint8_t *>("<html>"), 6);
+    capture.commit(cache);
+
+    std::shared_ptr<const PageCache::Body> body = cache.get(0, PageCache::Identity, 1);
+    TEST_ASSERT_NOT_NULL(body.get());
+    TEST_ASSERT_EQUAL_UINT32(6, body->size());
+    TEST_ASSERT_NULL(cache.get(0, PageCache::Identity, 2).get());
+    TEST_ASSERT_NULL(cache.get(1, PageCache::Identity, 1).get());
+    TEST_ASSERT_NULL(cache.get(PageCache::MAX_PAGES, PageCache::Identity, 1).get());
+    TEST_ASSERT_EQUAL_UINT32(1, cache.getHits());
+    TEST_ASSERT_EQUAL_UINT32(4, cache.getMisses());
+
+    TEST_ASSERT_NOT_EQUAL(PageCache::mix(0, 1), PageCache::mix(0, 2));
+    TEST_ASSERT_NOT_EQUAL(PageCache::mix(PageCache::mix(0, 1), 2), PageCache::mix(PageCache::mix(0, 2), 1));
+}
+
+void test_encodings_keep_their_own_slot(void) {
+    PageCache cache;
+    PageCache::Capture plain(1, PageCache::Identity, 0, 16);
+    plain.append(reinterpret_cast<const uint8_t *>("<html>"), 6);
+    plain.commit(cache);
+    PageCache::Capture gzip(1, PageCache::Gzip, 0, 16);
+    gzip.append(reinterpret_cast<const uint8_t *>("\x1f\x8b"), 2);
+    gzip.commit(cache);
+
+    // a client of one kind does not evict the body the other one gets
+    TEST_ASSERT_EQUAL_UINT32(6, cache.get(1, PageCache::Identity, 0)->size());
+    TEST_ASSERT_EQUAL_UINT32(2, cache.get(1, PageCache::Gzip, 0)->size());
+    TEST_ASSERT_NULL(cache.get(1, PageCache::ENCODING_COUNT, 0).get());
+
+    cache.clear();
+    TEST_ASSERT_NULL(cache.get(1, PageCache::Gzip, 0).get());
+}
+
+void test_capture_limit(void) {
+    PageCache cache;
+    PageCache::Capture exact(1, PageCache::Identity, 7, PageCache::MAX_BODY_SIZE);
+    fill(exact, PageCache::MAX_BODY_SIZE);
+    exact.commit(cache);
+    TEST_ASSERT_NOT_NULL(cache.get(1, PageCache::Identity, 7).get());
+
+    PageCache::Capture large(2, PageCache::Identity, 7, 1024);
+    fill(large, PageCache::MAX_BODY_SIZE + 1);
+    large.commit(cache);
+    TEST_ASSERT_NULL(cache.get(2, PageCache::Identity, 7).get());
+}
+
+void test_body_outlives_slot(void) {
+    PageCache cache;
+    PageCache::Capture first(0, PageCache::Identity, 1, 16);
+    first.append(reinterpret_cast<const uint8_t *>("old"), 3);
+    first.commit(cache);
+    std::shared_ptr<const PageCache::Body> streaming = cache.get(0, PageCache::Identity, 1);
+
+    PageCache::Capture second(0, PageCache::Identity, 2, 16);
+    second.append(reinterpret_cast<const uint8_t *>("newer"), 5);
+    second.commit(cache);
+
+    // a response still sending the old version keeps its bytes
+    TEST_ASSERT_EQUAL_UINT32(3, streaming->size());
+    TEST_ASSERT_EQUAL_MEMORY("old", streaming->data(), 3);
+    TEST_ASSERT_NULL(cache.get(0, PageCache::Identity, 1).get());
+    TEST_ASSERT_EQUAL_UINT32(5, cache.get(0, PageCache::Identity, 2)->size());
+
+    cache.clear();
+    TEST_ASSERT_NULL(cache.get(0, PageCache::Identity, 2).get());
+    TEST_ASSERT_EQUAL_UINT32(3, streaming->size());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_etag_format);
+    RUN_TEST(test_etag_matching);
+    RUN_TEST(test_versions);
+    RUN_TEST(test_encodings_keep_their_own_slot);
+    RUN_TEST(test_capture_limit);
+    RUN_TEST(test_body_outlives_slot);
+    return UNITY_END();
+}
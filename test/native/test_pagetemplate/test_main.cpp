@@ -0,0 +1,155 @@
+#include <unity.h>
+#include <string>
+#include <string.h>
+#include "pagetemplate.h"
+
+static const char HEADER[] = "<h1>%PAGE_TITLE%</h1><a class=\"%ACTIVE_LIGHT%\">Light</a>";
+static const char PAGE[] = "<html>%INCLUDE_HEADER%<input value=\"%ACTIVE_TIME%\" %ACTIVE_SYSTEM%>"
+                           "<p>100%% %NOT_A_VARIABLE% 5% off %bad name%</p>%PAGE_TITLE%";
+
+static PageTemplate compile(const char *text, size_t chunk) {
+    PageTemplate compiled;
+    size_t length = strlen(text);
+    for (size_t offset = 0; offset < length; offset += chunk) {
+        compiled.feed(text + offset, length - offset < chunk ? length - offset : chunk);
+    }
+    compiled.finish();
+    return compiled;
+}
+
+class TestRenderer : public TemplateRenderer {
+public:
+    TestRenderer(const PageTemplate &page, const char *pageText, const PageTemplate &header, const char *headerText)
+        : TemplateRenderer(page, header, headerText), pageText(pageText) {}
+
+    size_t pageReads = 0;
+
+protected:
+    size_t readPage(uint32_t offset, uint8_t *buffer, size_t length) override {
+        pageReads++;
+        memcpy(buffer, pageText + offset, length);
+        return length;
+    }
+
+    size_t writeVariable(PageTemplate::Variable variable, char *buffer, size_t length) override {
+        const char *value = "";
+        switch (variable) {
+        case PageTemplate::PageTitle: value = "Light Settings"; break;
+        case PageTemplate::ActiveLight: value = "active"; break;
+        case PageTemplate::ActiveTime: value = "#FF8000"; break;
+        case PageTemplate::ActiveSystem: value = "checked"; break;
+        default: break;
+        }
+        size_t count = strlen(value) < length ? strlen(value) : length;
+        memcpy(buffer, value, count);
+        return count;
+    }
+
+private:
+    const char *pageText;
+};
+
+static std::string render(TemplateRenderer &renderer, size_t chunk) {
+    std::string output;
+    uint8_t buffer[256];
+    size_t length;
+    while ((length = renderer.read(buffer, chunk)) > 0) {
+        output.append(reinterpret_cast<const char *>(buffer), length);
+    }
+    return output;
+}
+
+static const char EXPECTED[] = "<html><h1>Light Settings</h1><a class=\"active\">Light</a><input value=\"#FF8000\" checked>"
+                               "<p>100%  5% off %bad name%</p>Light Settings";
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_variable_names(void) {
+    TEST_ASSERT_EQUAL_INT(PageTemplate::ActiveTime, PageTemplate::findVariable("ACTIVE_TIME", 11));
+    TEST_ASSERT_EQUAL_INT(PageTemplate::PageTitle, PageTemplate::findVariable("PAGE_TITLE", 10));
+    TEST_ASSERT_EQUAL_INT(PageTemplate::Unknown, PageTemplate::findVariable("LIGHT", 5));
+    for (uint8_t i = PageTemplate::IncludeHeader; i < PageTemplate::VARIABLE_COUNT; i++) {
+        const char *name = PageTemplate::getName(static_cast<PageTemplate::Variable>(i));
+        TEST_ASSERT_NOT_NULL(name);
+        TEST_ASSERT_EQUAL_INT(i, PageTemplate::findVariable(name, strlen(name)));
+    }
+}
+
+void test_tokens(void) {
+    PageTemplate page = compile(PAGE, 4096);
+    TEST_ASSERT_EQUAL_UINT32(strlen(PAGE), page.getSize());
+    const PageTemplate::Token *tokens = page.getTokens();
+    TEST_ASSERT_EQUAL_INT(PageTemplate::Literal, tokens[0].variable);
+    TEST_ASSERT_EQUAL_UINT32(6, tokens[0].length);
+    TEST_ASSERT_EQUAL_INT(PageTemplate::IncludeHeader, tokens[1].variable);
+    TEST_ASSERT_EQUAL_UINT32(6, tokens[1].offset);
+    TEST_ASSERT_EQUAL_UINT32(16, tokens[1].length);
+    TEST_ASSERT_EQUAL_INT(PageTemplate::PageTitle, tokens[page.getTokenCount() - 1].variable);
+
+    size_t unknown = 0;
+    for (size_t i = 0; i < page.getTokenCount(); i++) {
+        unknown += tokens[i].variable == PageTemplate::Unknown;
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, unknown);
+}
+
+void test_chunked_compile_matches(void) {
+    PageTemplate whole = compile(PAGE, 4096);
+    for (size_t chunk = 1; chunk < 24; chunk++) {
+        PageTemplate pieces = compile(PAGE, chunk);
+        TEST_ASSERT_EQUAL_UINT32(whole.getTokenCount(), pieces.getTokenCount());
+        for (size_t i = 0; i < whole.getTokenCount(); i++) {
+            TEST_ASSERT_EQUAL_UINT32(whole.getTokens()[i].offset, pieces.getTokens()[i].offset);
+            TEST_ASSERT_EQUAL_UINT32(whole.getTokens()[i].length, pieces.getTokens()[i].length);
+            TEST_ASSERT_EQUAL_INT(whole.getTokens()[i].variable, pieces.getTokens()[i].variable);
+        }
+    }
+}
+
+void test_render(void) {
+    PageTemplate header = compile(HEADER, 4096);
+    PageTemplate page = compile(PAGE, 4096);
+    for (size_t chunk = 1; chunk <= 256; chunk = chunk * 2 + 1) {
+        TestRenderer renderer(page, PAGE, header, HEADER);
+        TEST_ASSERT_EQUAL_STRING(EXPECTED, render(renderer, chunk).c_str());
+        uint8_t rest[8];
+        TEST_ASSERT_EQUAL_UINT32(0, renderer.read(rest, sizeof(rest)));
+    }
+}
+
+void test_literal_reads_are_spans(void) {
+    PageTemplate header = compile(HEADER, 4096);
+    PageTemplate page = compile(PAGE, 4096);
+    TestRenderer renderer(page, PAGE, header, HEADER);
+    render(renderer, 1024);
+
+    size_t literals = 0;
+    for (size_t i = 0; i < page.getTokenCount(); i++) {
+        literals += page.getTokens()[i].variable == PageTemplate::Literal;
+    }
+    // one read per literal span, nothing is scanned again while rendering
+    TEST_ASSERT_EQUAL_UINT32(literals, renderer.pageReads);
+}
+
+void test_without_header(void) {
+    PageTemplate header;
+    PageTemplate page = compile("a%INCLUDE_HEADER%b%ACTIVE_SYSTEM%", 4096);
+    TestRenderer renderer(page, "a%INCLUDE_HEADER%b%ACTIVE_SYSTEM%", header, nullptr);
+    TEST_ASSERT_EQUAL_STRING("abchecked", render(renderer, 64).c_str());
+
+    PageTemplate trailing = compile("50%", 4096);
+    TestRenderer open(trailing, "50%", header, nullptr);
+    TEST_ASSERT_EQUAL_STRING("50%", render(open, 64).c_str());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_variable_names);
+    RUN_TEST(test_tokens);
+    RUN_TEST(test_chunked_compile_matches);
+    RUN_TEST(test_render);
+    RUN_TEST(test_literal_reads_are_spans);
+    RUN_TEST(test_without_header);
+    return UNITY_END();
+}
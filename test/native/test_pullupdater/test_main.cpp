@@ -0,0 +1,419 @@
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "pullupdater.h"
+
+// A stand-in for the LAN server: serves files from memory on 127.0.0.1,
+// honours "Range: bytes=N-", and can break connections off on purpose.
+class StandInServer {
+public:
+    std::map<std::string, std::vector<uint8_t>> files;
+    // the first dropCount image responses end after dropAfter body bytes
+    int dropCount = 0;
+    size_t dropAfter = 0;
+    bool ignoreRange = false;
+    std::vector<std::string> requests;
+
+    StandInServer() {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        bind(listener, (sockaddr *)&address, sizeof(address));
+        socklen_t length = sizeof(address);
+        getsockname(listener, (sockaddr *)&address, &length);
+        port = ntohs(address.sin_port);
+        listen(listener, 4);
+        worker = std::thread([this]() { serve(); });
+    }
+
+    ~StandInServer() {
+        running = false;
+        shutdown(listener, SHUT_RDWR);
+        close(listener);
+        worker.join();
+    }
+
+    uint16_t getPort() const { return port; }
+
+    std::vector<std::string> takeRequests() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::string> taken;
+        taken.swap(requests);
+        return taken;
+    }
+
+private:
+    int listener;
+    uint16_t port;
+    std::atomic<bool> running{true};
+    std::thread worker;
+    std::mutex mutex;
+
+    void serve() {
+        while (running) {
+            int connection = accept(listener, nullptr, nullptr);
+            if (connection < 0) {
+                return;
+            }
+            respond(connection);
+            close(connection);
+        }
+    }
+
+    void respond(int connection) {
+        std::string request;
+        char buffer[512];
+        while (request.find("\r\n\r\n") == std::string::npos) {
+            ssize_t count = recv(connection, buffer, sizeof(buffer), 0);
+            if (count <= 0) {
+                return;
+            }
+            request.append(buffer, count);
+        }
+        char path[128] = "";
+        sscanf(request.c_str(), "GET %127s HTTP/1.1", path);
+        unsigned long offset = 0;
+        size_t range = request.find("Range: bytes=");
+        bool ranged = range != std::string::npos && !ignoreRange;
+        if (ranged) {
+            offset = strtoul(request.c_str() + range + 13, nullptr, 10);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requests.push_back(std::string(path) + (range != std::string::npos ? " from " + std::to_string(strtoul(request.c_str() + range + 13, nullptr, 10)) : ""));
+        }
+
+        auto file = files.find(path);
+        char header[256];
+        if (file == files.end()) {
+            snprintf(header, sizeof(header), "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            send(connection, header, strlen(header), MSG_NOSIGNAL);
+            return;
+        }
+        const std::vector<uint8_t> &data = file->second;
+        if (ranged) {
+            snprintf(header, sizeof(header), "HTTP/1.1 206 Partial Content\r\nContent-Length: %zu\r\nContent-Range: bytes %lu-%zu/%zu\r\nConnection: close\r\n\r\n",
+                     data.size() - offset, offset, data.size() - 1, data.size());
+        } else {
+            snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n", data.size());
+        }
+        send(connection, header, strlen(header), MSG_NOSIGNAL);
+
+        size_t length = data.size() - offset;
+        bool isImage = strstr(path, ".json") == nullptr;
+        if (isImage && dropCount > 0) {
+            dropCount--;
+            length = dropAfter < length ? dropAfter : length;
+        }
+        send(connection, data.data() + offset, length, MSG_NOSIGNAL);
+    }
+};
+
+// what WiFiClient does on the device
+class SocketStream : public PullUpdater::Stream {
+public:
+    int connections = 0;
+
+    bool connect(const char *host, uint16_t port) override {
+        stop();
+        handle = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        inet_pton(AF_INET, host, &address.sin_addr);
+        connections++;
+        return ::connect(handle, (sockaddr *)&address, sizeof(address)) == 0;
+    }
+
+    size_t write(const uint8_t *data, size_t length) override {
+        ssize_t count = send(handle, data, length, MSG_NOSIGNAL);
+        return count < 0 ? 0 : count;
+    }
+
+    int read(uint8_t *buffer, size_t length) override {
+        ssize_t count = recv(handle, buffer, length, MSG_DONTWAIT);
+        if (count > 0) {
+            return count;
+        }
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 0;
+        }
+        return -1;
+    }
+
+    void stop() override {
+        if (handle >= 0) {
+            close(handle);
+            handle = -1;
+        }
+    }
+
+    ~SocketStream() { stop(); }
+
+private:
+    int handle = -1;
+};
+
+struct Flash {
+    std::map<UpdateType, std::vector<uint8_t>> written;
+    std::map<UpdateType, bool> activated;
+    UpdateType current = UpdateType::FIRMWARE;
+    std::vector<uint8_t> partition;
+    int begins = 0;
+};
+
+static std::vector<uint8_t> makeImage(size_t length, uint32_t seed) {
+    std::vector<uint8_t> image(length);
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245 + 12345;
+        image[i] = (uint8_t)(seed >> 16);
+    }
+    return image;
+}
+
+static std::vector<uint8_t> manifestFor(const std::vector<uint8_t> &image, const char *version) {
+    Sha256 hash;
+    hash.update(image.data(), image.size());
+    uint8_t digest[Sha256::DIGEST_SIZE];
+    hash.finish(digest);
+    char hex[Sha256::HEX_SIZE];
+    Sha256::toHex(digest, hex);
+    char json[200];
+    snprintf(json, sizeof(json), "{\"version\": \"%s\", \"size\": %zu, \"sha256\": \"%s\"}\n", version, image.size(), hex);
+    return std::vector<uint8_t>(json, json + strlen(json));
+}
+
+struct Harness {
+    StandInServer server;
+    SocketStream stream;
+    Flash flash;
+    OtaWriter writer;
+    PullUpdater update;
+    uint32_t now = 0;
+
+    Harness()
+        : writer([this](const uint8_t *data, size_t length) {
+              flash.partition.insert(flash.partition.end(), data, data + length);
+              return true;
+          }),
+          update(stream, writer,
+                 [this](UpdateType type, uint32_t) {
+                     flash.current = type;
+                     flash.partition.clear();
+                     flash.begins++;
+                     return true;
+                 },
+                 [this](UpdateType type, bool verified) {
+                     flash.activated[type] = verified;
+                     if (verified) {
+                         flash.written[type] = flash.partition;
+                     }
+                     return verified;
+                 }) {}
+
+    std::string url() const {
+        return "http://127.0.0.1:" + std::to_string(server.getPort()) + "/fleet/";
+    }
+
+    void run() {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+        while (update.isBusy() && std::chrono::steady_clock::now() < deadline) {
+            update.loop(now);
+            now += 10;
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+};
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_parse_helpers(void) {
+    char host[32];
+    uint16_t port;
+    const char *path;
+    TEST_ASSERT_TRUE(PullUpdater::parseUrl("http://192.168.1.10:8080/ota/clock", host, sizeof(host), port, path));
+    TEST_ASSERT_EQUAL_STRING("192.168.1.10", host);
+    TEST_ASSERT_EQUAL(8080, port);
+    TEST_ASSERT_EQUAL_STRING("/ota/clock", path);
+    TEST_ASSERT_TRUE(PullUpdater::parseUrl("http://updates.lan", host, sizeof(host), port, path));
+    TEST_ASSERT_EQUAL_STRING("updates.lan", host);
+    TEST_ASSERT_EQUAL(80, port);
+    TEST_ASSERT_EQUAL_STRING("", path);
+    TEST_ASSERT_FALSE(PullUpdater::parseUrl("https://updates.lan/", host, sizeof(host), port, path));
+    TEST_ASSERT_FALSE(PullUpdater::parseUrl("http://updates.lan:99999/", host, sizeof(host), port, path));
+    TEST_ASSERT_FALSE(PullUpdater::parseUrl("http://:80/", host, sizeof(host), port, path));
+
+    uint32_t start, total;
+    TEST_ASSERT_TRUE(PullUpdater::parseContentRange("bytes 100-199/1000", start, total));
+    TEST_ASSERT_EQUAL(100, start);
+    TEST_ASSERT_EQUAL(1000, total);
+    TEST_ASSERT_FALSE(PullUpdater::parseContentRange("bytes */1000", start, total));
+    TEST_ASSERT_FALSE(PullUpdater::parseContentRange("bytes 100-1000/1000", start, total));
+
+    PullUpdater::Manifest manifest;
+    std::vector<uint8_t> json = manifestFor(makeImage(1000, 1), "1.2");
+    json.push_back('\0');
+    TEST_ASSERT_TRUE(PullUpdater::parseManifest((const char *)json.data(), manifest));
+    TEST_ASSERT_EQUAL_STRING("1.2", manifest.version);
+    TEST_ASSERT_EQUAL(1000, manifest.image.size);
+    TEST_ASSERT_TRUE(manifest.image.hasDigest);
+    TEST_ASSERT_FALSE(PullUpdater::parseManifest("{\"version\":\"1.2\",\"size\":1000}", manifest));
+}
+
+void test_up_to_date_downloads_nothing(void) {
+    Harness harness;
+    std::vector<uint8_t> image = makeImage(50000, 2);
+    harness.server.files["/fleet/firmware.bin.json"] = manifestFor(image, "1.1-OTA");
+    harness.server.files["/fleet/firmware.bin"] = image;
+
+    TEST_ASSERT_TRUE(harness.update.start(harness.url().c_str(), "1.1-OTA", 0));
+    harness.run();
+    TEST_ASSERT_EQUAL(PullUpdater::UpToDate, harness.update.getStatus());
+    TEST_ASSERT_FALSE(harness.update.hasActivated());
+    TEST_ASSERT_EQUAL(0, harness.flash.begins);
+    TEST_ASSERT_EQUAL(1, harness.server.takeRequests().size());
+}
+
+void test_firmware_and_filesystem(void) {
+    Harness harness;
+    std::vector<uint8_t> firmware = makeImage(300000, 3);
+    std::vector<uint8_t> filesystem = makeImage(70000, 4);
+    harness.server.files["/fleet/firmware.bin.json"] = manifestFor(firmware, "1.2");
+    harness.server.files["/fleet/firmware.bin"] = firmware;
+    harness.server.files["/fleet/littlefs.bin.json"] = manifestFor(filesystem, "1.2");
+    harness.server.files["/fleet/littlefs.bin"] = filesystem;
+
+    TEST_ASSERT_TRUE(harness.update.start(harness.url().c_str(), "1.1-OTA", 0));
+    TEST_ASSERT_FALSE(harness.update.start(harness.url().c_str(), "1.1-OTA", 0));
+    harness.run();
+    TEST_ASSERT_EQUAL(PullUpdater::Done, harness.update.getStatus());
+    TEST_ASSERT_TRUE(harness.update.hasActivated());
+    TEST_ASSERT_TRUE(harness.flash.written[UpdateType::FIRMWARE] == firmware);
+    TEST_ASSERT_TRUE(harness.flash.written[UpdateType::FILESYSTEM] == filesystem);
+    TEST_ASSERT_EQUAL(0, harness.update.getResumes());
+}
+
+void test_firmware_only(void) {
+    Harness harness;
+    std::vector<uint8_t> firmware = makeImage(20000, 5);
+    harness.server.files["/fleet/firmware.bin.json"] = manifestFor(firmware, "1.2");
+    harness.server.files["/fleet/firmware.bin"] = firmware;
+
+    TEST_ASSERT_TRUE(harness.update.start(harness.url().c_str(), "1.1-OTA", 0));
+    harness.run();
+    TEST_ASSERT_EQUAL(PullUpdater::Done, harness.update.getStatus());
+    TEST_ASSERT_TRUE(harness.flash.written[UpdateType::FIRMWARE] == firmware);
+    TEST_ASSERT_EQUAL(1, harness.flash.begins);
+}
+
+void test_resumes_with_range(void) {
+    Harness harness;
+    std::vector<uint8_t> firmware = makeImage(200000, 6);
+    harness.server.files["/fleet/firmware.bin.json"] = manifestFor(firmware, "1.2");
+    harness.server.files["/fleet/firmware.bin"] = firmware;
+    harness.server.dropCount = 3;
+    harness.server.dropAfter = 30000;
+
+    TEST_ASSERT_TRUE(harness.update.start(harness.url().c_str(), "1.1-OTA", 0));
+    harness.run();
+    TEST_ASSERT_EQUAL(PullUpdater::Done, harness.update.getStatus());
+    TEST_ASSERT_TRUE(harness.flash.written[UpdateType::FIRMWARE] == firmware);
+    TEST_ASSERT_EQUAL(3, harness.update.getResumes());
+
+    std::vector<std::string> requests = harness.server.takeRequests();
+    TEST_ASSERT_EQUAL(6, requests.size());
+    TEST_ASSERT_EQUAL_STRING("/fleet/firmware.bin", requests[2].c_str());
+    TEST_ASSERT_EQUAL_STRING("/fleet/firmware.bin from 30000", requests[3].c_str());
+    TEST_ASSERT_EQUAL_STRING("/fleet/firmware.bin from 60000", requests[4].c_str());
+    TEST_ASSERT_EQUAL_STRING("/fleet/firmware.bin from 90000", requests[5].c_str());
+}
+
+void test_resumes_without_range_support(void) {
+    Harness harness;
+    std::vector<uint8_t> firmware = makeImage(100000, 7);
+    harness.server.files["/fleet/firmware.bin.json"] = manifestFor(firmware, "1.2");
+    harness.server.files["/fleet/firmware.bin"] = firmware;
+    harness.server.dropCount = 1;
+    harness.server.dropAfter = 40000;
+    harness.server.ignoreRange = true;
+
+    TEST_ASSERT_TRUE(harness.update.start(harness.url().c_str(), "1.1-OTA", 0));
+    harness.run();
+    TEST_ASSERT_EQUAL(PullUpdater::Done, harness.update.getStatus());
+    TEST_ASSERT_TRUE(harness.flash.written[UpdateType::FIRMWARE] == firmware);
+}
+
+void test_gives_up_and_rejects_bad_images(void) {
+    Harness harness;
+    std::vector<uint8_t> firmware = makeImage(100000, 8);
+    harness.server.files["/fleet/firmware.bin.json"] = manifestFor(firmware, "1.2");
+    firmware[1234] ^= 0x40;
+    harness.server.files["/fleet/firmware.bin"] = firmware;
+
+    TEST_ASSERT_TRUE(harness.update.start(harness.url().c_str(), "1.1-OTA", 0));
+    harness.run();
+    TEST_ASSERT_EQUAL(PullUpdater::Failed, harness.update.getStatus());
+    TEST_ASSERT_FALSE(harness.update.hasActivated());
+    TEST_ASSERT_FALSE(harness.flash.activated[UpdateType::FIRMWARE]);
+    TEST_ASSERT_EQUAL(OtaWriter::ErrorDigest, harness.writer.getProgress().error);
+
+    // the connection breaks off every time
+    harness.server.files["/fleet/firmware.bin"] = makeImage(100000, 8);
+    harness.server.dropCount = 100;
+    harness.server.dropAfter = 1000;
+    TEST_ASSERT_TRUE(harness.update.start(harness.url().c_str(), "1.1-OTA", harness.now));
+    harness.run();
+    TEST_ASSERT_EQUAL(PullUpdater::Failed, harness.update.getStatus());
+    TEST_ASSERT_EQUAL(PullUpdater::MAX_RESUMES, harness.update.getResumes());
+    TEST_ASSERT_EQUAL(OtaWriter::Failed, harness.writer.getProgress().status);
+    TEST_ASSERT_FALSE(harness.flash.activated[UpdateType::FIRMWARE]);
+}
+
+void test_benchmark_throughput(void) {
+    Harness harness;
+    std::vector<uint8_t> firmware = makeImage(1536 * 1024, 9);
+    harness.server.files["/fleet/firmware.bin.json"] = manifestFor(firmware, "1.2");
+    harness.server.files["/fleet/firmware.bin"] = firmware;
+
+    auto begin = std::chrono::steady_clock::now();
+    TEST_ASSERT_TRUE(harness.update.start(harness.url().c_str(), "1.1-OTA", 0));
+    harness.run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    TEST_ASSERT_EQUAL(PullUpdater::Done, harness.update.getStatus());
+
+    char message[128];
+    snprintf(message, sizeof(message), "1.5 MiB over loopback in %.0f ms, %.1f MiB/s with %u KiB per loop()",
+             seconds * 1000, 1.5 / seconds, (unsigned)(PullUpdater::BYTES_PER_LOOP / 1024));
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_helpers);
+    RUN_TEST(test_up_to_date_downloads_nothing);
+    RUN_TEST(test_firmware_and_filesystem);
+    RUN_TEST(test_firmware_only);
+    RUN_TEST(test_resumes_with_range);
+    RUN_TEST(test_resumes_without_range_support);
+    RUN_TEST(test_gives_up_and_rejects_bad_images);
+    RUN_TEST(test_benchmark_throughput);
+    return UNITY_END();
+}
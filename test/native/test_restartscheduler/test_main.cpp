@@ -0,0 +1,50 @@
+#include <unity.h>
+#include "restartscheduler.h"
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_nothing_pending(void) {
+    RestartScheduler restart;
+    TEST_ASSERT_FALSE(restart.isPending());
+    TEST_ASSERT_FALSE(restart.due(0));
+    TEST_ASSERT_FALSE(restart.due(100000));
+}
+
+void test_due_after_grace(void) {
+    RestartScheduler restart;
+    restart.schedule(5000);
+    TEST_ASSERT_TRUE(restart.isPending());
+    TEST_ASSERT_FALSE(restart.due(5000));
+    TEST_ASSERT_FALSE(restart.due(5000 + RestartScheduler::GRACE_MS - 1));
+    TEST_ASSERT_TRUE(restart.due(5000 + RestartScheduler::GRACE_MS));
+}
+
+void test_later_request_extends(void) {
+    RestartScheduler restart;
+    restart.schedule(1000, 2000);
+    restart.schedule(1500, 3000);
+    TEST_ASSERT_FALSE(restart.due(3000));
+    TEST_ASSERT_TRUE(restart.due(4500));
+    // an earlier deadline does not bring it forward
+    restart.schedule(1600, 100);
+    TEST_ASSERT_FALSE(restart.due(4000));
+}
+
+void test_millis_wrap(void) {
+    RestartScheduler restart;
+    restart.schedule(0xFFFFFF00u, 0x200);
+    TEST_ASSERT_FALSE(restart.due(0xFFFFFFF0u));
+    TEST_ASSERT_FALSE(restart.due(0x000000FFu));
+    TEST_ASSERT_TRUE(restart.due(0x00000100u));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_pending);
+    RUN_TEST(test_due_after_grace);
+    RUN_TEST(test_later_request_extends);
+    RUN_TEST(test_millis_wrap);
+    return UNITY_END();
+}
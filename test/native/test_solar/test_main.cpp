@@ -0,0 +1,114 @@
+#include <unity.h>
+#include "solarcalculator.h"
+#include "lightscheduler.h"
+#include "clockticker.h"
+
+static const char *BERLIN_TZ = "CET-1CEST,M3.5.0,M10.5.0/3";
+
+static int minuteOfUtcDay(time_t utc) {
+    return static_cast<int>((utc % 86400 + 86400) % 86400) / 60;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_berlin_solstices(void) {
+    SolarCalculator::SunTimes summer = SolarCalculator::compute(2025, 6, 21, 52.52f, 13.405f);
+    TEST_ASSERT_EQUAL_UINT8(SolarCalculator::Normal, summer.type);
+    TEST_ASSERT_INT_WITHIN(3, 2 * 60 + 43, minuteOfUtcDay(summer.sunrise));
+    TEST_ASSERT_INT_WITHIN(3, 19 * 60 + 33, minuteOfUtcDay(summer.sunset));
+
+    SolarCalculator::SunTimes winter = SolarCalculator::compute(2025, 12, 21, 52.52f, 13.405f);
+    TEST_ASSERT_EQUAL_UINT8(SolarCalculator::Normal, winter.type);
+    TEST_ASSERT_INT_WITHIN(3, 7 * 60 + 15, minuteOfUtcDay(winter.sunrise));
+    TEST_ASSERT_INT_WITHIN(3, 14 * 60 + 54, minuteOfUtcDay(winter.sunset));
+}
+
+void test_polar_day_and_night(void) {
+    // Tromsø
+    TEST_ASSERT_EQUAL_UINT8(SolarCalculator::PolarDay, SolarCalculator::compute(2025, 6, 21, 69.65f, 18.96f).type);
+    TEST_ASSERT_EQUAL_UINT8(SolarCalculator::PolarNight, SolarCalculator::compute(2025, 12, 21, 69.65f, 18.96f).type);
+    TEST_ASSERT_FALSE(SolarCalculator::isValidLocation(91.0f, 0.0f));
+    TEST_ASSERT_FALSE(SolarCalculator::isValidLocation(0.0f, -180.5f));
+}
+
+void test_anchored_rules_follow_solar_times(void) {
+    // from 30 minutes before sunset until 23:00, and from sunrise until 45 minutes after it
+    LightScheduler::Rule rules[] = {
+        {static_cast<uint16_t>(-30), 23 * 60, LightScheduler::ALL_DAYS, 100, {0, 0, 0},
+         LightScheduler::RULE_ENABLED | LightScheduler::RULE_START_SUNSET},
+        {0, 45, LightScheduler::ALL_DAYS, 50, {0, 0, 0},
+         LightScheduler::RULE_ENABLED | LightScheduler::RULE_START_SUNRISE | LightScheduler::RULE_END_SUNRISE},
+    };
+    LightScheduler schedule;
+    TEST_ASSERT_TRUE(schedule.setRules(rules, 2));
+    // nothing to resolve the anchors against yet
+    TEST_ASSERT_EQUAL(0, schedule.getEventCount());
+
+    schedule.setSolarTimes(6 * 60, 20 * 60);
+    TEST_ASSERT_EQUAL(28, schedule.getEventCount());
+    const LightScheduler::Event *event = schedule.nextEvent(LightScheduler::toMinuteOfWeek(1, 12, 0));
+    TEST_ASSERT_EQUAL_UINT16(LightScheduler::toMinuteOfWeek(1, 19, 30), event->minuteOfWeek);
+    event = schedule.nextEvent(LightScheduler::toMinuteOfWeek(1, 23, 30));
+    TEST_ASSERT_EQUAL_UINT16(LightScheduler::toMinuteOfWeek(2, 6, 0), event->minuteOfWeek);
+    event = schedule.nextEvent(event->minuteOfWeek);
+    TEST_ASSERT_EQUAL_UINT16(LightScheduler::toMinuteOfWeek(2, 6, 45), event->minuteOfWeek);
+
+    // polar night drops the anchored rules again
+    schedule.clearSolarTimes();
+    TEST_ASSERT_EQUAL(0, schedule.getEventCount());
+}
+
+void test_anchored_rule_validation(void) {
+    LightScheduler::Rule rule = {static_cast<uint16_t>(-721), 0, LightScheduler::ALL_DAYS, 0, {0, 0, 0},
+                                 LightScheduler::RULE_ENABLED | LightScheduler::RULE_START_SUNRISE};
+    TEST_ASSERT_FALSE(LightScheduler::isValid(rule));
+    rule.start = static_cast<uint16_t>(-720);
+    TEST_ASSERT_TRUE(LightScheduler::isValid(rule));
+    // same anchor and offset on both ends
+    rule.start = 10;
+    rule.end = 10;
+    rule.flags |= LightScheduler::RULE_END_SUNRISE;
+    TEST_ASSERT_FALSE(LightScheduler::isValid(rule));
+    rule.flags = LightScheduler::RULE_ENABLED | LightScheduler::RULE_START_SUNRISE | LightScheduler::RULE_START_SUNSET;
+    TEST_ASSERT_FALSE(LightScheduler::isValid(rule));
+}
+
+static int sunTimesCallbacks = 0;
+
+void test_ticker_computes_once_per_day(void) {
+    ClockTicker ticker;
+    sunTimesCallbacks = 0;
+    ticker.setCallback([](SchedulerType type, uint8_t, uint8_t) {
+        if (type == SchedulerType::SunTimes) {
+            sunTimesCallbacks++;
+        }
+    });
+    TEST_ASSERT_TRUE(ticker.setTimeZone(BERLIN_TZ));
+    TEST_ASSERT_TRUE(ticker.setLocation(52.52f, 13.405f));
+
+    // 2025-06-21 00:00 CEST, one tick per minute for two days
+    const time_t start = 1750456800;
+    for (time_t utc = start; utc < start + 2 * 86400; utc += 60) {
+        ticker.tick(utc);
+    }
+    TEST_ASSERT_EQUAL(2, sunTimesCallbacks);
+    TEST_ASSERT_INT_WITHIN(3, 4 * 60 + 43, ticker.getSunrise());
+    TEST_ASSERT_INT_WITHIN(3, 21 * 60 + 33, ticker.getSunset());
+
+    ticker.clearLocation();
+    ticker.tick(start + 2 * 86400);
+    TEST_ASSERT_EQUAL(3, sunTimesCallbacks);
+    TEST_ASSERT_EQUAL_INT16(-1, ticker.getSunrise());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_berlin_solstices);
+    RUN_TEST(test_polar_day_and_night);
+    RUN_TEST(test_anchored_rules_follow_solar_times);
+    RUN_TEST(test_anchored_rule_validation);
+    RUN_TEST(test_ticker_computes_once_per_day);
+    return UNITY_END();
+}
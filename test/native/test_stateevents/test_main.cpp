@@ -0,0 +1,105 @@
+#include <unity.h>
+#include <string>
+#include <string.h>
+#include "stateevents.h"
+
+static StateEvents::Values makeValues() {
+    StateEvents::Values values;
+    memset(&values, 0, sizeof(values));
+    values.state = true;
+    values.brightness = 120;
+    strcpy(values.color, "#FF8000");
+    values.minutes = 12 * 60 + 34;
+    values.illuminance = 1000;
+    values.renderMicros = 900;
+    values.renderMaxMicros = 1500;
+    return values;
+}
+
+static std::string take(StateEvents &events, uint32_t now) {
+    char buffer[StateEvents::MESSAGE_SIZE];
+    size_t length = events.take(now, buffer, sizeof(buffer));
+    return std::string(buffer, length);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_first_message_has_everything(void) {
+    StateEvents events;
+    events.update(makeValues());
+    TEST_ASSERT_EQUAL_STRING("{\"state\":true,\"brightness\":120,\"autoBrightness\":false,\"color\":\"#FF8000\","
+                             "\"time\":\"12:34\",\"illuminance\":1000,\"renderUs\":900,\"renderMaxUs\":1500}",
+                             take(events, 0).c_str());
+    TEST_ASSERT_FALSE(events.hasPending());
+    TEST_ASSERT_EQUAL_STRING("", take(events, 10000).c_str());
+}
+
+void test_changes_are_coalesced_and_spaced(void) {
+    StateEvents events;
+    StateEvents::Values values = makeValues();
+    events.update(values);
+    take(events, 1000);
+
+    // a fade: only the last brightness goes out, after the interval
+    for (uint8_t brightness = 121; brightness <= 130; brightness++) {
+        values.brightness = brightness;
+        events.update(values);
+        TEST_ASSERT_EQUAL_STRING("", take(events, 1000 + brightness - 121).c_str());
+    }
+    values.state = false;
+    events.update(values);
+    TEST_ASSERT_EQUAL_STRING("{\"state\":false,\"brightness\":130}",
+                             take(events, 1000 + StateEvents::STATE_INTERVAL_MS).c_str());
+
+    // back to what clients already have: nothing to send
+    values.state = true;
+    events.update(values);
+    values.state = false;
+    events.update(values);
+    TEST_ASSERT_FALSE(events.hasPending());
+}
+
+void test_sensor_fields_are_slower_and_filtered(void) {
+    StateEvents events;
+    StateEvents::Values values = makeValues();
+    events.update(values);
+    take(events, 0);
+
+    values.illuminance += StateEvents::ILLUMINANCE_STEP - 1;
+    events.update(values);
+    TEST_ASSERT_FALSE(events.hasPending());
+
+    values.illuminance += 1;
+    values.renderMicros = 950;
+    events.update(values);
+    TEST_ASSERT_EQUAL_STRING("", take(events, StateEvents::STATE_INTERVAL_MS).c_str());
+    TEST_ASSERT_EQUAL_STRING("{\"illuminance\":1016,\"renderUs\":950,\"renderMaxUs\":1500}",
+                             take(events, StateEvents::SENSOR_INTERVAL_MS).c_str());
+}
+
+void test_mark_all_skips_the_interval(void) {
+    StateEvents events;
+    events.update(makeValues());
+    take(events, 500);
+
+    events.markAll();
+    std::string full = take(events, 501);
+    TEST_ASSERT_TRUE(full.find("\"state\":true") != std::string::npos);
+    TEST_ASSERT_TRUE(full.find("\"renderMaxUs\":1500") != std::string::npos);
+
+    char small[16];
+    events.markAll();
+    TEST_ASSERT_EQUAL_UINT32(0, events.take(502, small, sizeof(small)));
+    TEST_ASSERT_TRUE(events.hasPending());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_message_has_everything);
+    RUN_TEST(test_changes_are_coalesced_and_spaced);
+    RUN_TEST(test_sensor_fields_are_slower_and_filtered);
+    RUN_TEST(test_mark_all_skips_the_interval);
+    return UNITY_END();
+}
@@ -0,0 +1,166 @@
+#include <unity.h>
+#include "statestore.h"
+#include <string.h>
+
+struct Recorder {
+    uint32_t calls = 0;
+    StateStore::FieldMask last = 0;
+    StateStore::FieldMask all = 0;
+};
+
+static StateStore::Subscriber record(Recorder &recorder) {
+    return [&recorder](StateStore::FieldMask changed, const StateStore &) {
+        recorder.calls++;
+        recorder.last = changed;
+        recorder.all |= changed;
+    };
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_burst_is_coalesced(void) {
+    StateStore state;
+    Recorder leds;
+    TEST_ASSERT_TRUE(state.subscribe(StateStore::LIGHT_FIELDS, record(leds)));
+
+    // a schedule start: brightness, color and state in one loop iteration
+    state.setBrightness(10);
+    state.setBrightness(20);
+    state.setColor("#FF0000");
+    state.setLightState(!state.getLight().state);
+    state.notify();
+
+    TEST_ASSERT_EQUAL_UINT32(1, leds.calls);
+    TEST_ASSERT_EQUAL_UINT16(StateStore::bit(StateStore::Brightness) | StateStore::bit(StateStore::Color) |
+                             StateStore::bit(StateStore::LightState), leds.last);
+    TEST_ASSERT_EQUAL_UINT8(20, state.getLight().brightness);
+
+    state.notify();
+    TEST_ASSERT_EQUAL_UINT32(1, leds.calls);
+}
+
+void test_unchanged_values_do_not_notify(void) {
+    StateStore state;
+    Recorder any;
+    state.subscribe(StateStore::ALL_FIELDS, record(any));
+
+    uint32_t version = state.getVersion();
+    TEST_ASSERT_FALSE(state.setLightState(state.getLight().state));
+    TEST_ASSERT_FALSE(state.setColor(state.getLight().color));
+    ConfigData::MqttConfig mqtt = state.getSystem().mqttConfig;
+    TEST_ASSERT_FALSE(state.setMqttConfig(mqtt));
+    TEST_ASSERT_FALSE(state.hasPendingChanges());
+    state.notify();
+
+    TEST_ASSERT_EQUAL_UINT32(0, any.calls);
+    TEST_ASSERT_EQUAL_UINT32(version, state.getVersion());
+}
+
+void test_interest_and_versions(void) {
+    StateStore state;
+    Recorder leds;
+    Recorder mqtt;
+    state.subscribe(StateStore::LIGHT_FIELDS | StateStore::bit(StateStore::ClockMode), record(leds));
+    state.subscribe(StateStore::bit(StateStore::Mqtt), record(mqtt));
+
+    ConfigData::MqttConfig config = state.getSystem().mqttConfig;
+    config.port = 1884;
+    TEST_ASSERT_TRUE(state.setMqttConfig(config));
+    state.notify();
+    TEST_ASSERT_EQUAL_UINT32(0, leds.calls);
+    TEST_ASSERT_EQUAL_UINT32(1, mqtt.calls);
+    TEST_ASSERT_EQUAL_UINT32(1, state.getVersion(StateStore::Mqtt));
+    TEST_ASSERT_EQUAL_UINT32(0, state.getVersion(StateStore::Color));
+
+    state.setClockMode(ConfigData::Option_1);
+    state.setAutoBrightness(!state.getLight().autoBrightnessConfig.enabled);
+    state.notify();
+    TEST_ASSERT_EQUAL_UINT32(1, leds.calls);
+    TEST_ASSERT_EQUAL_UINT16(StateStore::bit(StateStore::ClockMode) | StateStore::bit(StateStore::AutoBrightness), leds.last);
+    TEST_ASSERT_EQUAL_UINT32(3, state.getVersion());
+}
+
+void test_changes_from_subscribers_go_out_next(void) {
+    StateStore state;
+    Recorder later;
+    // e.g. the clock rejecting a location and switching it off again
+    StateStore *store = &state;
+    state.subscribe(StateStore::bit(StateStore::Location), [store](StateStore::FieldMask, const StateStore &current) {
+        if (current.getSystem().locationConfig.enabled) {
+            ConfigData::LocationConfig location = current.getSystem().locationConfig;
+            location.enabled = false;
+            store->setLocationConfig(location);
+        }
+    });
+    state.subscribe(StateStore::bit(StateStore::Location), record(later));
+
+    ConfigData::LocationConfig location = state.getSystem().locationConfig;
+    location.enabled = true;
+    state.setLocationConfig(location);
+    state.notify();
+    TEST_ASSERT_EQUAL_UINT32(1, later.calls);
+    TEST_ASSERT_TRUE(state.hasPendingChanges());
+    state.notify();
+    TEST_ASSERT_EQUAL_UINT32(2, later.calls);
+    TEST_ASSERT_FALSE(state.getSystem().locationConfig.enabled);
+}
+
+void test_subscriber_limit(void) {
+    StateStore state;
+    Recorder recorder;
+    for (uint8_t i = 0; i < StateStore::MAX_SUBSCRIBERS; i++) {
+        TEST_ASSERT_TRUE(state.subscribe(StateStore::ALL_FIELDS, record(recorder)));
+    }
+    TEST_ASSERT_FALSE(state.subscribe(StateStore::ALL_FIELDS, record(recorder)));
+}
+
+void test_update_applies_selected_fields_at_once(void) {
+    StateStore state;
+    Recorder any;
+    state.subscribe(StateStore::ALL_FIELDS, record(any));
+
+    ConfigData next = state.get();
+    next.light.brightness = next.light.brightness == 42 ? 43 : 42;
+    ConfigData::copyString(next.light.color, "#00FF00", sizeof(next.light.color));
+    next.light.state = state.getLight().state;
+    ConfigData::copyString(next.wifi.ssid, "other", sizeof(next.wifi.ssid));
+
+    StateStore::FieldMask changed = state.update(next, StateStore::ALL_FIELDS & ~StateStore::bit(StateStore::Wifi));
+    TEST_ASSERT_EQUAL_UINT16(StateStore::bit(StateStore::Brightness) | StateStore::bit(StateStore::Color), changed);
+    TEST_ASSERT_EQUAL_UINT8(next.light.brightness, state.getLight().brightness);
+    TEST_ASSERT_EQUAL_STRING("#00FF00", state.getLight().color);
+    TEST_ASSERT_NOT_EQUAL(0, strcmp("other", state.getWifi().ssid));
+
+    state.notify();
+    TEST_ASSERT_EQUAL_UINT32(1, any.calls);
+    TEST_ASSERT_EQUAL_UINT16(changed, any.last);
+}
+
+void test_fields_at_maps_config_layout(void) {
+    TEST_ASSERT_EQUAL_UINT16(StateStore::bit(StateStore::Brightness),
+                             StateStore::fieldsAt(offsetof(ConfigData, light.brightness), 1));
+    TEST_ASSERT_EQUAL_UINT16(StateStore::bit(StateStore::Mqtt),
+                             StateStore::fieldsAt(offsetof(ConfigData, system.mqttConfig.port), 2));
+    TEST_ASSERT_EQUAL_UINT16(StateStore::bit(StateStore::AutoBrightness),
+                             StateStore::fieldsAt(offsetof(ConfigData, light.autoBrightnessConfig.illuminanceThresholdLow), 2));
+    TEST_ASSERT_EQUAL_UINT16(StateStore::bit(StateStore::Schedule),
+                             StateStore::fieldsAt(offsetof(ConfigData, system.lightScheduleConfig.rules), 1));
+    TEST_ASSERT_EQUAL_UINT16(StateStore::bit(StateStore::Wifi),
+                             StateStore::fieldsAt(offsetof(ConfigData, wifi.password), 1));
+    TEST_ASSERT_EQUAL_UINT16(StateStore::ALL_FIELDS, StateStore::fieldsAt(0, sizeof(ConfigData)));
+    TEST_ASSERT_EQUAL_UINT16(0, StateStore::fieldsAt(0, 0));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_burst_is_coalesced);
+    RUN_TEST(test_unchanged_values_do_not_notify);
+    RUN_TEST(test_interest_and_versions);
+    RUN_TEST(test_changes_from_subscribers_go_out_next);
+    RUN_TEST(test_subscriber_limit);
+    RUN_TEST(test_update_applies_selected_fields_at_once);
+    RUN_TEST(test_fields_at_maps_config_layout);
+    return UNITY_END();
+}
@@ -0,0 +1,211 @@
+#include <unity.h>
+#include <string.h>
+#include "timearbiter.h"
+#include "timeformats.h"
+#include "mqtttimeprobe.h"
+
+static const int64_t REFERENCE_MS = 1750000000000LL;
+static uint32_t fakeMillis = 0;
+
+static uint32_t millisSource() {
+    return fakeMillis;
+}
+
+// answers after a fixed latency with a fixed error from the true time
+class FakeProbe : public ITimeProbe {
+public:
+    int64_t biasMs = 0;
+    uint32_t errorMs = 50;
+    uint32_t latencyMs = 20;
+    bool silent = false;
+    uint32_t requestedMs = 0;
+    bool pending = false;
+
+    const char *getName() const override { return "fake"; }
+    void request(uint32_t nowMs) override {
+        requestedMs = nowMs;
+        pending = !silent;
+    }
+    bool poll(uint32_t nowMs, TimeSample &sample) override {
+        if (!pending || nowMs - requestedMs < latencyMs) {
+            return false;
+        }
+        pending = false;
+        sample = {REFERENCE_MS + nowMs + biasMs, nowMs, errorMs};
+        return true;
+    }
+    void cancel() override { pending = false; }
+};
+
+static bool runRound(TimeArbiter &arbiter, TimeArbiter::Estimate &estimate) {
+    arbiter.startRound(fakeMillis);
+    while (arbiter.isRoundActive()) {
+        fakeMillis += 10;
+        if (arbiter.loop(fakeMillis, estimate)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void setUp(void) {
+    fakeMillis = 1000;
+}
+
+void tearDown(void) {}
+
+void test_intersection_majority(void) {
+    const int64_t offsets[] = {0, 10, 2000};
+    const uint32_t errors[] = {50, 50, 50};
+    int64_t low, high;
+    uint8_t agreeing;
+    TEST_ASSERT_TRUE(TimeArbiter::intersect(offsets, errors, 3, low, high, agreeing));
+    TEST_ASSERT_EQUAL_UINT8(2, agreeing);
+    TEST_ASSERT_EQUAL_INT64(-40, low);
+    TEST_ASSERT_EQUAL_INT64(50, high);
+
+    // two disjoint sources, no majority
+    TEST_ASSERT_FALSE(TimeArbiter::intersect(offsets + 1, errors, 2, low, high, agreeing));
+}
+
+void test_falseticker_is_outvoted_and_scored_down(void) {
+    SoftwareClock clock(millisSource);
+    TimeArbiter arbiter(clock);
+    FakeProbe good1, good2, bad;
+    good2.biasMs = 30;
+    bad.biasMs = 5 * 60000;
+    arbiter.addProbe(&good1);
+    arbiter.addProbe(&good2);
+    arbiter.addProbe(&bad);
+
+    TimeArbiter::Estimate estimate;
+    TEST_ASSERT_TRUE(runRound(arbiter, estimate));
+    TEST_ASSERT_EQUAL_UINT8(2, estimate.sources);
+    TEST_ASSERT_TRUE(clock.isValid());
+    TEST_ASSERT_INT_WITHIN(50, REFERENCE_MS + fakeMillis, clock.utcMsAt(fakeMillis));
+
+    for (int i = 0; i < 5; i++) {
+        runRound(arbiter, estimate);
+    }
+    TEST_ASSERT_TRUE(arbiter.getProbeState(0)->truechimer);
+    TEST_ASSERT_FALSE(arbiter.getProbeState(2)->truechimer);
+    TEST_ASSERT_LESS_THAN(TimeArbiter::MIN_VOTING_SCORE, arbiter.getProbeState(2)->score);
+    TEST_ASSERT_GREATER_THAN(TimeArbiter::INITIAL_SCORE, arbiter.getProbeState(0)->score);
+    // the falseticker no longer votes
+    TEST_ASSERT_EQUAL_UINT8(2, estimate.voters);
+}
+
+void test_silent_probe_times_out(void) {
+    SoftwareClock clock(millisSource);
+    TimeArbiter arbiter(clock);
+    FakeProbe good, silent;
+    silent.silent = true;
+    arbiter.addProbe(&good);
+    arbiter.addProbe(&silent);
+
+    uint32_t start = fakeMillis;
+    TimeArbiter::Estimate estimate;
+    TEST_ASSERT_TRUE(runRound(arbiter, estimate));
+    TEST_ASSERT_TRUE(fakeMillis - start >= TimeArbiter::ROUND_TIMEOUT_MS);
+    TEST_ASSERT_EQUAL_UINT32(1, arbiter.getProbeState(1)->misses);
+    TEST_ASSERT_LESS_THAN(TimeArbiter::INITIAL_SCORE, arbiter.getProbeState(1)->score);
+}
+
+void test_software_clock_learns_drift(void) {
+    SoftwareClock clock(millisSource);
+    TimeArbiter arbiter(clock);
+    FakeProbe probe;
+    probe.errorMs = 5;
+    arbiter.addProbe(&probe);
+
+    // the crystal runs 100 ppm slow compared to the reference
+    TimeArbiter::Estimate estimate;
+    for (int hour = 0; hour < 12; hour++) {
+        runRound(arbiter, estimate);
+        fakeMillis += 3600000;
+        probe.biasMs += 360;
+    }
+    TEST_ASSERT_INT_WITHIN(10, 100, clock.getDriftPpm());
+
+    // once learned, an hour without sync stays within a few ms
+    runRound(arbiter, estimate);
+    fakeMillis += 3600000;
+    probe.biasMs += 360;
+    runRound(arbiter, estimate);
+    TEST_ASSERT_INT_WITHIN(40, 0, estimate.offsetMs);
+}
+
+void test_ntp_reply_parsing(void) {
+    uint8_t packet[TimeFormats::NTP_PACKET_SIZE];
+    TimeFormats::buildNtpRequest(packet, 0x0102030405060708ULL);
+    TEST_ASSERT_EQUAL_HEX8(0x23, packet[0]);
+
+    // turn the request into a server reply for 2025-06-15 15:06:40.5 UTC
+    uint8_t reply[TimeFormats::NTP_PACKET_SIZE];
+    memset(reply, 0, sizeof(reply));
+    reply[0] = 0x24;
+    reply[1] = 2;
+    reply[10] = 0x80; // root dispersion 0.5 s, 16.16 fixed point
+    memcpy(reply + 24, packet + 40, 8);
+    const uint32_t seconds = 1750000000UL + 2208988800UL;
+    for (int offset = 32; offset <= 40; offset += 8) {
+        for (int i = 0; i < 4; i++) {
+            reply[offset + i] = static_cast<uint8_t>(seconds >> (24 - 8 * i));
+        }
+        reply[offset + 4] = 0x80;
+    }
+
+    TimeFormats::NtpReply parsed;
+    TEST_ASSERT_TRUE(TimeFormats::parseNtpReply(reply, sizeof(reply), 0x0102030405060708ULL, parsed));
+    TEST_ASSERT_EQUAL_INT64(1750000000500LL, parsed.transmitMs);
+    TEST_ASSERT_EQUAL_UINT32(500, parsed.rootDispersionMs);
+    // wrong nonce and kiss-o'-death are rejected
+    TEST_ASSERT_FALSE(TimeFormats::parseNtpReply(reply, sizeof(reply), 1, parsed));
+    reply[1] = 0;
+    TEST_ASSERT_FALSE(TimeFormats::parseNtpReply(reply, sizeof(reply), 0x0102030405060708ULL, parsed));
+}
+
+void test_http_date_and_epoch_parsing(void) {
+    time_t utc;
+    TEST_ASSERT_TRUE(TimeFormats::parseHttpDate("Sun, 15 Jun 2025 15:06:40 GMT", utc));
+    TEST_ASSERT_EQUAL_INT64(1750000000, utc);
+    TEST_ASSERT_FALSE(TimeFormats::parseHttpDate("Sun, 15 Foo 2025 15:06:40 GMT", utc));
+    TEST_ASSERT_FALSE(TimeFormats::parseHttpDate("Sunday, 15-Jun-25 15:06:40 GMT", utc));
+
+    int64_t utcMs;
+    TEST_ASSERT_TRUE(TimeFormats::parseEpoch("1750000000.25", utcMs));
+    TEST_ASSERT_EQUAL_INT64(1750000000250LL, utcMs);
+    TEST_ASSERT_FALSE(TimeFormats::parseEpoch("unavailable", utcMs));
+    TEST_ASSERT_FALSE(TimeFormats::parseEpoch("12", utcMs));
+}
+
+void test_mqtt_probe_offers_fresh_push_once_per_round(void) {
+    MqttTimeProbe probe;
+    TimeSample sample;
+    probe.request(0);
+    TEST_ASSERT_FALSE(probe.poll(0, sample));
+
+    TEST_ASSERT_TRUE(probe.push("1750000000", 1000));
+    TEST_ASSERT_TRUE(probe.poll(1500, sample));
+    TEST_ASSERT_EQUAL_INT64(1750000000000LL, sample.utcMs);
+    TEST_ASSERT_EQUAL_UINT32(1000, sample.localMs);
+    TEST_ASSERT_FALSE(probe.poll(1600, sample));
+
+    probe.request(2000);
+    TEST_ASSERT_TRUE(probe.poll(2000, sample));
+    // too old for the next round
+    probe.request(1000 + 3600000);
+    TEST_ASSERT_FALSE(probe.poll(1000 + 3600000, sample));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_intersection_majority);
+    RUN_TEST(test_falseticker_is_outvoted_and_scored_down);
+    RUN_TEST(test_silent_probe_times_out);
+    RUN_TEST(test_software_clock_learns_drift);
+    RUN_TEST(test_ntp_reply_parsing);
+    RUN_TEST(test_http_date_and_epoch_parsing);
+    RUN_TEST(test_mqtt_probe_offers_fresh_push_once_per_round);
+    return UNITY_END();
+}
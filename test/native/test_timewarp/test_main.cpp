@@ -0,0 +1,168 @@
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include "clockticker.h"
+#include "virtualtimesource.h"
+#include "timezones.h"
+
+static const time_t BERLIN_SPRING_FORWARD_DAY = 1743289200; // 2025-03-30 00:00 CET
+static const time_t BERLIN_FALL_BACK_DAY = 1761429600;      // 2025-10-26 00:00 CEST
+
+struct ReplayStats {
+    uint32_t timestamps = 0;
+    uint32_t starts = 0;
+    uint32_t ends = 0;
+};
+
+static LightScheduler::Rule makeRule(uint16_t start, uint16_t end) {
+    LightScheduler::Rule rule = {};
+    rule.start = start;
+    rule.end = end;
+    rule.weekdays = LightScheduler::ALL_DAYS;
+    rule.flags = LightScheduler::RULE_ENABLED;
+    return rule;
+}
+
+// replays [from, from + seconds) at one second resolution
+static ReplayStats replay(time_t from, uint32_t seconds, uint32_t step = 1) {
+    ReplayStats stats;
+    VirtualTimeSource source;
+    ClockTicker ticker;
+    ticker.setTimeZone(TimeZones::findPosixTz("Europe/Berlin"));
+    ticker.setCallback([&stats](SchedulerType type, uint8_t, uint8_t) {
+        switch (type) {
+        case SchedulerType::Timestamp: stats.timestamps++; break;
+        case SchedulerType::ScheduleStart: stats.starts++; break;
+        case SchedulerType::ScheduleEnd: stats.ends++; break;
+        default: break;
+        }
+    });
+
+    const LightScheduler::Rule rules[] = {makeRule(7 * 60, 22 * 60), makeRule(23 * 60 + 30, 30)};
+    ticker.enableSchedule(rules, 2);
+
+    source.jumpTo(from);
+    time_t utc;
+    source.now(utc);
+    ticker.sync(utc);
+
+    for (uint32_t elapsed = 0; elapsed < seconds; elapsed += step) {
+        source.now(utc);
+        ticker.tick(utc);
+        source.advance(step);
+    }
+    return stats;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_virtual_source_speed(void) {
+    static uint32_t fakeMillis = 0;
+    VirtualTimeSource source([]() -> uint32_t { return fakeMillis; });
+    source.jumpTo(1000);
+    source.setSpeed(60);
+    fakeMillis += 2000;
+
+    time_t utc;
+    TEST_ASSERT_TRUE(source.now(utc));
+    TEST_ASSERT_EQUAL_INT64(1000 + 120, utc);
+
+    // changing speed keeps time continuous
+    source.setSpeed(1);
+    fakeMillis += 1000;
+    source.now(utc);
+    TEST_ASSERT_EQUAL_INT64(1000 + 121, utc);
+}
+
+void test_spring_forward_day(void) {
+    ReplayStats stats = replay(BERLIN_SPRING_FORWARD_DAY, 23 * 3600);
+    // 02:00-02:59 does not exist
+    TEST_ASSERT_EQUAL_UINT32(23 * 60, stats.timestamps);
+    // boot evaluation (still in the overnight rule) + 07:00 + 23:30 starts
+    TEST_ASSERT_EQUAL_UINT32(3, stats.starts);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.ends);
+}
+
+void test_fall_back_day(void) {
+    ReplayStats stats = replay(BERLIN_FALL_BACK_DAY, 25 * 3600);
+    // 02:00-02:59 repeats, the repeated minutes tick again but fire no schedule edges
+    TEST_ASSERT_EQUAL_UINT32(25 * 60, stats.timestamps);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.starts);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.ends);
+}
+
+void test_corrections_do_not_refire_schedule(void) {
+    ReplayStats stats;
+    ClockTicker ticker;
+    ticker.setCallback([&stats](SchedulerType type, uint8_t, uint8_t) {
+        if (type == SchedulerType::ScheduleStart) {
+            stats.starts++;
+        } else if (type == SchedulerType::ScheduleEnd) {
+            stats.ends++;
+        }
+    });
+    const LightScheduler::Rule rules[] = {makeRule(7 * 60, 22 * 60)};
+    ticker.enableSchedule(rules, 1);
+
+    // 2025-06-02 12:00 UTC, inside the window
+    time_t utc = 1748865600;
+    ticker.sync(utc);
+    ticker.tick(utc);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.starts);
+
+    // hourly syncs that nudge the clock by a second either way keep manual changes
+    for (int hour = 0; hour < 6; hour++) {
+        utc += 3600;
+        ticker.tick(utc);
+        ticker.adjust(utc + (hour % 2 ? 1 : -1));
+        ticker.tick(utc + 1);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, stats.starts);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.ends);
+
+    // a forward step over the end of the window is caught up once
+    utc = 1748865600 + 9 * 3600 + 50 * 60; // 21:50
+    ticker.tick(utc);
+    ticker.adjust(utc + 20 * 60);
+    ticker.tick(utc + 20 * 60);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.ends);
+
+    // a small step back crosses no edge again
+    ticker.adjust(utc);
+    ticker.tick(utc);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.starts);
+
+    // a large step back into the window re-evaluates it
+    ticker.adjust(utc + 3 * 3600);
+    ticker.tick(utc + 3 * 3600);
+    ticker.adjust(utc - 3600);
+    ticker.tick(utc - 3600);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.starts);
+}
+
+void test_benchmark_replay_week(void) {
+    const uint32_t seconds = 7 * 24 * 3600;
+    auto begin = std::chrono::steady_clock::now();
+    ReplayStats stats = replay(BERLIN_SPRING_FORWARD_DAY, seconds);
+    auto end = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(end - begin).count();
+
+    char message[128];
+    snprintf(message, sizeof(message), "replayed %u s (%u minute ticks) in %.3f s: %.0f ticks/s",
+             seconds, stats.timestamps, elapsed, seconds / elapsed);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32(7 * 24 * 60, stats.timestamps);
+    TEST_ASSERT_TRUE(elapsed < 10.0);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_virtual_source_speed);
+    RUN_TEST(test_spring_forward_day);
+    RUN_TEST(test_fall_back_day);
+    RUN_TEST(test_corrections_do_not_refire_schedule);
+    RUN_TEST(test_benchmark_replay_week);
+    return UNITY_END();
+}
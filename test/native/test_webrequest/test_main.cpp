@@ -0,0 +1,232 @@
+#include <unity.h>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <string.h>
+#include "webrequest.h"
+
+// every heap allocation in this process is counted
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    void *memory = malloc(size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+// GCC flags free() on memory from operator new, which is the deliberate pairing here
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept {
+    free(memory);
+}
+#pragma GCC diagnostic pop
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_parse_color(void) {
+    uint8_t rgb[3] = {};
+    TEST_ASSERT_TRUE(WebRequest::parseColor("#FF8001", rgb));
+    TEST_ASSERT_EQUAL_UINT8(0xFF, rgb[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x80, rgb[1]);
+    TEST_ASSERT_EQUAL_UINT8(0x01, rgb[2]);
+    TEST_ASSERT_TRUE(WebRequest::parseColor("#a0b0c0", rgb));
+    TEST_ASSERT_FALSE(WebRequest::parseColor("FF8001", rgb));
+    TEST_ASSERT_FALSE(WebRequest::parseColor("#FF800", rgb));
+    TEST_ASSERT_FALSE(WebRequest::parseColor("#FF80012", rgb));
+    TEST_ASSERT_FALSE(WebRequest::parseColor("#GG8001", rgb));
+    TEST_ASSERT_FALSE(WebRequest::parseColor(nullptr, rgb));
+}
+
+void test_parse_time_of_day(void) {
+    WebRequest::TimeOfDay time = {};
+    TEST_ASSERT_TRUE(WebRequest::parseTimeOfDay("07:45", time));
+    TEST_ASSERT_EQUAL_UINT8(7, time.hour);
+    TEST_ASSERT_EQUAL_UINT8(45, time.minute);
+    TEST_ASSERT_TRUE(WebRequest::parseTimeOfDay("23:59", time));
+    TEST_ASSERT_FALSE(WebRequest::parseTimeOfDay("24:00", time));
+    TEST_ASSERT_FALSE(WebRequest::parseTimeOfDay("12:60", time));
+    TEST_ASSERT_FALSE(WebRequest::parseTimeOfDay("7:45", time));
+    TEST_ASSERT_FALSE(WebRequest::parseTimeOfDay("07-45", time));
+    TEST_ASSERT_FALSE(WebRequest::parseTimeOfDay("", time));
+}
+
+void test_schedule_edges(void) {
+    WebRequest::Anchor anchor;
+    uint16_t value = 0;
+
+    TEST_ASSERT_TRUE(WebRequest::parseScheduleEdge(nullptr, "22:30", nullptr, anchor, value));
+    TEST_ASSERT_EQUAL_INT(WebRequest::AnchorTime, anchor);
+    TEST_ASSERT_EQUAL_UINT16(22 * 60 + 30, value);
+    TEST_ASSERT_TRUE(WebRequest::parseScheduleEdge("time", "06:00", "15", anchor, value));
+    TEST_ASSERT_EQUAL_UINT16(6 * 60, value);
+    TEST_ASSERT_FALSE(WebRequest::parseScheduleEdge("time", nullptr, nullptr, anchor, value));
+
+    TEST_ASSERT_TRUE(WebRequest::parseScheduleEdge("sunset", nullptr, "-30", anchor, value));
+    TEST_ASSERT_EQUAL_INT(WebRequest::AnchorSunset, anchor);
+    TEST_ASSERT_EQUAL_INT16(-30, static_cast<int16_t>(value));
+    TEST_ASSERT_TRUE(WebRequest::parseScheduleEdge("sunrise", "bogus", nullptr, anchor, value));
+    TEST_ASSERT_EQUAL_INT(WebRequest::AnchorSunrise, anchor);
+    TEST_ASSERT_EQUAL_UINT16(0, value);
+    TEST_ASSERT_FALSE(WebRequest::parseScheduleEdge("sunrise", nullptr, "721", anchor, value));
+    TEST_ASSERT_FALSE(WebRequest::parseScheduleEdge("sunrise", nullptr, "10min", anchor, value));
+    TEST_ASSERT_FALSE(WebRequest::parseScheduleEdge("noon", "12:00", nullptr, anchor, value));
+
+    TEST_ASSERT_EQUAL_UINT8(LightScheduler::RULE_START_SUNSET | LightScheduler::RULE_END_SUNRISE,
+                            WebRequest::anchorFlags(WebRequest::AnchorSunset, WebRequest::AnchorSunrise));
+    TEST_ASSERT_EQUAL_UINT8(0, WebRequest::anchorFlags(WebRequest::AnchorTime, WebRequest::AnchorTime));
+}
+
+void test_payload_starts_empty(void) {
+    WebRequest request(ControlType::HaIntegration);
+    TEST_ASSERT_EQUAL_INT(ControlType::HaIntegration, request.type);
+    TEST_ASSERT_FALSE(request.mqtt.enabled);
+    TEST_ASSERT_EQUAL_STRING("", request.mqtt.host);
+    TEST_ASSERT_EQUAL_UINT16(0, request.mqtt.port);
+
+    PageState page(PageType::TIME);
+    TEST_ASSERT_EQUAL_INT(PageType::TIME, page.page);
+    TEST_ASSERT_EQUAL_UINT8(0, page.time.time.hour);
+    TEST_ASSERT_EQUAL_INT16(0, page.time.sunrise);
+}
+
+// The former interface: every handler filled a map of strings and the
+// application looked values up and converted them back. std::string is
+// used as a stand-in for Arduino's String, both keep short values inline.
+using ParamMap = std::map<std::string, std::string>;
+
+static void legacyScheduleRequest(ParamMap &params) {
+    params["scheduleEnabled"] = "1";
+    params["scheduleStart"] = std::to_string(7 * 3600);
+    params["scheduleEnd"] = std::to_string(22 * 3600 + 30 * 60);
+    params["scheduleStartAnchor"] = "time";
+    params["scheduleEndAnchor"] = "sunset";
+    params["scheduleStartOffset"] = "0";
+    params["scheduleEndOffset"] = "-30";
+    params["scheduleRule"] = "0";
+    params["scheduleDays"] = "127";
+    params["scheduleBrightness"] = "0";
+    params["scheduleColor"] = "#FF8000";
+}
+
+static uint16_t legacyScheduleApply(const ParamMap &params) {
+    // every lookup builds its key again, like FPSTR(...) did
+    uint16_t start = atoi(params.at(std::string("scheduleStart")).c_str()) / 60;
+    int16_t end = atoi(params.at(std::string("scheduleEndOffset")).c_str());
+    uint8_t days = atoi(params.at(std::string("scheduleDays")).c_str());
+    return start + end + days + params.at(std::string("scheduleColor")).size();
+}
+
+static void legacyTimePage(ParamMap &params) {
+    params["time"] = "12:30";
+    params["ntpEnabled"] = "1";
+    params["ntpHost"] = "europe.pool.ntp.org";
+    params["ntpInterval"] = std::to_string(86400);
+    params["ntpTimezone"] = "Europe/Berlin";
+    params["scheduleStart"] = std::to_string(7 * 3600);
+    params["scheduleEnd"] = "0";
+    params["scheduleStartAnchor"] = "time";
+    params["scheduleEndAnchor"] = "sunset";
+    params["scheduleStartOffset"] = "0";
+    params["scheduleEndOffset"] = "-30";
+    params["scheduleEnabled"] = "1";
+    params["locationEnabled"] = "1";
+    params["latitude"] = "52.5200";
+    params["longitude"] = "13.4050";
+    params["sunrise"] = std::to_string(6 * 60 + 12);
+    params["sunset"] = std::to_string(20 * 60 + 41);
+}
+
+static uint16_t typedScheduleApply(const WebRequest &request) {
+    const LightScheduler::Rule &rule = request.schedule.rule;
+    return rule.start + static_cast<int16_t>(rule.end) + rule.weekdays + (rule.flags & LightScheduler::RULE_HAS_COLOR ? 7 : 0);
+}
+
+void test_benchmark_allocations_per_request(void) {
+    const int iterations = 1000;
+    volatile uint32_t sink = 0;
+
+    size_t before = allocations;
+    for (int i = 0; i < iterations; i++) {
+        ParamMap params;
+        legacyScheduleRequest(params);
+        sink = sink + legacyScheduleApply(params);
+    }
+    size_t legacyRequest = (allocations - before) / iterations;
+
+    before = allocations;
+    for (int i = 0; i < iterations; i++) {
+        // what handleSetLightSchedule now builds from the raw parameters
+        WebRequest request(ControlType::LightSchedule);
+        WebRequest::Anchor startAnchor, endAnchor;
+        LightScheduler::Rule &rule = request.schedule.rule;
+        TEST_ASSERT_TRUE(WebRequest::parseScheduleEdge("time", "07:00", nullptr, startAnchor, rule.start));
+        TEST_ASSERT_TRUE(WebRequest::parseScheduleEdge("sunset", nullptr, "-30", endAnchor, rule.end));
+        TEST_ASSERT_TRUE(WebRequest::parseColor("#FF8000", rule.color));
+        request.schedule.enabled = true;
+        rule.weekdays = LightScheduler::ALL_DAYS;
+        rule.flags = LightScheduler::RULE_ENABLED | LightScheduler::RULE_HAS_COLOR | WebRequest::anchorFlags(startAnchor, endAnchor);
+        sink = sink + typedScheduleApply(request);
+    }
+    size_t typedRequest = (allocations - before) / iterations;
+
+    before = allocations;
+    for (int i = 0; i < iterations; i++) {
+        // the map was copied into the template processor of the response
+        ParamMap params;
+        legacyTimePage(params);
+        std::shared_ptr<ParamMap> captured = std::make_shared<ParamMap>(params);
+        sink = sink + captured->size();
+    }
+    size_t legacyPage = (allocations - before) / iterations;
+
+    before = allocations;
+    for (int i = 0; i < iterations; i++) {
+        std::shared_ptr<PageState> page = std::make_shared<PageState>(PageType::TIME);
+        page->time.time.hour = 12;
+        page->time.sunrise = 7 * 60 + 12;
+        sink = sink + page->time.time.hour;
+    }
+    size_t typedPage = (allocations - before) / iterations;
+
+    char message[192];
+    snprintf(message, sizeof(message), "schedule request: %u allocations with a map, %u typed; time page: %u with a map, %u typed (%u byte snapshot)",
+             (unsigned)legacyRequest, (unsigned)typedRequest, (unsigned)legacyPage, (unsigned)typedPage, (unsigned)sizeof(PageState));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32(0, typedRequest);
+    TEST_ASSERT_EQUAL_UINT32(1, typedPage);
+    TEST_ASSERT_GREATER_THAN(10, legacyRequest);
+    TEST_ASSERT_GREATER_THAN(30, legacyPage);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_color);
+    RUN_TEST(test_parse_time_of_day);
+    RUN_TEST(test_schedule_edges);
+    RUN_TEST(test_payload_starts_empty);
+    RUN_TEST(test_benchmark_allocations_per_request);
+    return UNITY_END();
+}
@@ -0,0 +1,96 @@
+#ifdef UNIT_TEST
+
+#include <Arduino.h>
+#include <unity.h>
+#include "lightscheduler.h"
+
+static LightScheduler::Rule makeRule(uint16_t start, uint16_t end, uint8_t weekdays = LightScheduler::ALL_DAYS) {
+    LightScheduler::Rule rule = {};
+    rule.start = start;
+    rule.end = end;
+    rule.weekdays = weekdays;
+    rule.flags = LightScheduler::RULE_ENABLED;
+    return rule;
+}
+
+void test_next_event_wraps_week(void) {
+    LightScheduler scheduler;
+    const LightScheduler::Rule rules[] = {makeRule(7 * 60, 22 * 60, 0x02)}; // Monday only
+    TEST_ASSERT_TRUE(scheduler.setRules(rules, 1));
+    TEST_ASSERT_EQUAL_UINT32(2, scheduler.getEventCount());
+
+    // Saturday evening -> next is Monday 07:00
+    const LightScheduler::Event *next = scheduler.nextEvent(LightScheduler::toMinuteOfWeek(6, 20, 0));
+    TEST_ASSERT_NOT_NULL(next);
+    TEST_ASSERT_EQUAL_UINT16(LightScheduler::toMinuteOfWeek(1, 7, 0), next->minuteOfWeek);
+    TEST_ASSERT_EQUAL_UINT8(LightScheduler::Start, next->type);
+}
+
+void test_overnight_rule_ends_next_day(void) {
+    LightScheduler scheduler;
+    const LightScheduler::Rule rules[] = {makeRule(22 * 60, 6 * 60, 0x40)}; // Saturday night
+    TEST_ASSERT_TRUE(scheduler.setRules(rules, 1));
+
+    const LightScheduler::Event *current = scheduler.currentEvent(LightScheduler::toMinuteOfWeek(0, 3, 0));
+    TEST_ASSERT_NOT_NULL(current);
+    TEST_ASSERT_EQUAL_UINT8(LightScheduler::Start, current->type);
+
+    current = scheduler.currentEvent(LightScheduler::toMinuteOfWeek(0, 6, 30));
+    TEST_ASSERT_EQUAL_UINT8(LightScheduler::End, current->type);
+}
+
+void test_poll_evaluates_state_on_boot(void) {
+    LightScheduler scheduler;
+    const LightScheduler::Rule rules[] = {makeRule(8 * 60, 18 * 60)};
+    scheduler.setRules(rules, 1);
+
+    const LightScheduler::Event *event = scheduler.poll(LightScheduler::toMinuteOfWeek(3, 12, 0));
+    TEST_ASSERT_NOT_NULL(event);
+    TEST_ASSERT_EQUAL_UINT8(LightScheduler::Start, event->type);
+    TEST_ASSERT_NULL(scheduler.poll(LightScheduler::toMinuteOfWeek(3, 12, 1)));
+}
+
+void test_poll_catches_up_on_missed_event(void) {
+    LightScheduler scheduler;
+    const LightScheduler::Rule rules[] = {makeRule(8 * 60, 18 * 60)};
+    scheduler.setRules(rules, 1);
+
+    scheduler.poll(LightScheduler::toMinuteOfWeek(3, 17, 58));
+    // the 18:00 tick was skipped
+    const LightScheduler::Event *event = scheduler.poll(LightScheduler::toMinuteOfWeek(3, 18, 2));
+    TEST_ASSERT_NOT_NULL(event);
+    TEST_ASSERT_EQUAL_UINT8(LightScheduler::End, event->type);
+    TEST_ASSERT_NULL(scheduler.poll(LightScheduler::toMinuteOfWeek(3, 18, 3)));
+}
+
+void test_invalid_rules_are_dropped(void) {
+    LightScheduler scheduler;
+    const LightScheduler::Rule rules[] = {makeRule(8 * 60, 8 * 60), makeRule(9 * 60, 10 * 60, 0)};
+    TEST_ASSERT_FALSE(scheduler.setRules(rules, 2));
+    TEST_ASSERT_EQUAL_UINT8(0, scheduler.getRuleCount());
+    TEST_ASSERT_NULL(scheduler.poll(0));
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_next_event_wraps_week);
+    RUN_TEST(test_overnight_rule_ends_next_day);
+    RUN_TEST(test_poll_evaluates_state_on_boot);
+    RUN_TEST(test_poll_catches_up_on_missed_event);
+    RUN_TEST(test_invalid_rules_are_dropped);
+    return UNITY_END();
+}
+
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // not used
+}
+
+#endif
@@ -0,0 +1,210 @@
+# Builds delta patches between two firmware images, in the format
+# src/deltapatcher.h applies on the device while the patch is uploaded:
+#
+#   python tools/deltapatch.py diff  old.bin new.bin patch.delta
+#   python tools/deltapatch.py apply old.bin patch.delta out.bin
+#   python tools/deltapatch.py check old.bin new.bin    (diff, apply, compare)
+#
+# old.bin has to be the firmware the clock runs, it is checked by its MD5.
+# Layout, little endian:
+#
+#   "WDLT" u16 version u16 0 u32 old size u32 new size
+#   u8[16] MD5 of the old image, u8[32] SHA-256 of the new image
+#   records until "E":
+#     "L" varint length, literal bytes
+#     "D" u32 old offset, varint length, then pairs of varint zeros,
+#         varint count, count bytes: new = old + byte (mod 256), the zeros
+#         are unchanged bytes; pairs continue until length bytes are covered
+#     "E"
+#
+# Like bsdiff, matches are approximate, so code that only moved keeps a
+# mostly zero difference, which the zero runs take care of instead of the
+# bzip2 stage bsdiff uses. The device needs no decompression window.
+
+import hashlib
+import struct
+import sys
+
+MAGIC = b"WDLT"
+VERSION = 1
+HEADER = struct.Struct("<4sHHII16s32s")
+
+SEED = 8          # bytes that have to match exactly to start a match
+STRIDE = 4        # the old image is indexed every STRIDE bytes
+MIN_MATCH = 24    # shorter matches go out as literals
+GIVE_UP = 64      # approximate matching ends after this many bytes without gain
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def encode_difference(old, new):
+    out = bytearray()
+    pos = 0
+    length = len(new)
+    while pos < length:
+        zeros = pos
+        while zeros < length and old[zeros] == new[zeros]:
+            zeros += 1
+        end = zeros
+        # short equal stretches stay in the bytes, a pair costs at least two
+        while end < length:
+            if old[end] == new[end] and old[end:end + 3] == new[end:end + 3]:
+                break
+            end += 1
+        out += varint(zeros - pos) + varint(end - zeros)
+        out += bytes((new[k] - old[k]) & 0xFF for k in range(zeros, end))
+        pos = end
+    return bytes(out)
+
+
+def extend(old, new, old_pos, new_pos):
+    # bsdiff's score: matching bytes count double, so half matching is break-even
+    best_len = 0
+    best_score = 0
+    score = 0
+    k = 0
+    limit = min(len(old) - old_pos, len(new) - new_pos)
+    while k < limit:
+        score += 1 if old[old_pos + k] == new[new_pos + k] else -1
+        k += 1
+        if score > best_score:
+            best_score = score
+            best_len = k
+        elif k - best_len > GIVE_UP:
+            break
+    return best_len
+
+
+def diff(old, new):
+    index = {}
+    for j in range(0, len(old) - SEED + 1, STRIDE):
+        index.setdefault(old[j:j + SEED], j)
+
+    records = []
+    literal_start = 0
+    offset = None  # old position minus new position of the last match
+    i = 0
+    while i < len(new) - SEED + 1:
+        seed = new[i:i + SEED]
+        candidates = []
+        if offset is not None and 0 <= i + offset <= len(old) - SEED:
+            candidates.append(i + offset)
+        found = index.get(seed)
+        if found is not None:
+            candidates.append(found)
+
+        best_old, best_len = None, 0
+        for j in candidates:
+            if old[j:j + SEED] != seed:
+                continue
+            length = extend(old, new, j, i)
+            if length > best_len:
+                best_old, best_len = j, length
+        if best_len < MIN_MATCH:
+            i += 1
+            continue
+
+        # take back what the literal run had in common with the old image
+        back = 0
+        while back < i - literal_start and back < best_old and old[best_old - back - 1] == new[i - back - 1]:
+            back += 1
+        start, old_start, length = i - back, best_old - back, best_len + back
+        if start > literal_start:
+            records.append(b"L" + varint(start - literal_start) + new[literal_start:start])
+        records.append(b"D" + struct.pack("<I", old_start) + varint(length) +
+                       encode_difference(old[old_start:old_start + length], new[start:start + length]))
+        offset = old_start - start
+        i = literal_start = start + length
+
+    if literal_start < len(new):
+        records.append(b"L" + varint(len(new) - literal_start) + new[literal_start:])
+    records.append(b"E")
+
+    header = HEADER.pack(MAGIC, VERSION, 0, len(old), len(new),
+                         hashlib.md5(old).digest(), hashlib.sha256(new).digest())
+    return header + b"".join(records)
+
+
+def apply(old, patch):
+    magic, version, _, old_size, new_size, old_md5, new_sha256 = HEADER.unpack_from(patch)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a delta patch")
+    if len(old) != old_size or hashlib.md5(old).digest() != old_md5:
+        raise ValueError("the patch is for a different old image")
+
+    out = bytearray()
+    pos = HEADER.size
+    while True:
+        command = patch[pos:pos + 1]
+        pos += 1
+        if command == b"L":
+            length, pos = read_varint(patch, pos)
+            out += patch[pos:pos + length]
+            pos += length
+        elif command == b"D":
+            (old_pos,) = struct.unpack_from("<I", patch, pos)
+            length, pos = read_varint(patch, pos + 4)
+            end = old_pos + length
+            while old_pos < end:
+                zeros, pos = read_varint(patch, pos)
+                count, pos = read_varint(patch, pos)
+                out += old[old_pos:old_pos + zeros]
+                old_pos += zeros
+                out += bytes((old[old_pos + k] + patch[pos + k]) & 0xFF for k in range(count))
+                old_pos += count
+                pos += count
+        elif command == b"E":
+            break
+        else:
+            raise ValueError("bad record at %d" % (pos - 1))
+
+    if len(out) != new_size or hashlib.sha256(out).digest() != new_sha256:
+        raise ValueError("the patched image does not match")
+    return bytes(out)
+
+
+def read(path):
+    with open(path, "rb") as f:
+        return f.read()
+
+
+if __name__ == "__main__":
+    command = sys.argv[1] if len(sys.argv) > 1 else ""
+    if command == "diff" and len(sys.argv) == 5:
+        patch = diff(read(sys.argv[2]), read(sys.argv[3]))
+        with open(sys.argv[4], "wb") as f:
+            f.write(patch)
+    elif command == "apply" and len(sys.argv) == 5:
+        image = apply(read(sys.argv[2]), read(sys.argv[3]))
+        with open(sys.argv[4], "wb") as f:
+            f.write(image)
+    elif command == "check" and len(sys.argv) == 4:
+        old, new = read(sys.argv[2]), read(sys.argv[3])
+        patch = diff(old, new)
+        assert apply(old, patch) == new
+        print("patch %d bytes, %.1f %% of the %d byte image, verified" % (len(patch), 100.0 * len(patch) / len(new), len(new)))
+    else:
+        print("usage: deltapatch.py diff OLD NEW PATCH | apply OLD PATCH OUT | check OLD NEW")
+        sys.exit(1)
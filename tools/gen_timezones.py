@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Generates src/timezone_data.h from the system tz database.
+
+Every zone listed in zone.tab plus the fixed-offset Etc/ zones is mapped to
+the POSIX TZ string found in the footer of its TZif file. Names are sorted
+for binary search, identical POSIX rules are stored once, and the <option>
+list for the time page is prebuilt so the device never assembles it.
+
+usage: tools/gen_timezones.py [zoneinfo dir] > src/timezone_data.h
+"""
+
+import os
+import sys
+
+ZONEINFO = sys.argv[1] if len(sys.argv) > 1 else "/usr/share/zoneinfo"
+ETC_ZONES = ["Etc/UTC", "Etc/GMT"] + ["Etc/GMT%+d" % i for i in range(-14, 13) if i != 0]
+
+
+def posix_footer(name):
+    with open(os.path.join(ZONEINFO, name), "rb") as f:
+        data = f.read()
+    if not data.startswith(b"TZif") or data[4:5] < b"2":
+        raise ValueError("%s has no POSIX footer" % name)
+    footer = data.rstrip(b"\n").rsplit(b"\n", 1)[1].decode("ascii")
+    if not footer:
+        raise ValueError("%s has an empty POSIX footer" % name)
+    return footer
+
+
+def read_version():
+    try:
+        with open(os.path.join(ZONEINFO, "tzdata.zi")) as f:
+            return f.readline().split()[-1]
+    except OSError:
+        return "unknown"
+
+
+def c_string(data):
+    out = []
+    for chunk in [data[i:i + 96] for i in range(0, len(data), 96)]:
+        out.append('    "%s"' % chunk.replace("\\", "\\\\").replace('"', '\\"').replace("\0", "\\000"))
+    return "\n".join(out) if out else '    ""'
+
+
+def main():
+    names = set(ETC_ZONES)
+    with open(os.path.join(ZONEINFO, "zone.tab")) as f:
+        for line in f:
+            if line.startswith("#") or not line.strip():
+                continue
+            names.add(line.split("\t")[2].strip())
+
+    # byte order, matches strcmp on the device
+    zones = sorted(((name, posix_footer(name)) for name in names), key=lambda z: z[0].encode())
+
+    rules = {}
+    rule_blob = ""
+    for _, rule in zones:
+        if rule not in rules:
+            rules[rule] = len(rule_blob)
+            rule_blob += rule + "\0"
+
+    name_blob = ""
+    index = []
+    for name, rule in zones:
+        index.append((len(name_blob), rules[rule]))
+        name_blob += name + "\0"
+
+    options = "".join('<option value="%s">%s</option>' % (name, name) for name, _ in zones)
+
+    if len(name_blob) > 0xFFFF or len(rule_blob) > 0xFFFF:
+        raise ValueError("string tables exceed 16 bit offsets")
+
+    print("// generated by tools/gen_timezones.py from tzdata %s, do not edit" % read_version())
+    print("#ifndef TIMEZONE_DATA_H")
+    print("#define TIMEZONE_DATA_H")
+    print()
+    print("#include <stdint.h>")
+    print("#include <stddef.h>")
+    print()
+    print("#ifndef PROGMEM")
+    print("#define PROGMEM")
+    print("#endif")
+    print()
+    print("struct TzEntry {")
+    print("    uint16_t name;    // offset into TZ_NAMES")
+    print("    uint16_t posixTz; // offset into TZ_RULES")
+    print("};")
+    print()
+    print("// %d zones, %d distinct POSIX rules" % (len(zones), len(rules)))
+    print("const size_t TZ_COUNT = %d;" % len(zones))
+    print()
+    print("const char TZ_NAMES[] PROGMEM =")
+    print(c_string(name_blob) + ";")
+    print()
+    print("const char TZ_RULES[] PROGMEM =")
+    print(c_string(rule_blob) + ";")
+    print()
+    print("// sorted by name")
+    print("const TzEntry TZ_INDEX[TZ_COUNT] PROGMEM = {")
+    for i in range(0, len(index), 6):
+        print("    " + " ".join("{%d, %d}," % entry for entry in index[i:i + 6]))
+    print("};")
+    print()
+    print("const char TZ_OPTIONS_HTML[] PROGMEM =")
+    print(c_string(options) + ";")
+    print()
+    print("#endif")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,54 @@
+# Writes the manifest for a firmware or filesystem image next to it, e.g.
+# firmware.bin -> firmware.bin.json:
+#
+#   {"version": "1.1-OTA", "size": 1234567, "sha256": "<64 hex digits>"}
+#
+# The firmware page sends size and sha256 along with the upload, and the
+# device refuses to activate an image that does not match.
+
+import hashlib
+import json
+import os
+import re
+import sys
+
+VERSION_PATTERN = re.compile(r'FW_VERSION\s*=\s*"([^"]*)"')
+
+
+def firmware_version(defaults_header):
+    with open(defaults_header) as f:
+        match = VERSION_PATTERN.search(f.read())
+    return match.group(1) if match else ""
+
+
+def build_manifest(image, version):
+    digest = hashlib.sha256()
+    with open(image, "rb") as f:
+        for block in iter(lambda: f.read(65536), b""):
+            digest.update(block)
+    return {"version": version, "size": os.path.getsize(image), "sha256": digest.hexdigest()}
+
+
+def write_manifest(image, version):
+    path = image + ".json"
+    with open(path, "w") as f:
+        json.dump(build_manifest(image, version), f)
+        f.write("\n")
+    return path
+
+
+if __name__ == "__main__":
+    # python tools/otamanifest.py <image> [version]
+    print(write_manifest(sys.argv[1], sys.argv[2] if len(sys.argv) > 2 else ""))
+else:
+    Import("env")  # noqa: F821
+
+    version = firmware_version(os.path.join(env.subst("$PROJECT_SRC_DIR"), "defaults.h"))  # noqa: F821
+
+    def after_image(source, target, env):
+        for image in target:
+            print("OTA manifest: " + write_manifest(str(image), version))
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.bin", after_image)  # noqa: F821
+    # buildfs, for pull updates of the web interface
+    env.AddPostAction("$BUILD_DIR/littlefs.bin", after_image)  # noqa: F821
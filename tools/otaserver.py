@@ -0,0 +1,59 @@
+# Serves a directory of update images to the clocks on the LAN, with the
+# Range support http.server lacks, so interrupted downloads resume:
+#
+#   python tools/otaserver.py .pio/build/ESP32 --port 8080
+#
+# The clocks fetch firmware.bin.json and firmware.bin (plus littlefs.bin.json
+# and littlefs.bin if present) from http://<host>:8080/. --drop-after N
+# breaks every image response off after N bytes, to try the resume path.
+
+import argparse
+import functools
+import os
+import re
+from http.server import SimpleHTTPRequestHandler, ThreadingHTTPServer
+
+RANGE_PATTERN = re.compile(r"bytes=(\d+)-$")
+
+
+class RangeHandler(SimpleHTTPRequestHandler):
+    drop_after = 0
+
+    def send_head(self):
+        path = self.translate_path(self.path)
+        match = RANGE_PATTERN.match(self.headers.get("Range", ""))
+        if not os.path.isfile(path) or not match:
+            return super().send_head()
+
+        size = os.path.getsize(path)
+        start = int(match.group(1))
+        if start >= size:
+            self.send_error(416)
+            return None
+        f = open(path, "rb")
+        f.seek(start)
+        self.send_response(206)
+        self.send_header("Content-Type", self.guess_type(path))
+        self.send_header("Content-Length", str(size - start))
+        self.send_header("Content-Range", "bytes %d-%d/%d" % (start, size - 1, size))
+        self.end_headers()
+        return f
+
+    def copyfile(self, source, outputfile):
+        if self.drop_after <= 0 or self.path.endswith(".json"):
+            return super().copyfile(source, outputfile)
+        outputfile.write(source.read(self.drop_after))
+        self.close_connection = True
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Serve OTA images with Range support")
+    parser.add_argument("directory")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--drop-after", type=int, default=0, help="break image responses off after this many bytes")
+    args = parser.parse_args()
+
+    RangeHandler.drop_after = args.drop_after
+    handler = functools.partial(RangeHandler, directory=args.directory)
+    print("Serving %s on port %d" % (os.path.abspath(args.directory), args.port))
+    ThreadingHTTPServer(("", args.port), handler).serve_forever()
@@ -0,0 +1,233 @@
+# Minifies and compresses the web interface before the filesystem image is
+# built. The output goes to $BUILD_DIR/data, which replaces data/ as the image
+# source, so the sources in data/ stay readable.
+#
+#   style.css, index.js, favicon.ico, wifimanager.html  -> file + file.gz
+#   pages with %VARIABLES%                              -> file + file.gzt
+#
+# A .gzt file is a template whose literal spans are deflated one by one and
+# byte aligned, so the device can splice in the values as stored blocks and
+# send the page gzip encoded without compressing anything itself. Layout,
+# little endian:
+#
+#   "WGZT" u16 version u16 segments
+#   per segment: u8 0, u32 deflated length, u32 text length, u32 text crc32
+#            or: u8 1, u8 name length, name
+#   deflated literal spans in segment order
+#
+# Environments with -DWOC_EMBEDDED_ASSETS also get the output as const arrays
+# in src/webasset_data.h (not checked in), so the firmware carries its own UI.
+
+import hashlib
+import os
+import re
+import shutil
+import struct
+import sys
+import zlib
+
+GZT_MAGIC = b"WGZT"
+GZT_VERSION = 1
+MAX_NAME = 32
+
+STATIC_FILES = ("style.css", "index.js", "favicon.ico", "wifimanager.html")
+TEMPLATE_FILES = ("navigation.html", "light.html", "time.html", "system.html", "firmware.html")
+
+CONTENT_TYPES = {
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".ico": "image/x-icon",
+    ".html": "text/html",
+}
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{};,>])\s*", r"\1", text)
+    text = re.sub(r":\s+", ":", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_js(text):
+    # line based so automatic semicolon insertion still sees the same code
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line and not line.startswith("//"))
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line)
+
+
+MINIFIERS = {".css": minify_css, ".js": minify_js, ".html": minify_html}
+
+
+def minify(name, data):
+    minifier = MINIFIERS.get(os.path.splitext(name)[1])
+    if minifier is None:
+        return data
+    return minifier(data.decode("utf-8")).encode("utf-8")
+
+
+def gzip_bytes(data):
+    # no file name or time stamp, the output only changes with the input
+    compressor = zlib.compressobj(9, zlib.DEFLATED, 31)
+    gz = compressor.compress(data) + compressor.flush()
+    return gz[:4] + b"\0\0\0\0" + gz[8:]
+
+
+def split_template(text):
+    """Same rules as PageTemplate::feed: returns ("literal", bytes) and ("variable", name)."""
+    parts = []
+    literal = bytearray()
+    i = 0
+    while i < len(text):
+        c = text[i:i + 1]
+        if c != b"%":
+            literal += c
+            i += 1
+            continue
+        j = i + 1
+        while j < len(text) and j - i - 1 < MAX_NAME and (text[j:j + 1].isalnum() or text[j:j + 1] == b"_"):
+            j += 1
+        if j < len(text) and text[j:j + 1] == b"%":
+            if j == i + 1:
+                literal += b"%"
+            else:
+                if literal:
+                    parts.append(("literal", bytes(literal)))
+                    literal = bytearray()
+                parts.append(("variable", text[i + 1:j]))
+            i = j + 1
+        else:
+            # not a variable, the text is kept as it is
+            literal += text[i:j]
+            i = j
+    if literal:
+        parts.append(("literal", bytes(literal)))
+    return parts
+
+
+def deflate_segment(data):
+    # raw deflate ending in a sync flush: byte aligned and never the final block
+    compressor = zlib.compressobj(9, zlib.DEFLATED, -15)
+    return compressor.compress(data) + compressor.flush(zlib.Z_SYNC_FLUSH)
+
+
+def build_gzt(text):
+    table = bytearray()
+    body = bytearray()
+    parts = split_template(text)
+    for kind, value in parts:
+        if kind == "literal":
+            segment = deflate_segment(value)
+            table += struct.pack("<BIII", 0, len(segment), len(value), zlib.crc32(value) & 0xFFFFFFFF)
+            body += segment
+        else:
+            table += struct.pack("<BB", 1, len(value)) + value
+    return GZT_MAGIC + struct.pack("<HH", GZT_VERSION, len(parts)) + bytes(table) + bytes(body)
+
+
+def build(source, target):
+    if os.path.isdir(target):
+        shutil.rmtree(target)
+    os.makedirs(target)
+
+    for name in sorted(os.listdir(source)):
+        path = os.path.join(source, name)
+        if not os.path.isfile(path):
+            continue
+        with open(path, "rb") as f:
+            data = minify(name, f.read())
+        with open(os.path.join(target, name), "wb") as f:
+            f.write(data)
+
+        if name in STATIC_FILES:
+            extra, suffix = gzip_bytes(data), ".gz"
+        elif name in TEMPLATE_FILES:
+            extra, suffix = build_gzt(data), ".gzt"
+        else:
+            print("webassets: %s copied" % name)
+            continue
+        with open(os.path.join(target, name + suffix), "wb") as f:
+            f.write(extra)
+        print("webassets: %s %d -> %d bytes, %s %d bytes" % (name, os.path.getsize(path), len(data), suffix, len(extra)))
+
+
+def content_type(name):
+    if name.endswith(".gzt"):
+        return "application/octet-stream"
+    if name.endswith(".gz"):
+        name = name[:-3]
+    return CONTENT_TYPES.get(os.path.splitext(name)[1], "application/octet-stream")
+
+
+def embedded_header(directory):
+    # byte order, matches strcmp on the device
+    names = sorted((name for name in os.listdir(directory) if os.path.isfile(os.path.join(directory, name))), key=lambda n: n.encode())
+    lines = [
+        "// generated by tools/webassets.py, do not edit",
+        "#ifndef WEBASSET_DATA_H",
+        "#define WEBASSET_DATA_H",
+        "",
+        '#include "embeddedassets.h"',
+        "",
+    ]
+    entries = []
+    total = 0
+    for i, name in enumerate(names):
+        with open(os.path.join(directory, name), "rb") as f:
+            data = f.read()
+        total += len(data)
+        lines.append("// %s, %d bytes" % (name, len(data)))
+        lines.append("alignas(4) static const uint8_t ASSET_DATA_%d[] = {" % i)
+        for offset in range(0, len(data), 16):
+            lines.append("    " + " ".join("0x%02x," % b for b in data[offset:offset + 16]))
+        lines.append("};")
+        lines.append("")
+        etag = '\\"%s\\"' % hashlib.sha256(data).hexdigest()[:16]
+        entries.append('    {"/%s", "%s", "%s", ASSET_DATA_%d, %d},' % (name, content_type(name), etag, i, len(data)))
+
+    lines.append("// %d assets, %d bytes, sorted by path" % (len(names), total))
+    lines.append("static const size_t ASSET_COUNT = %d;" % len(names))
+    lines.append("static const EmbeddedAssets::Asset ASSETS[ASSET_COUNT] = {")
+    lines.extend(entries)
+    lines.append("};")
+    lines.append("")
+    lines.append("#endif")
+    return "\n".join(lines) + "\n"
+
+
+def write_if_changed(path, text):
+    # an unchanged header keeps the firmware from being rebuilt
+    if os.path.isfile(path):
+        with open(path) as f:
+            if f.read() == text:
+                return
+    with open(path, "w") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    # python tools/webassets.py <data dir> <output dir> [embedded header]
+    build(sys.argv[1], sys.argv[2])
+    if len(sys.argv) > 3:
+        write_if_changed(sys.argv[3], embedded_header(sys.argv[2]))
+else:
+    Import("env")  # noqa: F821
+
+    output = os.path.join(env.subst("$BUILD_DIR"), "data")  # noqa: F821
+    build_flags = env.GetProjectOption("build_flags", "")  # noqa: F821
+    if not isinstance(build_flags, str):
+        build_flags = " ".join(build_flags)
+
+    FS_TARGETS = ("buildfs", "uploadfs", "uploadfsota")
+    if "WOC_EMBEDDED_ASSETS" in build_flags:
+        build(env.subst("$PROJECT_DATA_DIR"), output)  # noqa: F821
+        write_if_changed(os.path.join(env.subst("$PROJECT_SRC_DIR"), "webasset_data.h"), embedded_header(output))  # noqa: F821
+        env.Replace(PROJECT_DATA_DIR=output)  # noqa: F821
+    elif any(target in FS_TARGETS for target in COMMAND_LINE_TARGETS):  # noqa: F821
+        build(env.subst("$PROJECT_DATA_DIR"), output)  # noqa: F821
+        env.Replace(PROJECT_DATA_DIR=output)  # noqa: F821